@@ -0,0 +1,321 @@
+/*
+ * Description: AES-256-GCM decryption (see aes_gcm.h). GHASH is computed over the
+ * ciphertext block before the block is decrypted, which is what allows in-place use.
+ * There is no additional authenticated data.
+ */
+
+#include "string.h"
+#include "aes_gcm.h"
+
+#ifndef AES_GCM_USE_CE
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRYPTO)
+#define AES_GCM_USE_CE 1
+#else
+#define AES_GCM_USE_CE 0
+#endif
+#endif
+
+#if AES_GCM_USE_CE && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#define AES_256_ROUNDS 14
+
+static const uint8_t aesSbox[256] =
+{
+    0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+    0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+    0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+    0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+    0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+    0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+    0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+    0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+    0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+    0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+    0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+    0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+    0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+    0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+    0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+    0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+};
+
+static uint32_t aes_get32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void aes_put32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t)(value >> 24);
+    p[1] = (uint8_t)(value >> 16);
+    p[2] = (uint8_t)(value >> 8);
+    p[3] = (uint8_t)value;
+}
+
+#if AES_GCM_USE_CE
+
+static void aes_encrypt_block(const struct aes_gcm_context *context, const uint8_t *in, uint8_t *out)
+{
+    uint8x16_t block = vld1q_u8(in);
+
+    for (uint32_t round = 0; round < AES_256_ROUNDS - 1; round++)
+    {
+        block = vaesmcq_u8(vaeseq_u8(block, vld1q_u8(&context->roundKeyBytes[16 * round])));
+    }
+    block = vaeseq_u8(block, vld1q_u8(&context->roundKeyBytes[16 * (AES_256_ROUNDS - 1)]));
+    block = veorq_u8(block, vld1q_u8(&context->roundKeyBytes[16 * AES_256_ROUNDS]));
+
+    vst1q_u8(out, block);
+}
+
+// Carry-less 64x64 multiply
+static void ghash_clmul(uint64_t a, uint64_t b, uint64_t *lo, uint64_t *hi)
+{
+    uint64x2_t product = vreinterpretq_u64_p128(vmull_p64((poly64_t)a, (poly64_t)b));
+
+    *lo = vgetq_lane_u64(product, 0);
+    *hi = vgetq_lane_u64(product, 1);
+}
+
+// x = x * H in GF(2^128). Reversing the bits of every byte turns GCM's reflected
+// representation into a plain polynomial, reduced by x^128 = x^7 + x^2 + x + 1.
+static void ghash_multiply(const struct aes_gcm_context *context, uint8_t *x)
+{
+    uint64x2_t a = vreinterpretq_u64_u8(vrbitq_u8(vld1q_u8(x)));
+    uint64x2_t b = vreinterpretq_u64_u8(vrbitq_u8(vld1q_u8(context->h)));
+    uint64_t a0 = vgetq_lane_u64(a, 0), a1 = vgetq_lane_u64(a, 1);
+    uint64_t b0 = vgetq_lane_u64(b, 0), b1 = vgetq_lane_u64(b, 1);
+    uint64_t p0, p1, p2, p3, lo, hi;
+
+    // 256-bit product p3:p2:p1:p0
+    ghash_clmul(a0, b0, &p0, &p1);
+    ghash_clmul(a1, b1, &p2, &p3);
+    ghash_clmul(a0, b1, &lo, &hi);
+    p1 ^= lo;
+    p2 ^= hi;
+    ghash_clmul(a1, b0, &lo, &hi);
+    p1 ^= lo;
+    p2 ^= hi;
+
+    // Fold the high half down twice
+    uint64_t m0lo, m0hi, m1lo, m1hi, flo, fhi;
+    ghash_clmul(p2, 0x87, &m0lo, &m0hi);
+    ghash_clmul(p3, 0x87, &m1lo, &m1hi);
+    ghash_clmul(m1hi, 0x87, &flo, &fhi);
+    p0 ^= m0lo ^ flo;
+    p1 ^= m0hi ^ m1lo;
+
+    uint64x2_t result = vcombine_u64(vcreate_u64(p0), vcreate_u64(p1));
+    vst1q_u8(x, vrbitq_u8(vreinterpretq_u8_u64(result)));
+}
+
+#else
+
+// Reduction constants for the 4-bit GHASH table walk
+static const uint64_t ghashLast4[16] =
+{
+    0x0000, 0x1C20, 0x3840, 0x2460, 0x7080, 0x6CA0, 0x48C0, 0x54E0,
+    0xE100, 0xFD20, 0xD940, 0xC560, 0x9180, 0x8DA0, 0xA9C0, 0xB5E0
+};
+
+static uint32_t aes_ror(uint32_t value, uint32_t bits)
+{
+    return (value >> bits) | (value << (32 - bits));
+}
+
+static void aes_encrypt_block(const struct aes_gcm_context *context, const uint8_t *in, uint8_t *out)
+{
+    const uint32_t *te = context->te;
+    const uint32_t *rk = context->roundKeys;
+    uint32_t s0 = aes_get32(in) ^ rk[0];
+    uint32_t s1 = aes_get32(in + 4) ^ rk[1];
+    uint32_t s2 = aes_get32(in + 8) ^ rk[2];
+    uint32_t s3 = aes_get32(in + 12) ^ rk[3];
+    uint32_t t0, t1, t2, t3;
+
+    for (uint32_t round = 1; round < AES_256_ROUNDS; round++)
+    {
+        rk += 4;
+        t0 = te[s0 >> 24] ^ aes_ror(te[(s1 >> 16) & 0xFF], 8) ^ aes_ror(te[(s2 >> 8) & 0xFF], 16) ^
+            aes_ror(te[s3 & 0xFF], 24) ^ rk[0];
+        t1 = te[s1 >> 24] ^ aes_ror(te[(s2 >> 16) & 0xFF], 8) ^ aes_ror(te[(s3 >> 8) & 0xFF], 16) ^
+            aes_ror(te[s0 & 0xFF], 24) ^ rk[1];
+        t2 = te[s2 >> 24] ^ aes_ror(te[(s3 >> 16) & 0xFF], 8) ^ aes_ror(te[(s0 >> 8) & 0xFF], 16) ^
+            aes_ror(te[s1 & 0xFF], 24) ^ rk[2];
+        t3 = te[s3 >> 24] ^ aes_ror(te[(s0 >> 16) & 0xFF], 8) ^ aes_ror(te[(s1 >> 8) & 0xFF], 16) ^
+            aes_ror(te[s2 & 0xFF], 24) ^ rk[3];
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+
+    // Final round: SubBytes and ShiftRows only
+    rk += 4;
+    aes_put32(out, (((uint32_t)aesSbox[s0 >> 24] << 24) | ((uint32_t)aesSbox[(s1 >> 16) & 0xFF] << 16) |
+        ((uint32_t)aesSbox[(s2 >> 8) & 0xFF] << 8) | aesSbox[s3 & 0xFF]) ^ rk[0]);
+    aes_put32(out + 4, (((uint32_t)aesSbox[s1 >> 24] << 24) | ((uint32_t)aesSbox[(s2 >> 16) & 0xFF] << 16) |
+        ((uint32_t)aesSbox[(s3 >> 8) & 0xFF] << 8) | aesSbox[s0 & 0xFF]) ^ rk[1]);
+    aes_put32(out + 8, (((uint32_t)aesSbox[s2 >> 24] << 24) | ((uint32_t)aesSbox[(s3 >> 16) & 0xFF] << 16) |
+        ((uint32_t)aesSbox[(s0 >> 8) & 0xFF] << 8) | aesSbox[s1 & 0xFF]) ^ rk[2]);
+    aes_put32(out + 12, (((uint32_t)aesSbox[s3 >> 24] << 24) | ((uint32_t)aesSbox[(s0 >> 16) & 0xFF] << 16) |
+        ((uint32_t)aesSbox[(s1 >> 8) & 0xFF] << 8) | aesSbox[s2 & 0xFF]) ^ rk[3]);
+}
+
+// x = x * H in GF(2^128), four bits at a time
+static void ghash_multiply(const struct aes_gcm_context *context, uint8_t *x)
+{
+    uint8_t low = x[15] & 0xF;
+    uint64_t zh = context->hh[low];
+    uint64_t zl = context->hl[low];
+
+    for (int32_t i = 15; i >= 0; i--)
+    {
+        uint8_t high = x[i] >> 4;
+        uint8_t rem;
+
+        low = x[i] & 0xF;
+        if (i != 15)
+        {
+            rem = zl & 0xF;
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ (ghashLast4[rem] << 48);
+            zh ^= context->hh[low];
+            zl ^= context->hl[low];
+        }
+
+        rem = zl & 0xF;
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4) ^ (ghashLast4[rem] << 48);
+        zh ^= context->hh[high];
+        zl ^= context->hl[high];
+    }
+
+    aes_put32(x, (uint32_t)(zh >> 32));
+    aes_put32(x + 4, (uint32_t)zh);
+    aes_put32(x + 8, (uint32_t)(zl >> 32));
+    aes_put32(x + 12, (uint32_t)zl);
+}
+
+#endif
+
+void aes_gcm_init(struct aes_gcm_context *context, const uint8_t *key)
+{
+    uint32_t *rk = context->roundKeys;
+    uint8_t rcon = 0x01;
+
+    // Round table: te[x] = {2s, s, s, 3s} for s = S(x); the other columns are rotations
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t s = aesSbox[i];
+        uint32_t s2 = ((s << 1) ^ ((s & 0x80) ? 0x1B : 0)) & 0xFF;
+
+        context->te[i] = (s2 << 24) | (s << 16) | (s << 8) | (s2 ^ s);
+    }
+
+    // AES-256 key expansion
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        rk[i] = aes_get32(key + 4 * i);
+    }
+    for (uint32_t i = 8; i < 60; i++)
+    {
+        uint32_t word = rk[i - 1];
+
+        if (i % 8 == 0)
+        {
+            word = ((uint32_t)aesSbox[(word >> 16) & 0xFF] << 24) | ((uint32_t)aesSbox[(word >> 8) & 0xFF] << 16) |
+                ((uint32_t)aesSbox[word & 0xFF] << 8) | aesSbox[word >> 24];
+            word ^= (uint32_t)rcon << 24;
+            rcon = (uint8_t)((rcon << 1) ^ ((rcon & 0x80) ? 0x1B : 0));
+        }
+        else if (i % 8 == 4)
+        {
+            word = ((uint32_t)aesSbox[word >> 24] << 24) | ((uint32_t)aesSbox[(word >> 16) & 0xFF] << 16) |
+                ((uint32_t)aesSbox[(word >> 8) & 0xFF] << 8) | aesSbox[word & 0xFF];
+        }
+        rk[i] = rk[i - 8] ^ word;
+    }
+    for (uint32_t i = 0; i < 60; i++)
+    {
+        aes_put32(&context->roundKeyBytes[4 * i], rk[i]);
+    }
+
+    // H = E(K, 0) and its multiples for the table-driven GHASH
+    memset(context->h, 0, sizeof(context->h));
+    aes_encrypt_block(context, context->h, context->h);
+
+    uint64_t vh = ((uint64_t)aes_get32(context->h) << 32) | aes_get32(context->h + 4);
+    uint64_t vl = ((uint64_t)aes_get32(context->h + 8) << 32) | aes_get32(context->h + 12);
+    context->hl[0] = 0;
+    context->hh[0] = 0;
+    context->hl[8] = vl;
+    context->hh[8] = vh;
+    for (uint32_t i = 4; i > 0; i >>= 1)
+    {
+        uint64_t carry = (vl & 1) ? 0xE100000000000000ULL : 0;
+        vl = (vh << 63) | (vl >> 1);
+        vh = (vh >> 1) ^ carry;
+        context->hl[i] = vl;
+        context->hh[i] = vh;
+    }
+    for (uint32_t i = 2; i <= 8; i *= 2)
+    {
+        for (uint32_t j = 1; j < i; j++)
+        {
+            context->hh[i + j] = context->hh[i] ^ context->hh[j];
+            context->hl[i + j] = context->hl[i] ^ context->hl[j];
+        }
+    }
+}
+
+int32_t aes_gcm_decrypt(const struct aes_gcm_context *context, const uint8_t *iv,
+    const uint8_t *src, uint8_t *dst, uint32_t size, const uint8_t *tag)
+{
+    uint8_t counter[16];
+    uint8_t keystream[16];
+    uint8_t ghash[16];
+
+    // J0 = IV || 1; data starts at J0 + 1
+    memcpy(counter, iv, AES_GCM_IV_SIZE);
+    aes_put32(&counter[12], 1);
+    memset(ghash, 0, sizeof(ghash));
+
+    for (uint32_t offset = 0; offset < size; offset += 16)
+    {
+        uint32_t chunk = (size - offset < 16) ? size - offset : 16;
+
+        // Authenticate the ciphertext before it is overwritten
+        for (uint32_t i = 0; i < chunk; i++)
+        {
+            ghash[i] ^= src[offset + i];
+        }
+        ghash_multiply(context, ghash);
+
+        aes_put32(&counter[12], aes_get32(&counter[12]) + 1);
+        aes_encrypt_block(context, counter, keystream);
+        for (uint32_t i = 0; i < chunk; i++)
+        {
+            dst[offset + i] = src[offset + i] ^ keystream[i];
+        }
+    }
+
+    // Length block: 64-bit bit counts of the (empty) AAD and the ciphertext
+    uint64_t bits = (uint64_t)size * 8;
+    aes_put32(&ghash[8], aes_get32(&ghash[8]) ^ (uint32_t)(bits >> 32));
+    aes_put32(&ghash[12], aes_get32(&ghash[12]) ^ (uint32_t)bits);
+    ghash_multiply(context, ghash);
+
+    // Tag = E(K, J0) ^ GHASH, compared without an early exit
+    aes_put32(&counter[12], 1);
+    aes_encrypt_block(context, counter, keystream);
+    uint8_t difference = 0;
+    for (uint32_t i = 0; i < AES_GCM_TAG_SIZE; i++)
+    {
+        difference |= (uint8_t)(keystream[i] ^ ghash[i] ^ tag[i]);
+    }
+
+    return (difference == 0) ? 0 : -1;
+}
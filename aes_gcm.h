@@ -0,0 +1,35 @@
+/*
+ * Description: AES-256-GCM decryption for encrypted boot pack blocks. The portable path
+ * uses T-table AES and 4-bit table GHASH, which is what the R5 runs; on the A53, building
+ * with the crypto extensions enabled (-march=armv8-a+crypto) switches both to the AES
+ * and polynomial multiply instructions. Blocks are decrypted 16 bytes at a time, so the
+ * output may overwrite the input in place.
+ */
+
+#ifndef AES_GCM_H
+#define AES_GCM_H
+
+#include "stdint.h"
+
+#define AES_GCM_KEY_SIZE 32
+#define AES_GCM_IV_SIZE 12
+#define AES_GCM_TAG_SIZE 16
+
+// Expanded key and lookup tables; read-only once initialized, so cores can share one
+struct aes_gcm_context
+{
+    uint32_t te[256];               // Combined SubBytes/MixColumns table for the portable path
+    uint32_t roundKeys[60];
+    uint8_t roundKeyBytes[240];     // Same schedule in byte order for the AES instructions
+    uint8_t h[16];
+    uint64_t hl[16];
+    uint64_t hh[16];
+};
+
+void aes_gcm_init(struct aes_gcm_context *context, const uint8_t *key);
+
+// Decrypts size bytes and checks the tag; returns 0 if authentic, -1 otherwise
+int32_t aes_gcm_decrypt(const struct aes_gcm_context *context, const uint8_t *iv,
+    const uint8_t *src, uint8_t *dst, uint32_t size, const uint8_t *tag);
+
+#endif
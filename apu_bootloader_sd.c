@@ -21,248 +21,142 @@
 #include <xil_printf.h> // Include Debug IO
 
 // Addtional Libraries
-#include "elf.h"
+#include "elf_loader.h"
+#include "apu_control.h"
+#include "boot_memmap.h"
+#include "ddr_ecc.h"
+#include "boot_zero.h"
+#include "bootpack.h"
+#include "boot_log.h"
+#include "boot_stats.h"
+#include "boot_trace.h"
 
 // Prototypes
-uint64_t load_elf64(const char *file_name);
 void print_buffer(const uint8_t *buffer, size_t size);
-void reset_apu_cores(uint32_t value);
-void set_apu_rvba(uint32_t entrypoint);
 void delay_ms(int milliseconds);
-void mock_handoff(uint32_t entry_point);
-
-// Generic Definitions
-#define CHUNK_SIZE 4096
-
-// Required for pointing to mock handoff structure
-#define GLOBAL_GEN_STORAGE6 (*(volatile uint32_t *)(0xFFD80048U))
-#define FSBL_MAX_PARTITIONS 8
-
-// APU Module Reset Vector Base Address
-#define RVBARADDR0L (*(volatile uint32_t *)(0xFD5C0040U))
-#define RVBARADDR0H (*(volatile uint32_t *)(0xFD5C0044U))
-#define RVBARADDR1L (*(volatile uint32_t *)(0xFD5C0048U))
-#define RVBARADDR1H (*(volatile uint32_t *)(0xFD5C004CU))
-#define RVBARADDR2L (*(volatile uint32_t *)(0xFD5C0050U))
-#define RVBARADDR2H (*(volatile uint32_t *)(0xFD5C0054U))
-#define RVBARADDR3L (*(volatile uint32_t *)(0xFD5C0058U))
-#define RVBARADDR3H (*(volatile uint32_t *)(0xFD5C005CU))
-#define RVBARADDR_LOW_VALU 0x0U
-
-// APU Software Controlled MPCore Reset Address
-#define RST_FPD_APU (*(volatile uint32_t *)(0xFD1A0104U))
-#define RST_FPD_APU_VALU 0xFU
-#define RST_FPD_APU_CLER 0x0U
-
-struct xfsbl_atf_handoff_params 
+void start_decode_workers(void);
+
+// Boot pack decompression workers. Cores 1..BPK_WORKER_CORES help decode blocks until
+// the whole APU is put back into reset for the AT-F handoff.
+#define BPK_WORKER_CORES 3
+#define WORKER_STACK_SIZE 0x1000
+#define APU_WORKER_MASK ((((1U << BPK_WORKER_CORES) - 1U) << 1))
+#define STRINGIFY(x) #x
+#define TO_STRING(x) STRINGIFY(x)
+
+// Translation regime of the boot core, adopted by the workers before they enter C
+struct apu_worker_mmu
 {
-    char magic[4];
-    uint32_t num_entries;
-    struct {
-        uint32_t entry_point;
-        uint32_t flags;
-    } partition[1]; // Adjust partition count as necessary
+    uint64_t ttbr0;
+    uint64_t tcr;
+    uint64_t mair;
+    uint64_t sctlr;
 };
 
+struct apu_worker_mmu apu_worker_mmu;
+uint8_t apu_worker_stack[BPK_WORKER_CORES][WORKER_STACK_SIZE] __attribute__((aligned(16)));
+void apu_worker_entry(void);
+
+// Secondary core reset entry. The worker joins the SMP coherency domain and enables the
+// boot core's MMU configuration so the job queue and the images are shared coherently.
+asm(
+    ".section .text\n"
+    ".global apu_worker_entry\n"
+    ".balign 64\n"
+    "apu_worker_entry:\n"
+    "    mrs x0, S3_1_C15_C2_1\n"        // CPUECTLR_EL1.SMPEN
+    "    orr x0, x0, #(1 << 6)\n"
+    "    msr S3_1_C15_C2_1, x0\n"
+    "    msr cptr_el3, xzr\n"
+    "    isb\n"
+    "    ldr x1, =apu_worker_mmu\n"
+    "    ldr x0, [x1, #0]\n"
+    "    msr ttbr0_el3, x0\n"
+    "    ldr x0, [x1, #8]\n"
+    "    msr tcr_el3, x0\n"
+    "    ldr x0, [x1, #16]\n"
+    "    msr mair_el3, x0\n"
+    "    tlbi alle3\n"
+    "    dsb sy\n"
+    "    isb\n"
+    "    ldr x0, [x1, #24]\n"
+    "    msr sctlr_el3, x0\n"
+    "    isb\n"
+    "    mrs x0, mpidr_el1\n"            // Core N uses the top of stack N-1
+    "    and x0, x0, #0xFF\n"
+    "    ldr x1, =apu_worker_stack\n"
+    "    mov x2, #" TO_STRING(WORKER_STACK_SIZE) "\n"
+    "    madd x1, x0, x2, x1\n"
+    "    mov sp, x1\n"
+    "    bl bpk_worker\n"
+    "1:  wfe\n"
+    "    b 1b\n"
+    ".ltorg\n"
+);
+
 // Main
 int main() 
 {
-    // Load AT-F onto Cortex-A53 processor and retrieve entry point
-    uint32_t bl31_entrypoint = load_elf64("bl31.elf");
-    
-    // Load SSBL into DDR4 Memory
-    uint32_t uboot_entrypoint = load_elf64("u-boot.elf");
-
-    // Configure GLOBAL_GEN_STORAGE6 Register for FSBL AT-F Handoff
-    mock_handoff(uboot_entrypoint);
-    
-    // Place the APU Cores in a soft reset state
-    xil_printf("Placing APU Core(s) in reset state!\r\n");
-    reset_apu_cores((uint32_t)RST_FPD_APU_VALU);
-
-    // Modify the RVBARADDR for each APU core to point to AT-F
-    xil_printf("Relocating APU Core(s) PC to: 0x%8X\r\n", bl31_entrypoint);
-    set_apu_rvba( bl31_entrypoint);
-    
-    // Clear the APU Core reset state
-    xil_printf("Clearing APU Core(s) reset state!\r\n");
-    reset_apu_cores((uint32_t)RST_FPD_APU_CLER);
-
-    // BL31 has now loaded and is looking to handoff address set in compile-time binary
-    // which should be the ssbl (u-boot)
-
-    // Debug - Loop Forever 
-    while(1)
+    boot_stats_init();
+    boot_trace_init();
+
+    // Bring up the secondary cores to help decompress boot pack images
+    start_decode_workers();
+    boot_stats_stage(BOOT_STAGE_WORKERS);
+    boot_log_init();
+
+    // Load AT-F and u-boot onto Cortex-A53 processor and configure GLOBAL_GEN_STORAGE6
+    // for the FSBL AT-F handoff while they load
+    uint64_t bl31_entrypoint = 0;
+    uint64_t uboot_entrypoint = 0;
+    if (boot_memmap_init() != 0 || ddr_ecc_init() != 0 || elf_mount() != 0 ||
+        load_apu_images("bl31.elf", "u-boot.elf", &bl31_entrypoint, &uboot_entrypoint) != 0)
     {
+        xil_printf("Failed to load boot images, halting.\r\n");
+        while(1)
+        {
 
-    };
-    
-    return 0;
-}
-
-uint64_t load_elf64(const char *file_name) 
-{
-    FRESULT fr;  
-    FATFS fs;    
-    FIL file;    
-    UINT bytesRead;
-    Elf64_Ehdr elfHeader;
-
-    // Mount the file system
-    fr = f_mount(&fs, "0:", 0); 
-    if (fr != FR_OK) 
-    {
-        xil_printf("Failed to mount SD card.\r\n");
-        return -1;
-    }
-    xil_printf("SD card mounted successfully.\r\n");
-
-    // Open the ELF file
-    fr = f_open(&file, file_name, FA_READ);
-    if(fr != FR_OK)
-    {
-        xil_printf("Failed to open file: %s (%d bytes)\r\n", file_name, fr);
-        return -1;
-    }
-    xil_printf("File opened successfully: %s\r\n", file_name);
-
-    // Read ELF header
-    fr = f_read(&file, &elfHeader, sizeof(elfHeader), &bytesRead);
-    if (fr != FR_OK || bytesRead != sizeof(elfHeader)) 
-    {
-        xil_printf("Failed to read ELF header\r\n");
-        f_close(&file);
-        return -1;
-    }
-    xil_printf("ELF header read successfully.\r\n");
-
-    // Validate ELF identification
-    if (elfHeader.e_ident[0] != ELFMAG0 || elfHeader.e_ident[1] != ELFMAG1 ||
-        elfHeader.e_ident[2] != ELFMAG2 || elfHeader.e_ident[3] != ELFMAG3) 
-    {
-        xil_printf("File is not a valid ELF file\r\n");
-        f_close(&file);
-        return -1;
-    }    
-    xil_printf("Valid ELF file identified.\r\n");
-
-    // Debug: Print ELF header info
-    xil_printf("ELF Header - Program header offset: %llu, Number of program headers: %u\r\n",
-        elfHeader.e_phoff, elfHeader.e_phnum);
-
-    // Jump to the program headers
-    if (elfHeader.e_phoff >= f_size(&file)) 
-    {
-        xil_printf("Invalid program header offset.\r\n");
-        f_close(&file);
-        return -1;
-    }
-    
-    // Allocate memory for all program headers
-    Elf64_Phdr *programHeaders = malloc(elfHeader.e_phnum * sizeof(Elf64_Phdr));
-    if (programHeaders == NULL) 
-    {
-        xil_printf("Memory allocation for program headers failed.\r\n");
-        f_close(&file);
-        return -1;
-    }
-
-    f_lseek(&file, elfHeader.e_phoff); // Seek to the program headers section
-
-    // Read all program headers at once
-    fr = f_read(&file, programHeaders, elfHeader.e_phnum * sizeof(Elf64_Phdr), &bytesRead);
-    if (fr != FR_OK || bytesRead != elfHeader.e_phnum * sizeof(Elf64_Phdr)) 
-    {
-        xil_printf("Failed to read program headers; Read bytes: %u, Expected: %u\r\n", bytesRead, elfHeader.e_phnum * sizeof(Elf64_Phdr));
-        free(programHeaders);
-        f_close(&file);
-        return -1;
+        };
     }
+    boot_stats_stage(BOOT_STAGE_LOADED);
 
-    for (int i = 0; i < elfHeader.e_phnum; i++) 
+    // Finish checking cold boot pack segments while the workers are still running
+    if (bpk_verify_deferred() != 0)
     {
-        Elf64_Phdr *programHeader = &programHeaders[i];
-
-        // Print the values of the program header
-        xil_printf("Program header %d read successfully: type=0x%x, offset=0x%llx, filesz=0x%llx, memsz=0x%llx\r\n", 
-            i, programHeader->p_type, programHeader->p_offset, programHeader->p_filesz, programHeader->p_memsz);
-
-        // Validate segment offset
-        if (programHeader->p_offset + programHeader->p_filesz > f_size(&file)) 
+        xil_printf("Boot image verification failed, halting.\r\n");
+        while(1)
         {
-            xil_printf("Invalid segment offset for program header %d: offset=0x%llx, filesize=0x%llx\r\n", 
-                i, programHeader->p_offset, f_size(&file));
-            free(programHeaders);
-            f_close(&file);
-            return -1;
-        }
-
-        // Seek to the segment data offset
-        f_lseek(&file, programHeader->p_offset);
-        
-        // Allocate memory for the segment
-        void *segmentMemory = (void *)(uintptr_t)(programHeader->p_vaddr);
 
-        // Read segment data into memory
-        uint8_t buffer[CHUNK_SIZE];
-        uint64_t bytesToRead = programHeader->p_filesz; // Total bytes to read
-        uint64_t bytesLoaded = 0;
-
-        xil_printf("Reading segment data: offset=0x%llx, filesize=0x%llx, memsize=0x%llx\r\n", 
-            programHeader->p_offset, programHeader->p_filesz, programHeader->p_memsz);
-
-        // Read data in chunks
-        while (bytesToRead > 0) 
-        {
-            uint32_t chunkSize;
-            if (bytesToRead > CHUNK_SIZE) 
-            {
-                chunkSize = CHUNK_SIZE;
-            } 
-            else 
-            {
-                chunkSize = bytesToRead;
-            }
+        };
+    }
 
-            fr = f_read(&file, buffer, chunkSize, &bytesRead);
-            if (fr != FR_OK || bytesRead == 0) 
-            {
-                xil_printf("Error reading segment data at offset 0x%llx: %d\r\n", programHeader->p_offset + bytesLoaded, fr);
-                free(programHeaders);
-                f_close(&file);
-                return -1;
-            }
+    boot_stats_stage(BOOT_STAGE_VERIFIED);
 
-            // Copy data to allocated memory
-            memcpy(segmentMemory + bytesLoaded, buffer, bytesRead);
-            bytesLoaded += bytesRead;
-            bytesToRead -= bytesRead;
+    // Hand the measurement log and boot statistics to the next stage
+    boot_log_seal();
+    boot_stats_publish();
 
-            // Flush cache
-            Xil_DCacheFlushRange((uint32_t)(uintptr_t)(segmentMemory + bytesLoaded - bytesRead), bytesRead);
-        }
+    // Nothing may run before the images' DDR is initialized and their bss is clear
+    ddr_ecc_finish();
+    boot_zero_finish();
 
-        // Clear uninitialized space
-        if (programHeader->p_memsz > programHeader->p_filesz) 
-        {
-            memset(segmentMemory + bytesLoaded, 0, programHeader->p_memsz - programHeader->p_filesz);
-        }
+    // Last chance to read the trace: the reset below takes this core down too
+    boot_trace_mark(BOOT_TRACE_RELEASE, (uint32_t)bl31_entrypoint);
+    boot_trace_dump();
 
-        // Print the loaded segment information        
-        xil_printf("Segment loaded successfully: vaddr=0x%llx, filesz=0x%llx, memsz=0x%llx\r\n",
-            programHeader->p_vaddr, programHeader->p_filesz, programHeader->p_memsz);
-    }
+    // Restart every APU core, this one included, at AT-F
+    release_apu((uint32_t)bl31_entrypoint);
 
-    xil_printf("All segments loaded successfully.\r\n");
-    free(programHeaders); // Free allocated memory for program headers
-    f_close(&file);
+    // BL31 has now loaded and is looking to handoff address set in compile-time binary
+    // which should be the ssbl (u-boot)
 
-    // Calculate the entry point
-    uint32_t entry_point = elfHeader.e_entry;
-    xil_printf("Entry point calculated: 0x%08x\r\n", entry_point);
+    // Debug - Loop Forever 
+    while(1)
+    {
 
-    // return entry point
-    return entry_point;
+    };
+    
+    return 0;
 }
 
 // Debug for printing buffer data and their ASCI values similar to BIO_DUMP
@@ -310,25 +204,31 @@ void print_buffer(const uint8_t *buffer, size_t size)
     }
 }
 
-void reset_apu_cores(uint32_t value)
+void start_decode_workers(void)
 {
-    // Write modified value back to the register
-    RST_FPD_APU = (uint32_t)value;
-}
-
-void set_apu_rvba(uint32_t entrypoint)
-{
-    // Set the Reset Vector Base Address Low Bits to Entry Point
-    RVBARADDR0L = (uint32_t)entrypoint;
-    RVBARADDR1L = (uint32_t)entrypoint;
-    RVBARADDR2L = (uint32_t)entrypoint;
-    RVBARADDR3L = (uint32_t)entrypoint;
+    bpk_init();
+
+#if BPK_WORKER_CORES > 0
+    // Capture this core's translation regime for the workers, which read it with the MMU off
+    asm volatile("mrs %0, ttbr0_el3" : "=r" (apu_worker_mmu.ttbr0));
+    asm volatile("mrs %0, tcr_el3" : "=r" (apu_worker_mmu.tcr));
+    asm volatile("mrs %0, mair_el3" : "=r" (apu_worker_mmu.mair));
+    asm volatile("mrs %0, sctlr_el3" : "=r" (apu_worker_mmu.sctlr));
+    Xil_DCacheFlushRange((UINTPTR)&apu_worker_mmu, sizeof(apu_worker_mmu));
+
+    // Point the secondary cores at the worker entry
+    for (uint32_t core = 1; core <= BPK_WORKER_CORES; core++)
+    {
+        RVBARADDRL(core) = (uint32_t)(uintptr_t)apu_worker_entry;
+        RVBARADDRH(core) = (uint32_t)RVBARADDR_LOW_VALU;
+    }
 
-    // Set the Reset Vector Base Address High Bits to 0x0
-    RVBARADDR0H = (uint32_t)RVBARADDR_LOW_VALU;
-    RVBARADDR1H = (uint32_t)RVBARADDR_LOW_VALU;
-    RVBARADDR2H = (uint32_t)RVBARADDR_LOW_VALU;
-    RVBARADDR3H = (uint32_t)RVBARADDR_LOW_VALU;
+    // Power up the secondary cores and release them from reset
+    power_up_apu_cores(APU_WORKER_MASK);
+    boot_trace_mark(BOOT_TRACE_RELEASE, APU_WORKER_MASK);
+    RST_FPD_APU &= ~APU_WORKER_MASK;
+    xil_printf("Started %d APU core(s) as boot pack workers.\r\n", BPK_WORKER_CORES);
+#endif
 }
 
 void delay_ms(int milliseconds) 
@@ -341,39 +241,3 @@ void delay_ms(int milliseconds)
         }
     }
 }
-
-void mock_handoff(uint32_t entry_point)
-{
-    struct xfsbl_atf_handoff_params *atfhandoffparams;
-  
-    // Allocate memory for handoff parameters
-    atfhandoffparams = (struct xfsbl_atf_handoff_params *)malloc(sizeof(struct xfsbl_atf_handoff_params));
-    if (atfhandoffparams == NULL) {
-        xil_printf("Memory allocation failed.\r\n");
-        return; // Handle error appropriately
-    }
-
-    // Initialize the magic number
-    atfhandoffparams->magic[0] = 'X';
-    atfhandoffparams->magic[1] = 'L';
-    atfhandoffparams->magic[2] = 'N';
-    atfhandoffparams->magic[3] = 'X';
-
-    // Set the number of entries
-    atfhandoffparams->num_entries = 1;
-
-    // Set the parameters for the first partition
-    atfhandoffparams->partition[0].entry_point = entry_point;
-    atfhandoffparams->partition[0].flags = 2 << 3; // Ensure flag setting is correct
-
-    // For debugging purposes, print the contents of the handoff structure
-    xil_printf("Handoff Parameters Set:\r\n");
-    xil_printf("Magic: %c%c%c%c\r\n", atfhandoffparams->magic[0], atfhandoffparams->magic[1], 
-        atfhandoffparams->magic[2], atfhandoffparams->magic[3]);
-    xil_printf("Partition Count: %d\r\n", atfhandoffparams->num_entries);
-    xil_printf("Execution Address: 0x%08x\r\n", atfhandoffparams->partition[0].entry_point);
-
-    // Store the handoff structure into the global register (ensure proper type)
-    GLOBAL_GEN_STORAGE6 = (uint32_t)atfhandoffparams;  // Adjust if using a different register type
-    xil_printf("PMU_GLOBAL_GEN_STORAGE6 REGISTER = 0x%08x\r\n", GLOBAL_GEN_STORAGE6);
-}
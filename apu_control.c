@@ -0,0 +1,126 @@
+/*
+ * Description: Cortex-A53 cluster control shared by the bootloaders (see apu_control.h).
+ */
+
+// Standard Libraries
+#include "stdint.h"
+
+// Xilinx Libraries
+#include "xil_cache.h"  // Include cache management functions
+#include <xil_printf.h> // Include Debug IO
+
+// Addtional Libraries
+#include "apu_control.h"
+#include "boot_sched.h"
+#include "elf_loader.h"
+
+// Too large for the loaders' stacks
+static struct elf_load atfLoad;
+static struct elf_load ssblLoad;
+
+void power_up_apu_cores(uint32_t mask)
+{
+    REQ_PWRUP_INT_EN = mask;
+    REQ_PWRUP_TRIG = mask;
+    while (REQ_PWRUP_STATUS & mask)
+    {
+        boot_sched_yield();
+    };
+}
+
+void reset_apu_cores(uint32_t value)
+{
+    // Write modified value back to the register
+    RST_FPD_APU = (uint32_t)value;
+}
+
+void set_apu_rvba(uint32_t entrypoint)
+{
+    // Set the Reset Vector Base Address Low Bits to Entry Point
+    RVBARADDR0L = (uint32_t)entrypoint;
+    RVBARADDR1L = (uint32_t)entrypoint;
+    RVBARADDR2L = (uint32_t)entrypoint;
+    RVBARADDR3L = (uint32_t)entrypoint;
+
+    // Set the Reset Vector Base Address High Bits to 0x0
+    RVBARADDR0H = (uint32_t)RVBARADDR_LOW_VALU;
+    RVBARADDR1H = (uint32_t)RVBARADDR_LOW_VALU;
+    RVBARADDR2H = (uint32_t)RVBARADDR_LOW_VALU;
+    RVBARADDR3H = (uint32_t)RVBARADDR_LOW_VALU;
+}
+
+void mock_handoff(uint32_t entry_point)
+{
+    // Fixed OCM location rather than the heap: when the RPU fills this in, its heap may
+    // sit in TCM or at addresses the APU sees differently
+    struct xfsbl_atf_handoff_params *atfhandoffparams = (struct xfsbl_atf_handoff_params *)ATF_HANDOFF_ADDR;
+
+    // Initialize the magic number
+    atfhandoffparams->magic[0] = 'X';
+    atfhandoffparams->magic[1] = 'L';
+    atfhandoffparams->magic[2] = 'N';
+    atfhandoffparams->magic[3] = 'X';
+
+    // Set the number of entries
+    atfhandoffparams->num_entries = 1;
+
+    // Set the parameters for the first partition
+    atfhandoffparams->partition[0].entry_point = entry_point;
+    atfhandoffparams->partition[0].flags = 2 << 3; // Ensure flag setting is correct
+    Xil_DCacheFlushRange((UINTPTR)atfhandoffparams, sizeof(*atfhandoffparams));
+
+    // For debugging purposes, print the contents of the handoff structure
+    xil_printf("Handoff Parameters Set:\r\n");
+    xil_printf("Magic: %c%c%c%c\r\n", atfhandoffparams->magic[0], atfhandoffparams->magic[1],
+        atfhandoffparams->magic[2], atfhandoffparams->magic[3]);
+    xil_printf("Partition Count: %d\r\n", atfhandoffparams->num_entries);
+    xil_printf("Execution Address: 0x%08x\r\n", atfhandoffparams->partition[0].entry_point);
+
+    // Store the handoff structure into the global register (ensure proper type)
+    GLOBAL_GEN_STORAGE6 = (uint32_t)(uintptr_t)atfhandoffparams;
+    xil_printf("PMU_GLOBAL_GEN_STORAGE6 REGISTER = 0x%08x\r\n", GLOBAL_GEN_STORAGE6);
+}
+
+void release_apu(uint32_t entrypoint)
+{
+    // Place the APU Cores in a soft reset state
+    xil_printf("Placing APU Core(s) in reset state!\r\n");
+    reset_apu_cores((uint32_t)RST_FPD_APU_VALU);
+
+    // Modify the RVBARADDR for each APU core to point to AT-F
+    xil_printf("Relocating APU Core(s) PC to: 0x%8X\r\n", entrypoint);
+    set_apu_rvba(entrypoint);
+
+    // Make sure every core is powered before letting it run
+    power_up_apu_cores(APU_CORE_MASK);
+
+    // Clear the APU Core reset state
+    xil_printf("Clearing APU Core(s) reset state!\r\n");
+    reset_apu_cores((uint32_t)RST_FPD_APU_CLER);
+}
+
+int32_t load_apu_images(const char *atfImage, const char *ssblImage, uint64_t *atfEntry, uint64_t *ssblEntry)
+{
+    int32_t status;
+
+    if (elf_load_start(&atfLoad, atfImage) != 0)
+    {
+        return -1;
+    }
+    if (elf_load_start(&ssblLoad, ssblImage) != 0)
+    {
+        elf_load_wait(&atfLoad, atfEntry);
+        return -1;
+    }
+
+    // The handoff only needs the entry point, which is known before any segment is read
+    mock_handoff((uint32_t)ssblLoad.entry);
+
+    status = elf_load_wait(&atfLoad, atfEntry);
+    if (elf_load_wait(&ssblLoad, ssblEntry) != 0)
+    {
+        status = -1;
+    }
+
+    return status;
+}
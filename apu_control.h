@@ -0,0 +1,75 @@
+/*
+ * Description: Cortex-A53 cluster control shared by the bootloaders: power-up requests,
+ * the per-core reset vector base addresses, the MPCore reset and the FSBL style AT-F
+ * handoff structure. Either processor can drive these, so the RPU can release the APU
+ * into images it loaded while it carries on loading its own.
+ */
+
+#ifndef APU_CONTROL_H
+#define APU_CONTROL_H
+
+#include "stdint.h"
+
+// Required for pointing to mock handoff structure
+#define GLOBAL_GEN_STORAGE6 (*(volatile uint32_t *)(0xFFD80048U))
+#define FSBL_MAX_PARTITIONS 8
+
+// AT-F reads the handoff structure with its caches off, from OCM just below the boot trace
+#ifndef ATF_HANDOFF_ADDR
+#define ATF_HANDOFF_ADDR 0xFFFE3F00U
+#endif
+
+// APU Module Reset Vector Base Address
+#define RVBARADDR0L (*(volatile uint32_t *)(0xFD5C0040U))
+#define RVBARADDR0H (*(volatile uint32_t *)(0xFD5C0044U))
+#define RVBARADDR1L (*(volatile uint32_t *)(0xFD5C0048U))
+#define RVBARADDR1H (*(volatile uint32_t *)(0xFD5C004CU))
+#define RVBARADDR2L (*(volatile uint32_t *)(0xFD5C0050U))
+#define RVBARADDR2H (*(volatile uint32_t *)(0xFD5C0054U))
+#define RVBARADDR3L (*(volatile uint32_t *)(0xFD5C0058U))
+#define RVBARADDR3H (*(volatile uint32_t *)(0xFD5C005CU))
+#define RVBARADDR_LOW_VALU 0x0U
+#define RVBARADDRL(core) (*(volatile uint32_t *)(0xFD5C0040U + ((core) * 8U)))
+#define RVBARADDRH(core) (*(volatile uint32_t *)(0xFD5C0044U + ((core) * 8U)))
+
+// APU Software Controlled MPCore Reset Address
+#define RST_FPD_APU (*(volatile uint32_t *)(0xFD1A0104U))
+#define RST_FPD_APU_VALU 0xFU
+#define RST_FPD_APU_CLER 0x0U
+
+// PMU Power-Up Requests for the APU Cores
+#define REQ_PWRUP_STATUS (*(volatile uint32_t *)(0xFFD80110U))
+#define REQ_PWRUP_INT_EN (*(volatile uint32_t *)(0xFFD80118U))
+#define REQ_PWRUP_TRIG (*(volatile uint32_t *)(0xFFD80120U))
+#define APU_CORE_MASK 0xFU
+
+struct xfsbl_atf_handoff_params 
+{
+    char magic[4];
+    uint32_t num_entries;
+    struct {
+        uint32_t entry_point;
+        uint32_t flags;
+    } partition[1]; // Adjust partition count as necessary
+};
+
+// Asks the PMU to power up the APU cores in mask and waits until it has
+void power_up_apu_cores(uint32_t mask);
+
+// Writes the MPCore reset register
+void reset_apu_cores(uint32_t value);
+
+// Points every APU core's reset vector at entrypoint
+void set_apu_rvba(uint32_t entrypoint);
+
+// Fills in the AT-F handoff structure for the next stage and publishes it in GLOBAL_GEN_STORAGE6
+void mock_handoff(uint32_t entry_point);
+
+// Holds the APU in reset, points it at entrypoint and lets every core run
+void release_apu(uint32_t entrypoint);
+
+// Loads AT-F and the next stage side by side and fills in the AT-F handoff while their
+// segments are still being read
+int32_t load_apu_images(const char *atfImage, const char *ssblImage, uint64_t *atfEntry, uint64_t *ssblEntry);
+
+#endif
@@ -0,0 +1,379 @@
+/*
+ * Description: eMMC as a boot medium (see boot_emmc.h).
+ */
+
+// Standard Libraries
+#include "stdint.h"
+#include "string.h"
+
+// Xilinx Libraries
+#include "xil_cache.h"  // Include cache management functions
+#include <xil_printf.h> // Include Debug IO
+
+// Addtional Libraries
+#include "boot_emmc.h"
+#include "boot_storage.h"
+#include "boot_qspi.h"
+#include "boot_sched.h"
+#include "boot_trace.h"
+#include "sd_adma.h"
+
+#if BOOT_STORAGE_EMMC && !defined(BOOT_EMMC_EMULATE)
+#include "xparameters.h"
+#include "xsdps.h"
+#endif
+
+#ifdef BOOT_EMMC_EMULATE
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define EMMC_BLOCK SD_ADMA_BLOCK_SIZE
+
+// DMA runs start on whole cache lines of either processor
+#define EMMC_LINE 64U
+
+// The R5's TCM at the bottom of its map is not where the controller would write
+#if defined(__aarch64__)
+#define EMMC_DMA_START 0x0ULL
+#else
+#define EMMC_DMA_START 0x40000ULL
+#endif
+
+// Partial blocks and ranges the DMA cannot take are read through this
+#define EMMC_BOUNCE_SIZE 4096U
+
+#define EMMC_DIRECTORY_BLOCKS ((sizeof(struct boot_qspi_directory) + EMMC_BLOCK - 1) / EMMC_BLOCK)
+
+// CMD6 SWITCH of EXT_CSD PARTITION_CONFIG; only its access bits are touched
+#define EMMC_EXT_CSD_PART_CONFIG 179U
+#define EMMC_SWITCH_SET_BITS 1U
+#define EMMC_SWITCH_CLEAR_BITS 2U
+#define EMMC_SWITCH_ARG(mode, index, value) (((mode) << 24) | ((index) << 16) | ((value) << 8))
+#define EMMC_PART_ACCESS_MASK 0x7U
+
+// EXT_CSD fields sizing the partitions: the user area in blocks, boot partitions in
+// units of 128 KiB. Devices of 2 GB or less leave SEC_COUNT zero.
+#define EMMC_EXT_CSD_SEC_COUNT 212U
+#define EMMC_EXT_CSD_BOOT_SIZE_MULT 226U
+#define EMMC_BOOT_SIZE_UNIT 0x20000U
+#define EMMC_SMALL_DEVICE_SIZE 0x80000000ULL
+
+#if BOOT_STORAGE_EMMC
+
+static int32_t emmc_step(struct boot_task *task);
+static struct boot_task emmcTask = { "eMMC read", emmc_step, NULL, 0, 0, NULL };
+
+static uint8_t emmcReady = 0;
+static int32_t emmcStatus = -1;     // Device and directory found
+static uint64_t emmcPartSize;       // Bytes of the partition holding the images
+static union
+{
+    struct boot_qspi_directory directory;
+    uint8_t blocks[EMMC_DIRECTORY_BLOCKS * EMMC_BLOCK];
+} emmcDirectory __attribute__((aligned(64)));
+static uint8_t emmcBounce[EMMC_BOUNCE_SIZE] __attribute__((aligned(64)));
+
+// Read in flight: the DMA part of the range, and how far the transfer has got
+static int32_t *emmcResult;
+static int32_t emmcReadStatus;
+static uint8_t *emmcStart;
+static uint32_t emmcSize;
+static uint8_t *emmcDst;
+static uint64_t emmcBlock;
+static uint32_t emmcRemaining;
+static uint32_t emmcPiece;          // Bytes of the command in flight
+static int32_t emmcPieceStatus;
+
+#ifndef BOOT_EMMC_EMULATE
+
+static XSdPs emmcDevice;
+static struct sd_adma emmcHost = { BOOT_EMMC_BASE, BOOT_EMMC_DESC_ADDR, 0 };
+
+static int32_t emmc_device_init(void)
+{
+    XSdPs_Config *config = XSdPs_LookupConfig(BOOT_EMMC_DEVICE_ID);
+
+    if (config == NULL || XSdPs_CfgInitialize(&emmcDevice, config, config->BaseAddress) != XST_SUCCESS ||
+        XSdPs_CardInitialize(&emmcDevice) != XST_SUCCESS)
+    {
+        return -1;
+    }
+
+#if BOOT_EMMC_PART_SIZE == 0
+    const uint8_t *extCsd = emmcBounce;
+    if (XSdPs_Get_Mmc_ExtCsd(&emmcDevice, emmcBounce) != XST_SUCCESS)
+    {
+        return -1;
+    }
+#if BOOT_EMMC_PARTITION != 0
+    emmcPartSize = (uint64_t)extCsd[EMMC_EXT_CSD_BOOT_SIZE_MULT] * EMMC_BOOT_SIZE_UNIT;
+#else
+    emmcPartSize = (uint64_t)((uint32_t)extCsd[EMMC_EXT_CSD_SEC_COUNT] |
+        ((uint32_t)extCsd[EMMC_EXT_CSD_SEC_COUNT + 1] << 8) | ((uint32_t)extCsd[EMMC_EXT_CSD_SEC_COUNT + 2] << 16) |
+        ((uint32_t)extCsd[EMMC_EXT_CSD_SEC_COUNT + 3] << 24)) * EMMC_BLOCK;
+    if (emmcPartSize == 0)
+    {
+        emmcPartSize = EMMC_SMALL_DEVICE_SIZE;
+    }
+#endif
+#else
+    emmcPartSize = BOOT_EMMC_PART_SIZE;
+#endif
+
+#if BOOT_EMMC_PARTITION != 0
+    if (XSdPs_Set_Mmc_ExtCsd(&emmcDevice, EMMC_SWITCH_ARG(EMMC_SWITCH_CLEAR_BITS, EMMC_EXT_CSD_PART_CONFIG,
+            EMMC_PART_ACCESS_MASK)) != XST_SUCCESS ||
+        XSdPs_Set_Mmc_ExtCsd(&emmcDevice, EMMC_SWITCH_ARG(EMMC_SWITCH_SET_BITS, EMMC_EXT_CSD_PART_CONFIG,
+            BOOT_EMMC_PARTITION)) != XST_SUCCESS)
+    {
+        return -1;
+    }
+#endif
+    emmcHost.byte_address = (emmcDevice.HCS == 0);
+
+    return 0;
+}
+
+// Reads whole blocks on the spot through the driver
+static int32_t emmc_read_blocks(uint64_t block, uint8_t *dst, uint32_t count)
+{
+    return (XSdPs_ReadPolled(&emmcDevice, (uint32_t)block, count, dst) == XST_SUCCESS) ? 0 : -1;
+}
+
+// Issues CMD18 for emmcPiece bytes at emmcBlock into emmcDst and returns
+static void emmc_piece_start(void)
+{
+    sd_adma_start(&emmcHost, emmcBlock, emmcDst, emmcPiece);
+}
+
+static int32_t emmc_piece_done(void)
+{
+    return sd_adma_done(&emmcHost);
+}
+
+#else
+
+// Host stand-in: a file holding the partition, read a few polls after the command
+static int emmcFile = -1;
+static uint32_t emmcEmulatePolls;
+
+static int32_t emmc_device_init(void)
+{
+    struct stat info;
+
+    emmcFile = open(BOOT_EMMC_EMULATE_FILE, O_RDONLY);
+    if (emmcFile < 0 || fstat(emmcFile, &info) != 0)
+    {
+        return -1;
+    }
+    emmcPartSize = BOOT_EMMC_PART_SIZE ? BOOT_EMMC_PART_SIZE : (uint64_t)info.st_size;
+
+    return 0;
+}
+
+static int32_t emmc_read_blocks(uint64_t block, uint8_t *dst, uint32_t count)
+{
+    ssize_t bytesRead = pread(emmcFile, dst, count * EMMC_BLOCK, block * EMMC_BLOCK);
+
+    if (bytesRead < 0)
+    {
+        return -1;
+    }
+
+    // Blocks past the end of the file read as erased
+    memset(dst + bytesRead, 0, count * EMMC_BLOCK - bytesRead);
+    return 0;
+}
+
+static void emmc_piece_start(void)
+{
+    emmcEmulatePolls = BOOT_EMMC_EMULATE_POLLS;
+}
+
+static int32_t emmc_piece_done(void)
+{
+    if (emmcEmulatePolls != 0)
+    {
+        emmcEmulatePolls--;
+        return 0;
+    }
+
+    return (emmc_read_blocks(emmcBlock, emmcDst, emmcPiece / EMMC_BLOCK) == 0) ? 1 : -1;
+}
+
+#endif
+
+// Brings the device up and reads the directory the first time an image is looked up
+static int32_t emmc_init(void)
+{
+    const struct boot_qspi_directory *directory = &emmcDirectory.directory;
+
+    if (emmcReady)
+    {
+        return emmcStatus;
+    }
+    emmcReady = 1;
+
+    if (emmc_device_init() != 0 || emmc_read_blocks(BOOT_EMMC_LBA, emmcDirectory.blocks, EMMC_DIRECTORY_BLOCKS) != 0)
+    {
+        xil_printf("eMMC not available\r\n");
+    }
+    else if (memcmp(directory->magic, BOOT_QSPI_MAGIC, 4) != 0 || directory->version != BOOT_QSPI_VERSION ||
+        directory->num_images > BOOT_QSPI_MAX_IMAGES)
+    {
+        xil_printf("No image directory in eMMC partition %u at block %u\r\n", BOOT_EMMC_PARTITION, BOOT_EMMC_LBA);
+    }
+    else
+    {
+        xil_printf("eMMC partition %u: %u images, 0x%llx bytes\r\n", BOOT_EMMC_PARTITION, directory->num_images,
+            emmcPartSize);
+        emmcStatus = 0;
+    }
+
+    return emmcStatus;
+}
+
+// Reads a byte range on the spot through the bounce buffer and pushes it out to memory
+static int32_t emmc_read_now(uint64_t position, uint8_t *dst, uint32_t size)
+{
+    for (uint32_t done = 0; done < size;)
+    {
+        uint32_t within = (uint32_t)((position + done) % EMMC_BLOCK);
+        uint32_t chunkSize = (size - done > EMMC_BOUNCE_SIZE - within) ? EMMC_BOUNCE_SIZE - within : size - done;
+        uint32_t blocks = (within + chunkSize + EMMC_BLOCK - 1) / EMMC_BLOCK;
+
+        if (emmc_read_blocks((position + done) / EMMC_BLOCK, emmcBounce, blocks) != 0)
+        {
+            return -1;
+        }
+        boot_trace_begin(BOOT_TRACE_COPY, chunkSize);
+        memcpy(dst + done, emmcBounce + within, chunkSize);
+        boot_trace_end(BOOT_TRACE_COPY, chunkSize);
+        done += chunkSize;
+    }
+    Xil_DCacheFlushRange((UINTPTR)dst, size);
+
+    return 0;
+}
+
+static int32_t emmc_open(struct boot_file *file, const char *name)
+{
+    const struct boot_qspi_directory *directory = &emmcDirectory.directory;
+
+    if (emmc_init() != 0)
+    {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < directory->num_images; i++)
+    {
+        const struct boot_qspi_image *image = &directory->images[i];
+
+        if (strncmp(image->name, name, BOOT_QSPI_NAME_SIZE) == 0)
+        {
+            file->base = (uint64_t)BOOT_EMMC_LBA * EMMC_BLOCK + image->offset;
+            file->size = image->size;
+
+            // The directory is read as found on the device
+            if (file->base + file->size > emmcPartSize)
+            {
+                xil_printf("eMMC image %.16s at 0x%llx (%u bytes) lies outside the partition\r\n", image->name,
+                    file->base, image->size);
+                return -1;
+            }
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+// Moves the read through the partition a command at a time
+static int32_t emmc_step(struct boot_task *task)
+{
+    BOOT_TASK_BEGIN(task);
+    while (emmcRemaining != 0)
+    {
+        emmcPiece = (emmcRemaining < SD_ADMA_MAX_READ) ? emmcRemaining : SD_ADMA_MAX_READ;
+        emmc_piece_start();
+
+        BOOT_TASK_WAIT_UNTIL(task, (emmcPieceStatus = emmc_piece_done()) != 0);
+        if (emmcPieceStatus < 0)
+        {
+            // Rare enough to block for: read it again through the driver
+            xil_printf("eMMC transfer at block 0x%llx failed, reading it again\r\n", emmcBlock);
+            if (emmc_read_now(emmcBlock * EMMC_BLOCK, emmcDst, emmcPiece) != 0)
+            {
+                emmcReadStatus = -1;
+                break;
+            }
+        }
+        emmcDst += emmcPiece;
+        emmcBlock += emmcPiece / EMMC_BLOCK;
+        emmcRemaining -= emmcPiece;
+    }
+
+    // Drop whatever the core fetched from the range while the controller wrote it
+    Xil_DCacheInvalidateRange((UINTPTR)emmcStart, emmcSize);
+    *emmcResult = emmcReadStatus;
+    BOOT_TASK_END(task);
+}
+
+static int32_t emmc_read(struct boot_file *file, uint64_t offset, void *dst, uint32_t size, int32_t *status)
+{
+    uint8_t *bytes = dst;
+    uint64_t position = file->base + offset;
+    uint32_t head = (uint32_t)((EMMC_BLOCK - position % EMMC_BLOCK) % EMMC_BLOCK);
+    uint32_t tail = (uint32_t)((position + size) % EMMC_BLOCK);
+
+    if (offset + size > file->size)
+    {
+        *status = -1;
+        return -1;
+    }
+
+    // Whole blocks go to the DMA when they start on a cache line; blocks are whole lines
+    if (head + tail >= size || ((uintptr_t)bytes + head) % EMMC_LINE != 0 || (uintptr_t)bytes < EMMC_DMA_START)
+    {
+        *status = emmc_read_now(position, bytes, size);
+        return *status;
+    }
+
+    // The driver has to be done with the controller before the transfer starts
+    if (emmc_read_now(position, bytes, head) != 0 ||
+        emmc_read_now(position + size - tail, bytes + size - tail, tail) != 0)
+    {
+        *status = -1;
+        return -1;
+    }
+
+    emmcStart = emmcDst = bytes + head;
+    emmcSize = emmcRemaining = size - head - tail;
+    emmcBlock = (position + head) / EMMC_BLOCK;
+    emmcReadStatus = 0;
+    emmcResult = status;
+    *status = BOOT_TASK_RUNNING;
+    Xil_DCacheInvalidateRange((UINTPTR)emmcStart, emmcSize);
+
+    boot_sched_start(&emmcTask);
+    boot_sched_yield();
+    return 0;
+}
+
+static int32_t emmc_busy(void)
+{
+    boot_sched_yield();
+
+    return boot_sched_running(&emmcTask);
+}
+
+static void emmc_close(struct boot_file *file)
+{
+    (void)file;
+}
+
+const struct boot_storage bootEmmc = { "eMMC", emmc_open, emmc_read, emmc_busy, emmc_close };
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * Description: eMMC as a boot medium (see boot_storage.h). Images are read as raw blocks
+ * from one hardware partition, a boot partition or the user area, through an image
+ * directory at BOOT_EMMC_LBA in the same layout as the QSPI image partition
+ * (boot_qspi.h), built with tools/qspiimg.c and written to the device with dd. The
+ * device is brought up by the XSdPs driver on first use, which also picks the fastest
+ * bus mode the controller configuration allows (HS200 on an 8-bit 1.8 V bus), and the
+ * partition is selected through EXT_CSD PARTITION_CONFIG, leaving its boot settings
+ * alone. Directory entries reaching past the end of the partition, as EXT_CSD gives it,
+ * are rejected.
+ *
+ * Reads go the same way as background SD reads (sd_async.h): whole blocks are read by
+ * the controller's ADMA2 engine straight into place (sd_adma.h), up to 2 MiB per CMD18,
+ * as a boot_sched.h task, and only the partial blocks at either end pass through a
+ * bounce buffer. Ranges the DMA cannot take are read through the driver on the spot.
+ * The eMMC must sit on a controller of its own, not the one FatFs reads the SD card
+ * through, so the two media can read at the same time. Building with
+ * BOOT_EMMC_EMULATE reads the blocks from the file named by BOOT_EMMC_EMULATE_FILE, a
+ * few polls after each transfer starts, so the loaders can run on a host
+ * (tests/test_loader.c); the file's size stands for the partition's.
+ */
+
+#ifndef BOOT_EMMC_H
+#define BOOT_EMMC_H
+
+#include "stdint.h"
+
+struct boot_storage;
+
+// Driver instance and controller of the eMMC. ZCU102 and most carriers: SD0.
+#ifndef BOOT_EMMC_DEVICE_ID
+#define BOOT_EMMC_DEVICE_ID XPAR_XSDPS_0_DEVICE_ID
+#endif
+#ifndef BOOT_EMMC_BASE
+#define BOOT_EMMC_BASE 0xFF160000U
+#endif
+
+// Hardware partition holding the images: 0 user area, 1 boot partition 1, 2 boot
+// partition 2
+#ifndef BOOT_EMMC_PARTITION
+#define BOOT_EMMC_PARTITION 1
+#endif
+
+// Block of the partition where the image directory starts
+#ifndef BOOT_EMMC_LBA
+#define BOOT_EMMC_LBA 0
+#endif
+
+// Bytes of the hardware partition, which directory entries must not reach past; 0 reads
+// it from EXT_CSD when the device comes up
+#ifndef BOOT_EMMC_PART_SIZE
+#define BOOT_EMMC_PART_SIZE 0
+#endif
+
+// ADMA2 descriptor table in reserved OCM, below the SD card's
+#ifndef BOOT_EMMC_DESC_ADDR
+#define BOOT_EMMC_DESC_ADDR 0xFFFE3900U
+#endif
+
+// Polls before the host stand-in completes a transfer
+#ifndef BOOT_EMMC_EMULATE_POLLS
+#define BOOT_EMMC_EMULATE_POLLS 4
+#endif
+#ifndef BOOT_EMMC_EMULATE_FILE
+#define BOOT_EMMC_EMULATE_FILE "emmc.bin"
+#endif
+
+// Medium for boot_storage.c
+extern const struct boot_storage bootEmmc;
+
+#endif
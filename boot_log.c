@@ -0,0 +1,105 @@
+/*
+ * Description: Measured-boot event log (see boot_log.h). Events are appended in place in
+ * the reserved region; the only data copied is the event record itself.
+ */
+
+// Standard Libraries
+#include "stdint.h"
+#include "string.h"
+
+// Xilinx Libraries
+#include "xil_cache.h"
+#include <xil_printf.h>
+
+// Addtional Libraries
+#include "boot_log.h"
+
+#define BOOT_LOG ((struct boot_log_header *)(uintptr_t)BOOT_LOG_ADDR)
+
+static struct boot_log_event *bootLogLast = NULL;
+
+void boot_log_init(void)
+{
+    struct boot_log_header *log = BOOT_LOG;
+
+    memset(log, 0, sizeof(*log));
+    memcpy(log->magic, BOOT_LOG_MAGIC, sizeof(log->magic));
+    log->version = BOOT_LOG_VERSION;
+    log->header_size = sizeof(*log);
+    log->capacity = BOOT_LOG_SIZE;
+    log->used = (sizeof(*log) + 7) & ~7U;
+    log->digest_alg = BOOT_LOG_ALG_SHA3_384;
+    log->digest_size = BOOT_LOG_DIGEST_SIZE;
+    bootLogLast = NULL;
+}
+
+// Reserves an event record at the end of the log
+static struct boot_log_event *boot_log_append(uint32_t type, const char *name, const uint8_t *digest)
+{
+    struct boot_log_header *log = BOOT_LOG;
+    struct boot_log_event *event;
+
+    if (log->used + sizeof(*event) > log->capacity)
+    {
+        xil_printf("Boot log full, %s not recorded\r\n", name);
+        return NULL;
+    }
+
+    event = (struct boot_log_event *)((uint8_t *)log + log->used);
+    memset(event, 0, sizeof(*event));
+    event->pcr = BOOT_LOG_PCR_IPL;
+    event->type = type;
+    event->event_size = sizeof(*event);
+    strncpy(event->name, name, BOOT_LOG_NAME_SIZE - 1);
+    if (digest != NULL)
+    {
+        memcpy(event->digest, digest, BOOT_LOG_DIGEST_SIZE);
+        event->flags = BOOT_LOG_MEASURED;
+    }
+
+    log->used += event->event_size;
+    log->num_events++;
+    return event;
+}
+
+int32_t boot_log_image(const char *name, uint64_t entry, const uint8_t *digest)
+{
+    bootLogLast = boot_log_append(BOOT_LOG_EV_IPL, name, digest);
+    if (bootLogLast == NULL)
+    {
+        return -1;
+    }
+
+    bootLogLast->entry = entry;
+    return 0;
+}
+
+int32_t boot_log_range(uint64_t start, uint64_t size)
+{
+    struct boot_log_header *log = BOOT_LOG;
+    struct boot_log_range range = { start, size };
+
+    // Only the newest event can grow, since nothing follows it yet
+    if (bootLogLast == NULL || log->used + sizeof(range) > log->capacity)
+    {
+        return -1;
+    }
+
+    memcpy((uint8_t *)log + log->used, &range, sizeof(range));
+    log->used += sizeof(range);
+    bootLogLast->event_size += sizeof(range);
+    bootLogLast->num_ranges++;
+    return 0;
+}
+
+void boot_log_seal(void)
+{
+    struct boot_log_header *log = BOOT_LOG;
+
+    boot_log_append(BOOT_LOG_EV_SEPARATOR, "separator", NULL);
+    bootLogLast = NULL;
+
+    Xil_DCacheFlushRange((UINTPTR)log, log->used);
+    BOOT_LOG_HANDOFF = (uint32_t)BOOT_LOG_ADDR;
+    xil_printf("Boot log: %u event(s), %u bytes at 0x%08x\r\n", log->num_events, log->used, (uint32_t)BOOT_LOG_ADDR);
+}
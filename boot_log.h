@@ -0,0 +1,86 @@
+/*
+ * Description: Measured-boot event log. The loader appends one TCG-style event per image
+ * it loads (name, entry point, the memory ranges it wrote and a digest) to a compact
+ * binary log in a reserved OCM region, and hands the region's address to the next
+ * stage in PMU GLOBAL_GEN_STORAGE4. Digests are never computed here: boot packs record
+ * their hash tree root, which the loader already checked every block against, and plain
+ * ELF images are recorded without a digest.
+ */
+
+#ifndef BOOT_LOG_H
+#define BOOT_LOG_H
+
+#include "stdint.h"
+
+// Reserved region between the boot pack staging area and bl31
+#ifndef BOOT_LOG_ADDR
+#define BOOT_LOG_ADDR 0xFFFE9000U
+#endif
+#ifndef BOOT_LOG_SIZE
+#define BOOT_LOG_SIZE 0x1000U
+#endif
+
+// Register the log address is handed off in (PMU GLOBAL_GEN_STORAGE4)
+#ifndef BOOT_LOG_HANDOFF
+#define BOOT_LOG_HANDOFF (*(volatile uint32_t *)(0xFFD80040U))
+#endif
+
+#define BOOT_LOG_MAGIC "BLOG"
+#define BOOT_LOG_VERSION 1
+#define BOOT_LOG_NAME_SIZE 16
+#define BOOT_LOG_DIGEST_SIZE 48
+#define BOOT_LOG_ALG_SHA3_384 0x0029        // TPM_ALG_SHA3_384
+
+// Event types and PCRs follow the TCG PC client profile
+#define BOOT_LOG_EV_SEPARATOR 0x00000004
+#define BOOT_LOG_EV_IPL 0x0000000D
+#define BOOT_LOG_PCR_IPL 4
+
+// Event flags
+#define BOOT_LOG_MEASURED 0x1               // digest holds a boot pack hash tree root
+
+struct boot_log_header
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t capacity;          // Bytes reserved for the log, header included
+    uint32_t used;              // Bytes written so far, header included
+    uint32_t num_events;
+    uint16_t digest_alg;        // BOOT_LOG_ALG_* used by every measured event
+    uint16_t digest_size;
+};
+
+struct boot_log_range
+{
+    uint64_t start;
+    uint64_t size;
+};
+
+// Events are 8-byte aligned and followed by num_ranges ranges
+struct boot_log_event
+{
+    uint32_t pcr;
+    uint32_t type;
+    uint32_t event_size;        // Bytes to the next event
+    uint32_t flags;
+    uint8_t digest[BOOT_LOG_DIGEST_SIZE];
+    char name[BOOT_LOG_NAME_SIZE];
+    uint64_t entry;
+    uint32_t num_ranges;
+    uint32_t reserved;
+};
+
+// Clears the log region; call once before the first image is loaded
+void boot_log_init(void);
+
+// Starts an event for a loaded image; digest may be NULL for unmeasured images
+int32_t boot_log_image(const char *name, uint64_t entry, const uint8_t *digest);
+
+// Appends a memory range written by the image of the last event
+int32_t boot_log_range(uint64_t start, uint64_t size);
+
+// Closes the log with a separator, flushes it and publishes its address for handoff
+void boot_log_seal(void);
+
+#endif
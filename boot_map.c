@@ -0,0 +1,229 @@
+/*
+ * Description: Load address translation (see boot_map.h).
+ */
+
+// Standard Libraries
+#include "stdint.h"
+
+// Xilinx Libraries
+#include <xil_printf.h>
+
+// Addtional Libraries
+#include "boot_map.h"
+
+// Regions of one address space, sorted by start and not overlapping
+struct boot_map_table
+{
+    struct boot_map_region regions[BOOT_MAP_MAX_REGIONS];
+    uint64_t usedLow[BOOT_MAP_MAX_REGIONS];     // Image addresses written through each region
+    uint64_t usedHigh[BOOT_MAP_MAX_REGIONS];
+    uint32_t count;
+};
+
+static struct boot_map_table bootMapRun;
+static struct boot_map_table bootMapLoad;
+
+static int32_t boot_map_insert(struct boot_map_table *table, const struct boot_map_region *region)
+{
+    uint32_t i = table->count;
+
+    // Insertion sort; tables are a handful of entries
+    while (i > 0 && table->regions[i - 1].start > region->start)
+    {
+        table->regions[i] = table->regions[i - 1];
+        i--;
+    }
+    table->regions[i] = *region;
+    table->count++;
+
+    if ((i > 0 && table->regions[i - 1].start + table->regions[i - 1].size > region->start) ||
+        (i + 1 < table->count && region->start + region->size > table->regions[i + 1].start))
+    {
+        xil_printf("Translated region 0x%llx-0x%llx overlaps another\r\n", region->start,
+            region->start + region->size);
+        return -1;
+    }
+
+    return 0;
+}
+
+int32_t boot_map_set(const struct boot_map_region *regions, uint32_t count)
+{
+    bootMapRun.count = 0;
+    bootMapLoad.count = 0;
+
+    if (regions == NULL)
+    {
+        return 0;
+    }
+    if (count > BOOT_MAP_MAX_REGIONS)
+    {
+        xil_printf("Too many translated regions: %u\r\n", count);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        struct boot_map_table *table = (regions[i].flags & BOOT_MAP_LMA) ? &bootMapLoad : &bootMapRun;
+
+        if (regions[i].size == 0)
+        {
+            continue;
+        }
+        if (boot_map_insert(table, &regions[i]) != 0)
+        {
+            bootMapRun.count = 0;
+            bootMapLoad.count = 0;
+            return -1;
+        }
+    }
+
+    for (uint32_t i = 0; i < BOOT_MAP_MAX_REGIONS; i++)
+    {
+        bootMapRun.usedLow[i] = bootMapLoad.usedLow[i] = UINT64_MAX;
+        bootMapRun.usedHigh[i] = bootMapLoad.usedHigh[i] = 0;
+    }
+
+    return 0;
+}
+
+// Finds the region holding the segment; returns its index, -1 if it straddles a region
+// boundary and -2 if no region overlaps it
+static int32_t boot_map_find(const struct boot_map_table *table, uint64_t address, uint64_t size)
+{
+    uint32_t low = 0;
+    uint32_t high = table->count;
+
+    // First region starting beyond the address
+    while (low < high)
+    {
+        uint32_t middle = (low + high) / 2;
+
+        if (table->regions[middle].start <= address)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    // Only the region before it can hold the start, only the one at it can hold the tail
+    const struct boot_map_region *before = (low > 0) ? &table->regions[low - 1] : NULL;
+    const struct boot_map_region *after = (low < table->count) ? &table->regions[low] : NULL;
+
+    if (before != NULL && address < before->start + before->size)
+    {
+        if (address + size > before->start + before->size)
+        {
+            xil_printf("Segment 0x%llx-0x%llx crosses translated region 0x%llx-0x%llx\r\n", address,
+                address + size, before->start, before->start + before->size);
+            return -1;
+        }
+        return (int32_t)(low - 1);
+    }
+    if (after != NULL && address + size > after->start)
+    {
+        xil_printf("Segment 0x%llx-0x%llx crosses translated region 0x%llx-0x%llx\r\n", address,
+            address + size, after->start, after->start + after->size);
+        return -1;
+    }
+
+    return -2;
+}
+
+// Moves the segment through the region at index, recording what was written
+static int32_t boot_map_apply(struct boot_map_table *table, int32_t index, uint64_t address, uint64_t size,
+    uint64_t *target)
+{
+    const struct boot_map_region *region = &table->regions[index];
+
+    if (region->flags & BOOT_MAP_RESERVED)
+    {
+        xil_printf("Segment 0x%llx-0x%llx overlaps reserved region 0x%llx-0x%llx\r\n", address,
+            address + size, region->start, region->start + region->size);
+        return -1;
+    }
+
+    if (address < table->usedLow[index])
+    {
+        table->usedLow[index] = address;
+    }
+    if (address + size > table->usedHigh[index])
+    {
+        table->usedHigh[index] = address + size;
+    }
+
+    *target = region->target + (address - region->start);
+    return 0;
+}
+
+int32_t boot_map_translate(uint64_t vaddr, uint64_t paddr, uint64_t size, uint64_t *target)
+{
+    int32_t index;
+
+    index = boot_map_find(&bootMapRun, vaddr, size);
+    if (index >= 0)
+    {
+        return boot_map_apply(&bootMapRun, index, vaddr, size, target);
+    }
+    if (index == -1)
+    {
+        return -1;
+    }
+
+    index = boot_map_find(&bootMapLoad, paddr, size);
+    if (index >= 0)
+    {
+        return boot_map_apply(&bootMapLoad, index, paddr, size, target);
+    }
+    if (index == -1)
+    {
+        return -1;
+    }
+
+    *target = vaddr;
+    return 0;
+}
+
+int32_t boot_map_targets(uint64_t start, uint64_t size)
+{
+    const struct boot_map_table *tables[] = { &bootMapRun, &bootMapLoad };
+
+    for (uint32_t t = 0; t < 2; t++)
+    {
+        for (uint32_t i = 0; i < tables[t]->count; i++)
+        {
+            const struct boot_map_region *region = &tables[t]->regions[i];
+
+            if (!(region->flags & BOOT_MAP_RESERVED) && start >= region->target &&
+                start + size <= region->target + region->size)
+            {
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+int32_t boot_map_extent(uint64_t start, uint64_t *low, uint64_t *high)
+{
+    const struct boot_map_table *tables[] = { &bootMapRun, &bootMapLoad };
+
+    for (uint32_t t = 0; t < 2; t++)
+    {
+        for (uint32_t i = 0; i < tables[t]->count; i++)
+        {
+            if (tables[t]->regions[i].start == start && tables[t]->usedLow[i] < tables[t]->usedHigh[i])
+            {
+                *low = tables[t]->usedLow[i];
+                *high = tables[t]->usedHigh[i];
+                return 0;
+            }
+        }
+    }
+
+    return -1;
+}
@@ -0,0 +1,55 @@
+/*
+ * Description: Load address translation. An image is linked for the address map of the
+ * core that runs it, which is not always the map of the core loading it: R5-1's TCM sits
+ * at 0x0 for R5-1 but at 0xFFE90000 for everyone else, and hot code linked to run from
+ * TCM would otherwise only reach it through a copy made by the application at startup.
+ * The loader installs a table for the image it is about to load and every segment is
+ * moved through it, once, before a byte is written. That happens in elf_load_start(), so
+ * the table may be replaced for the next image while the last is still being read.
+ *
+ * Regions match a segment's run address (p_vaddr) by default, so code linked to run in
+ * TCM lands there directly whatever its load address. Regions flagged BOOT_MAP_LMA match
+ * the load address (p_paddr) instead, for views the image only knows by load address.
+ * Run address regions win when both match. Segments matching no region are written at
+ * their run address, as before. The table is sorted when installed and searched by
+ * bisection.
+ */
+
+#ifndef BOOT_MAP_H
+#define BOOT_MAP_H
+
+#include "stdint.h"
+
+// Regions per table, run and load address regions together
+#define BOOT_MAP_MAX_REGIONS 16
+
+// Region flags
+#define BOOT_MAP_LMA 0x1            // Match p_paddr rather than p_vaddr
+#define BOOT_MAP_RESERVED 0x2       // Fail segments that land here instead of translating them
+
+// Image addresses [start, start + size) are written at target onwards
+struct boot_map_region
+{
+    uint64_t start;
+    uint64_t size;
+    uint64_t target;
+    uint32_t flags;
+};
+
+// Installs the table used for the following images; NULL and 0 load at the run addresses.
+// Returns -1, leaving no table installed, if it is too large or regions overlap.
+int32_t boot_map_set(const struct boot_map_region *regions, uint32_t count);
+
+// Translates a segment by its run and load addresses; returns -1 if it only partly
+// overlaps a region
+int32_t boot_map_translate(uint64_t vaddr, uint64_t paddr, uint64_t size, uint64_t *target);
+
+// Returns 1 if [start, start + size) lies where an installed region translates to, so a
+// segment there may have come through the table
+int32_t boot_map_targets(uint64_t start, uint64_t size);
+
+// Image address range written through the installed region starting at start since the
+// table was installed; returns -1 if nothing was
+int32_t boot_map_extent(uint64_t start, uint64_t *low, uint64_t *high);
+
+#endif
@@ -0,0 +1,176 @@
+/*
+ * Description: Memory map validation (see boot_memmap.h).
+ */
+
+// Standard Libraries
+#include "stdint.h"
+
+// Xilinx Libraries
+#include <xil_printf.h>
+
+// Addtional Libraries
+#include "boot_memmap.h"
+#include "apu_control.h"
+#include "bootpack.h"
+#include "boot_log.h"
+#include "boot_map.h"
+#include "boot_reloc.h"
+#include "boot_stats.h"
+#include "boot_trace.h"
+#include "sd_async.h"
+#include "boot_storage.h"
+#include "boot_emmc.h"
+
+// Regions of one table, sorted by start and not overlapping
+struct boot_memmap_index
+{
+    struct boot_memmap_region regions[BOOT_MEMMAP_MAX_REGIONS];
+    uint32_t count;
+};
+
+// Memory the loading core may write images to
+static const struct boot_memmap_region memoryRegions[] =
+{
+#if defined(__aarch64__)
+    { 0x0000000000000000ULL, 0x80000000ULL, "DDR low", 0 },
+    { 0x0000000800000000ULL, 0x80000000ULL, "DDR high", 0 },
+#else
+    // The R5 sees its own TCM in front of the bottom of DDR
+    { 0x00000000U, 0x00040000U, "TCM", 0 },
+    { 0x00040000U, 0x7FFC0000U, "DDR low", 0 },
+#endif
+    { 0xFFE00000U, 0x000C0000U, "TCM global", 0 },
+    { 0xFFFC0000U, 0x00040000U, "OCM", 0 },
+};
+
+// Parts of that memory the loader still needs
+static const struct boot_memmap_region reservedRegions[] =
+{
+    { BOOT_MEMMAP_LOADER_ADDR, BOOT_MEMMAP_LOADER_SIZE, "loader", 0 },
+    { BPK_STAGING_ADDR, BPK_STAGING_SIZE, "boot pack staging", 0 },
+    { BOOT_RELOC_STUB_ADDR, BOOT_RELOC_STUB_SIZE, "copy stub", 0 },
+    { BOOT_RELOC_STAGING_ADDR, RPU_LOAD_OVER_LOADER ? BOOT_RELOC_STAGING_SIZE : 0, "relocation staging",
+        BOOT_MEMMAP_MAPPED },
+    { SD_ASYNC_DESC_ADDR, SD_ASYNC_DESC_SIZE, "SD descriptors", 0 },
+    { BOOT_EMMC_DESC_ADDR, BOOT_STORAGE_EMMC ? SD_ADMA_DESC_SIZE : 0, "eMMC descriptors", 0 },
+    { ATF_HANDOFF_ADDR, sizeof(struct xfsbl_atf_handoff_params), "AT-F handoff", 0 },
+    { BOOT_TRACE_ADDR, BOOT_TRACE_SIZE, "boot trace", 0 },
+    { BOOT_STATS_ADDR, sizeof(struct boot_stats), "boot statistics", 0 },
+    { BOOT_LOG_ADDR, BOOT_LOG_SIZE, "boot log", 0 },
+};
+
+static struct boot_memmap_index memoryIndex;
+static struct boot_memmap_index reservedIndex;
+
+static int32_t boot_memmap_build(struct boot_memmap_index *index, const struct boot_memmap_region *regions,
+    uint32_t count)
+{
+    index->count = 0;
+    if (count > BOOT_MEMMAP_MAX_REGIONS)
+    {
+        xil_printf("Too many memory map regions: %u\r\n", count);
+        return -1;
+    }
+
+    for (uint32_t n = 0; n < count; n++)
+    {
+        uint32_t i = index->count;
+
+        if (regions[n].size == 0)
+        {
+            continue;
+        }
+
+        // Insertion sort; tables are a handful of entries
+        while (i > 0 && index->regions[i - 1].start > regions[n].start)
+        {
+            index->regions[i] = index->regions[i - 1];
+            i--;
+        }
+        index->regions[i] = regions[n];
+        index->count++;
+    }
+
+    for (uint32_t i = 1; i < index->count; i++)
+    {
+        if (index->regions[i - 1].start + index->regions[i - 1].size > index->regions[i].start)
+        {
+            xil_printf("Memory map regions %s and %s overlap\r\n", index->regions[i - 1].name,
+                index->regions[i].name);
+            index->count = 0;
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int32_t boot_memmap_init(void)
+{
+    if (boot_memmap_build(&memoryIndex, memoryRegions, sizeof(memoryRegions) / sizeof(memoryRegions[0])) != 0 ||
+        boot_memmap_build(&reservedIndex, reservedRegions, sizeof(reservedRegions) / sizeof(reservedRegions[0])) != 0)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+// Last region starting below address, or NULL
+static const struct boot_memmap_region *boot_memmap_below(const struct boot_memmap_index *index, uint64_t address)
+{
+    uint32_t low = 0;
+    uint32_t high = index->count;
+
+    while (low < high)
+    {
+        uint32_t middle = (low + high) / 2;
+
+        if (index->regions[middle].start < address)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return (low > 0) ? &index->regions[low - 1] : NULL;
+}
+
+int32_t boot_memmap_check(uint64_t start, uint64_t size)
+{
+    const struct boot_memmap_region *region;
+    uint64_t end = start + size;
+
+    if (size == 0)
+    {
+        return 0;
+    }
+    if (end < start)
+    {
+        xil_printf("Segment at 0x%llx wraps the address space\r\n", start);
+        return -1;
+    }
+
+    // Regions do not overlap, so only the last one starting at or below the segment can hold it
+    region = boot_memmap_below(&memoryIndex, start + 1);
+    if (region == NULL || end > region->start + region->size)
+    {
+        xil_printf("Segment 0x%llx-0x%llx is not within memory\r\n", start, end);
+        return -1;
+    }
+
+    // Ends are sorted as well, so the last reserved region starting below the end reaches furthest
+    region = boot_memmap_below(&reservedIndex, end);
+    if (region != NULL && region->start + region->size > start &&
+        !((region->flags & BOOT_MEMMAP_MAPPED) && boot_map_targets(start, size)))
+    {
+        xil_printf("Segment 0x%llx-0x%llx overlaps the %s at 0x%llx-0x%llx\r\n", start, end, region->name,
+            region->start, region->start + region->size);
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,49 @@
+/*
+ * Description: Memory map validation. Every segment is checked against the loading
+ * core's memory map once it has been translated (see boot_map.h) and before any of the
+ * image is read: it must lie within one memory region (DDR, OCM or TCM) and must not
+ * touch anything the loader still needs (itself, its staging area, the handoff
+ * structures and the boot trace, statistics and log). Device space is simply not in the
+ * map. A bad layout then fails in milliseconds instead of after the whole image has been
+ * read from the SD card, or after it has overwritten the loader.
+ */
+
+#ifndef BOOT_MEMMAP_H
+#define BOOT_MEMMAP_H
+
+#include "stdint.h"
+
+// Range owned by the loader itself, as the loading core sees it: TCM for the R5 loader,
+// the bottom of DDR for the A53 loader
+#ifndef BOOT_MEMMAP_LOADER_ADDR
+#define BOOT_MEMMAP_LOADER_ADDR 0x00000000U
+#endif
+#ifndef BOOT_MEMMAP_LOADER_SIZE
+#if defined(__aarch64__)
+#define BOOT_MEMMAP_LOADER_SIZE 0x00100000U
+#else
+#define BOOT_MEMMAP_LOADER_SIZE 0x00040000U
+#endif
+#endif
+
+#define BOOT_MEMMAP_MAX_REGIONS 16
+
+// Region flags
+#define BOOT_MEMMAP_MAPPED 0x1      // Reserved except for segments translated into it (see boot_map.h)
+
+struct boot_memmap_region
+{
+    uint64_t start;
+    uint64_t size;
+    const char *name;
+    uint32_t flags;
+};
+
+// Sorts the memory and reserved tables into their search index; returns -1 if regions
+// of a table overlap
+int32_t boot_memmap_init(void);
+
+// Returns -1, with a message, if a segment may not be written at [start, start + size)
+int32_t boot_memmap_check(uint64_t start, uint64_t size);
+
+#endif
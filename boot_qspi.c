@@ -0,0 +1,673 @@
+/*
+ * Description: QSPI flash as a boot medium (see boot_qspi.h).
+ */
+
+// Standard Libraries
+#include "stdint.h"
+#include "string.h"
+
+// Xilinx Libraries
+#include "xil_cache.h"  // Include cache management functions
+#include <xil_printf.h> // Include Debug IO
+
+// Addtional Libraries
+#include "boot_qspi.h"
+#include "boot_storage.h"
+#include "boot_sched.h"
+#include "zdma.h"
+#include "sha3.h"
+#include "bootpack.h"
+
+#if BOOT_STORAGE_CACHE && !defined(BOOT_QSPI_EMULATE)
+#include "xparameters.h"
+#include "xqspipsu.h"
+#endif
+
+#ifdef BOOT_QSPI_EMULATE
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// DMA channel for the copies; 0 and 1 belong to ddr_ecc.c and boot_zero.c
+#ifndef BOOT_QSPI_ZDMA_BASE
+#define BOOT_QSPI_ZDMA_BASE ZDMA_GDMA_CH(2)
+#endif
+
+// Legacy (linear) QSPI controller
+#define QSPI_REG(offset) (*(volatile uint32_t *)(0xFF0F0000U + (offset)))
+#define QSPI_CONFIG 0x00U
+#define QSPI_EN 0x14U
+#define QSPI_LQSPI_CFG 0xA0U
+#define QSPI_GQSPI_SEL 0x144U
+#define QSPI_CONFIG_LINEAR 0x80080001U  // Flash interface, HOLD driven, master
+
+// Flash commands used to program the partition, with 3-byte addresses
+#define FLASH_WRITE_ENABLE 0x06U
+#define FLASH_READ_STATUS 0x05U
+#define FLASH_PAGE_PROGRAM 0x02U
+#define FLASH_SECTOR_ERASE 0xD8U
+#define FLASH_STATUS_BUSY 0x01U
+
+// Images are programmed from a bounce buffer of this size read off the source medium
+#define QSPI_STORE_CHUNK 0x1000U
+
+#define QSPI_ALIGN_UP(value, align) (((value) + (align) - 1) & ~(uint64_t)((align) - 1))
+
+// DMA runs start on whole cache lines of either processor
+#define QSPI_LINE 64U
+
+// The R5's TCM at the bottom of its map is not where the DMA would write
+#if defined(__aarch64__)
+#define QSPI_DMA_START 0x0ULL
+#else
+#define QSPI_DMA_START 0x40000ULL
+#endif
+
+static const uint8_t *qspiPartition = NULL;
+static const struct boot_qspi_directory *qspiDirectory = NULL;  // NULL if the partition is empty
+static uint8_t qspiMapped = 0;
+static uint32_t qspiOpenFiles = 0;  // Images a store must not overwrite while they are read
+
+static int32_t qspi_step(struct boot_task *task);
+static struct boot_task qspiTask = { "QSPI read", qspi_step, NULL, 0, 0, NULL };
+
+// Copy in flight: the DMA part of the range, and how far it has got
+static uint64_t qspiStart;
+static uint64_t qspiSize;
+static uint64_t qspiDst;
+static uint64_t qspiSrc;
+static uint64_t qspiRemaining;
+static uint32_t qspiPiece;
+static int32_t qspiPieceStatus;
+static int32_t *qspiResult;
+static uint8_t qspiDmaReady = 0;
+
+#ifndef BOOT_QSPI_EMULATE
+
+static const uint8_t *qspi_map(void)
+{
+#if BOOT_QSPI_LINEAR_INIT
+    QSPI_REG(QSPI_EN) = 0;
+    QSPI_REG(QSPI_GQSPI_SEL) = 0;
+    QSPI_REG(QSPI_CONFIG) = QSPI_CONFIG_LINEAR;
+    QSPI_REG(QSPI_LQSPI_CFG) = BOOT_QSPI_LQSPI_CFG;
+    QSPI_REG(QSPI_EN) = 1;
+#endif
+
+    return (const uint8_t *)(uintptr_t)(BOOT_QSPI_WINDOW + BOOT_QSPI_PART_OFFSET);
+}
+
+static void qspi_copy_start(uint64_t dst, uint64_t src, uint32_t size)
+{
+    if (!qspiDmaReady)
+    {
+        zdma_copy_init(BOOT_QSPI_ZDMA_BASE);
+        qspiDmaReady = 1;
+    }
+    zdma_copy_start(BOOT_QSPI_ZDMA_BASE, dst, src, size);
+}
+
+static int32_t qspi_copy_done(void)
+{
+    return zdma_fill_done(BOOT_QSPI_ZDMA_BASE);
+}
+
+// Programming, for the cache only, which is all the generic controller is used for
+#if BOOT_STORAGE_CACHE
+
+static XQspiPsu qspiFlash;
+static uint8_t qspiFlashReady = 0;
+static uint32_t qspiSavedEn;
+static uint32_t qspiSavedSel;
+static uint32_t qspiSavedConfig;
+static uint32_t qspiSavedLinear;
+
+static int32_t qspi_flash_transfer(uint8_t *command, uint32_t commandSize, uint8_t *data, uint32_t dataSize,
+    uint32_t direction)
+{
+    XQspiPsu_Msg messages[2];
+
+    memset(messages, 0, sizeof(messages));
+    messages[0].TxBfrPtr = command;
+    messages[0].ByteCount = commandSize;
+    messages[0].BusWidth = XQSPIPSU_SELECT_MODE_SPI;
+    messages[0].Flags = XQSPIPSU_MSG_FLAG_TX;
+    messages[1].TxBfrPtr = (direction == XQSPIPSU_MSG_FLAG_TX) ? data : NULL;
+    messages[1].RxBfrPtr = (direction == XQSPIPSU_MSG_FLAG_RX) ? data : NULL;
+    messages[1].ByteCount = dataSize;
+    messages[1].BusWidth = XQSPIPSU_SELECT_MODE_SPI;
+    messages[1].Flags = direction;
+
+    return (XQspiPsu_PolledTransfer(&qspiFlash, messages, (dataSize != 0) ? 2 : 1) == XST_SUCCESS) ? 0 : -1;
+}
+
+// Sends a write command for the partition offset and waits for the flash to finish it
+static int32_t qspi_flash_write(uint8_t opcode, uint32_t offset, const uint8_t *data, uint32_t size)
+{
+    uint32_t address = BOOT_QSPI_PART_OFFSET + offset;
+    uint8_t enable = FLASH_WRITE_ENABLE;
+    uint8_t command[4] = { opcode, (uint8_t)(address >> 16), (uint8_t)(address >> 8), (uint8_t)address };
+    uint8_t poll = FLASH_READ_STATUS;
+    uint8_t status;
+
+    if (qspi_flash_transfer(&enable, 1, NULL, 0, XQSPIPSU_MSG_FLAG_TX) != 0 ||
+        qspi_flash_transfer(command, sizeof(command), (uint8_t *)data, size, XQSPIPSU_MSG_FLAG_TX) != 0)
+    {
+        return -1;
+    }
+    do
+    {
+        if (qspi_flash_transfer(&poll, 1, &status, 1, XQSPIPSU_MSG_FLAG_RX) != 0)
+        {
+            return -1;
+        }
+    } while (status & FLASH_STATUS_BUSY);
+
+    return 0;
+}
+
+static int32_t qspi_flash_erase(uint32_t offset)
+{
+    return qspi_flash_write(FLASH_SECTOR_ERASE, offset, NULL, 0);
+}
+
+static int32_t qspi_flash_program(uint32_t offset, const uint8_t *data, uint32_t size)
+{
+    return qspi_flash_write(FLASH_PAGE_PROGRAM, offset, data, size);
+}
+
+// Hands the flash to the generic controller; nothing may read the window until
+// qspi_flash_end()
+static int32_t qspi_flash_begin(void)
+{
+    qspiSavedEn = QSPI_REG(QSPI_EN);
+    qspiSavedSel = QSPI_REG(QSPI_GQSPI_SEL);
+    qspiSavedConfig = QSPI_REG(QSPI_CONFIG);
+    qspiSavedLinear = QSPI_REG(QSPI_LQSPI_CFG);
+    QSPI_REG(QSPI_EN) = 0;
+    QSPI_REG(QSPI_GQSPI_SEL) = 1;
+
+    if (!qspiFlashReady)
+    {
+        XQspiPsu_Config *config = XQspiPsu_LookupConfig(BOOT_QSPI_DEVICE_ID);
+        if (config == NULL || XQspiPsu_CfgInitialize(&qspiFlash, config, config->BaseAddress) != XST_SUCCESS)
+        {
+            return -1;
+        }
+        XQspiPsu_SetOptions(&qspiFlash, XQSPIPSU_MANUAL_START_OPTION);
+        XQspiPsu_SetClkPrescaler(&qspiFlash, XQSPIPSU_CLK_PRESCALE_8);
+        XQspiPsu_SelectFlash(&qspiFlash, XQSPIPSU_SELECT_FLASH_CS_LOWER, XQSPIPSU_SELECT_FLASH_BUS_LOWER);
+        XQspiPsu_SetReadMode(&qspiFlash, XQSPIPSU_READMODE_IO);
+        qspiFlashReady = 1;
+    }
+
+    return 0;
+}
+
+// Puts linear mode back as it was found
+static void qspi_flash_end(void)
+{
+    QSPI_REG(QSPI_EN) = 0;
+    QSPI_REG(QSPI_GQSPI_SEL) = qspiSavedSel;
+    QSPI_REG(QSPI_CONFIG) = qspiSavedConfig;
+    QSPI_REG(QSPI_LQSPI_CFG) = qspiSavedLinear;
+    QSPI_REG(QSPI_EN) = qspiSavedEn;
+}
+
+#endif
+
+#else
+
+// Host stand-in: the flash image is a file mapped at the partition, copied by the core
+static uint64_t qspiEmulateDst;
+static uint64_t qspiEmulateSrc;
+static uint32_t qspiEmulateSize;
+static uint32_t qspiEmulatePolls;
+
+static const uint8_t *qspi_map(void)
+{
+    struct stat info;
+    int fd = open(BOOT_QSPI_EMULATE_FILE, O_RDWR | O_CREAT, 0644);
+
+    // The file stands for the whole partition, so stores can write anywhere in it
+    if (fd < 0 || fstat(fd, &info) != 0 ||
+        (info.st_size < BOOT_QSPI_PART_SIZE && ftruncate(fd, BOOT_QSPI_PART_SIZE) != 0))
+    {
+        return NULL;
+    }
+    void *data = mmap(NULL, BOOT_QSPI_PART_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    return (data == MAP_FAILED) ? NULL : data;
+}
+
+static void qspi_copy_start(uint64_t dst, uint64_t src, uint32_t size)
+{
+    qspiEmulateDst = dst;
+    qspiEmulateSrc = src;
+    qspiEmulateSize = size;
+    qspiEmulatePolls = BOOT_QSPI_EMULATE_POLLS;
+    qspiDmaReady = 1;
+}
+
+static int32_t qspi_copy_done(void)
+{
+    if (qspiEmulatePolls != 0)
+    {
+        qspiEmulatePolls--;
+        return 0;
+    }
+    memcpy((void *)(uintptr_t)qspiEmulateDst, (const void *)(uintptr_t)qspiEmulateSrc, qspiEmulateSize);
+
+    return 1;
+}
+
+#if BOOT_STORAGE_CACHE
+
+// Erased flash reads as ones and programming only clears bits
+static int32_t qspi_flash_erase(uint32_t offset)
+{
+    memset((uint8_t *)(uintptr_t)qspiPartition + offset, 0xFF, BOOT_QSPI_SECTOR_SIZE);
+
+    return 0;
+}
+
+static int32_t qspi_flash_program(uint32_t offset, const uint8_t *data, uint32_t size)
+{
+    uint8_t *flash = (uint8_t *)(uintptr_t)qspiPartition + offset;
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        flash[i] &= data[i];
+    }
+
+    return 0;
+}
+
+static int32_t qspi_flash_begin(void)
+{
+    return 0;
+}
+
+static void qspi_flash_end(void)
+{
+}
+
+#endif
+
+#endif
+
+// Finds the directory the first time an image is looked up
+static int32_t qspi_init(void)
+{
+    if (!qspiMapped)
+    {
+        const struct boot_qspi_directory *directory;
+
+        qspiMapped = 1;
+        qspiPartition = qspi_map();
+        directory = (const struct boot_qspi_directory *)qspiPartition;
+        if (qspiPartition != NULL && memcmp(directory->magic, BOOT_QSPI_MAGIC, 4) == 0 &&
+            directory->version == BOOT_QSPI_VERSION && directory->num_images <= BOOT_QSPI_MAX_IMAGES)
+        {
+            qspiDirectory = directory;
+            xil_printf("QSPI image partition: %u images\r\n", qspiDirectory->num_images);
+        }
+        else
+        {
+            xil_printf("No QSPI image partition at 0x%x\r\n", BOOT_QSPI_PART_OFFSET);
+        }
+    }
+
+    return (qspiDirectory != NULL) ? 0 : -1;
+}
+
+// The directory is read as found in flash, so an entry must lie inside the partition
+// before it is read through the window
+static int32_t qspi_image_fits(const struct boot_qspi_image *image)
+{
+    if ((uint64_t)image->offset + image->size > BOOT_QSPI_PART_SIZE)
+    {
+        xil_printf("QSPI image %.16s at 0x%x (%u bytes) lies outside the partition\r\n", image->name,
+            image->offset, image->size);
+        return 0;
+    }
+
+    return 1;
+}
+
+#if BOOT_STORAGE_CACHE
+// Whether the entry is a cached copy of a card image, which is only found by its key
+static int32_t qspi_image_keyed(const struct boot_qspi_image *image)
+{
+    for (uint32_t i = 0; i < BOOT_QSPI_KEY_SIZE; i++)
+    {
+        if (image->key[i] != 0)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+#endif
+
+static void qspi_file_open(struct boot_file *file, const struct boot_qspi_image *image)
+{
+    file->storage = &bootQspi;
+    file->base = image->offset;
+    file->size = image->size;
+    qspiOpenFiles++;
+}
+
+static int32_t qspi_open(struct boot_file *file, const char *name)
+{
+    if (qspi_init() != 0)
+    {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < qspiDirectory->num_images; i++)
+    {
+        const struct boot_qspi_image *image = &qspiDirectory->images[i];
+
+        if (strncmp(image->name, name, BOOT_QSPI_NAME_SIZE) != 0)
+        {
+            continue;
+        }
+#if BOOT_STORAGE_CACHE
+        // The card stays the source of cached images; their copies are only found through it
+        if (qspi_image_keyed(image))
+        {
+            continue;
+        }
+#endif
+        if (!qspi_image_fits(image))
+        {
+            return -1;
+        }
+        qspi_file_open(file, image);
+        return 0;
+    }
+
+    return -1;
+}
+
+// Whether the entry holds a container with the key as its root, so a stale or
+// mislabelled entry is not taken for the image the card holds
+static int32_t qspi_image_rooted(const struct boot_qspi_image *image, const uint8_t *key)
+{
+    const struct bpk_header *header = (const struct bpk_header *)(qspiPartition + image->offset);
+
+    return image->size >= sizeof(*header) && bpk_is_container(header) &&
+        memcmp(header->root, key, BOOT_QSPI_KEY_SIZE) == 0;
+}
+
+int32_t boot_qspi_find(struct boot_file *file, const uint8_t *key, uint64_t size)
+{
+    if (qspi_init() != 0)
+    {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < qspiDirectory->num_images; i++)
+    {
+        const struct boot_qspi_image *image = &qspiDirectory->images[i];
+
+        if (image->size == size && memcmp(image->key, key, BOOT_QSPI_KEY_SIZE) == 0 && qspi_image_fits(image) &&
+            qspi_image_rooted(image, key))
+        {
+            qspi_file_open(file, image);
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+// Copies the middle of a read a DMA transfer at a time
+static int32_t qspi_step(struct boot_task *task)
+{
+    BOOT_TASK_BEGIN(task);
+    while (qspiRemaining != 0)
+    {
+        qspiPiece = (qspiRemaining > ZDMA_MAX_TRANSFER) ? ZDMA_MAX_TRANSFER : (uint32_t)qspiRemaining;
+        qspi_copy_start(qspiDst, qspiSrc, qspiPiece);
+
+        BOOT_TASK_WAIT_UNTIL(task, (qspiPieceStatus = qspi_copy_done()) != 0);
+        if (qspiPieceStatus < 0)
+        {
+            // Still readable by the core; copy it here
+            xil_printf("QSPI DMA copy to 0x%llx failed, copying it again\r\n", qspiDst);
+            memcpy((void *)(uintptr_t)qspiDst, (const void *)(uintptr_t)qspiSrc, qspiPiece);
+            Xil_DCacheFlushRange((UINTPTR)qspiDst, qspiPiece);
+        }
+        qspiDst += qspiPiece;
+        qspiSrc += qspiPiece;
+        qspiRemaining -= qspiPiece;
+    }
+
+    // Drop whatever the core fetched from the range while the DMA wrote it
+    Xil_DCacheInvalidateRange((UINTPTR)qspiStart, qspiSize);
+    *qspiResult = 0;
+    BOOT_TASK_END(task);
+}
+
+static int32_t qspi_read(struct boot_file *file, uint64_t offset, void *dst, uint32_t size, int32_t *status)
+{
+    const uint8_t *src = qspiPartition + file->base + offset;
+    uint64_t start = (uintptr_t)dst;
+    uint64_t head = (start + QSPI_LINE - 1) & ~(uint64_t)(QSPI_LINE - 1);
+    uint64_t tail = (start + size) & ~(uint64_t)(QSPI_LINE - 1);
+
+    if (offset + size > file->size)
+    {
+        *status = -1;
+        return -1;
+    }
+
+    if (!BOOT_QSPI_DMA || size < BOOT_QSPI_DMA_MIN || start < QSPI_DMA_START || tail <= head)
+    {
+        memcpy(dst, src, size);
+        Xil_DCacheFlushRange((UINTPTR)dst, size);
+        *status = 0;
+        return 0;
+    }
+
+    // The core copies the partial lines, the DMA everything between them
+    memcpy(dst, src, (size_t)(head - start));
+    memcpy((void *)(uintptr_t)tail, src + (tail - start), (size_t)(start + size - tail));
+    Xil_DCacheFlushRange((UINTPTR)start, head - start);
+    Xil_DCacheFlushRange((UINTPTR)tail, start + size - tail);
+    Xil_DCacheInvalidateRange((UINTPTR)head, tail - head);
+
+    qspiStart = qspiDst = head;
+    qspiSrc = (uintptr_t)src + (head - start);
+    qspiSize = qspiRemaining = tail - head;
+    qspiResult = status;
+    *status = BOOT_TASK_RUNNING;
+
+    boot_sched_start(&qspiTask);
+    boot_sched_yield();
+    return 0;
+}
+
+static int32_t qspi_busy(void)
+{
+    boot_sched_yield();
+
+    return boot_sched_running(&qspiTask);
+}
+
+static void qspi_close(struct boot_file *file)
+{
+    (void)file;
+    qspiOpenFiles--;
+}
+
+const struct boot_storage bootQspi = { "QSPI", qspi_open, qspi_read, qspi_busy, qspi_close };
+
+#if BOOT_STORAGE_CACHE
+
+// Programs one stretch of the partition; other reads of the window have to be finished
+// and none may start before linear mode is back
+static int32_t qspi_store_range(uint32_t offset, const uint8_t *data, uint32_t size, uint8_t erase)
+{
+    int32_t status;
+
+    boot_sched_wait(&qspiTask);
+    status = qspi_flash_begin();
+    if (status == 0 && erase)
+    {
+        status = qspi_flash_erase(offset);
+    }
+    for (uint32_t done = 0; status == 0 && done < size; done += BOOT_QSPI_PAGE_SIZE)
+    {
+        uint32_t page = (size - done < BOOT_QSPI_PAGE_SIZE) ? size - done : BOOT_QSPI_PAGE_SIZE;
+        status = qspi_flash_program(offset + done, data + done, page);
+    }
+    qspi_flash_end();
+    Xil_DCacheInvalidateRange((UINTPTR)(qspiPartition + offset), size);
+
+    return status;
+}
+
+// Replaces the directory; on failure the partition is taken as empty
+static int32_t qspi_write_directory(const struct boot_qspi_directory *directory)
+{
+    if (qspi_store_range(0, (const uint8_t *)directory, sizeof(*directory), 1) != 0)
+    {
+        xil_printf("Failed to write the QSPI directory\r\n");
+        qspiDirectory = NULL;
+        return -1;
+    }
+    qspiDirectory = (const struct boot_qspi_directory *)qspiPartition;
+
+    return 0;
+}
+
+int32_t boot_qspi_forget(const uint8_t *key)
+{
+    static struct boot_qspi_directory directory;
+    uint32_t count = 0;
+
+    if (qspi_init() != 0)
+    {
+        return -1;
+    }
+
+    directory = *qspiDirectory;
+    for (uint32_t i = 0; i < qspiDirectory->num_images; i++)
+    {
+        if (memcmp(qspiDirectory->images[i].key, key, BOOT_QSPI_KEY_SIZE) != 0)
+        {
+            directory.images[count++] = qspiDirectory->images[i];
+        }
+    }
+    if (count == qspiDirectory->num_images)
+    {
+        return 0;
+    }
+    memset(&directory.images[count], 0, (BOOT_QSPI_MAX_IMAGES - count) * sizeof(struct boot_qspi_image));
+    directory.num_images = count;
+
+    return qspi_write_directory(&directory);
+}
+
+int32_t boot_qspi_store(const char *name, const uint8_t *key, struct boot_file *source)
+{
+    static struct boot_qspi_directory directory;
+    static uint8_t chunk[QSPI_STORE_CHUNK];
+    struct sha3_context context;
+    uint8_t written[SHA3_384_DIGEST_SIZE];
+    uint8_t readBack[SHA3_384_DIGEST_SIZE];
+    uint64_t first = QSPI_ALIGN_UP(sizeof(directory), BOOT_QSPI_SECTOR_SIZE);
+    uint64_t start = first;
+    uint32_t count = 0;
+
+    qspi_init();
+    if (qspiPartition == NULL || source->size > BOOT_QSPI_PART_SIZE - first)
+    {
+        xil_printf("%s does not fit in the QSPI image partition\r\n", name);
+        return -1;
+    }
+
+    // Keep every image but an older copy of this one and any sharing the directory's
+    // sector, and store after the last
+    memset(&directory, 0, sizeof(directory));
+    memcpy(directory.magic, BOOT_QSPI_MAGIC, 4);
+    directory.version = BOOT_QSPI_VERSION;
+    for (uint32_t i = 0; qspiDirectory != NULL && i < qspiDirectory->num_images; i++)
+    {
+        const struct boot_qspi_image *image = &qspiDirectory->images[i];
+        uint64_t end = QSPI_ALIGN_UP((uint64_t)image->offset + image->size, BOOT_QSPI_SECTOR_SIZE);
+
+        // Entries outside the partition are dropped rather than kept in the new directory
+        if (!qspi_image_fits(image))
+        {
+            continue;
+        }
+        start = (end > start) ? end : start;
+        if (strncmp(image->name, name, BOOT_QSPI_NAME_SIZE) != 0 && image->offset >= first)
+        {
+            directory.images[count++] = *image;
+        }
+    }
+
+    if (count == BOOT_QSPI_MAX_IMAGES || start + source->size > BOOT_QSPI_PART_SIZE)
+    {
+        // Starting over erases images that may be loading
+        if (qspiOpenFiles != 0)
+        {
+            xil_printf("QSPI image partition full while in use, not storing %s\r\n", name);
+            return -1;
+        }
+        xil_printf("QSPI image partition full, starting it over\r\n");
+        start = first;
+        count = 0;
+
+        // The old directory names the sectors about to be reused, so it goes first
+        qspiDirectory = NULL;
+        if (qspi_store_range(0, NULL, 0, 1) != 0)
+        {
+            xil_printf("Failed to erase the QSPI directory\r\n");
+            return -1;
+        }
+    }
+
+    xil_printf("Storing %s in QSPI at 0x%llx (%llu bytes)\r\n", name, start, source->size);
+    sha3_384_init(&context);
+    for (uint64_t offset = 0; offset < source->size; offset += QSPI_STORE_CHUNK)
+    {
+        uint32_t size = (source->size - offset < QSPI_STORE_CHUNK) ? (uint32_t)(source->size - offset) : QSPI_STORE_CHUNK;
+
+        if (boot_read_now(source, offset, chunk, size) != 0 ||
+            qspi_store_range((uint32_t)(start + offset), chunk, size, (offset % BOOT_QSPI_SECTOR_SIZE) == 0) != 0)
+        {
+            xil_printf("Failed to store %s in QSPI\r\n", name);
+            return -1;
+        }
+        sha3_384_update(&context, chunk, size);
+    }
+
+    // The directory only names the image once it reads back intact
+    sha3_384_final(&context, written);
+    sha3_384(qspiPartition + start, (uint32_t)source->size, readBack);
+    if (memcmp(written, readBack, sizeof(written)) != 0)
+    {
+        xil_printf("%s did not read back from QSPI as written\r\n", name);
+        return -1;
+    }
+
+    strncpy(directory.images[count].name, name, BOOT_QSPI_NAME_SIZE);
+    directory.images[count].offset = (uint32_t)start;
+    directory.images[count].size = (uint32_t)source->size;
+    memcpy(directory.images[count].key, key, BOOT_QSPI_KEY_SIZE);
+    directory.num_images = count + 1;
+
+    return qspi_write_directory(&directory);
+}
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * Description: QSPI flash as a boot medium (see boot_storage.h). Images live in an image
+ * partition: a directory of names, offsets and sizes followed by the images, built on
+ * the host with tools/qspiimg.c and programmed at BOOT_QSPI_PART_OFFSET. The controller
+ * is read in linear mode, where the flash appears as memory at BOOT_QSPI_WINDOW, so a
+ * read copies straight from the window into place. Reads of BOOT_QSPI_DMA_MIN or more
+ * go to an FPD DMA channel in the background; the loading core copies only the partial
+ * cache lines at either end. Smaller reads, and reads into the R5's TCM, are copied on
+ * the spot.
+ *
+ * Linear mode has to be set up before the loader runs, as the BootROM and FSBL leave it
+ * when booting from QSPI, or by building with BOOT_QSPI_LINEAR_INIT. The partition must
+ * lie inside the part of the flash the window reaches. Building with BOOT_QSPI_EMULATE
+ * maps the file named by BOOT_QSPI_EMULATE_FILE in place of the window and copies with
+ * memcpy a few polls after each read starts, so the loaders can run on a host
+ * (tests/test_loader.c).
+ *
+ * The partition also serves as a cache of SD images (BOOT_STORAGE_CACHE in
+ * boot_storage.h). Directory entries then carry a key, the hash tree root of a boot pack
+ * container; keyed entries are found by key only, never by name. boot_qspi_store()
+ * programs missing images into it through the generic QSPI controller, switching back
+ * to linear mode when done. Stored images start on erase sectors after the last image;
+ * once the partition or the directory is full it is started over, with the directory
+ * erased before any sector it names is reused. The data is written before the new
+ * directory, so an interrupted store leaves the old directory or none, and images are
+ * then read from the SD card again. A keyed entry is only a hit while the container
+ * stored there carries its key as the hash tree root, and boot_qspi_forget() drops a
+ * copy that failed to load. Under BOOT_QSPI_EMULATE the mapped file is written instead.
+ */
+
+#ifndef BOOT_QSPI_H
+#define BOOT_QSPI_H
+
+#include "stdint.h"
+
+struct boot_storage;
+struct boot_file;
+
+// Linear read window of the QSPI controller
+#ifndef BOOT_QSPI_WINDOW
+#define BOOT_QSPI_WINDOW 0xC0000000UL
+#endif
+
+// Flash offset of the image partition; inside the 16 MiB a 3-byte address reaches
+#ifndef BOOT_QSPI_PART_OFFSET
+#define BOOT_QSPI_PART_OFFSET 0x00800000U
+#endif
+
+// Switch the controller to linear reads before the first image is looked up
+#ifndef BOOT_QSPI_LINEAR_INIT
+#define BOOT_QSPI_LINEAR_INIT 0
+#endif
+
+// LQSPI_CFG for linear mode: quad output fast read (0x6B) with one dummy byte
+#ifndef BOOT_QSPI_LQSPI_CFG
+#define BOOT_QSPI_LQSPI_CFG 0x8000016BU
+#endif
+
+// Size of the partition and of the flash's erase sectors and program pages
+#ifndef BOOT_QSPI_PART_SIZE
+#define BOOT_QSPI_PART_SIZE 0x00800000U
+#endif
+#ifndef BOOT_QSPI_SECTOR_SIZE
+#define BOOT_QSPI_SECTOR_SIZE 0x10000U
+#endif
+#ifndef BOOT_QSPI_PAGE_SIZE
+#define BOOT_QSPI_PAGE_SIZE 256U
+#endif
+
+// Generic QSPI controller used to program the partition
+#ifndef BOOT_QSPI_DEVICE_ID
+#define BOOT_QSPI_DEVICE_ID XPAR_XQSPIPSU_0_DEVICE_ID
+#endif
+
+// Copy with the DMA from this size up; 0 copies everything with memcpy
+#ifndef BOOT_QSPI_DMA
+#define BOOT_QSPI_DMA 1
+#endif
+#ifndef BOOT_QSPI_DMA_MIN
+#define BOOT_QSPI_DMA_MIN 0x4000U
+#endif
+
+// Polls before the host stand-in completes a copy
+#ifndef BOOT_QSPI_EMULATE_POLLS
+#define BOOT_QSPI_EMULATE_POLLS 4
+#endif
+#ifndef BOOT_QSPI_EMULATE_FILE
+#define BOOT_QSPI_EMULATE_FILE "qspi.bin"
+#endif
+
+// Image partition layout, shared with tools/qspiimg.c
+#define BOOT_QSPI_MAGIC "BQSP"
+#define BOOT_QSPI_VERSION 2
+#define BOOT_QSPI_NAME_SIZE 16
+#define BOOT_QSPI_KEY_SIZE 48           // Boot pack hash tree root
+#define BOOT_QSPI_MAX_IMAGES 15
+#define BOOT_QSPI_ALIGN 64U         // Images start on cache lines
+
+struct boot_qspi_image
+{
+    char name[BOOT_QSPI_NAME_SIZE]; // NUL padded
+    uint32_t offset;                // From the start of the partition
+    uint32_t size;
+    uint8_t key[BOOT_QSPI_KEY_SIZE];    // All zero if the image is not a hashed container
+};
+
+struct boot_qspi_directory
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t num_images;
+    uint32_t reserved;
+    struct boot_qspi_image images[BOOT_QSPI_MAX_IMAGES];
+};
+
+// Medium for boot_storage.c
+extern const struct boot_storage bootQspi;
+
+// Opens the boot pack container stored under key with the given size; returns -1 if
+// there is none, or if the container stored there has another hash tree root
+int32_t boot_qspi_find(struct boot_file *file, const uint8_t *key, uint64_t size);
+
+// Removes the entries stored under key from the directory
+int32_t boot_qspi_forget(const uint8_t *key);
+
+// Programs the image read from source into the partition under name and key, replacing
+// any image stored under the same name, and checks it reads back intact
+int32_t boot_qspi_store(const char *name, const uint8_t *key, struct boot_file *source);
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * Description: Loading over the loader (see boot_reloc.h).
+ */
+
+// Standard Libraries
+#include "stdint.h"
+#include "string.h"
+
+// Xilinx Libraries
+#include "xil_cache.h"      // Include cache management functions
+#include "xil_exception.h"  // Include exception control
+#include <xil_printf.h>     // Include Debug IO
+
+// Addtional Libraries
+#include "boot_map.h"
+#include "boot_reloc.h"
+
+// Copy granule of the stub
+#define STUB_BURST 32U
+
+#if defined(__arm__)
+// Copies r2 bytes, a multiple of STUB_BURST, from r1 to r0 and branches to r3. Position
+// independent and free of literals so it runs from wherever it is copied to.
+extern const uint8_t boot_reloc_stub[];
+extern const uint8_t boot_reloc_stub_end[];
+
+__asm__(
+    "   .pushsection .text.boot_reloc_stub, \"ax\", %progbits\n"
+    "   .arm\n"
+    "   .align 2\n"
+    "   .global boot_reloc_stub\n"
+    "   .global boot_reloc_stub_end\n"
+    "   .type boot_reloc_stub, %function\n"
+    "boot_reloc_stub:\n"
+    "1: subs r2, r2, #32\n"
+    "   blt 2f\n"
+    "   ldmia r1!, {r4-r11}\n"
+    "   stmia r0!, {r4-r11}\n"
+    "   b 1b\n"
+    "2: dsb\n"
+    "   isb\n"
+    "   bx r3\n"
+    "boot_reloc_stub_end:\n"
+    "   .popsection\n");
+#endif
+
+// Staging and reserved regions for the image loaded over the loader
+static const struct boot_map_region relocMap[] =
+{
+    { BOOT_RELOC_WINDOW_ADDR, BOOT_RELOC_WINDOW_SIZE, BOOT_RELOC_STAGING_ADDR, 0 },
+    { BOOT_RELOC_STAGING_ADDR, BOOT_RELOC_STAGING_SIZE, 0, BOOT_MAP_RESERVED },
+    { BOOT_RELOC_STUB_ADDR, BOOT_RELOC_STUB_SIZE, 0, BOOT_MAP_RESERVED },
+};
+
+int32_t boot_reloc_prepare(void)
+{
+    return boot_map_set(relocMap, sizeof(relocMap) / sizeof(relocMap[0]));
+}
+
+int32_t boot_reloc_start(uint32_t entry)
+{
+#if defined(__arm__)
+    size_t stubSize = (size_t)(boot_reloc_stub_end - boot_reloc_stub);
+    uint32_t offset = 0;
+    uint32_t size = 0;
+    uint64_t low;
+    uint64_t high;
+
+    if (stubSize > BOOT_RELOC_STUB_SIZE)
+    {
+        xil_printf("Copy stub too large: 0x%x bytes\r\n", (uint32_t)stubSize);
+        return -1;
+    }
+
+    // Only the part of the window the image wrote is copied, in whole bursts
+    if (boot_map_extent(BOOT_RELOC_WINDOW_ADDR, &low, &high) == 0)
+    {
+        offset = (uint32_t)(low - BOOT_RELOC_WINDOW_ADDR) & ~(STUB_BURST - 1);
+        size = (((uint32_t)(high - BOOT_RELOC_WINDOW_ADDR) + STUB_BURST - 1) & ~(STUB_BURST - 1)) - offset;
+        xil_printf("Copying 0x%x staged bytes to 0x%08x at handoff\r\n", size, BOOT_RELOC_WINDOW_ADDR + offset);
+    }
+    boot_map_set(NULL, 0);
+
+    memcpy((void *)BOOT_RELOC_STUB_ADDR, boot_reloc_stub, stubSize);
+
+    // The stub overwrites the vector table and reads the staging copy straight from DDR;
+    // disabling the data cache also writes back the staged segments and the stub
+    Xil_ExceptionDisable();
+    Xil_DCacheDisable();
+    Xil_ICacheDisable();
+
+    ((void (*)(uint32_t, uint32_t, uint32_t, uint32_t))BOOT_RELOC_STUB_ADDR)(BOOT_RELOC_WINDOW_ADDR + offset,
+        BOOT_RELOC_STAGING_ADDR + offset, size, entry);
+#else
+    (void)entry;
+    xil_printf("Loading over the loader is only supported on the R5\r\n");
+#endif
+
+    return -1;
+}
@@ -0,0 +1,59 @@
+/*
+ * Description: Loading over the loader. The R5 loader runs from TCM, which is also where
+ * an application wants its hot code and data, so images used to be linked around it.
+ * Instead, segments that land in the loader's window are written to a DDR staging copy
+ * of the window, and at handoff a small copy stub moved into OCM copies the part that
+ * was written into place and branches to the entry point. Nothing the loader still needs
+ * is touched before the stub runs, so images may use the whole 256 KiB of TCM.
+ *
+ * The stub's OCM home and the staging area are reserved while the image loads: a segment
+ * reaching into either fails the load rather than corrupting the handoff. The memory map
+ * (boot_memmap.h) reserves both for the images loaded earlier as well, leaving the
+ * staging area to the window's translation only. The staging area must be DDR the R5
+ * owns, kept out of the APU OS memory map.
+ */
+
+#ifndef BOOT_RELOC_H
+#define BOOT_RELOC_H
+
+#include "stdint.h"
+
+// Addresses the loader occupies, as the loading core sees them (R5 TCM in lockstep)
+#ifndef BOOT_RELOC_WINDOW_ADDR
+#define BOOT_RELOC_WINDOW_ADDR 0x00000000U
+#endif
+#ifndef BOOT_RELOC_WINDOW_SIZE
+#define BOOT_RELOC_WINDOW_SIZE 0x00040000U
+#endif
+
+// Load R5-0's image over the loader's own TCM through the staging copy. The A53 loader
+// runs from DDR and loads nothing over itself.
+#ifndef RPU_LOAD_OVER_LOADER
+#if defined(__aarch64__)
+#define RPU_LOAD_OVER_LOADER 0
+#else
+#define RPU_LOAD_OVER_LOADER 1
+#endif
+#endif
+
+// Staging copy of the window
+#ifndef BOOT_RELOC_STAGING_ADDR
+#define BOOT_RELOC_STAGING_ADDR 0x3FE00000U
+#endif
+#define BOOT_RELOC_STAGING_SIZE BOOT_RELOC_WINDOW_SIZE
+
+// OCM home of the copy stub, below the AT-F handoff structure
+#ifndef BOOT_RELOC_STUB_ADDR
+#define BOOT_RELOC_STUB_ADDR 0xFFFE0000U
+#endif
+#define BOOT_RELOC_STUB_SIZE 0x100U
+
+// Installs the staging and reserved regions for the next image. Replaces any boot_map
+// table, so images loaded with a table of their own must come first.
+int32_t boot_reloc_prepare(void);
+
+// Moves the copy stub into OCM, then copies the staged part of the window into place and
+// branches to entry. Only returns, with -1, if the stub cannot be installed.
+int32_t boot_reloc_start(uint32_t entry);
+
+#endif
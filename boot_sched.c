@@ -0,0 +1,92 @@
+/*
+ * Description: Cooperative scheduler for the loaders (see boot_sched.h).
+ */
+
+// Standard Libraries
+#include "stdint.h"
+#include "stddef.h"
+
+// Xilinx Libraries
+#include <xil_printf.h>
+
+// Addtional Libraries
+#include "boot_sched.h"
+
+static struct boot_task *schedTasks = NULL;
+static uint8_t schedStepping = 0;
+
+int32_t boot_sched_running(const struct boot_task *task)
+{
+    for (const struct boot_task *t = schedTasks; t != NULL; t = t->next)
+    {
+        if (t == task)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void boot_sched_start(struct boot_task *task)
+{
+    if (boot_sched_running(task))
+    {
+        return;
+    }
+
+    task->resume = 0;
+    task->status = BOOT_TASK_RUNNING;
+
+    // Appended, so tasks are stepped in the order they were started
+    struct boot_task **link = &schedTasks;
+    while (*link != NULL)
+    {
+        link = &(*link)->next;
+    }
+    task->next = NULL;
+    *link = task;
+}
+
+void boot_sched_yield(void)
+{
+    struct boot_task **link = &schedTasks;
+
+    // A task waiting inside its step must not step itself again
+    if (schedStepping)
+    {
+        return;
+    }
+    schedStepping = 1;
+
+    while (*link != NULL)
+    {
+        struct boot_task *task = *link;
+
+        task->status = task->step(task);
+        if (task->status == BOOT_TASK_RUNNING)
+        {
+            link = &task->next;
+            continue;
+        }
+
+        if (task->status < 0)
+        {
+            xil_printf("Boot task %s failed: %d\r\n", task->name, task->status);
+        }
+        *link = task->next;
+        task->next = NULL;
+    }
+
+    schedStepping = 0;
+}
+
+int32_t boot_sched_wait(struct boot_task *task)
+{
+    while (boot_sched_running(task))
+    {
+        boot_sched_yield();
+    }
+
+    return task->status;
+}
@@ -0,0 +1,60 @@
+/*
+ * Description: Cooperative scheduler for the loaders. Work that mostly waits on hardware
+ * (DMA fills, the CSU, power and reset handshakes) runs as tasks that the loading core
+ * steps whenever it would otherwise wait itself: before each SD read, while it waits on
+ * the CSU or on decode workers, and in boot_sched_wait(). Every task is one step
+ * function written as a stackless coroutine with the BOOT_TASK_* macros below; it keeps
+ * its state in statics or its context, since locals do not survive a yield. Steps must
+ * return quickly and never block. There is no preemption and no interrupt handling.
+ */
+
+#ifndef BOOT_SCHED_H
+#define BOOT_SCHED_H
+
+#include "stdint.h"
+
+// Step results; negative values are errors and end the task too
+#define BOOT_TASK_DONE 0
+#define BOOT_TASK_RUNNING 1
+
+struct boot_task
+{
+    const char *name;
+    int32_t (*step)(struct boot_task *task);
+    void *context;
+    uint32_t resume;                // Coroutine position, 0 at the start
+    int32_t status;                 // Last step result
+    struct boot_task *next;         // Run list link while running
+};
+
+// The first test of a wait falls through into its resume label on purpose
+#if defined(__GNUC__) && __GNUC__ >= 7
+#define BOOT_TASK_FALLTHROUGH __attribute__((fallthrough))
+#else
+#define BOOT_TASK_FALLTHROUGH do { } while (0)
+#endif
+
+// Coroutine body: BOOT_TASK_BEGIN(task); ... BOOT_TASK_END(task);
+#define BOOT_TASK_BEGIN(task) switch ((task)->resume) { case 0:
+#define BOOT_TASK_YIELD(task) \
+    do { (task)->resume = __LINE__; return BOOT_TASK_RUNNING; case __LINE__:; } while (0)
+#define BOOT_TASK_WAIT_UNTIL(task, condition) \
+    do { (task)->resume = __LINE__; BOOT_TASK_FALLTHROUGH; case __LINE__: \
+        if (!(condition)) return BOOT_TASK_RUNNING; } while (0)
+#define BOOT_TASK_END(task) } (task)->resume = 0; return BOOT_TASK_DONE
+
+// Adds a task to the run list from the start of its step function; does nothing if it is
+// already running
+void boot_sched_start(struct boot_task *task);
+
+// Steps every running task once; does nothing when called from inside a step
+void boot_sched_yield(void);
+
+// Steps every task until this one is done; returns its final status. Not for use
+// inside a step.
+int32_t boot_sched_wait(struct boot_task *task);
+
+// Whether the task is still on the run list
+int32_t boot_sched_running(const struct boot_task *task);
+
+#endif
@@ -0,0 +1,98 @@
+/*
+ * Description: Boot statistics handoff record (see boot_stats.h).
+ */
+
+// Standard Libraries
+#include "stdint.h"
+#include "string.h"
+
+// Xilinx Libraries
+#include "xil_cache.h"
+#include "xtime_l.h"
+#include <xil_printf.h>
+
+// Addtional Libraries
+#include "boot_stats.h"
+
+#define BOOT_STATS ((struct boot_stats *)(uintptr_t)BOOT_STATS_ADDR)
+
+static struct boot_stats_image *bootStatsCurrent = NULL;
+
+static uint64_t boot_stats_now(void)
+{
+    XTime now;
+
+    XTime_GetTime(&now);
+    return now;
+}
+
+void boot_stats_init(void)
+{
+    struct boot_stats *stats = BOOT_STATS;
+
+    memset(stats, 0, sizeof(*stats));
+    memcpy(stats->magic, BOOT_STATS_MAGIC, sizeof(stats->magic));
+    stats->version = BOOT_STATS_VERSION;
+    stats->size = sizeof(*stats);
+    stats->counts_per_second = COUNTS_PER_SECOND;
+    stats->stages[BOOT_STAGE_MAIN] = boot_stats_now();
+    bootStatsCurrent = NULL;
+}
+
+void boot_stats_stage(uint32_t stage)
+{
+    if (stage < BOOT_NUM_STAGES)
+    {
+        BOOT_STATS->stages[stage] = boot_stats_now();
+    }
+}
+
+struct boot_stats_image *boot_stats_image(const char *name)
+{
+    struct boot_stats *stats = BOOT_STATS;
+
+    if (stats->num_images == BOOT_STATS_MAX_IMAGES)
+    {
+        bootStatsCurrent = NULL;
+        return NULL;
+    }
+
+    bootStatsCurrent = &stats->images[stats->num_images++];
+    strncpy(bootStatsCurrent->name, name, BOOT_STATS_NAME_SIZE - 1);
+    bootStatsCurrent->start = boot_stats_now();
+    return bootStatsCurrent;
+}
+
+struct boot_stats_image *boot_stats_current(void)
+{
+    return bootStatsCurrent;
+}
+
+void boot_stats_image_done(void)
+{
+    if (bootStatsCurrent != NULL)
+    {
+        boot_stats_image_end(bootStatsCurrent);
+    }
+}
+
+void boot_stats_image_end(struct boot_stats_image *image)
+{
+    image->end = boot_stats_now();
+    if (image == bootStatsCurrent)
+    {
+        bootStatsCurrent = NULL;
+    }
+}
+
+void boot_stats_publish(void)
+{
+    struct boot_stats *stats = BOOT_STATS;
+
+    boot_stats_stage(BOOT_STAGE_HANDOFF);
+    Xil_DCacheFlushRange((UINTPTR)stats, sizeof(*stats));
+    BOOT_STATS_HANDOFF = (uint32_t)BOOT_STATS_ADDR;
+    xil_printf("Boot stats: %u image(s), %llu us in the loader, record at 0x%08x\r\n", stats->num_images,
+        ((stats->stages[BOOT_STAGE_HANDOFF] - stats->stages[BOOT_STAGE_MAIN]) * 1000000) / COUNTS_PER_SECOND,
+        (uint32_t)BOOT_STATS_ADDR);
+}
@@ -0,0 +1,100 @@
+/*
+ * Description: Boot statistics handoff record. The loader timestamps its stages and
+ * fills in per-image counters (bytes read, time spent reading, decoding and verifying,
+ * retries and which fast paths were taken) in a versioned record in reserved OCM, and
+ * leaves its address in PMU GLOBAL_GEN_STORAGE3 so the OS can export it. Timestamps
+ * are raw XTime counts; counts_per_second converts them. On the APU this is the system
+ * counter, which keeps running into the OS, so bootloader and kernel times line up.
+ */
+
+#ifndef BOOT_STATS_H
+#define BOOT_STATS_H
+
+#include "stdint.h"
+
+// Reserved region below the boot log
+#ifndef BOOT_STATS_ADDR
+#define BOOT_STATS_ADDR 0xFFFE8000U
+#endif
+
+// Register the record address is handed off in (PMU GLOBAL_GEN_STORAGE3)
+#ifndef BOOT_STATS_HANDOFF
+#define BOOT_STATS_HANDOFF (*(volatile uint32_t *)(0xFFD8003CU))
+#endif
+
+#define BOOT_STATS_MAGIC "BSTA"
+#define BOOT_STATS_VERSION 1
+#define BOOT_STATS_MAX_IMAGES 4
+#define BOOT_STATS_NAME_SIZE 16
+
+// Stage timestamps
+#define BOOT_STAGE_MAIN 0           // Loader main() entered
+#define BOOT_STAGE_WORKERS 1        // Decode workers started
+#define BOOT_STAGE_LOADED 2         // Every image loaded
+#define BOOT_STAGE_VERIFIED 3       // Deferred verification finished
+#define BOOT_STAGE_HANDOFF 4        // Record published, about to hand off
+#define BOOT_NUM_STAGES 5
+
+// Per-image fast path flags
+#define BOOT_STATS_BOOTPACK 0x01    // Loaded from a boot pack container
+#define BOOT_STATS_HASHED 0x02      // Checked against a hash tree
+#define BOOT_STATS_CSU_SHA3 0x04    // Some blocks were checked by the CSU SHA3 engine
+#define BOOT_STATS_ENCRYPTED 0x08   // Blocks were decrypted
+#define BOOT_STATS_SIGNED 0x10      // Root signature verified
+#define BOOT_STATS_DICTIONARY 0x20  // zstd blocks used the shared dictionary
+#define BOOT_STATS_WORKERS 0x40     // Worker cores decoded some blocks
+#define BOOT_STATS_PLANNED 0x80     // Loaded from a baked elf_plan.h plan
+
+struct boot_stats_image
+{
+    char name[BOOT_STATS_NAME_SIZE];
+    uint64_t start;                 // XTime when loading began and ended
+    uint64_t end;
+    uint64_t bytes_read;            // From the boot medium
+    uint64_t bytes_elided;          // Fill blocks that were never read
+    uint64_t bytes_loaded;          // Written to memory, bss excluded
+    uint64_t read_ticks;            // Spent in reads by the booting core
+    uint64_t decode_ticks;          // Summed over every decoding core
+    uint64_t decrypt_ticks;
+    uint64_t verify_ticks;          // Software hashing, summed over cores
+    uint64_t stall_ticks;           // Booting core waiting on the CSU SHA3 engine
+    uint32_t blocks;
+    uint32_t worker_blocks;
+    uint32_t retries;               // Reads retried after an error
+    uint32_t flags;                 // BOOT_STATS_* fast paths taken
+};
+
+struct boot_stats
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t size;                  // sizeof(struct boot_stats)
+    uint32_t counts_per_second;
+    uint32_t num_images;
+    uint64_t stages[BOOT_NUM_STAGES];   // XTime per BOOT_STAGE_*, 0 if not reached
+    struct boot_stats_image images[BOOT_STATS_MAX_IMAGES];
+};
+
+// Clears the record and timestamps BOOT_STAGE_MAIN; call first thing in main()
+void boot_stats_init(void);
+
+// Timestamps a BOOT_STAGE_*
+void boot_stats_stage(uint32_t stage);
+
+// Starts the record of a new image, or returns NULL if the table is full
+struct boot_stats_image *boot_stats_image(const char *name);
+
+// Image being loaded, or NULL
+struct boot_stats_image *boot_stats_current(void);
+
+// Timestamps the end of the current image
+void boot_stats_image_done(void);
+
+// Timestamps the end of an image that may no longer be the current one, for images
+// loaded in the background
+void boot_stats_image_end(struct boot_stats_image *image);
+
+// Timestamps BOOT_STAGE_HANDOFF, flushes the record and publishes its address
+void boot_stats_publish(void);
+
+#endif
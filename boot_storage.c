@@ -0,0 +1,287 @@
+/*
+ * Description: Boot media under the image loaders (see boot_storage.h).
+ */
+
+// Standard Libraries
+#include "stdint.h"
+#include "string.h"
+
+// Xilinx Libraries
+#include "ff.h"
+#include <xil_printf.h> // Include Debug IO
+
+// Addtional Libraries
+#include "boot_storage.h"
+#include "boot_sched.h"
+#include "boot_qspi.h"
+#include "boot_emmc.h"
+#include "boot_stripe.h"
+#include "sd_async.h"
+#include "bootpack.h"
+
+static int32_t boot_sd_open(struct boot_file *file, const char *name)
+{
+    // FatFs must not run under a background read
+    sd_async_wait();
+    if (f_open(&file->fil, name, FA_READ) != FR_OK)
+    {
+        return -1;
+    }
+    file->size = f_size(&file->fil);
+    file->base = 0;
+
+    return 0;
+}
+
+static int32_t boot_sd_read(struct boot_file *file, uint64_t offset, void *dst, uint32_t size, int32_t *status)
+{
+    return sd_async_read(&file->fil, (uint32_t)offset, dst, size, status);
+}
+
+// Closing a file opened for reading does not touch the card, so it may run under
+// another image's read, and in a step
+static void boot_sd_close(struct boot_file *file)
+{
+    f_close(&file->fil);
+}
+
+static const struct boot_storage bootSd = { "SD", boot_sd_open, boot_sd_read, sd_async_busy, boot_sd_close };
+
+// Tried in order by boot_open()
+static const struct boot_storage *const bootMedia[] =
+{
+#if BOOT_STORAGE_QSPI
+    &bootQspi,
+#endif
+#if BOOT_STORAGE_EMMC
+    &bootEmmc,
+#endif
+    &bootSd,
+};
+
+#define BOOT_NUM_MEDIA (sizeof(bootMedia) / sizeof(bootMedia[0]))
+
+#if BOOT_STORAGE_STRIPE
+// Finds the other part of a striped image on a medium after the first part's and opens
+// the two as one image
+static int32_t boot_open_stripe(struct boot_file *file, const char *name, uint32_t first,
+    const struct boot_stripe_header *header)
+{
+    struct boot_file other;
+    struct boot_stripe_header otherHeader;
+    struct boot_file *parts[BOOT_STRIPE_PARTS];
+
+    for (uint32_t i = first + 1; i < BOOT_NUM_MEDIA && header->index < BOOT_STRIPE_PARTS; i++)
+    {
+        if (bootMedia[i]->open(&other, name) != 0)
+        {
+            continue;
+        }
+        other.storage = bootMedia[i];
+        if (boot_stripe_probe(&other, &otherHeader) == 0 && otherHeader.index != header->index &&
+            otherHeader.index < BOOT_STRIPE_PARTS &&
+            otherHeader.unit == header->unit && otherHeader.size == header->size &&
+            memcmp(otherHeader.id, header->id, BOOT_STRIPE_ID_SIZE) == 0)
+        {
+            parts[header->index] = file;
+            parts[otherHeader.index] = &other;
+            if (boot_stripe_open(file, parts, header) == 0)
+            {
+                xil_printf("%s is striped over %s and %s\r\n", name, bootMedia[first]->name, bootMedia[i]->name);
+                return 0;
+            }
+        }
+        boot_close(&other);
+    }
+
+    xil_printf("No matching second part of striped image %s\r\n", name);
+    return -1;
+}
+#endif
+
+#if BOOT_STORAGE_CACHE
+static int8_t bootCacheFlagged = -1;
+
+// Swaps a card image for its QSPI copy when the cache holds one. Only hashed boot pack
+// containers carry a key covering all of their data.
+static void boot_cache_lookup(struct boot_file *file)
+{
+    struct bpk_header header;
+    struct boot_file cached;
+
+    if (file->size < sizeof(header) || boot_read_now(file, 0, &header, sizeof(header)) != 0 ||
+        !bpk_is_container(&header) || header.hash_offset == 0)
+    {
+        return;
+    }
+    memcpy(file->key, header.root, sizeof(file->key));
+
+    if (boot_qspi_find(&cached, file->key, file->size) != 0)
+    {
+        file->cache_miss = 1;
+        return;
+    }
+    memcpy(cached.key, file->key, sizeof(cached.key));
+    cached.cache_miss = 0;
+    cached.cached = 1;
+    cached.stripe = NULL;
+    boot_close(file);
+    *file = cached;
+}
+
+// Whether the card asks for this boot to fill the cache; looked up once
+static uint8_t boot_cache_flagged(void)
+{
+    FIL flag;
+
+    if (bootCacheFlagged < 0)
+    {
+        sd_async_wait();
+        bootCacheFlagged = (f_open(&flag, BOOT_STORAGE_CACHE_FLAG, FA_READ) == FR_OK);
+        if (bootCacheFlagged)
+        {
+            f_close(&flag);
+            xil_printf("Storing images missing from the QSPI cache\r\n");
+        }
+    }
+
+    return (uint8_t)bootCacheFlagged;
+}
+#endif
+
+int32_t boot_open(struct boot_file *file, const char *name)
+{
+    memset(file->key, 0, sizeof(file->key));
+    file->cache_miss = 0;
+    file->cached = 0;
+    file->stripe = NULL;
+
+    for (uint32_t i = 0; i < BOOT_NUM_MEDIA; i++)
+    {
+        if (bootMedia[i]->open(file, name) == 0)
+        {
+            file->storage = bootMedia[i];
+#if BOOT_STORAGE_STRIPE
+            struct boot_stripe_header stripe;
+            if (boot_stripe_probe(file, &stripe) == 0 && boot_open_stripe(file, name, i, &stripe) != 0)
+            {
+                boot_close(file);
+                return -1;
+            }
+#endif
+#if BOOT_STORAGE_CACHE
+            if (file->storage == &bootSd)
+            {
+                boot_cache_lookup(file);
+            }
+#endif
+            xil_printf("Reading %s from %s (%llu bytes)\r\n", name, file->storage->name, file->size);
+            return 0;
+        }
+    }
+
+    file->storage = NULL;
+    return -1;
+}
+
+int32_t boot_read(struct boot_file *file, uint64_t offset, void *dst, uint32_t size, int32_t *status)
+{
+    while (file->storage->busy())
+    {
+        boot_sched_yield();
+    }
+
+    return file->storage->read(file, offset, dst, size, status);
+}
+
+int32_t boot_read_now(struct boot_file *file, uint64_t offset, void *dst, uint32_t size)
+{
+    int32_t status;
+
+    if (boot_read(file, offset, dst, size, &status) != 0)
+    {
+        return -1;
+    }
+    while (status == BOOT_TASK_RUNNING)
+    {
+        boot_sched_yield();
+    }
+
+    return status;
+}
+
+int32_t boot_busy(const struct boot_file *file)
+{
+    return file->storage->busy();
+}
+
+void boot_close(struct boot_file *file)
+{
+    if (file->storage != NULL)
+    {
+        file->storage->close(file);
+        file->storage = NULL;
+    }
+}
+
+int32_t boot_cache_fallback(struct boot_file *file, const char *name)
+{
+#if BOOT_STORAGE_CACHE
+    uint8_t key[BOOT_QSPI_KEY_SIZE];
+
+    if (!file->cached)
+    {
+        return -1;
+    }
+    xil_printf("Cached copy of %s is bad, dropping it and reading the card\r\n", name);
+    memcpy(key, file->key, sizeof(key));
+    boot_close(file);
+    boot_qspi_forget(key);
+
+    // The card image goes back into the cache if this boot is flagged to fill it
+    if (boot_sd_open(file, name) != 0)
+    {
+        return -1;
+    }
+    file->storage = &bootSd;
+    memcpy(file->key, key, sizeof(file->key));
+    file->cache_miss = 1;
+    file->cached = 0;
+    xil_printf("Reading %s from %s (%llu bytes)\r\n", name, file->storage->name, file->size);
+
+    return 0;
+#else
+    (void)file;
+    (void)name;
+
+    return -1;
+#endif
+}
+
+void boot_cache_update(struct boot_file *file, const char *name)
+{
+#if BOOT_STORAGE_CACHE
+    struct boot_file source;
+
+    if (!file->cache_miss || !boot_cache_flagged())
+    {
+        return;
+    }
+    file->cache_miss = 0;
+
+    // Copied from the card again; the loaded image is no longer laid out as the file
+    if (boot_sd_open(&source, name) != 0)
+    {
+        return;
+    }
+    source.storage = &bootSd;
+    if (source.size == file->size)
+    {
+        boot_qspi_store(name, file->key, &source);
+    }
+    boot_close(&source);
+#else
+    (void)file;
+    (void)name;
+#endif
+}
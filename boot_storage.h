@@ -0,0 +1,111 @@
+/*
+ * Description: Boot media under the image loaders. Each medium opens images by name
+ * and reads byte ranges of them straight into place, possibly in the background; the
+ * loaders only go through boot_open() and boot_read(). boot_open() tries the media
+ * built in, in order, and the image is read from the first one holding it: QSPI
+ * (boot_qspi.h) when BOOT_STORAGE_QSPI is set, eMMC (boot_emmc.h) when
+ * BOOT_STORAGE_EMMC is set, then the SD card through FatFs and sd_async.h. Each medium
+ * has at most one read in flight; reads on different media run at the same time. With
+ * BOOT_STORAGE_STRIPE an image found on one medium may be one part of an image striped
+ * across two (boot_stripe.h), and is read from both.
+ *
+ * With BOOT_STORAGE_CACHE the QSPI partition caches the SD card, which stays the source
+ * of the images. An image opened on the card is read from QSPI instead when the
+ * partition holds one keyed by the hash tree root in its boot pack header, which costs
+ * a header read from the card. Other images are always read from the card. When the
+ * card holds BOOT_STORAGE_CACHE_FLAG, images that missed are programmed into QSPI once
+ * they have loaded (boot_cache_update()), so the next boot reads them from flash. A
+ * cached copy that fails to load is dropped from the cache and the card image loaded in
+ * its place (boot_cache_fallback()).
+ */
+
+#ifndef BOOT_STORAGE_H
+#define BOOT_STORAGE_H
+
+#include "stdint.h"
+#include "ff.h"
+#include "boot_qspi.h"
+
+// Look for images in the QSPI image partition before the SD card
+#ifndef BOOT_STORAGE_QSPI
+#define BOOT_STORAGE_QSPI 0
+#endif
+
+// Look for images on the eMMC before the SD card
+#ifndef BOOT_STORAGE_EMMC
+#define BOOT_STORAGE_EMMC 0
+#endif
+
+// Read images striped across two media from both
+#ifndef BOOT_STORAGE_STRIPE
+#define BOOT_STORAGE_STRIPE 0
+#endif
+
+// Read SD images from their copy in the QSPI partition when it holds one
+#ifndef BOOT_STORAGE_CACHE
+#define BOOT_STORAGE_CACHE 0
+#endif
+
+// File on the card that asks for missed images to be stored in QSPI
+#ifndef BOOT_STORAGE_CACHE_FLAG
+#define BOOT_STORAGE_CACHE_FLAG "cache.upd"
+#endif
+
+struct boot_file;
+struct boot_stripe_set;
+
+struct boot_storage
+{
+    const char *name;
+
+    // Finds an image; returns -1 if the medium does not hold it
+    int32_t (*open)(struct boot_file *file, const char *name);
+
+    // Starts reading; *status as for sd_async_read(). Called only while not busy.
+    int32_t (*read)(struct boot_file *file, uint64_t offset, void *dst, uint32_t size, int32_t *status);
+
+    // Whether a read is still in flight; steps it like sd_async_busy()
+    int32_t (*busy)(void);
+
+    // Must not wait for the medium; loads close their image inside a step
+    void (*close)(struct boot_file *file);
+};
+
+// Image open on one medium
+struct boot_file
+{
+    const struct boot_storage *storage;
+    uint64_t size;
+    uint64_t base;                  // Start of the image on raw media
+    FIL fil;                        // Open file on the SD card
+    struct boot_stripe_set *stripe; // Parts of a striped image
+    uint8_t key[BOOT_QSPI_KEY_SIZE];    // Cache key of a card image, all zero if none
+    uint8_t cache_miss;             // Keyed card image missing from the cache
+    uint8_t cached;                 // QSPI copy of a card image, opened in its place
+};
+
+// Opens an image on the first medium holding it
+int32_t boot_open(struct boot_file *file, const char *name);
+
+// Starts reading size bytes at offset into dst once the medium is free. Not for use
+// inside a step unless boot_busy() has just returned 0.
+int32_t boot_read(struct boot_file *file, uint64_t offset, void *dst, uint32_t size, int32_t *status);
+
+// Reads and waits for the data, stepping other work meanwhile; returns 0 or -1
+int32_t boot_read_now(struct boot_file *file, uint64_t offset, void *dst, uint32_t size);
+
+// Whether the image's medium has a read in flight
+int32_t boot_busy(const struct boot_file *file);
+
+void boot_close(struct boot_file *file);
+
+// Drops a cached copy that failed to load from the cache and opens the card image in
+// its place. Returns -1 if file is not a cached copy, which leaves it as it was, or if
+// the card image cannot be opened, which leaves it closed.
+int32_t boot_cache_fallback(struct boot_file *file, const char *name);
+
+// Stores an image that missed the cache in QSPI if this boot is flagged for it; call
+// once the image has loaded and been closed
+void boot_cache_update(struct boot_file *file, const char *name);
+
+#endif
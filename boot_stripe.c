@@ -0,0 +1,230 @@
+/*
+ * Description: Images striped across two boot media (see boot_stripe.h).
+ */
+
+// Standard Libraries
+#include "stdint.h"
+#include "string.h"
+
+// Xilinx Libraries
+#include <xil_printf.h> // Include Debug IO
+
+// Addtional Libraries
+#include "boot_stripe.h"
+#include "boot_storage.h"
+#include "boot_sched.h"
+
+#if BOOT_STORAGE_STRIPE
+
+struct boot_stripe_set
+{
+    struct boot_file parts[BOOT_STRIPE_PARTS];
+    uint32_t unit;
+    uint8_t used;
+};
+
+static int32_t stripe_step(struct boot_task *task);
+static struct boot_task stripeTask = { "Stripe read", stripe_step, NULL, 0, 0, NULL };
+
+static struct boot_stripe_set stripeSets[BOOT_STRIPE_MAX_FILES];
+
+// Read in flight: the range, and for each part the image offset it reads next
+static struct boot_stripe_set *stripeSet;
+static int32_t *stripeResult;
+static int32_t stripeReadStatus;
+static uint8_t *stripeDst;
+static uint64_t stripeOffset;
+static uint64_t stripeEnd;
+static uint64_t stripeNext[BOOT_STRIPE_PARTS];
+static int32_t stripeStatus[BOOT_STRIPE_PARTS];
+
+// Bytes a part holds, header included
+static uint64_t stripe_part_size(uint64_t size, uint32_t unit, uint32_t index)
+{
+    uint64_t units = size / unit;
+    uint64_t bytes = (units + BOOT_STRIPE_PARTS - 1 - index) / BOOT_STRIPE_PARTS * unit;
+
+    if (units % BOOT_STRIPE_PARTS == index)
+    {
+        bytes += size % unit;
+    }
+
+    return BOOT_STRIPE_HEADER_SIZE + bytes;
+}
+
+int32_t boot_stripe_probe(struct boot_file *part, struct boot_stripe_header *header)
+{
+    if (part->size < BOOT_STRIPE_HEADER_SIZE || boot_read_now(part, 0, header, sizeof(*header)) != 0 ||
+        memcmp(header->magic, BOOT_STRIPE_MAGIC, 4) != 0)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+int32_t boot_stripe_open(struct boot_file *file, struct boot_file *const parts[BOOT_STRIPE_PARTS],
+    const struct boot_stripe_header *header)
+{
+    struct boot_stripe_set *set = NULL;
+
+    if (header->version != BOOT_STRIPE_VERSION || header->count != BOOT_STRIPE_PARTS || header->unit == 0 ||
+        header->unit % BOOT_STRIPE_UNIT_ALIGN != 0)
+    {
+        xil_printf("Unsupported striped image, version %u\r\n", header->version);
+        return -1;
+    }
+    for (uint32_t i = 0; i < BOOT_STRIPE_PARTS; i++)
+    {
+        if (parts[i]->size < stripe_part_size(header->size, header->unit, i))
+        {
+            xil_printf("Part %u of striped image on %s is truncated\r\n", i, parts[i]->storage->name);
+            return -1;
+        }
+    }
+
+    for (uint32_t i = 0; i < BOOT_STRIPE_MAX_FILES; i++)
+    {
+        if (!stripeSets[i].used)
+        {
+            set = &stripeSets[i];
+            break;
+        }
+    }
+    if (set == NULL)
+    {
+        xil_printf("More than %u striped images open\r\n", BOOT_STRIPE_MAX_FILES);
+        return -1;
+    }
+
+    // file may be one of the parts, so it is taken over last
+    for (uint32_t i = 0; i < BOOT_STRIPE_PARTS; i++)
+    {
+        set->parts[i] = *parts[i];
+    }
+    set->unit = header->unit;
+    set->used = 1;
+    file->storage = &bootStripe;
+    file->stripe = set;
+    file->size = header->size;
+    file->base = 0;
+
+    return 0;
+}
+
+static int32_t stripe_open(struct boot_file *file, const char *name)
+{
+    // Opened through boot_stripe_open() once both parts are found
+    (void)file;
+    (void)name;
+
+    return -1;
+}
+
+// Starts the next unit on every part whose medium is free; returns 1 once both parts
+// have finished
+static int32_t stripe_advance(void)
+{
+    uint32_t unit = stripeSet->unit;
+    int32_t done = 1;
+
+    for (uint32_t i = 0; i < BOOT_STRIPE_PARTS; i++)
+    {
+        struct boot_file *part = &stripeSet->parts[i];
+        uint64_t position = stripeNext[i];
+
+        if (stripeStatus[i] == BOOT_TASK_RUNNING)
+        {
+            done = 0;
+            continue;
+        }
+        if (stripeStatus[i] < 0)
+        {
+            stripeReadStatus = -1;
+        }
+        if (position >= stripeEnd || stripeReadStatus != 0)
+        {
+            continue;
+        }
+        done = 0;
+
+        // Still busy with another image's read
+        if (boot_busy(part))
+        {
+            continue;
+        }
+
+        uint64_t unitEnd = (position / unit + 1) * unit;
+        uint32_t length = (uint32_t)(((unitEnd < stripeEnd) ? unitEnd : stripeEnd) - position);
+        uint64_t partOffset = BOOT_STRIPE_HEADER_SIZE + position / unit / BOOT_STRIPE_PARTS * unit + position % unit;
+
+        stripeNext[i] = unitEnd + (uint64_t)(BOOT_STRIPE_PARTS - 1) * unit;
+        if (boot_read(part, partOffset, stripeDst + (position - stripeOffset), length, &stripeStatus[i]) != 0)
+        {
+            stripeStatus[i] = -1;
+        }
+    }
+
+    return done;
+}
+
+static int32_t stripe_step(struct boot_task *task)
+{
+    BOOT_TASK_BEGIN(task);
+    BOOT_TASK_WAIT_UNTIL(task, stripe_advance());
+    *stripeResult = stripeReadStatus;
+    BOOT_TASK_END(task);
+}
+
+static int32_t stripe_read(struct boot_file *file, uint64_t offset, void *dst, uint32_t size, int32_t *status)
+{
+    uint32_t unit = file->stripe->unit;
+    uint64_t first = offset / unit;
+
+    if (offset + size > file->size)
+    {
+        *status = -1;
+        return -1;
+    }
+
+    // Each part starts at its first unit in the range
+    for (uint32_t i = 0; i < BOOT_STRIPE_PARTS; i++)
+    {
+        uint32_t skip = (uint32_t)((i + BOOT_STRIPE_PARTS - first % BOOT_STRIPE_PARTS) % BOOT_STRIPE_PARTS);
+
+        stripeNext[i] = (skip == 0) ? offset : (first + skip) * unit;
+        stripeStatus[i] = 0;
+    }
+    stripeSet = file->stripe;
+    stripeDst = dst;
+    stripeOffset = offset;
+    stripeEnd = offset + size;
+    stripeReadStatus = 0;
+    stripeResult = status;
+    *status = BOOT_TASK_RUNNING;
+
+    boot_sched_start(&stripeTask);
+    boot_sched_yield();
+    return 0;
+}
+
+static int32_t stripe_busy(void)
+{
+    boot_sched_yield();
+
+    return boot_sched_running(&stripeTask);
+}
+
+static void stripe_close(struct boot_file *file)
+{
+    for (uint32_t i = 0; i < BOOT_STRIPE_PARTS; i++)
+    {
+        boot_close(&file->stripe->parts[i]);
+    }
+    file->stripe->used = 0;
+    file->stripe = NULL;
+}
+
+const struct boot_storage bootStripe = { "striped", stripe_open, stripe_read, stripe_busy, stripe_close };
+
+#endif
@@ -0,0 +1,62 @@
+/*
+ * Description: Images striped across two boot media (see boot_storage.h). The image is
+ * cut into units of a fixed size and every other unit goes to the second part, so each
+ * part holds about half of the image behind a short header, under the image's own name
+ * on its medium. boot_open() finds the part on the first medium holding the name,
+ * then the other part on a later medium, and the loaders read the pair as one image.
+ * Each read is split at the unit boundaries and both media transfer their units
+ * straight into place at the same time, one read in flight on each, as a boot_sched.h
+ * task; the read completes once both parts have. A read spanning several units then
+ * takes about half as long as from one medium of the same speed.
+ *
+ * tools/bootpack.c writes boot pack containers in two parts with -p. Units are whole
+ * blocks and the header is a whole number of them, so every byte keeps its block and
+ * cache line offset and the media read it with DMA wherever they would read the image.
+ */
+
+#ifndef BOOT_STRIPE_H
+#define BOOT_STRIPE_H
+
+#include "stdint.h"
+
+struct boot_file;
+struct boot_storage;
+
+// Striped images open at the same time
+#ifndef BOOT_STRIPE_MAX_FILES
+#define BOOT_STRIPE_MAX_FILES 2
+#endif
+
+// Part layout, shared with tools/bootpack.c
+#define BOOT_STRIPE_MAGIC "BSTR"
+#define BOOT_STRIPE_VERSION 1
+#define BOOT_STRIPE_PARTS 2
+#define BOOT_STRIPE_HEADER_SIZE 4096U   // Part data starts here
+#define BOOT_STRIPE_UNIT_ALIGN 512U
+#define BOOT_STRIPE_ID_SIZE 16
+
+// Start of each part; unit n of the image is unit n / 2 of part n % 2
+struct boot_stripe_header
+{
+    char magic[4];
+    uint16_t version;
+    uint8_t index;                  // Part number
+    uint8_t count;                  // Parts of the image
+    uint32_t unit;                  // Bytes per unit, a multiple of BOOT_STRIPE_UNIT_ALIGN
+    uint32_t reserved;
+    uint64_t size;                  // Bytes of the whole image
+    uint8_t id[BOOT_STRIPE_ID_SIZE];    // The same in every part of one image
+};
+
+// Medium of a striped image; boot_open() opens it through its parts
+extern const struct boot_storage bootStripe;
+
+// Reads the header of an image just opened; returns 0 if it is a part of a striped image
+int32_t boot_stripe_probe(struct boot_file *part, struct boot_stripe_header *header);
+
+// Opens the image made of parts[], indexed by part number, into file, which then owns
+// them. file may be one of the parts. Returns -1 if they do not make up the image.
+int32_t boot_stripe_open(struct boot_file *file, struct boot_file *const parts[BOOT_STRIPE_PARTS],
+    const struct boot_stripe_header *header);
+
+#endif
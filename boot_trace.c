@@ -0,0 +1,97 @@
+/*
+ * Description: Boot timeline trace (see boot_trace.h).
+ */
+
+// Standard Libraries
+#include "stdint.h"
+#include "string.h"
+
+// Xilinx Libraries
+#include "xil_cache.h"
+#include "xtime_l.h"
+#include <xil_printf.h>
+
+// Addtional Libraries
+#include "boot_trace.h"
+
+#if BOOT_TRACE
+
+#define BOOT_TRACE_RING ((struct boot_trace *)(uintptr_t)BOOT_TRACE_ADDR)
+#define BOOT_TRACE_CAPACITY ((BOOT_TRACE_SIZE - sizeof(struct boot_trace)) / sizeof(struct boot_trace_event))
+#define BOOT_TRACE_LINE_BYTES 32
+
+static uint8_t boot_trace_core(void)
+{
+    uint64_t mpidr = 0;
+
+#if defined(__aarch64__)
+    asm volatile("mrs %0, mpidr_el1" : "=r" (mpidr));
+#elif defined(__arm__)
+    uint32_t value;
+    asm volatile("mrc p15, 0, %0, c0, c0, 5" : "=r" (value));
+    mpidr = value;
+#endif
+
+    return (uint8_t)(mpidr & 0xFF);
+}
+
+void boot_trace_init(void)
+{
+    struct boot_trace *trace = BOOT_TRACE_RING;
+
+    memset(trace, 0, sizeof(*trace));
+    memcpy(trace->magic, BOOT_TRACE_MAGIC, sizeof(trace->magic));
+    trace->version = BOOT_TRACE_VERSION;
+    trace->event_size = sizeof(struct boot_trace_event);
+    trace->counts_per_second = COUNTS_PER_SECOND;
+    trace->capacity = BOOT_TRACE_CAPACITY;
+#if defined(__aarch64__)
+    trace->cluster = BOOT_TRACE_APU;
+#else
+    trace->cluster = BOOT_TRACE_RPU;
+#endif
+    Xil_DCacheFlushRange((UINTPTR)trace, sizeof(*trace));
+}
+
+void boot_trace_event(uint8_t id, uint8_t phase, uint32_t arg)
+{
+    struct boot_trace *trace = BOOT_TRACE_RING;
+    uint32_t number = __atomic_fetch_add(&trace->count, 1, __ATOMIC_RELAXED);
+    struct boot_trace_event *event = &trace->events[number % BOOT_TRACE_CAPACITY];
+    XTime now;
+
+    XTime_GetTime(&now);
+    event->time = now;
+    event->arg = arg;
+    event->id = id;
+    event->core = boot_trace_core();
+    event->phase = phase;
+    event->reserved = 0;
+}
+
+void boot_trace_dump(void)
+{
+    struct boot_trace *trace = BOOT_TRACE_RING;
+    uint32_t events = (trace->count < trace->capacity) ? trace->count : trace->capacity;
+    uint32_t size = sizeof(*trace) + events * sizeof(struct boot_trace_event);
+
+    Xil_DCacheFlushRange((UINTPTR)trace, size);
+    xil_printf("Boot trace: %u event(s) at 0x%08x%s\r\n", trace->count, (uint32_t)BOOT_TRACE_ADDR,
+        (trace->count > trace->capacity) ? ", oldest overwritten" : "");
+
+#if BOOT_TRACE_DUMP
+    const uint8_t *bytes = (const uint8_t *)trace;
+
+    for (uint32_t i = 0; i < size; i += BOOT_TRACE_LINE_BYTES)
+    {
+        xil_printf(BOOT_TRACE_LINE_PREFIX);
+        for (uint32_t j = i; j < i + BOOT_TRACE_LINE_BYTES && j < size; j++)
+        {
+            xil_printf("%02x", bytes[j]);
+        }
+        xil_printf("\r\n");
+    }
+#endif
+}
+
+#endif
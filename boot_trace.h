@@ -0,0 +1,106 @@
+/*
+ * Description: Boot timeline trace. Every core taking part in the boot appends begin,
+ * end and instant events (SD reads, copies, decoding, hashing, cache flushes, zeroing,
+ * core release) to a ring buffer in reserved OCM, stamped with raw XTime counts. The
+ * buffer is read back by JTAG from memory, or printed over the UART before handoff with
+ * BOOT_TRACE_DUMP, and tools/boottrace.c turns either into a Chrome trace-event JSON
+ * file with one lane per core for chrome://tracing or Perfetto.
+ */
+
+#ifndef BOOT_TRACE_H
+#define BOOT_TRACE_H
+
+#include "stdint.h"
+
+// Record events at all; with 0 every call compiles away
+#ifndef BOOT_TRACE
+#define BOOT_TRACE 1
+#endif
+
+// Print the buffer over the UART before handoff (about 3 s for a full buffer at 115200 baud)
+#ifndef BOOT_TRACE_DUMP
+#define BOOT_TRACE_DUMP 0
+#endif
+
+// Reserved region between the staging area and the boot statistics record
+#ifndef BOOT_TRACE_ADDR
+#define BOOT_TRACE_ADDR 0xFFFE4000U
+#endif
+#ifndef BOOT_TRACE_SIZE
+#define BOOT_TRACE_SIZE 0x4000U
+#endif
+
+#define BOOT_TRACE_MAGIC "BTRC"
+#define BOOT_TRACE_VERSION 1
+
+// Prefix of the UART dump lines picked up by tools/boottrace
+#define BOOT_TRACE_LINE_PREFIX "#BT "
+
+// Events; arg is noted per event
+#define BOOT_TRACE_IMAGE 0          // Loading one image; image number
+#define BOOT_TRACE_SD_READ 1        // Read from the boot medium; bytes
+#define BOOT_TRACE_COPY 2           // Copy from a bounce buffer; bytes
+#define BOOT_TRACE_DECRYPT 3        // AES-GCM block; block number
+#define BOOT_TRACE_DECODE 4         // Decompress or fill block; block number
+#define BOOT_TRACE_HASH 5           // Software SHA3 leaf check; block number
+#define BOOT_TRACE_CSU_WAIT 6       // Booting core waiting on the CSU SHA3 engine
+#define BOOT_TRACE_FLUSH 7          // Data cache flush; bytes
+#define BOOT_TRACE_ZERO 8           // Clearing bss; bytes
+#define BOOT_TRACE_VERIFY 9         // Deferred verification; blocks
+#define BOOT_TRACE_RELEASE 10       // Core released from reset; core mask or entry point
+#define BOOT_TRACE_NUM_EVENTS 11
+
+// Event phases, matching the Chrome trace-event "ph" field
+#define BOOT_TRACE_BEGIN 'B'
+#define BOOT_TRACE_END 'E'
+#define BOOT_TRACE_INSTANT 'i'
+
+// Cluster the trace was recorded on
+#define BOOT_TRACE_APU 0
+#define BOOT_TRACE_RPU 1
+
+struct boot_trace_event
+{
+    uint64_t time;                  // XTime
+    uint32_t arg;
+    uint8_t id;                     // BOOT_TRACE_* event
+    uint8_t core;                   // MPIDR affinity level 0
+    uint8_t phase;                  // BOOT_TRACE_BEGIN, _END or _INSTANT
+    uint8_t reserved;
+};
+
+struct boot_trace
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t event_size;            // sizeof(struct boot_trace_event)
+    uint32_t counts_per_second;
+    uint32_t capacity;              // Events the ring holds
+    volatile uint32_t count;        // Events written; once past capacity the oldest are overwritten
+    uint32_t cluster;               // BOOT_TRACE_APU or BOOT_TRACE_RPU
+    uint32_t reserved[2];
+    struct boot_trace_event events[];
+};
+
+#if BOOT_TRACE
+// Clears the ring; call once before any core records events
+void boot_trace_init(void);
+
+// Appends an event from the calling core; safe to call from any core
+void boot_trace_event(uint8_t id, uint8_t phase, uint32_t arg);
+
+// Flushes the ring to memory and, with BOOT_TRACE_DUMP, prints it over the UART
+void boot_trace_dump(void);
+
+#define boot_trace_begin(id, arg) boot_trace_event((id), BOOT_TRACE_BEGIN, (arg))
+#define boot_trace_end(id, arg) boot_trace_event((id), BOOT_TRACE_END, (arg))
+#define boot_trace_mark(id, arg) boot_trace_event((id), BOOT_TRACE_INSTANT, (arg))
+#else
+#define boot_trace_init() do { } while (0)
+#define boot_trace_dump() do { } while (0)
+#define boot_trace_begin(id, arg) do { } while (0)
+#define boot_trace_end(id, arg) do { } while (0)
+#define boot_trace_mark(id, arg) do { } while (0)
+#endif
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ * Description: Background bss clearing (see boot_zero.h).
+ */
+
+// Standard Libraries
+#include "stdint.h"
+#include "string.h"
+
+// Xilinx Libraries
+#include "xil_cache.h"  // Include cache management functions
+#include <xil_printf.h> // Include Debug IO
+
+// Addtional Libraries
+#include "boot_zero.h"
+#include "boot_sched.h"
+#include "zdma.h"
+
+// FPD DMA channel doing the clearing; channel 0 belongs to the DDR ECC fill
+#ifndef BOOT_ZERO_ZDMA_BASE
+#define BOOT_ZERO_ZDMA_BASE ZDMA_GDMA_CH(1)
+#endif
+
+// DMA runs start and end on whole cache lines of either processor
+#define BOOT_ZERO_LINE 64U
+
+// The R5's TCM at the bottom of its map is not where the DMA would write
+#if defined(__aarch64__)
+#define BOOT_ZERO_DMA_START 0x0ULL
+#else
+#define BOOT_ZERO_DMA_START 0x40000ULL
+#endif
+
+struct boot_zero_run
+{
+    uint64_t start;
+    uint64_t end;
+};
+
+// Ring of runs; the task clears the first one
+static struct boot_zero_run zeroQueue[BOOT_ZERO_QUEUE_SIZE];
+static uint32_t zeroHead;
+static uint32_t zeroCount;
+static struct boot_zero_run zeroPiece;      // Part of the first run in flight
+static int32_t zeroStatus;
+static uint8_t zeroReady = 0;
+
+static int32_t boot_zero_step(struct boot_task *task);
+static struct boot_task zeroTask = { "bss clearing", boot_zero_step, NULL, 0, 0, NULL };
+
+// Works through the queue a transfer at a time
+static int32_t boot_zero_step(struct boot_task *task)
+{
+    BOOT_TASK_BEGIN(task);
+    while (zeroCount != 0)
+    {
+        // Runs larger than one transfer go in pieces
+        while (zeroQueue[zeroHead].start != zeroQueue[zeroHead].end)
+        {
+            zeroPiece.start = zeroQueue[zeroHead].start;
+            zeroPiece.end = zeroQueue[zeroHead].end;
+            if (zeroPiece.end - zeroPiece.start > ZDMA_MAX_TRANSFER)
+            {
+                zeroPiece.end = zeroPiece.start + ZDMA_MAX_TRANSFER;
+            }
+            zdma_fill_start(BOOT_ZERO_ZDMA_BASE, zeroPiece.start, (uint32_t)(zeroPiece.end - zeroPiece.start));
+            zeroQueue[zeroHead].start = zeroPiece.end;
+
+            BOOT_TASK_WAIT_UNTIL(task, (zeroStatus = zdma_fill_done(BOOT_ZERO_ZDMA_BASE)) != 0);
+            if (zeroStatus < 0)
+            {
+                // Still has to be zero; do it here
+                xil_printf("DMA clearing of 0x%llx-0x%llx failed\r\n", zeroPiece.start, zeroPiece.end);
+                memset((void *)(uintptr_t)zeroPiece.start, 0, (size_t)(zeroPiece.end - zeroPiece.start));
+                Xil_DCacheFlushRange((UINTPTR)zeroPiece.start, zeroPiece.end - zeroPiece.start);
+            }
+        }
+        zeroHead = (zeroHead + 1) % BOOT_ZERO_QUEUE_SIZE;
+        zeroCount--;
+    }
+    BOOT_TASK_END(task);
+}
+
+void boot_zero(uint64_t start, uint64_t size)
+{
+    uint64_t head = (start + BOOT_ZERO_LINE - 1) & ~(uint64_t)(BOOT_ZERO_LINE - 1);
+    uint64_t tail = (start + size) & ~(uint64_t)(BOOT_ZERO_LINE - 1);
+
+    if (!BOOT_ZERO_DMA || size < BOOT_ZERO_DMA_MIN || start < BOOT_ZERO_DMA_START || tail <= head)
+    {
+        memset((void *)(uintptr_t)start, 0, (size_t)size);
+        Xil_DCacheFlushRange((UINTPTR)start, size);
+        return;
+    }
+
+    if (!zeroReady)
+    {
+        zdma_fill_init(BOOT_ZERO_ZDMA_BASE);
+        zeroReady = 1;
+    }
+
+    // The core clears the partial lines, the DMA everything between them
+    memset((void *)(uintptr_t)start, 0, (size_t)(head - start));
+    memset((void *)(uintptr_t)tail, 0, (size_t)(start + size - tail));
+    Xil_DCacheFlushRange((UINTPTR)start, head - start);
+    Xil_DCacheFlushRange((UINTPTR)tail, start + size - tail);
+
+    // Callers may be tasks themselves and cannot wait for room; clear it here instead
+    if (zeroCount == BOOT_ZERO_QUEUE_SIZE)
+    {
+        memset((void *)(uintptr_t)head, 0, (size_t)(tail - head));
+        Xil_DCacheFlushRange((UINTPTR)head, tail - head);
+        return;
+    }
+    Xil_DCacheInvalidateRange((UINTPTR)head, tail - head);
+    zeroQueue[(zeroHead + zeroCount) % BOOT_ZERO_QUEUE_SIZE].start = head;
+    zeroQueue[(zeroHead + zeroCount) % BOOT_ZERO_QUEUE_SIZE].end = tail;
+    zeroCount++;
+
+    boot_sched_start(&zeroTask);
+    boot_sched_yield();
+}
+
+void boot_zero_finish(void)
+{
+    boot_sched_wait(&zeroTask);
+}
@@ -0,0 +1,35 @@
+/*
+ * Description: Background bss clearing. Large uninitialized tails are handed to an FPD
+ * DMA channel instead of being cleared with memset on the loading core, so the zeroing
+ * overlaps the SD reads of the segments and images that follow. The partial cache lines
+ * at either end are still cleared by the core, and the DMA part is invalidated from the
+ * cache first so no stale line can be written back over the zeros. boot_zero_finish()
+ * is the barrier: it runs before any core is released into the images.
+ */
+
+#ifndef BOOT_ZERO_H
+#define BOOT_ZERO_H
+
+#include "stdint.h"
+
+// Clear large bss tails with the DMA; 0 clears everything with memset
+#ifndef BOOT_ZERO_DMA
+#define BOOT_ZERO_DMA 1
+#endif
+
+// Smaller runs are cleared on the spot
+#ifndef BOOT_ZERO_DMA_MIN
+#define BOOT_ZERO_DMA_MIN 0x10000U
+#endif
+
+// Runs waiting for the DMA, beyond which boot_zero() clears on the spot; the clearing
+// itself is a boot_sched.h task
+#define BOOT_ZERO_QUEUE_SIZE 8
+
+// Zeroes [start, start + size), now or in the background
+void boot_zero(uint64_t start, uint64_t size);
+
+// Waits until every queued run is zero in memory
+void boot_zero_finish(void);
+
+#endif
@@ -0,0 +1,1189 @@
+/*
+ * Description: Boot pack container loader. The booting core streams stored blocks from
+ * the boot medium into staging slots and publishes each one as a job; every core running
+ * bpk_worker() (and the booting core itself whenever it would otherwise wait) claims
+ * jobs from the shared queue and decompresses them directly into their load address.
+ * Uncompressed blocks skip the queue and are read straight into place. When the container
+ * carries a hash tree, the tree is checked against its root up front and every block is
+ * then checked against its leaf by the core that decoded it, or for cold segments by
+ * bpk_verify_deferred() once the caller is ready to wait for it. With BPK_REQUIRE_SIGNATURE
+ * the root itself must carry a valid signature before the tree is read, so signing
+ * costs one verification per image on top of the streaming hash. With BPK_HASH_CSU the
+ * booting core hands its checks to the CSU SHA3 engine and carries on reading and
+ * decoding while the engine works through them. Encrypted containers route every stored
+ * block through a staging slot, where the claiming core authenticates and decrypts it
+ * with AES-256-GCM (in place ahead of decompression, or straight into the load address
+ * for raw blocks). Read, decrypt and decode throughput is timed and printed after each
+ * image so the packer's codec choice can be tuned to the board, and each read, decode
+ * and check is recorded in the boot trace under the core that did it.
+ */
+
+// Standard Libraries
+#include "stdlib.h"
+#include "stdint.h"
+#include "string.h"
+
+// Xilinx Libraries
+#include "ff.h"
+#include "xil_cache.h"
+#include "xtime_l.h"
+#include <xil_printf.h>
+
+// Addtional Libraries
+#include "bootpack.h"
+#include "lz4_block.h"
+#include "zstd_decoder.h"
+#include "bootpack_hash.h"
+#include "sha3.h"
+#include "csu_sha3.h"
+#include "aes_gcm.h"
+#include "p256.h"
+#include "boot_log.h"
+#include "boot_stats.h"
+#include "boot_trace.h"
+#include "boot_map.h"
+#include "boot_memmap.h"
+#include "ddr_ecc.h"
+#include "boot_zero.h"
+#include "boot_sched.h"
+#include "boot_storage.h"
+
+// Job states
+#define BPK_JOB_FREE   0
+#define BPK_JOB_READY  1
+#define BPK_JOB_BUSY   2
+#define BPK_JOB_DONE   3
+#define BPK_JOB_FAILED 4
+
+#define BPK_SLOT_ALIGN 64
+#define BPK_NUM_CODECS 4
+
+// Attempts per read before an SD error fails the image
+#define BPK_READ_ATTEMPTS 3
+
+struct bpk_job
+{
+    uint8_t *src;
+    uint8_t *dst;
+    uint32_t stored;
+    uint32_t length;
+    uint32_t codec;
+    uint32_t fill;
+    const struct zstd_dict *dict;
+    const uint8_t *expected;        // Leaf digest to check after decoding, or NULL
+    uint32_t index;                 // Block number within its container
+    uint32_t encrypted;             // src holds ciphertext and tag to decrypt first
+    uint8_t iv[AES_GCM_IV_SIZE];
+    volatile uint32_t status;
+};
+
+// Block of a cold segment waiting for bpk_verify_deferred()
+struct bpk_deferred
+{
+    uint8_t *dst;
+    uint32_t length;
+    uint32_t index;
+    uint8_t digest[BPK_HASH_SIZE];
+};
+
+// Shared between all cores; lives at the start of the staging area
+struct bpk_queue
+{
+    volatile uint32_t head;         // Jobs published so far
+    volatile uint32_t claim;        // Next job number to hand out
+    volatile uint32_t base;         // First job number of the current image
+    volatile uint32_t numSlots;     // Staging slots in use for the current image
+    volatile uint32_t workersOnline;
+    volatile uint32_t workerJobs;   // Jobs completed by secondary cores
+    volatile uint64_t decodeTicks[BPK_NUM_CODECS];
+    volatile uint64_t decodeBytes[BPK_NUM_CODECS];
+    volatile uint64_t verifyTicks;
+    volatile uint64_t verifyBytes;
+    volatile uint64_t decryptTicks;
+    volatile uint64_t decryptBytes;
+    struct bpk_job jobs[BPK_MAX_SLOTS];
+};
+
+#define BPK_QUEUE ((struct bpk_queue *)BPK_STAGING_ADDR)
+#define BPK_SLOTS_ADDR (BPK_STAGING_ADDR + ((sizeof(struct bpk_queue) + BPK_SLOT_ALIGN - 1) & ~(BPK_SLOT_ALIGN - 1)))
+
+static uint8_t bpkQueueReady = 0;
+
+// Context 0 belongs to the booting core, the rest to workers in the order they come online
+static struct zstd_context bpkContexts[BPK_MAX_CORES];
+
+static uint8_t bpkDictData[BPK_DICT_MAX_SIZE] __attribute__((aligned(64)));
+static struct zstd_dict bpkDict;
+static uint8_t bpkDictLoaded = 0;
+
+#if BPK_REQUIRE_SIGNATURE
+// Comb table for the signing key, from the generated boot_key.c
+extern const struct p256_comb bpkSigningKey;
+#endif
+
+// Key schedule for encrypted containers, shared read-only by every decoding core
+static struct aes_gcm_context bpkCipher __attribute__((aligned(64)));
+static uint8_t bpkKeyLoaded = 0;
+
+#if BPK_HASH_CSU
+// Leaf checks queued by the booting core for the CSU SHA3 engine, handled in order
+#define BPK_CSU_QUEUE 32
+
+#define BPK_CSU_PREFIX 0
+#define BPK_CSU_DATA   1
+#define BPK_CSU_PAD    2
+#define BPK_CSU_DIGEST 3
+
+struct bpk_csu_check
+{
+    const uint8_t *data;
+    uint32_t length;
+    uint32_t index;
+    const uint8_t *expected;
+};
+
+static struct bpk_csu_check bpkCsuChecks[BPK_CSU_QUEUE];
+static uint32_t bpkCsuHead = 0;
+static uint32_t bpkCsuTail = 0;
+static uint8_t bpkCsuStage = BPK_CSU_PREFIX;
+static uint8_t bpkCsuReady = 0;
+static int32_t bpkCsuStatus = 0;
+static uint8_t bpkCsuPrefix[BPK_HASH_PREFIX_SIZE] __attribute__((aligned(64)));
+static uint8_t bpkCsuPad[SHA3_384_RATE] __attribute__((aligned(64)));
+
+// Bytes hashed by the engine and time the booting core spent waiting on it
+static uint64_t bpkCsuBytes;
+static XTime bpkCsuStallTicks;
+#endif
+
+static struct bpk_deferred *bpkDeferred = NULL;
+static uint32_t bpkNumDeferred = 0;
+
+// Read time spent by the booting core on the current image
+static XTime bpkReadTicks;
+static uint64_t bpkReadBytes;
+static uint32_t bpkReadRetries;
+
+void bpk_init(void)
+{
+    memset(BPK_QUEUE, 0, sizeof(struct bpk_queue));
+    Xil_DCacheFlushRange((UINTPTR)BPK_QUEUE, sizeof(struct bpk_queue));
+    bpkQueueReady = 1;
+
+#ifdef BPK_IMAGE_KEY
+    static const uint8_t imageKey[AES_GCM_KEY_SIZE] = BPK_IMAGE_KEY;
+    bpk_set_key(imageKey);
+#endif
+
+#if BPK_HASH_CSU
+    bpkCsuReady = (csu_sha3_init() == 0);
+    if (!bpkCsuReady)
+    {
+        xil_printf("CSU SHA3 unavailable, verifying boot packs in software\r\n");
+    }
+#endif
+}
+
+void bpk_set_key(const uint8_t *key)
+{
+    aes_gcm_init(&bpkCipher, key);
+
+    // Workers on cores outside the booting core's cache domain read the schedule from memory
+    Xil_DCacheFlushRange((UINTPTR)&bpkCipher, sizeof(bpkCipher));
+    bpkKeyLoaded = 1;
+}
+
+uint8_t bpk_is_container(const void *header)
+{
+    const char *magic = (const char *)header;
+
+    return magic[0] == BPK_MAGIC0 && magic[1] == BPK_MAGIC1 &&
+        magic[2] == BPK_MAGIC2 && magic[3] == BPK_MAGIC3;
+}
+
+// Wake any worker parked in WFE once a job has been published
+static void bpk_signal(void)
+{
+#if defined(__aarch64__)
+    asm volatile("dsb sy\n\tsev" ::: "memory");
+#endif
+}
+
+static void bpk_idle(void)
+{
+#if defined(__aarch64__)
+    asm volatile("wfe" ::: "memory");
+#endif
+}
+
+// Hands out the next published job number, or returns -1 if none are waiting
+static int32_t bpk_claim(uint32_t *jobNumber)
+{
+    struct bpk_queue *queue = BPK_QUEUE;
+    uint32_t claim = __atomic_load_n(&queue->claim, __ATOMIC_ACQUIRE);
+
+    while (claim < __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE))
+    {
+        if (__atomic_compare_exchange_n(&queue->claim, &claim, claim + 1, 0,
+            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            *jobNumber = claim;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+#if BPK_HASH_CSU
+// Moves the oldest queued check on as far as the engine allows without waiting
+static void bpk_csu_poll(void)
+{
+    while (bpkCsuTail != bpkCsuHead && !csu_sha3_busy())
+    {
+        struct bpk_csu_check *check = &bpkCsuChecks[bpkCsuTail % BPK_CSU_QUEUE];
+        uint32_t words = check->length & ~3U;
+
+        switch (bpkCsuStage)
+        {
+            case BPK_CSU_PREFIX:
+                bpk_hash_leaf_prefix(check->index, check->length, bpkCsuPrefix);
+                csu_sha3_start();
+                csu_sha3_push(bpkCsuPrefix, BPK_HASH_PREFIX_SIZE, 0);
+                bpkCsuStage = BPK_CSU_DATA;
+                break;
+
+            case BPK_CSU_DATA:
+                // Whole words go straight from the load address
+                if (words != 0)
+                {
+                    csu_sha3_push(check->data, words, 0);
+                }
+                bpkCsuStage = BPK_CSU_PAD;
+                break;
+
+            case BPK_CSU_PAD:
+            {
+                // The engine does not pad: send the trailing bytes and SHA3 padding up to a
+                // whole rate block. Everything before is word sized, so this is too.
+                uint32_t tail = check->length & 3;
+                uint32_t padSize = SHA3_384_RATE - (BPK_HASH_PREFIX_SIZE + words) % SHA3_384_RATE;
+
+                memset(bpkCsuPad, 0, padSize);
+                memcpy(bpkCsuPad, check->data + words, tail);
+                bpkCsuPad[tail] = 0x06;
+                bpkCsuPad[padSize - 1] |= 0x80;
+                csu_sha3_push(bpkCsuPad, padSize, 1);
+                bpkCsuStage = BPK_CSU_DIGEST;
+                break;
+            }
+
+            default:
+            {
+                uint8_t digest[BPK_HASH_SIZE];
+
+                csu_sha3_digest(digest);
+                if (memcmp(digest, check->expected, BPK_HASH_SIZE) != 0)
+                {
+                    xil_printf("Boot pack block %u failed verification\r\n", check->index);
+                    bpkCsuStatus = -1;
+                }
+                bpkCsuBytes += check->length;
+                bpkCsuTail++;
+                bpkCsuStage = BPK_CSU_PREFIX;
+                break;
+            }
+        }
+    }
+}
+
+static void bpk_csu_submit(const uint8_t *data, uint32_t length, uint32_t index, const uint8_t *expected)
+{
+    XTime start, end;
+
+    XTime_GetTime(&start);
+    if (bpkCsuHead - bpkCsuTail == BPK_CSU_QUEUE)
+    {
+        boot_trace_begin(BOOT_TRACE_CSU_WAIT, 0);
+        while (bpkCsuHead - bpkCsuTail == BPK_CSU_QUEUE)
+        {
+            bpk_csu_poll();
+            boot_sched_yield();
+        }
+        boot_trace_end(BOOT_TRACE_CSU_WAIT, 0);
+    }
+    XTime_GetTime(&end);
+    bpkCsuStallTicks += end - start;
+
+    struct bpk_csu_check *check = &bpkCsuChecks[bpkCsuHead % BPK_CSU_QUEUE];
+    check->data = data;
+    check->length = length;
+    check->index = index;
+    check->expected = expected;
+    bpkCsuHead++;
+
+    bpk_csu_poll();
+}
+
+// Waits for every queued check; returns -1 if any block failed since the last call
+static int32_t bpk_csu_finish(void)
+{
+    XTime start, end;
+    int32_t status;
+
+    XTime_GetTime(&start);
+    if (bpkCsuTail != bpkCsuHead)
+    {
+        boot_trace_begin(BOOT_TRACE_CSU_WAIT, 0);
+        while (bpkCsuTail != bpkCsuHead)
+        {
+            bpk_csu_poll();
+            boot_sched_yield();
+        }
+        boot_trace_end(BOOT_TRACE_CSU_WAIT, 0);
+    }
+    XTime_GetTime(&end);
+    bpkCsuStallTicks += end - start;
+
+    status = bpkCsuStatus;
+    bpkCsuStatus = 0;
+    return status;
+}
+#else
+static void bpk_csu_poll(void)
+{
+
+}
+
+static int32_t bpk_csu_finish(void)
+{
+    return 0;
+}
+#endif
+
+// Materializes a fill block; zero runs take the memset path used for bss
+static int32_t bpk_fill(uint8_t *dst, uint32_t length, uint32_t pattern)
+{
+    uint32_t i = 0;
+
+    if (pattern == 0)
+    {
+        memset(dst, 0, length);
+        return (int32_t)length;
+    }
+
+    if (((uintptr_t)dst & 3) == 0)
+    {
+        uint32_t *words = (uint32_t *)dst;
+        for (; i + 4 <= length; i += 4)
+        {
+            *words++ = pattern;
+        }
+    }
+    for (; i < length; i++)
+    {
+        dst[i] = (uint8_t)(pattern >> (8 * (i & 3)));
+    }
+
+    return (int32_t)length;
+}
+
+// Claims and decodes one job; returns 1 if any work was done
+static uint8_t bpk_run_one(struct zstd_context *context, uint8_t isWorker)
+{
+    struct bpk_queue *queue = BPK_QUEUE;
+    uint32_t jobNumber;
+
+    if (bpk_claim(&jobNumber) != 0)
+    {
+        return 0;
+    }
+
+    struct bpk_job *job = &queue->jobs[(jobNumber - queue->base) % queue->numSlots];
+    job->status = BPK_JOB_BUSY;
+
+    XTime start, end;
+    XTime_GetTime(&start);
+
+    // Authenticate and decrypt first: raw blocks land in place, the rest stay in the slot
+    uint32_t stored = job->stored;
+    int32_t decoded = -1;
+    if (job->encrypted)
+    {
+        stored -= BPK_TAG_SIZE;
+        boot_trace_begin(BOOT_TRACE_DECRYPT, job->index);
+        if (aes_gcm_decrypt(&bpkCipher, job->iv, job->src, (job->codec == BPK_CODEC_RAW) ? job->dst : job->src,
+            stored, job->src + stored) != 0)
+        {
+            boot_trace_end(BOOT_TRACE_DECRYPT, job->index);
+            goto done;
+        }
+        boot_trace_end(BOOT_TRACE_DECRYPT, job->index);
+
+        XTime_GetTime(&end);
+        __atomic_fetch_add(&queue->decryptTicks, end - start, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&queue->decryptBytes, stored, __ATOMIC_RELAXED);
+        start = end;
+    }
+
+    boot_trace_begin(BOOT_TRACE_DECODE, job->index);
+    if (job->codec == BPK_CODEC_LZ4)
+    {
+        decoded = lz4_decompress_block(job->src, stored, job->dst, job->length);
+    }
+    else if (job->codec == BPK_CODEC_ZSTD)
+    {
+        decoded = zstd_decompress(context, job->src, stored, job->dst, job->length, job->dict);
+    }
+    else if (job->codec == BPK_CODEC_FILL)
+    {
+        decoded = bpk_fill(job->dst, job->length, job->fill);
+    }
+    else if (job->codec == BPK_CODEC_RAW)
+    {
+        decoded = job->length;      // Already in place; only needs verifying
+    }
+    boot_trace_end(BOOT_TRACE_DECODE, job->index);
+
+    XTime_GetTime(&end);
+    __atomic_fetch_add(&queue->decodeTicks[job->codec], end - start, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&queue->decodeBytes[job->codec], job->length, __ATOMIC_RELAXED);
+
+#if BPK_HASH_CSU
+    // The booting core queues its checks on the engine instead of hashing them itself
+    if (decoded == (int32_t)job->length && job->expected != NULL && !isWorker && bpkCsuReady)
+    {
+        bpk_csu_submit(job->dst, job->length, job->index, job->expected);
+    }
+    else
+#endif
+    if (decoded == (int32_t)job->length && job->expected != NULL)
+    {
+        uint8_t digest[BPK_HASH_SIZE];
+
+        boot_trace_begin(BOOT_TRACE_HASH, job->index);
+        bpk_hash_leaf(job->index, job->dst, job->length, digest);
+        boot_trace_end(BOOT_TRACE_HASH, job->index);
+        if (memcmp(digest, job->expected, BPK_HASH_SIZE) != 0)
+        {
+            decoded = -1;
+        }
+
+        XTime_GetTime(&start);
+        __atomic_fetch_add(&queue->verifyTicks, start - end, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&queue->verifyBytes, job->length, __ATOMIC_RELAXED);
+    }
+
+done:
+    __atomic_store_n(&job->status, (decoded == (int32_t)job->length) ? BPK_JOB_DONE : BPK_JOB_FAILED,
+        __ATOMIC_RELEASE);
+    if (isWorker)
+    {
+        __atomic_fetch_add(&queue->workerJobs, 1, __ATOMIC_RELAXED);
+    }
+
+    return 1;
+}
+
+void bpk_worker(void)
+{
+    uint32_t index = __atomic_fetch_add(&BPK_QUEUE->workersOnline, 1, __ATOMIC_RELAXED) + 1;
+
+    // Cores beyond the available decoder contexts stay parked
+    while (index >= BPK_MAX_CORES)
+    {
+        bpk_idle();
+    }
+
+    while (1)
+    {
+        if (!bpk_run_one(&bpkContexts[index], 1))
+        {
+            bpk_idle();
+        }
+    }
+}
+
+// Waits for a staging slot to be released, helping with decode in the meantime
+static int32_t bpk_wait_slot(struct bpk_job *job)
+{
+    while (job->status == BPK_JOB_READY || job->status == BPK_JOB_BUSY)
+    {
+        bpk_csu_poll();
+        boot_sched_yield();
+        bpk_run_one(&bpkContexts[0], 0);
+    }
+
+    return (job->status == BPK_JOB_FAILED) ? -1 : 0;
+}
+
+// Waits until every job of the current image has been decoded
+static int32_t bpk_drain(void)
+{
+    struct bpk_queue *queue = BPK_QUEUE;
+    int32_t status = 0;
+
+    for (uint32_t i = 0; i < queue->numSlots; i++)
+    {
+        if (bpk_wait_slot(&queue->jobs[i]) != 0)
+        {
+            status = -1;
+        }
+    }
+
+    return status;
+}
+
+// Hands a filled-in job to the decoding cores
+static void bpk_publish(struct bpk_job *job)
+{
+    struct bpk_queue *queue = BPK_QUEUE;
+
+    job->status = BPK_JOB_READY;
+    __atomic_store_n(&queue->head, queue->head + 1, __ATOMIC_RELEASE);
+    bpk_signal();
+}
+
+static int32_t bpk_read(struct boot_file *file, uint32_t offset, void *dst, uint32_t size)
+{
+    XTime start, end;
+
+    boot_sched_yield();
+    boot_trace_begin(BOOT_TRACE_SD_READ, size);
+    XTime_GetTime(&start);
+    for (uint32_t attempt = 0; attempt < BPK_READ_ATTEMPTS; attempt++)
+    {
+        if (attempt != 0)
+        {
+            bpkReadRetries++;
+        }
+
+        int32_t status;
+        if (boot_read(file, offset, dst, size, &status) != 0)
+        {
+            continue;
+        }
+
+        // Decode and check earlier blocks while the medium transfers
+        while (status == BOOT_TASK_RUNNING)
+        {
+            bpk_csu_poll();
+            bpk_run_one(&bpkContexts[0], 0);
+            boot_sched_yield();
+        }
+        if (status == 0)
+        {
+            XTime_GetTime(&end);
+            bpkReadTicks += end - start;
+            bpkReadBytes += size;
+            boot_trace_end(BOOT_TRACE_SD_READ, size);
+            return 0;
+        }
+    }
+
+    boot_trace_end(BOOT_TRACE_SD_READ, size);
+    return -1;
+}
+
+// Reads and parses the shared dictionary the first time a container asks for it
+static int32_t bpk_load_dict(uint32_t dictId)
+{
+    struct boot_file dictFile;
+
+    if (bpkDictLoaded && bpkDict.id == dictId)
+    {
+        return 0;
+    }
+
+    if (boot_open(&dictFile, BPK_DICT_FILE) != 0)
+    {
+        xil_printf("Failed to open boot pack dictionary: %s\r\n", BPK_DICT_FILE);
+        return -1;
+    }
+
+    uint32_t dictSize = (uint32_t)dictFile.size;
+    if (dictFile.size > BPK_DICT_MAX_SIZE)
+    {
+        xil_printf("Boot pack dictionary too large: %llu bytes\r\n", dictFile.size);
+        boot_close(&dictFile);
+        return -1;
+    }
+
+    int32_t status = boot_read_now(&dictFile, 0, bpkDictData, dictSize);
+    boot_close(&dictFile);
+    if (status != 0)
+    {
+        xil_printf("Failed to read boot pack dictionary\r\n");
+        return -1;
+    }
+
+    bpkDictLoaded = 0;
+    if (zstd_dict_load(&bpkDict, bpkDictData, dictSize) != 0 || bpkDict.id != dictId)
+    {
+        xil_printf("Boot pack dictionary mismatch: 0x%08x, Expected: 0x%08x\r\n", bpkDict.id, dictId);
+        return -1;
+    }
+
+    // Workers on cores outside the booting core's cache domain read these from memory
+    Xil_DCacheFlushRange((UINTPTR)bpkDictData, dictSize);
+    Xil_DCacheFlushRange((UINTPTR)&bpkDict, sizeof(bpkDict));
+    bpkDictLoaded = 1;
+    xil_printf("Boot pack dictionary loaded: ID 0x%08x, %u bytes\r\n", dictId, dictSize);
+
+    return 0;
+}
+
+#if BPK_REQUIRE_SIGNATURE
+// Checks the signature over the root, which the hash tree check then ties to every block
+static int32_t bpk_check_signature(const struct bpk_header *header)
+{
+    XTime start, end;
+
+    XTime_GetTime(&start);
+    int32_t status = p256_verify(&bpkSigningKey, header->root, BPK_HASH_SIZE, header->signature);
+    XTime_GetTime(&end);
+
+    if (header->hash_offset == 0 || status != 0)
+    {
+        xil_printf("Boot pack signature is missing or invalid\r\n");
+        return -1;
+    }
+
+    xil_printf("Boot pack signature verified in %llu us\r\n", ((end - start) * 1000000) / COUNTS_PER_SECOND);
+    return 0;
+}
+#endif
+
+// Reads the leaf digests and checks them, together with the metadata, against the root
+static uint8_t *bpk_read_tree(struct boot_file *file, const struct bpk_header *header,
+    const struct bpk_segment *segments, const struct bpk_block *blocks)
+{
+    uint32_t tableSize = header->num_blocks * BPK_HASH_SIZE;
+    uint8_t *leaves = malloc(tableSize ? tableSize : 1);
+    uint8_t *nodes = malloc(tableSize + BPK_HASH_SIZE);
+    uint8_t *stored = malloc(header->header_size);
+    uint8_t root[BPK_HASH_SIZE];
+
+    if (leaves == NULL || nodes == NULL || stored == NULL)
+    {
+        xil_printf("Memory allocation for boot pack hash tree failed.\r\n");
+        goto fail;
+    }
+
+    // The manifest covers the header as stored, which must be the one being used
+    if (bpk_read(file, 0, stored, header->header_size) != 0 || memcmp(stored, header, sizeof(*header)) != 0 ||
+        bpk_read(file, header->hash_offset, leaves, tableSize) != 0)
+    {
+        xil_printf("Failed to read boot pack hash table\r\n");
+        goto fail;
+    }
+
+    memcpy(nodes, leaves, tableSize);
+    bpk_hash_manifest(stored, segments, blocks, nodes + tableSize);
+    bpk_hash_root(nodes, header->num_blocks + 1, root);
+    if (memcmp(root, header->root, BPK_HASH_SIZE) != 0)
+    {
+        xil_printf("Boot pack hash tree does not match its root\r\n");
+        goto fail;
+    }
+
+    free(stored);
+    free(nodes);
+    return leaves;
+
+fail:
+    free(stored);
+    free(nodes);
+    free(leaves);
+    return NULL;
+}
+
+// Queues a block of a cold segment for bpk_verify_deferred()
+static int32_t bpk_defer(uint8_t *dst, uint32_t length, uint32_t index, const uint8_t *digest)
+{
+    struct bpk_deferred *deferred = realloc(bpkDeferred, (bpkNumDeferred + 1) * sizeof(struct bpk_deferred));
+
+    if (deferred == NULL)
+    {
+        return -1;
+    }
+
+    bpkDeferred = deferred;
+    deferred = &bpkDeferred[bpkNumDeferred++];
+    deferred->dst = dst;
+    deferred->length = length;
+    deferred->index = index;
+    memcpy(deferred->digest, digest, BPK_HASH_SIZE);
+    return 0;
+}
+
+int32_t bpk_verify_deferred(void)
+{
+    struct bpk_queue *queue = BPK_QUEUE;
+    int32_t status = 0;
+
+    if (bpkNumDeferred == 0)
+    {
+        return 0;
+    }
+
+    // Every job slot is free for verification; no image is loading
+    boot_trace_begin(BOOT_TRACE_VERIFY, bpkNumDeferred);
+    queue->base = queue->head;
+    queue->numSlots = BPK_MAX_SLOTS;
+    for (uint32_t i = 0; i < BPK_MAX_SLOTS; i++)
+    {
+        queue->jobs[i].status = BPK_JOB_FREE;
+    }
+
+    for (uint32_t i = 0; i < bpkNumDeferred; i++)
+    {
+        struct bpk_job *job = &queue->jobs[i % BPK_MAX_SLOTS];
+        if (bpk_wait_slot(job) != 0)
+        {
+            status = -1;
+        }
+
+        job->src = NULL;
+        job->dst = bpkDeferred[i].dst;
+        job->stored = 0;
+        job->length = bpkDeferred[i].length;
+        job->codec = BPK_CODEC_RAW;
+        job->encrypted = 0;
+        job->expected = bpkDeferred[i].digest;
+        job->index = bpkDeferred[i].index;
+        bpk_publish(job);
+    }
+
+    if (bpk_drain() != 0 || bpk_csu_finish() != 0)
+    {
+        status = -1;
+    }
+    boot_trace_end(BOOT_TRACE_VERIFY, bpkNumDeferred);
+
+    xil_printf("Deferred boot pack verification %s: %u block(s)\r\n", (status == 0) ? "passed" : "FAILED",
+        bpkNumDeferred);
+    free(bpkDeferred);
+    bpkDeferred = NULL;
+    bpkNumDeferred = 0;
+
+    return status;
+}
+
+static void bpk_print_rate(const char *name, uint64_t bytes, uint64_t ticks)
+{
+    if (bytes == 0 || ticks == 0)
+    {
+        return;
+    }
+
+    xil_printf("  %s: %llu KiB at %llu MB/s\r\n", name, bytes / 1024, (bytes * COUNTS_PER_SECOND) / ticks / 1000000);
+}
+
+// Bounds everything the header sizes by the file, before any of it is allocated or read.
+// The counts are not authenticated yet, so the sums are taken in 64 bits.
+static int32_t bpk_check_layout(const struct boot_file *file, const struct bpk_header *header)
+{
+    uint64_t segmentEnd = header->segment_offset + (uint64_t)header->num_segments * sizeof(struct bpk_segment);
+    uint64_t blockEnd = header->block_offset + (uint64_t)header->num_blocks * sizeof(struct bpk_block);
+    uint64_t hashEnd = header->hash_offset + (uint64_t)header->num_blocks * BPK_HASH_SIZE;
+
+    if (header->header_size > file->size || segmentEnd > file->size || blockEnd > file->size ||
+        (header->hash_offset != 0 && hashEnd > file->size) ||
+        ((uint64_t)header->num_blocks + 1) * BPK_HASH_SIZE > UINT32_MAX)
+    {
+        xil_printf("Boot pack tables do not fit the file: segments=%u, blocks=%u, size=0x%llx\r\n",
+            header->num_segments, header->num_blocks, file->size);
+        return -1;
+    }
+
+    return 0;
+}
+
+// Checks the segment and block tables against the header and the file before any data is read
+static int32_t bpk_validate(struct boot_file *file, const struct bpk_header *header,
+    const struct bpk_segment *segments, const struct bpk_block *blocks)
+{
+    uint32_t nextBlock = 0;
+
+    for (uint32_t i = 0; i < header->num_segments; i++)
+    {
+        const struct bpk_segment *segment = &segments[i];
+        uint64_t expectedBlocks = (segment->filesz + header->block_size - 1) / header->block_size;
+
+        if (segment->first_block != nextBlock || segment->num_blocks != expectedBlocks ||
+            segment->memsz < segment->filesz ||
+            (uint64_t)(uintptr_t)(segment->dest + segment->memsz) != segment->dest + segment->memsz)
+        {
+            xil_printf("Invalid boot pack segment %u: dest=0x%llx, filesz=0x%llx, memsz=0x%llx\r\n",
+                i, segment->dest, segment->filesz, segment->memsz);
+            return -1;
+        }
+        nextBlock += segment->num_blocks;
+    }
+
+    if (header->cipher > BPK_CIPHER_AES256_GCM || (header->cipher != BPK_CIPHER_NONE && !bpkKeyLoaded))
+    {
+        xil_printf("Cannot decrypt boot pack: cipher %u, key %s\r\n", header->cipher,
+            bpkKeyLoaded ? "loaded" : "not set");
+        return -1;
+    }
+#if BPK_REQUIRE_HASH
+    if (header->hash_offset == 0)
+    {
+        xil_printf("Boot pack is not hashed\r\n");
+        return -1;
+    }
+#endif
+
+    if (nextBlock != header->num_blocks)
+    {
+        xil_printf("Boot pack block count mismatch: %u, Expected: %u\r\n", nextBlock, header->num_blocks);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < header->num_blocks; i++)
+    {
+        const struct bpk_block *block = &blocks[i];
+        uint8_t staged = (block->codec != BPK_CODEC_RAW || header->cipher != BPK_CIPHER_NONE);
+        uint8_t tagged = (block->codec != BPK_CODEC_FILL && header->cipher != BPK_CIPHER_NONE);
+
+        if ((staged && block->stored > header->max_stored) || (tagged && block->stored < BPK_TAG_SIZE) ||
+            block->offset + (uint64_t)block->stored > file->size ||
+            (block->codec == BPK_CODEC_FILL && block->stored != 0) || block->codec > BPK_CODEC_FILL)
+        {
+            xil_printf("Invalid boot pack block %u: offset=0x%x, stored=0x%x, codec=%u\r\n",
+                i, block->offset, block->stored, block->codec);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int32_t bpk_load(struct boot_file *file, const char *name, uint64_t *entryPoint)
+{
+    struct bpk_queue *queue = BPK_QUEUE;
+    struct bpk_header header;
+    struct bpk_segment *segments = NULL;
+    struct bpk_block *blocks = NULL;
+    uint8_t *leaves = NULL;
+    uint64_t targets[BPK_MAX_SEGMENTS];
+    int32_t status = -1;
+
+    if (!bpkQueueReady)
+    {
+        bpk_init();
+    }
+
+    // Read and check the container header
+    if (bpk_read(file, 0, &header, sizeof(header)) != 0)
+    {
+        xil_printf("Failed to read boot pack header\r\n");
+        return -1;
+    }
+
+    if (!bpk_is_container(&header) || header.version != BPK_VERSION || header.header_size < sizeof(header) ||
+        header.num_segments == 0 || header.num_segments > BPK_MAX_SEGMENTS || header.block_size == 0)
+    {
+        xil_printf("Unsupported boot pack header: version=%u, segments=%u\r\n", header.version, header.num_segments);
+        return -1;
+    }
+    if (bpk_check_layout(file, &header) != 0)
+    {
+        return -1;
+    }
+#if BPK_REQUIRE_SIGNATURE
+    // Only a root signed by the build's key gets as far as the tables
+    if (bpk_check_signature(&header) != 0)
+    {
+        return -1;
+    }
+#endif
+    xil_printf("Boot pack header - Segments: %u, Blocks: %u, Block size: 0x%x\r\n",
+        header.num_segments, header.num_blocks, header.block_size);
+
+    // Size the staging slots for the largest stored block, plus room to read each block at
+    // its file offset's position in a cache line so its whole sectors can go to the DMA
+    uint32_t slotSize = (header.max_stored == 0 || header.max_stored > BPK_STAGING_SIZE) ? 0 :
+        (header.max_stored + 2 * BPK_SLOT_ALIGN - 1) & ~(BPK_SLOT_ALIGN - 1);
+    uint32_t numSlots = (slotSize == 0) ? BPK_MAX_SLOTS :
+        (BPK_STAGING_ADDR + BPK_STAGING_SIZE - BPK_SLOTS_ADDR) / slotSize;
+    if (numSlots > BPK_MAX_SLOTS)
+    {
+        numSlots = BPK_MAX_SLOTS;
+    }
+    if (numSlots == 0 || header.max_stored > BPK_STAGING_SIZE)
+    {
+        xil_printf("Boot pack blocks too large for staging area: 0x%x\r\n", header.max_stored);
+        return -1;
+    }
+
+    // Read the segment table and block index
+    segments = malloc(header.num_segments * sizeof(struct bpk_segment));
+    blocks = malloc(header.num_blocks * sizeof(struct bpk_block));
+    if (segments == NULL || (blocks == NULL && header.num_blocks != 0))
+    {
+        xil_printf("Memory allocation for boot pack tables failed.\r\n");
+        goto out;
+    }
+
+    if (bpk_read(file, header.segment_offset, segments, header.num_segments * sizeof(struct bpk_segment)) != 0 ||
+        bpk_read(file, header.block_offset, blocks, header.num_blocks * sizeof(struct bpk_block)) != 0)
+    {
+        xil_printf("Failed to read boot pack tables\r\n");
+        goto out;
+    }
+
+    // With a hash tree the header and tables are checked against the root before use
+    if (header.hash_offset != 0)
+    {
+        leaves = bpk_read_tree(file, &header, segments, blocks);
+        if (leaves == NULL)
+        {
+            goto out;
+        }
+    }
+
+    if (bpk_validate(file, &header, segments, blocks) != 0)
+    {
+        goto out;
+    }
+
+    // Place the segments before reading anything else. Containers only keep the run
+    // address, so load address regions match it as well.
+    for (uint32_t i = 0; i < header.num_segments; i++)
+    {
+        if (boot_map_translate(segments[i].dest, segments[i].dest, segments[i].memsz, &targets[i]) != 0 ||
+            boot_memmap_check(targets[i], segments[i].memsz) != 0 ||
+            ddr_ecc_claim(targets[i], segments[i].memsz) != 0)
+        {
+            goto out;
+        }
+    }
+
+    if (header.dict_id != 0 && bpk_load_dict(header.dict_id) != 0)
+    {
+        goto out;
+    }
+
+    // Move the segments to where this core sees them, now that the table has been checked
+    for (uint32_t i = 0; i < header.num_segments; i++)
+    {
+        segments[i].dest = targets[i];
+    }
+
+    // Start a new image on the queue; nothing is in flight at this point
+    queue->base = queue->head;
+    queue->numSlots = numSlots;
+    for (uint32_t i = 0; i < numSlots; i++)
+    {
+        queue->jobs[i].status = BPK_JOB_FREE;
+    }
+    for (uint32_t i = 0; i < BPK_NUM_CODECS; i++)
+    {
+        queue->decodeTicks[i] = 0;
+        queue->decodeBytes[i] = 0;
+    }
+    queue->verifyTicks = 0;
+    queue->verifyBytes = 0;
+    queue->decryptTicks = 0;
+    queue->decryptBytes = 0;
+#if BPK_HASH_CSU
+    bpkCsuBytes = 0;
+    bpkCsuStallTicks = 0;
+#endif
+    bpkReadTicks = 0;
+    bpkReadBytes = 0;
+    bpkReadRetries = 0;
+
+    uint32_t published = 0;
+    uint64_t elidedBytes = 0;
+    uint8_t encrypted = (header.cipher != BPK_CIPHER_NONE);
+    uint32_t workerJobsStart = queue->workerJobs;
+
+    for (uint32_t i = 0; i < header.num_segments; i++)
+    {
+        const struct bpk_segment *segment = &segments[i];
+        uint8_t *segmentMemory = (uint8_t *)(uintptr_t)segment->dest;
+
+        xil_printf("Loading boot pack segment %u: dest=0x%llx, filesz=0x%llx, memsz=0x%llx, blocks=%u\r\n",
+            i, segment->dest, segment->filesz, segment->memsz, segment->num_blocks);
+
+        for (uint32_t j = 0; j < segment->num_blocks; j++)
+        {
+            uint32_t index = segment->first_block + j;
+            const struct bpk_block *block = &blocks[index];
+            uint64_t blockStart = (uint64_t)j * header.block_size;
+            uint32_t length = (segment->filesz - blockStart < header.block_size) ?
+                (uint32_t)(segment->filesz - blockStart) : header.block_size;
+
+            // Blocks of cold segments are checked later by bpk_verify_deferred(), except in a
+            // cached copy, which must fail here to fall back to the card
+            const uint8_t *expected = (leaves != NULL) ? leaves + index * BPK_HASH_SIZE : NULL;
+            if (expected != NULL && (segment->flags & BPK_SEGMENT_COLD) && !file->cached)
+            {
+                if (bpk_defer(segmentMemory + blockStart, length, index, expected) != 0)
+                {
+                    xil_printf("Memory allocation for deferred verification failed.\r\n");
+                    goto drain;
+                }
+                expected = NULL;
+            }
+
+            // Plain uncompressed blocks are read straight into place and only queued for verification
+            if (block->codec == BPK_CODEC_RAW && !encrypted)
+            {
+                if (block->stored != length || bpk_read(file, block->offset, segmentMemory + blockStart, length) != 0)
+                {
+                    xil_printf("Error reading boot pack block %u\r\n", index);
+                    goto drain;
+                }
+                if (expected == NULL)
+                {
+                    continue;
+                }
+            }
+
+            // Wait for the slot's previous job before overwriting its staging data
+            struct bpk_job *job = &queue->jobs[published % numSlots];
+            uint8_t *slot = (uint8_t *)(uintptr_t)(BPK_SLOTS_ADDR + (published % numSlots) * slotSize +
+                block->offset % BPK_SLOT_ALIGN);
+            if (bpk_wait_slot(job) != 0)
+            {
+                xil_printf("Failed to decode boot pack block\r\n");
+                goto drain;
+            }
+
+            // Holes are filled by whichever core claims them; nothing is read
+            if (block->codec == BPK_CODEC_FILL)
+            {
+                elidedBytes += length;
+            }
+            else if ((block->codec != BPK_CODEC_RAW || encrypted) &&
+                ((block->codec == BPK_CODEC_RAW && block->stored != length + BPK_TAG_SIZE) ||
+                bpk_read(file, block->offset, slot, block->stored) != 0))
+            {
+                xil_printf("Error reading boot pack block %u\r\n", index);
+                goto drain;
+            }
+
+            job->src = slot;
+            job->dst = segmentMemory + blockStart;
+            job->stored = block->stored;
+            job->length = length;
+            job->codec = block->codec;
+            job->fill = block->fill;
+            job->dict = (header.dict_id != 0) ? &bpkDict : NULL;
+            job->expected = expected;
+            job->index = index;
+            job->encrypted = encrypted && block->codec != BPK_CODEC_FILL;
+            memcpy(job->iv, header.iv, AES_GCM_IV_SIZE);
+            for (uint32_t k = 0; k < 4; k++)
+            {
+                job->iv[AES_GCM_IV_SIZE - 1 - k] ^= (uint8_t)(index >> (8 * k));
+            }
+            bpk_publish(job);
+            published++;
+            bpk_csu_poll();
+        }
+    }
+    status = 0;
+
+drain:
+    // Help the workers finish, even on error, so no core is left writing to memory
+    if (bpk_drain() != 0 || bpk_csu_finish() != 0)
+    {
+        xil_printf("Failed to decode or verify boot pack block\r\n");
+        status = -1;
+    }
+    if (status != 0)
+    {
+        goto out;
+    }
+
+    // Push the decoded data out to memory and clear the uninitialized space
+    for (uint32_t i = 0; i < header.num_segments; i++)
+    {
+        const struct bpk_segment *segment = &segments[i];
+        uint8_t *segmentMemory = (uint8_t *)(uintptr_t)segment->dest;
+
+        boot_trace_begin(BOOT_TRACE_FLUSH, (uint32_t)segment->filesz);
+        Xil_DCacheFlushRange((UINTPTR)segmentMemory, segment->filesz);
+        boot_trace_end(BOOT_TRACE_FLUSH, (uint32_t)segment->filesz);
+        if (segment->memsz > segment->filesz)
+        {
+            uint64_t bssSize = segment->memsz - segment->filesz;
+
+            boot_trace_begin(BOOT_TRACE_ZERO, (uint32_t)bssSize);
+            boot_zero(segment->dest + segment->filesz, bssSize);
+            boot_trace_end(BOOT_TRACE_ZERO, (uint32_t)bssSize);
+        }
+    }
+
+    xil_printf("Boot pack loaded: %u blocks, %u queued, %u decoded by %u worker core(s)\r\n",
+        header.num_blocks, published, queue->workerJobs - workerJobsStart, queue->workersOnline);
+    xil_printf("Boot stats: %llu bytes read, %llu bytes elided as fill\r\n", bpkReadBytes, elidedBytes);
+    if (bpkReadRetries != 0)
+    {
+        xil_printf("  %u SD read(s) retried\r\n", bpkReadRetries);
+    }
+    bpk_print_rate("SD read", bpkReadBytes, bpkReadTicks);
+    bpk_print_rate("AES-GCM decrypt", queue->decryptBytes, queue->decryptTicks);
+    bpk_print_rate("lz4 decode", queue->decodeBytes[BPK_CODEC_LZ4], queue->decodeTicks[BPK_CODEC_LZ4]);
+    bpk_print_rate("zstd decode", queue->decodeBytes[BPK_CODEC_ZSTD], queue->decodeTicks[BPK_CODEC_ZSTD]);
+    bpk_print_rate("SHA3 verify", queue->verifyBytes, queue->verifyTicks);
+#if BPK_HASH_CSU
+    if (bpkCsuBytes != 0)
+    {
+        xil_printf("  CSU SHA3 verify: %llu KiB, %llu us stalled\r\n", bpkCsuBytes / 1024,
+            (bpkCsuStallTicks * 1000000) / COUNTS_PER_SECOND);
+    }
+#endif
+
+    // Hand the counters to the OS through the boot statistics record
+    struct boot_stats_image *stats = boot_stats_current();
+    if (stats != NULL)
+    {
+        stats->bytes_read = bpkReadBytes;
+        stats->bytes_elided = elidedBytes;
+        stats->read_ticks = bpkReadTicks;
+        stats->decrypt_ticks = queue->decryptTicks;
+        stats->verify_ticks = queue->verifyTicks;
+        stats->blocks = header.num_blocks;
+        stats->worker_blocks = queue->workerJobs - workerJobsStart;
+        stats->retries = bpkReadRetries;
+        stats->flags = BOOT_STATS_BOOTPACK;
+        for (uint32_t i = 0; i < BPK_NUM_CODECS; i++)
+        {
+            stats->decode_ticks += queue->decodeTicks[i];
+        }
+        for (uint32_t i = 0; i < header.num_segments; i++)
+        {
+            stats->bytes_loaded += segments[i].filesz;
+        }
+        stats->flags |= (header.hash_offset != 0) ? BOOT_STATS_HASHED : 0;
+        stats->flags |= (header.cipher != BPK_CIPHER_NONE) ? BOOT_STATS_ENCRYPTED : 0;
+        stats->flags |= BPK_REQUIRE_SIGNATURE ? BOOT_STATS_SIGNED : 0;
+        stats->flags |= (header.dict_id != 0) ? BOOT_STATS_DICTIONARY : 0;
+        stats->flags |= (stats->worker_blocks != 0) ? BOOT_STATS_WORKERS : 0;
+#if BPK_HASH_CSU
+        stats->stall_ticks = bpkCsuStallTicks;
+        stats->flags |= (bpkCsuBytes != 0) ? BOOT_STATS_CSU_SHA3 : 0;
+#endif
+    }
+
+    // The root already covers every block and the segment table, so it is the measurement
+    boot_log_image(name, header.entry, (header.hash_offset != 0) ? header.root : NULL);
+    for (uint32_t i = 0; i < header.num_segments; i++)
+    {
+        boot_log_range(segments[i].dest, segments[i].memsz);
+    }
+    *entryPoint = header.entry;
+
+out:
+    free(leaves);
+    free(blocks);
+    free(segments);
+    return status;
+}
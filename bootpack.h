@@ -0,0 +1,73 @@
+/*
+ * Description: Boot pack container loader. Blocks are read from the boot medium by the
+ * booting core and published to a small job queue in a shared staging area, where any
+ * core running bpk_worker() can claim and decompress them straight into their load
+ * address. See bootpack_format.h for the container layout.
+ */
+
+#ifndef BOOTPACK_H
+#define BOOTPACK_H
+
+#include "stdint.h"
+#include "boot_storage.h"
+#include "bootpack_format.h"
+
+// Staging area for compressed blocks and the job queue. It must be visible to every
+// core taking part in decompression, so it lives in OCM below the region used by bl31.
+#ifndef BPK_STAGING_ADDR
+#define BPK_STAGING_ADDR 0xFFFC0000U
+#endif
+#ifndef BPK_STAGING_SIZE
+#define BPK_STAGING_SIZE 0x00020000U
+#endif
+
+// Limits on the container tables
+#define BPK_MAX_SLOTS 16
+#define BPK_MAX_SEGMENTS 32
+
+// Cores that may decode at once (booting core plus workers), each with its own zstd context
+#define BPK_MAX_CORES 4
+
+// Trained zstd dictionary shared by containers with a dict_id, read once from the boot medium
+#define BPK_DICT_FILE "boot.dic"
+#define BPK_DICT_MAX_SIZE 0x8000
+
+// Let the booting core hand block verification to the CSU SHA3 engine
+#ifndef BPK_HASH_CSU
+#define BPK_HASH_CSU 1
+#endif
+
+// Refuse containers without a hash tree
+#ifndef BPK_REQUIRE_HASH
+#define BPK_REQUIRE_HASH 0
+#endif
+
+// Refuse containers without a valid ECDSA P-256 signature over their hash tree root. The
+// public key comes from boot_key.c, generated with tools/bootpack -S key.pem -K boot_key.c.
+#ifndef BPK_REQUIRE_SIGNATURE
+#define BPK_REQUIRE_SIGNATURE 0
+#endif
+
+// Encrypted containers need a key, either from bpk_set_key() or built in by defining
+// BPK_IMAGE_KEY as a 32-byte initializer, e.g. -DBPK_IMAGE_KEY="{0x4b, 0x9e, ...}"
+
+// Prepares the job queue; must run before any worker core is started
+void bpk_init(void);
+
+// Sets the AES-256 key for encrypted containers; call before bpk_load()
+void bpk_set_key(const uint8_t *key);
+
+// Returns 1 if the buffer starts with a boot pack header
+uint8_t bpk_is_container(const void *header);
+
+// Loads every segment of the container, records it in the boot log under name and
+// returns its entry point
+int32_t bpk_load(struct boot_file *file, const char *name, uint64_t *entryPoint);
+
+// Verifies the blocks of cold segments loaded since the last call; run before handoff
+int32_t bpk_verify_deferred(void);
+
+// Entry point for secondary cores; claims and decodes blocks forever
+void bpk_worker(void);
+
+#endif
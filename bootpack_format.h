@@ -0,0 +1,105 @@
+/*
+ * Description: On-disk layout of the boot pack container (.bpk). A container carries the
+ * PT_LOAD segments of one ELF image split into independently compressed blocks, so the
+ * loader can decompress blocks in any order and on any core. This header is shared by
+ * the bootloaders and the host packer in tools/ and must stay free of Xilinx includes.
+ *
+ * File layout (all fields little-endian):
+ *   struct bpk_header
+ *   struct bpk_segment[num_segments]   at segment_offset
+ *   struct bpk_block[num_blocks]       at block_offset
+ *   leaf digests[num_blocks]           at hash_offset, if hash_offset is not 0
+ *   stored block data                  at bpk_block.offset, 4-byte aligned
+ *
+ * Runs of zero or repeated-pattern blocks are stored as BPK_CODEC_FILL holes that take
+ * no space in the file, and trailing zeros are trimmed from filesz so they are cleared
+ * along with the rest of memsz.
+ *
+ * Encrypted containers (cipher BPK_CIPHER_AES256_GCM) store every non-fill block as
+ * ciphertext followed by a BPK_TAG_SIZE GCM tag, so stored includes the tag. Blocks are
+ * compressed before they are encrypted, and each uses the header IV with the block
+ * number XORed big-endian into its last four bytes. Leaf digests cover the plaintext.
+ *
+ * Signed containers carry an ECDSA P-256 signature over the hash tree root in the header;
+ * the manifest leaf is hashed with both the root and the signature zeroed.
+ *
+ * Containers with a non-zero dict_id need the matching zstd dictionary on the boot
+ * medium as BPK_DICT_FILE (see bootpack.h); one dictionary serves every image packed
+ * against it.
+ */
+
+#ifndef BOOTPACK_FORMAT_H
+#define BOOTPACK_FORMAT_H
+
+#include "stdint.h"
+
+#define BPK_MAGIC0 'B'
+#define BPK_MAGIC1 'P'
+#define BPK_MAGIC2 'K'
+#define BPK_MAGIC3 '1'
+#define BPK_VERSION 6
+
+// Stored data alignment within the container
+#define BPK_DATA_ALIGN 4
+
+// Block codecs
+#define BPK_CODEC_RAW 0
+#define BPK_CODEC_LZ4 1
+#define BPK_CODEC_ZSTD 2            // One zstd frame with its content size, optionally using the container dictionary
+#define BPK_CODEC_FILL 3            // Nothing stored; the block repeats bpk_block.fill (little-endian)
+
+// Segment flags
+#define BPK_SEGMENT_COLD 0x1        // Verification may be deferred until bpk_verify_deferred()
+
+// Block ciphers
+#define BPK_CIPHER_NONE 0
+#define BPK_CIPHER_AES256_GCM 1
+#define BPK_IV_SIZE 12
+#define BPK_TAG_SIZE 16
+
+// Hash tree (see bootpack_hash.h)
+#define BPK_HASH_SIZE 48            // SHA3-384
+
+// ECDSA P-256 signature (r || s, big-endian) over the hash tree root, all zero if unsigned
+#define BPK_SIGNATURE_SIZE 64
+
+struct bpk_header
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t header_size;       // sizeof(struct bpk_header) at pack time
+    uint32_t num_segments;
+    uint32_t num_blocks;
+    uint32_t block_size;        // Uncompressed size of every block but the last of a segment
+    uint32_t max_stored;        // Largest block read through staging, used to size the slots
+    uint64_t entry;
+    uint32_t segment_offset;
+    uint32_t block_offset;
+    uint32_t dict_id;           // zstd dictionary ID shared by all zstd blocks, 0 for none
+    uint32_t hash_offset;       // Leaf digest table, 0 if the container is not hashed
+    uint8_t root[BPK_HASH_SIZE];    // Hash tree root over the block leaves and the manifest
+    uint32_t cipher;            // BPK_CIPHER_* applied to the stored blocks
+    uint8_t iv[BPK_IV_SIZE];    // Base IV for the per-block IVs
+    uint8_t signature[BPK_SIGNATURE_SIZE];
+};
+
+struct bpk_segment
+{
+    uint64_t dest;              // p_vaddr of the original PT_LOAD
+    uint64_t filesz;
+    uint64_t memsz;
+    uint32_t first_block;
+    uint32_t num_blocks;
+    uint32_t flags;             // BPK_SEGMENT_* flags
+    uint32_t reserved;
+};
+
+struct bpk_block
+{
+    uint32_t offset;            // File offset of the stored data
+    uint32_t stored;            // Stored (compressed) size in bytes
+    uint32_t codec;
+    uint32_t fill;              // 32-bit pattern for BPK_CODEC_FILL blocks, 0 otherwise
+};
+
+#endif
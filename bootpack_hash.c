@@ -0,0 +1,92 @@
+/*
+ * Description: Hash tree helpers for boot pack containers (see bootpack_hash.h).
+ */
+
+#include "stddef.h"
+#include "string.h"
+#include "bootpack_hash.h"
+#include "sha3.h"
+
+static void bpk_hash_put32(uint8_t *dst, uint32_t value)
+{
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+    dst[2] = (uint8_t)(value >> 16);
+    dst[3] = (uint8_t)(value >> 24);
+}
+
+void bpk_hash_leaf_prefix(uint32_t index, uint32_t length, uint8_t *prefix)
+{
+    memset(prefix, 0, BPK_HASH_PREFIX_SIZE);
+    prefix[0] = BPK_HASH_LEAF;
+    bpk_hash_put32(&prefix[4], index);
+    bpk_hash_put32(&prefix[8], length);
+}
+
+void bpk_hash_leaf(uint32_t index, const void *data, uint32_t length, uint8_t *digest)
+{
+    struct sha3_context context;
+    uint8_t prefix[BPK_HASH_PREFIX_SIZE];
+
+    bpk_hash_leaf_prefix(index, length, prefix);
+
+    sha3_384_init(&context);
+    sha3_384_update(&context, prefix, sizeof(prefix));
+    sha3_384_update(&context, data, length);
+    sha3_384_final(&context, digest);
+}
+
+void bpk_hash_manifest(const void *header, const struct bpk_segment *segments,
+    const struct bpk_block *blocks, uint8_t *digest)
+{
+    static const uint8_t zero[BPK_SIGNATURE_SIZE];
+    const uint8_t *bytes = header;
+    struct sha3_context context;
+    struct bpk_header fields;
+    uint8_t domain = BPK_HASH_MANIFEST;
+    uint32_t rootEnd = offsetof(struct bpk_header, root) + BPK_HASH_SIZE;
+    uint32_t signatureEnd = offsetof(struct bpk_header, signature) + BPK_SIGNATURE_SIZE;
+
+    // Every stored header byte is covered, including any a newer packer adds after the struct
+    memcpy(&fields, header, sizeof(fields));
+
+    sha3_384_init(&context);
+    sha3_384_update(&context, &domain, 1);
+    sha3_384_update(&context, bytes, offsetof(struct bpk_header, root));
+    sha3_384_update(&context, zero, BPK_HASH_SIZE);
+    sha3_384_update(&context, bytes + rootEnd, offsetof(struct bpk_header, signature) - rootEnd);
+    sha3_384_update(&context, zero, BPK_SIGNATURE_SIZE);
+    sha3_384_update(&context, bytes + signatureEnd, fields.header_size - signatureEnd);
+    sha3_384_update(&context, segments, fields.num_segments * sizeof(struct bpk_segment));
+    sha3_384_update(&context, blocks, fields.num_blocks * sizeof(struct bpk_block));
+    sha3_384_final(&context, digest);
+}
+
+void bpk_hash_root(uint8_t *leaves, uint32_t count, uint8_t *root)
+{
+    while (count > 1)
+    {
+        uint32_t next = 0;
+
+        for (uint32_t i = 0; i < count; i += 2, next++)
+        {
+            uint8_t *out = leaves + next * BPK_HASH_SIZE;
+
+            if (i + 1 == count)
+            {
+                memmove(out, leaves + i * BPK_HASH_SIZE, BPK_HASH_SIZE);
+                continue;
+            }
+
+            struct sha3_context context;
+            uint8_t domain = BPK_HASH_NODE;
+            sha3_384_init(&context);
+            sha3_384_update(&context, &domain, 1);
+            sha3_384_update(&context, leaves + i * BPK_HASH_SIZE, 2 * BPK_HASH_SIZE);
+            sha3_384_final(&context, out);
+        }
+        count = next;
+    }
+
+    memcpy(root, leaves, BPK_HASH_SIZE);
+}
@@ -0,0 +1,42 @@
+/*
+ * Description: Hash tree over the blocks of a boot pack container, shared by the loader
+ * and the host packer. Leaf i is the digest of block i as it lands in memory, so blocks
+ * can be checked in any order, on any core, and long after they were loaded. One extra
+ * leaf after the blocks covers the header (with the root and signature zeroed) and both
+ * tables.
+ *
+ *   leaf     = SHA3-384(0x00 0x00 0x00 0x00 || le32 index || le32 length || le32 0 || block data)
+ *   manifest = SHA3-384(0x02 || header as stored, header_size bytes || segment table || block table)
+ *   node     = SHA3-384(0x01 || left || right)
+ *
+ * A level with an odd number of nodes promotes its last node unchanged. The leaf prefix is
+ * a whole number of words so block data can be streamed to the CSU SHA3 engine by DMA
+ * straight from its load address.
+ */
+
+#ifndef BOOTPACK_HASH_H
+#define BOOTPACK_HASH_H
+
+#include "stdint.h"
+#include "bootpack_format.h"
+
+#define BPK_HASH_LEAF 0x00
+#define BPK_HASH_NODE 0x01
+#define BPK_HASH_MANIFEST 0x02
+#define BPK_HASH_PREFIX_SIZE 16
+
+// Fills in the prefix hashed ahead of a block's data
+void bpk_hash_leaf_prefix(uint32_t index, uint32_t length, uint8_t *prefix);
+
+// Digest of one decoded block
+void bpk_hash_leaf(uint32_t index, const void *data, uint32_t length, uint8_t *digest);
+
+// Digest of the container metadata. header points to the header_size bytes of the header
+// as stored, at least a struct bpk_header; its root and signature are treated as zero.
+void bpk_hash_manifest(const void *header, const struct bpk_segment *segments,
+    const struct bpk_block *blocks, uint8_t *digest);
+
+// Reduces count leaf digests to the root; the leaves are overwritten
+void bpk_hash_root(uint8_t *leaves, uint32_t count, uint8_t *root);
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ * Description: CSU SHA3-384 engine access (see csu_sha3.h). The engine is started and
+ * read back through xilsecure, but transfers are issued directly with the CSU DMA
+ * driver so they do not block the caller.
+ */
+
+// Standard Libraries
+#include "stdint.h"
+#include "string.h"
+
+// Xilinx Libraries
+#ifndef CSU_SHA3_EMULATE
+#include "xparameters.h"
+#include "xcsudma.h"
+#include "xsecure_sha.h"
+#include "xil_cache.h"
+#endif
+
+// Addtional Libraries
+#include "csu_sha3.h"
+#include "sha3.h"
+
+#ifndef CSU_SHA3_EMULATE
+
+// The R5's TCM at the bottom of its map is only reachable by the DMA through its global
+// alias; the loader's own buffers live there too
+#if defined(__aarch64__)
+#define CSU_SHA3_TCM_SIZE 0x0U
+#else
+#define CSU_SHA3_TCM_SIZE 0x40000U
+#endif
+#define CSU_SHA3_TCM_GLOBAL 0xFFE00000U
+
+static XCsuDma csuDma;
+static XSecure_Sha3 csuSha3;
+static uint8_t csuTransferPending = 0;
+
+int32_t csu_sha3_init(void)
+{
+    XCsuDma_Config *config = XCsuDma_LookupConfig(XPAR_XCSUDMA_0_DEVICE_ID);
+    if (config == NULL || XCsuDma_CfgInitialize(&csuDma, config, config->BaseAddress) != XST_SUCCESS)
+    {
+        return -1;
+    }
+
+    if (XSecure_Sha3Initialize(&csuSha3, &csuDma) != XST_SUCCESS)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+void csu_sha3_start(void)
+{
+    // Resets the engine, routes the DMA to it and selects byte-swapped transfers
+    XSecure_Sha3Start(&csuSha3);
+}
+
+void csu_sha3_push(const void *data, uint32_t size, uint8_t last)
+{
+    UINTPTR address = (UINTPTR)data;
+
+    // The CSU DMA does not snoop the CPU caches
+    Xil_DCacheFlushRange(address, size);
+
+    if (address < CSU_SHA3_TCM_SIZE)
+    {
+        address += CSU_SHA3_TCM_GLOBAL;
+    }
+    XCsuDma_Transfer(&csuDma, XCSUDMA_SRC_CHANNEL, address, size / 4, last);
+    csuTransferPending = 1;
+}
+
+uint8_t csu_sha3_busy(void)
+{
+    if (!csuTransferPending)
+    {
+        return 0;
+    }
+
+    if ((XCsuDma_IntrGetStatus(&csuDma, XCSUDMA_SRC_CHANNEL) & XCSUDMA_IXR_DONE_MASK) == 0)
+    {
+        return 1;
+    }
+
+    XCsuDma_IntrClear(&csuDma, XCSUDMA_SRC_CHANNEL, XCSUDMA_IXR_DONE_MASK);
+    csuTransferPending = 0;
+    return 0;
+}
+
+void csu_sha3_digest(uint8_t *digest)
+{
+    while (csu_sha3_busy())
+    {
+
+    }
+
+    XSecure_Sha3WaitForDone(&csuSha3);
+    XSecure_Sha3_ReadHash(&csuSha3, digest);
+}
+
+#else
+
+// Host stand-in: absorbs the already padded message with the software permutation
+static struct sha3_context csuEmulated;
+
+int32_t csu_sha3_init(void)
+{
+    return 0;
+}
+
+void csu_sha3_start(void)
+{
+    sha3_384_init(&csuEmulated);
+}
+
+void csu_sha3_push(const void *data, uint32_t size, uint8_t last)
+{
+    (void)last;
+    sha3_384_update(&csuEmulated, data, size);
+}
+
+uint8_t csu_sha3_busy(void)
+{
+    return 0;
+}
+
+void csu_sha3_digest(uint8_t *digest)
+{
+    for (uint32_t i = 0; i < SHA3_384_DIGEST_SIZE; i++)
+    {
+        digest[i] = (uint8_t)(csuEmulated.state[i / 8] >> (8 * (i % 8)));
+    }
+}
+
+#endif
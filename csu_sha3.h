@@ -0,0 +1,30 @@
+/*
+ * Description: Non-blocking access to the CSU SHA3-384 engine. Data is streamed into the
+ * engine by the CSU DMA one transfer at a time, so the caller can keep reading and
+ * decoding while a transfer runs. The engine does not pad; the caller supplies the
+ * complete padded message in 4-byte multiples. Building with CSU_SHA3_EMULATE swaps
+ * the engine for the software Keccak in sha3.c so the same path can run on a host.
+ */
+
+#ifndef CSU_SHA3_H
+#define CSU_SHA3_H
+
+#include "stdint.h"
+
+// Sets up the CSU DMA and SHA3 drivers; returns -1 if the hardware is unavailable
+int32_t csu_sha3_init(void);
+
+// Resets the engine for a new message
+void csu_sha3_start(void);
+
+// Starts a DMA transfer of size bytes (a multiple of 4); last must be set on the final one.
+// data may be anywhere the calling core sees, R5 TCM included.
+void csu_sha3_push(const void *data, uint32_t size, uint8_t last);
+
+// Returns 1 while a transfer is still running
+uint8_t csu_sha3_busy(void);
+
+// Waits for the engine to finish the message and reads the digest
+void csu_sha3_digest(uint8_t *digest);
+
+#endif
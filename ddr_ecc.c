@@ -0,0 +1,336 @@
+/*
+ * Description: DDR ECC initialization owned by the loader (see ddr_ecc.h).
+ */
+
+// Standard Libraries
+#include "stdint.h"
+
+// Xilinx Libraries
+#include <xil_printf.h>
+
+// Addtional Libraries
+#include "ddr_ecc.h"
+#include "boot_memmap.h"
+#include "boot_sched.h"
+#include "zdma.h"
+
+// DDR controller ECC configuration
+#ifndef DDR_ECC_ECCCFG0
+#define DDR_ECC_ECCCFG0 (*(volatile uint32_t *)(0xFD070070U))
+#endif
+#define DDRC_ECCCFG0_ECC_MODE 0x7U
+
+// FPD general purpose DMA channel doing the fill
+#ifndef DDR_ECC_ZDMA_BASE
+#define DDR_ECC_ZDMA_BASE ZDMA_GDMA_CH(0)
+#endif
+
+// The R5 sees its own TCM in front of the bottom of DDR; those addresses are not DDR to it
+#if defined(__aarch64__)
+#define DDR_ECC_VIEW_START 0x0ULL
+#else
+#define DDR_ECC_VIEW_START 0x40000ULL
+#endif
+
+#define ECC_OFF 0
+#define ECC_FILLING 1
+#define ECC_DONE 2
+
+struct ddr_ecc_range
+{
+    uint64_t start;
+    uint64_t end;
+};
+
+static const struct ddr_ecc_range ddrRegions[] =
+{
+    { 0x0ULL, DDR_ECC_LOW_SIZE },
+    { DDR_ECC_HIGH_ADDR, DDR_ECC_HIGH_ADDR + DDR_ECC_HIGH_SIZE },
+};
+#define NUM_DDR_REGIONS (sizeof(ddrRegions) / sizeof(ddrRegions[0]))
+
+// Claimed ranges, sorted and merged
+static struct ddr_ecc_range eccClaims[DDR_ECC_MAX_CLAIMS];
+static uint32_t eccNumClaims;
+
+static uint32_t eccState = ECC_OFF;
+static uint32_t eccRegion;          // Region being filled, everything before it is done
+static uint64_t eccCursor;          // Fill position in it, including the transfer in flight
+static struct ddr_ecc_range eccBusy; // Transfer in flight, empty when idle
+static uint64_t eccFilled;
+
+static int32_t ddr_ecc_step(struct boot_task *task);
+static struct boot_task eccTask = { "DDR ECC fill", ddr_ecc_step, NULL, 0, 0, NULL };
+
+static void ddr_ecc_start(uint64_t start, uint64_t size)
+{
+    zdma_fill_start(DDR_ECC_ZDMA_BASE, start, (uint32_t)size);
+    eccBusy.start = start;
+    eccBusy.end = start + size;
+    eccFilled += size;
+}
+
+// Returns 1 while a transfer is in flight
+static int32_t ddr_ecc_busy(void)
+{
+    int32_t status;
+
+    if (eccBusy.start == eccBusy.end)
+    {
+        return 0;
+    }
+
+    status = zdma_fill_done(DDR_ECC_ZDMA_BASE);
+    if (status == 0)
+    {
+        return 1;
+    }
+    if (status < 0)
+    {
+        xil_printf("DDR ECC fill of 0x%llx-0x%llx failed\r\n", eccBusy.start, eccBusy.end);
+    }
+    eccBusy.start = eccBusy.end = 0;
+
+    return 0;
+}
+
+static void ddr_ecc_wait(void)
+{
+    while (ddr_ecc_busy())
+    {
+
+    };
+}
+
+// Whether [start, end) has been filled or is being filled
+static int32_t ddr_ecc_reached(uint64_t start, uint64_t end)
+{
+    for (uint32_t i = 0; i < NUM_DDR_REGIONS; i++)
+    {
+        if (start >= ddrRegions[i].start && start < ddrRegions[i].end)
+        {
+            return (i < eccRegion) || (i == eccRegion && end <= eccCursor);
+        }
+    }
+
+    return 1;
+}
+
+static int32_t ddr_ecc_claimed(uint64_t start, uint64_t end)
+{
+    for (uint32_t i = 0; i < eccNumClaims; i++)
+    {
+        if (eccClaims[i].start < end && eccClaims[i].end > start)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// Fills one partial block at a claim's edge, unless another claim or the fill got there first
+static void ddr_ecc_fill_edge(uint64_t start)
+{
+    uint64_t end = start + DDR_ECC_GRANULE;
+
+    if (ddr_ecc_reached(start, end) || ddr_ecc_claimed(start, end))
+    {
+        return;
+    }
+
+    ddr_ecc_wait();
+    ddr_ecc_start(start, DDR_ECC_GRANULE);
+    ddr_ecc_wait();
+}
+
+int32_t ddr_ecc_init(void)
+{
+    if (!DDR_ECC_INIT)
+    {
+        return 0;
+    }
+    if (!(DDR_ECC_ECCCFG0 & DDRC_ECCCFG0_ECC_MODE))
+    {
+        xil_printf("DDR ECC is disabled, nothing to initialize\r\n");
+        eccState = ECC_DONE;
+        return 0;
+    }
+
+    zdma_fill_init(DDR_ECC_ZDMA_BASE);
+
+    eccNumClaims = 0;
+    eccRegion = 0;
+    eccCursor = ddrRegions[0].start;
+    eccFilled = 0;
+    eccState = ECC_FILLING;
+    xil_printf("Initializing DDR ECC around the boot images\r\n");
+
+    // Whoever loaded the loader initialized the memory it lives in
+    if (ddr_ecc_claim(BOOT_MEMMAP_LOADER_ADDR, BOOT_MEMMAP_LOADER_SIZE) != 0)
+    {
+        return -1;
+    }
+
+    boot_sched_start(&eccTask);
+    return 0;
+}
+
+int32_t ddr_ecc_claim(uint64_t start, uint64_t size)
+{
+    uint64_t end = start + size;
+    uint32_t i;
+
+    if (eccState != ECC_FILLING || size == 0 || start < DDR_ECC_VIEW_START)
+    {
+        return 0;
+    }
+    for (i = 0; i < NUM_DDR_REGIONS; i++)
+    {
+        if (start >= ddrRegions[i].start && end <= ddrRegions[i].end)
+        {
+            break;
+        }
+    }
+    if (i == NUM_DDR_REGIONS)
+    {
+        return 0;
+    }
+
+    // Zeros still on their way must not land after the segment is written
+    if (eccBusy.start < end && eccBusy.end > start)
+    {
+        ddr_ecc_wait();
+    }
+
+    // Partial blocks at either end are filled now; the segment only writes part of them
+    uint64_t head = start & ~(uint64_t)(DDR_ECC_GRANULE - 1);
+    uint64_t tail = (end + DDR_ECC_GRANULE - 1) & ~(uint64_t)(DDR_ECC_GRANULE - 1);
+    if (head != start)
+    {
+        ddr_ecc_fill_edge(head);
+    }
+    if (tail != end && (tail - DDR_ECC_GRANULE != head || head == start))
+    {
+        ddr_ecc_fill_edge(tail - DDR_ECC_GRANULE);
+    }
+    start = head;
+    end = tail;
+
+    // Insert, merging with every claim it overlaps or touches
+    for (i = 0; i < eccNumClaims && eccClaims[i].end < start; i++)
+    {
+
+    }
+    uint32_t last = i;
+    while (last < eccNumClaims && eccClaims[last].start <= end)
+    {
+        if (eccClaims[last].start < start)
+        {
+            start = eccClaims[last].start;
+        }
+        if (eccClaims[last].end > end)
+        {
+            end = eccClaims[last].end;
+        }
+        last++;
+    }
+    if (last == i)
+    {
+        if (eccNumClaims == DDR_ECC_MAX_CLAIMS)
+        {
+            xil_printf("Too many DDR ranges claimed for ECC initialization\r\n");
+            return -1;
+        }
+        for (uint32_t n = eccNumClaims; n > i; n--)
+        {
+            eccClaims[n] = eccClaims[n - 1];
+        }
+        eccNumClaims++;
+    }
+    else
+    {
+        for (uint32_t n = last; n < eccNumClaims; n++)
+        {
+            eccClaims[i + 1 + n - last] = eccClaims[n];
+        }
+        eccNumClaims -= last - i - 1;
+    }
+    eccClaims[i].start = start;
+    eccClaims[i].end = end;
+
+    return 0;
+}
+
+// Starts the next unclaimed chunk whenever the DMA is idle
+static int32_t ddr_ecc_step(struct boot_task *task)
+{
+    (void)task;
+
+    if (eccState != ECC_FILLING)
+    {
+        return BOOT_TASK_DONE;
+    }
+    if (ddr_ecc_busy())
+    {
+        return BOOT_TASK_RUNNING;
+    }
+
+    while (eccRegion < NUM_DDR_REGIONS)
+    {
+        uint64_t regionEnd = ddrRegions[eccRegion].end;
+        uint64_t end;
+
+        if (eccCursor >= regionEnd)
+        {
+            if (++eccRegion < NUM_DDR_REGIONS)
+            {
+                eccCursor = ddrRegions[eccRegion].start;
+            }
+            continue;
+        }
+
+        // Skip claimed memory; stop short of the next claim
+        end = (regionEnd - eccCursor > DDR_ECC_CHUNK_SIZE) ? eccCursor + DDR_ECC_CHUNK_SIZE : regionEnd;
+        for (uint32_t i = 0; i < eccNumClaims; i++)
+        {
+            if (eccClaims[i].end <= eccCursor)
+            {
+                continue;
+            }
+            if (eccClaims[i].start <= eccCursor)
+            {
+                eccCursor = eccClaims[i].end;
+                end = 0;
+            }
+            else if (eccClaims[i].start < end)
+            {
+                end = eccClaims[i].start;
+            }
+            break;
+        }
+        if (end <= eccCursor)
+        {
+            continue;
+        }
+
+        ddr_ecc_start(eccCursor, end - eccCursor);
+        eccCursor = end;
+        return BOOT_TASK_RUNNING;
+    }
+
+    // The last chunk lands before the task ends
+    if (ddr_ecc_busy())
+    {
+        return BOOT_TASK_RUNNING;
+    }
+    eccState = ECC_DONE;
+    xil_printf("DDR ECC initialized: 0x%llx bytes filled, the rest by the images\r\n", eccFilled);
+
+    return BOOT_TASK_DONE;
+}
+
+void ddr_ecc_finish(void)
+{
+    boot_sched_wait(&eccTask);
+}
@@ -0,0 +1,57 @@
+/*
+ * Description: DDR ECC initialization owned by the loader. With ECC enabled in the DDR
+ * controller every ECC word has to be written before it is read, which the FSBL
+ * normally does for all of DDR before the images are written over the same memory
+ * again. Built with DDR_ECC_INIT (for an FSBL that skips its own ECC initialization),
+ * the loader claims the DDR each image will cover while it places the segments, and the
+ * FPD DMA fills only the unclaimed memory with zeros, a chunk at a time from a
+ * boot_sched.h task. Segment data and bss clearing initialize the claimed memory.
+ *
+ * A claimed range only starts and ends on whole DDR_ECC_GRANULE blocks; the partial
+ * blocks at either end are filled by the DMA when they are claimed, before the segment
+ * is written, so that no store ever merges with an uninitialized ECC word. Everything
+ * left is filled by ddr_ecc_finish(), which must run before any core is released into
+ * DDR. Images claimed after that gain nothing, but are still written after the fill.
+ */
+
+#ifndef DDR_ECC_H
+#define DDR_ECC_H
+
+#include "stdint.h"
+
+// Fill unclaimed DDR when the controller has ECC enabled; off leaves DDR to the FSBL
+#ifndef DDR_ECC_INIT
+#define DDR_ECC_INIT 0
+#endif
+
+// DDR as seen by the DMA. ZCU102: 2 GiB low, 2 GiB high.
+#ifndef DDR_ECC_LOW_SIZE
+#define DDR_ECC_LOW_SIZE 0x80000000ULL
+#endif
+#ifndef DDR_ECC_HIGH_ADDR
+#define DDR_ECC_HIGH_ADDR 0x800000000ULL
+#endif
+#ifndef DDR_ECC_HIGH_SIZE
+#define DDR_ECC_HIGH_SIZE 0x80000000ULL
+#endif
+
+// DMA transfer started between reads
+#ifndef DDR_ECC_CHUNK_SIZE
+#define DDR_ECC_CHUNK_SIZE 0x01000000U
+#endif
+
+// Claims are kept to whole blocks of this size, a cache line on either processor
+#define DDR_ECC_GRANULE 64U
+
+#define DDR_ECC_MAX_CLAIMS 64
+
+// Checks the DDR controller and starts filling; claims the loader's own DDR, if any
+int32_t ddr_ecc_init(void);
+
+// Marks DDR an image segment will write; returns -1 if no more ranges can be claimed
+int32_t ddr_ecc_claim(uint64_t start, uint64_t size);
+
+// Fills whatever is left and waits for it
+void ddr_ecc_finish(void);
+
+#endif
@@ -0,0 +1,579 @@
+/*
+ * Description: ELF image loading shared by the bootloaders. The SD card is mounted once
+ * with elf_mount(). elf_load_start() then checks and places every PT_LOAD segment of an
+ * image and hands the reading to a boot_sched.h task, so the caller can start several
+ * images and keep working while they load; elf_load_wait() collects the entry point.
+ * Boot pack containers under the same file name are loaded in elf_load_start() itself.
+ * Every image is recorded in the boot log, statistics and trace; handing off to it is
+ * left to the caller, which may load images for several processors before releasing any
+ * of them. Segments go through the boot_map.h table, so an image can be loaded for a
+ * core whose address map differs from the loading core's, and every one is checked
+ * against boot_memmap.h before the first is read. Images with a baked elf_plan.h plan
+ * take their segments from it once their headers match.
+ */
+
+// Standard Libraries
+#include "stddef.h"
+#include "stdlib.h"
+#include "stdint.h"
+#include "string.h"
+
+// Xilinx Libraries
+#include "ff.h"         // Include the FatFs library header
+#include "xil_cache.h"  // Include cache management functions
+#include <xil_printf.h> // Include Debug IO
+
+// Addtional Libraries
+#include "elf.h"
+#include "elf_loader.h"
+#include "bootpack.h"
+#include "boot_map.h"
+#include "boot_memmap.h"
+#include "ddr_ecc.h"
+#include "boot_zero.h"
+#include "boot_sched.h"
+#include "boot_storage.h"
+#include "boot_log.h"
+#include "boot_stats.h"
+#include "boot_trace.h"
+#include "elf_plan.h"
+#include "sha3.h"
+
+// Either class of header, as read before the class is known
+union elf_header
+{
+    unsigned char ident[EI_NIDENT];
+    Elf32_Ehdr elf32;
+    Elf64_Ehdr elf64;
+};
+
+// File system shared by every image loaded
+static FATFS elfFileSystem;
+static uint32_t elfImageCount = 0;
+
+#if ELF_PLAN
+// Plans for known images, from the generated elf_plan.c
+extern const struct elf_plan elfPlans[];
+extern const uint32_t elfNumPlans;
+
+// Headers of an image with a plan, for its fingerprint
+static uint8_t elfPlanHeader[ELF_PLAN_MAX_HEADER];
+#endif
+
+int32_t elf_mount(void)
+{
+    FRESULT fr;
+
+    // Mount the file system
+    fr = f_mount(&elfFileSystem, "0:", 0);
+    if (fr != FR_OK)
+    {
+        xil_printf("Failed to mount SD card.\r\n");
+        return -1;
+    }
+    xil_printf("SD card mounted successfully.\r\n");
+
+    return 0;
+}
+
+// Closes the image and records how it ended
+static int32_t elf_load_finish(struct elf_load *load, int32_t status)
+{
+    boot_close(&load->file);
+    if (load->stats != NULL)
+    {
+        boot_stats_image_end(load->stats);
+    }
+    boot_trace_mark(BOOT_TRACE_IMAGE, load->image_number);
+    load->status = status;
+
+    return status;
+}
+
+// Reads the segments in order; the loads in progress take turns on the card
+static int32_t elf_load_step(struct boot_task *task)
+{
+    struct elf_load *load = task->context;
+    struct elf_load_segment *segment = &load->segments[load->next];
+
+    BOOT_TASK_BEGIN(task);
+    for (load->next = 0; load->next < load->num_segments; load->next++)
+    {
+        segment = &load->segments[load->next];
+        xil_printf("Reading segment data: offset=0x%llx, filesize=0x%llx, memsize=0x%llx\r\n",
+            segment->offset, segment->filesz, segment->memsz);
+
+        // Starting a read waits for the one in flight, which a step cannot do
+        BOOT_TASK_WAIT_UNTIL(task, !boot_busy(&load->file));
+        boot_trace_begin(BOOT_TRACE_SD_READ, (uint32_t)segment->filesz);
+        if (boot_read(&load->file, segment->offset, (void *)(uintptr_t)segment->address,
+            (uint32_t)segment->filesz, &load->read_status) == 0)
+        {
+            BOOT_TASK_WAIT_UNTIL(task, load->read_status != BOOT_TASK_RUNNING);
+        }
+        boot_trace_end(BOOT_TRACE_SD_READ, (uint32_t)segment->filesz);
+        if (load->read_status != 0)
+        {
+            xil_printf("Error reading segment data at offset 0x%llx of %s\r\n", segment->offset, load->name);
+            return elf_load_finish(load, -1);
+        }
+        if (load->stats != NULL)
+        {
+            load->stats->bytes_read += segment->filesz;
+            load->stats->bytes_loaded += segment->filesz;
+        }
+        load->bytes_loaded += segment->filesz;
+
+        // Clear uninitialized space
+        if (segment->memsz > segment->filesz)
+        {
+            uint64_t bssSize = segment->memsz - segment->filesz;
+
+            boot_trace_begin(BOOT_TRACE_ZERO, (uint32_t)bssSize);
+            boot_zero(segment->address + segment->filesz, bssSize);
+            boot_trace_end(BOOT_TRACE_ZERO, (uint32_t)bssSize);
+        }
+        segment->done = 1;
+
+        // Print the loaded segment information
+        xil_printf("Segment loaded successfully: address=0x%llx, filesz=0x%llx, memsz=0x%llx\r\n",
+            segment->address, segment->filesz, segment->memsz);
+
+        // Let any other load have the card before reading the next segment
+        BOOT_TASK_YIELD(task);
+    }
+
+    xil_printf("All segments of %s loaded successfully.\r\n", load->name);
+    elf_load_finish(load, 0);
+    BOOT_TASK_END(task);
+}
+
+// Translates a segment to where this core sees it and checks it can go there
+static int32_t elf_place_segment(struct elf_load *load, uint32_t index, uint64_t vaddr, uint64_t paddr)
+{
+    struct elf_load_segment *segment = &load->segments[index];
+
+    segment->done = 0;
+
+    // The read lands inside the range checked below, in one transfer
+    if (segment->filesz > segment->memsz || segment->filesz > UINT32_MAX)
+    {
+        xil_printf("Invalid sizes for program header %u of %s: filesz=0x%llx, memsz=0x%llx\r\n", index, load->name,
+            segment->filesz, segment->memsz);
+        return -1;
+    }
+    if (boot_map_translate(vaddr, paddr, segment->memsz, &segment->address) != 0 ||
+        boot_memmap_check(segment->address, segment->memsz) != 0 ||
+        ddr_ecc_claim(segment->address, segment->memsz) != 0)
+    {
+        xil_printf("Invalid placement for program header %u of %s\r\n", index, load->name);
+        return -1;
+    }
+    load->bytes_total += segment->filesz;
+
+    return 0;
+}
+
+// Logs the placed image and reads its segments in the background
+static int32_t elf_load_begin(struct elf_load *load, const uint8_t *digest)
+{
+    boot_log_image(load->name, load->entry, digest);
+    for (uint32_t i = 0; i < load->num_segments; i++)
+    {
+        boot_log_range(load->segments[i].address, load->segments[i].memsz);
+    }
+
+    load->status = BOOT_TASK_RUNNING;
+    load->task = (struct boot_task){ load->name, elf_load_step, load, 0, 0, NULL };
+    boot_sched_start(&load->task);
+    boot_sched_yield();
+
+    return 0;
+}
+
+#if ELF_PLAN
+// Finds the plan for an open image and checks it still describes the file
+static const struct elf_plan *elf_plan_find(struct elf_load *load)
+{
+    uint8_t fingerprint[SHA3_384_DIGEST_SIZE];
+
+    for (uint32_t i = 0; i < elfNumPlans; i++)
+    {
+        const struct elf_plan *plan = &elfPlans[i];
+
+        if (strcmp(plan->name, load->name) != 0)
+        {
+            continue;
+        }
+
+        if (load->file.size == plan->file_size &&
+            boot_read_now(&load->file, 0, elfPlanHeader, plan->header_size) == 0)
+        {
+            sha3_384(elfPlanHeader, plan->header_size, fingerprint);
+            if (memcmp(fingerprint, plan->fingerprint, sizeof(fingerprint)) == 0)
+            {
+                return plan;
+            }
+        }
+        xil_printf("%s no longer matches its load plan, parsing it\r\n", load->name);
+        return NULL;
+    }
+
+    return NULL;
+}
+
+// Places the segments of a plan the generator already checked against the file
+static int32_t elf_load_planned(struct elf_load *load, const struct elf_plan *plan)
+{
+    load->plan = plan;
+    load->entry = plan->entry;
+    load->segments = malloc(plan->num_segments * sizeof(struct elf_load_segment) + 1);
+    if (load->segments == NULL)
+    {
+        xil_printf("Memory allocation for program headers failed.\r\n");
+        return elf_load_finish(load, -1);
+    }
+
+    for (uint32_t i = 0; i < plan->num_segments; i++)
+    {
+        const struct elf_plan_segment *planned = &plan->segments[i];
+
+        load->segments[i].offset = planned->offset;
+        load->segments[i].filesz = planned->filesz;
+        load->segments[i].memsz = planned->memsz;
+        if (elf_place_segment(load, i, planned->vaddr, planned->paddr) != 0)
+        {
+            free(load->segments);
+            load->segments = NULL;
+            return elf_load_finish(load, -1);
+        }
+    }
+    load->num_segments = plan->num_segments;
+    if (load->stats != NULL)
+    {
+        load->stats->flags |= BOOT_STATS_PLANNED;
+    }
+    xil_printf("Loading %s from its plan: %u segments, entry 0x%llx\r\n", load->name, load->num_segments, load->entry);
+
+    // Only a checked image is logged as measured
+    return elf_load_begin(load, ELF_PLAN_VERIFY ? plan->digest : NULL);
+}
+
+#if ELF_PLAN_VERIFY
+// Checks every planned segment against its digest once it is in memory
+static int32_t elf_plan_verify(const struct elf_load *load)
+{
+    uint8_t digest[SHA3_384_DIGEST_SIZE];
+
+    for (uint32_t i = 0; i < load->num_segments; i++)
+    {
+        const struct elf_load_segment *segment = &load->segments[i];
+
+        sha3_384((const void *)(uintptr_t)segment->address, (uint32_t)segment->filesz, digest);
+        if (memcmp(digest, load->plan->segments[i].digest, sizeof(digest)) != 0)
+        {
+            xil_printf("Segment %u of %s does not match its load plan digest\r\n", i, load->name);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+#endif
+#endif
+
+// Whether a core taking images of elfClass, or 0 for any, can run the image. A 32-bit
+// core takes neither ELF64 images nor entry points above 4 GiB.
+static int32_t elf_check_class(const struct elf_load *load, uint8_t elfClass)
+{
+    if (elfClass == ELFCLASS32 && (load->elf_class == ELFCLASS64 || load->entry > UINT32_MAX))
+    {
+        xil_printf("%s is not a 32-bit image: ELF class %u, entry 0x%llx\r\n", load->name, load->elf_class,
+            load->entry);
+        return -1;
+    }
+
+    return 0;
+}
+
+// elf_load_start() for a core taking images of elfClass; the class is checked before
+// anything is placed, and for a container once more after it loads
+static int32_t elf_load_open(struct elf_load *load, const char *file_name, uint8_t elfClass)
+{
+    union elf_header elfHeader;
+    uint32_t headerBytes;
+    uint8_t *programHeaders = NULL;
+    uint64_t headerOffset;
+    uint32_t headerCount;
+    uint32_t headerSize;
+
+    memset(load, 0, sizeof(*load));
+    load->name = file_name;
+    load->status = -1;
+
+    // Open the ELF file on whichever medium holds it
+    if (boot_open(&load->file, file_name) != 0)
+    {
+        xil_printf("Failed to open file: %s\r\n", file_name);
+        return -1;
+    }
+    xil_printf("File opened successfully: %s\r\n", file_name);
+    load->stats = boot_stats_image(file_name);
+    load->image_number = elfImageCount++;
+    boot_trace_mark(BOOT_TRACE_IMAGE, load->image_number);
+
+#if ELF_PLAN
+    // Known images skip the parsing and checks below
+    const struct elf_plan *plan = elf_plan_find(load);
+    if (plan != NULL)
+    {
+        load->entry = plan->entry;
+        if (elf_check_class(load, elfClass) != 0)
+        {
+            return elf_load_finish(load, -1);
+        }
+        return elf_load_planned(load, plan);
+    }
+#endif
+
+    // Read ELF header; an ELF32 file may be shorter than the ELF64 one
+    headerBytes = (load->file.size < sizeof(elfHeader)) ? (uint32_t)load->file.size : sizeof(elfHeader);
+    if (headerBytes < sizeof(Elf32_Ehdr) || boot_read_now(&load->file, 0, &elfHeader, headerBytes) != 0)
+    {
+        xil_printf("Failed to read ELF header\r\n");
+        return elf_load_finish(load, -1);
+    }
+    xil_printf("ELF header read successfully.\r\n");
+
+    // Boot pack containers carry the same segments in independently compressed blocks
+    if (bpk_is_container(&elfHeader))
+    {
+        // The container header's entry point lies within the bytes of an ELF32 header
+        memcpy(&load->entry, (const uint8_t *)&elfHeader + offsetof(struct bpk_header, entry), sizeof(load->entry));
+        if (elf_check_class(load, elfClass) != 0)
+        {
+            return elf_load_finish(load, -1);
+        }
+        int32_t status = bpk_load(&load->file, file_name, &load->entry);
+
+        // The card stays the source of a cached image, so a bad copy only costs a second load
+        if (status != 0 && boot_cache_fallback(&load->file, file_name) == 0)
+        {
+            status = bpk_load(&load->file, file_name, &load->entry);
+        }
+        if (status != 0)
+        {
+            xil_printf("Failed to load boot pack: %s\r\n", file_name);
+            return elf_load_finish(load, -1);
+        }
+
+        // The header was read again and authenticated while the container loaded
+        return elf_load_finish(load, elf_check_class(load, elfClass));
+    }
+
+    // Validate ELF identification
+    if (elfHeader.ident[0] != ELFMAG0 || elfHeader.ident[1] != ELFMAG1 ||
+        elfHeader.ident[2] != ELFMAG2 || elfHeader.ident[3] != ELFMAG3)
+    {
+        xil_printf("File is not a valid ELF file\r\n");
+        return elf_load_finish(load, -1);
+    }
+
+    if (elfHeader.ident[EI_CLASS] == ELFCLASS64 && headerBytes == sizeof(Elf64_Ehdr))
+    {
+        headerOffset = elfHeader.elf64.e_phoff;
+        headerCount = elfHeader.elf64.e_phnum;
+        headerSize = sizeof(Elf64_Phdr);
+        load->entry = elfHeader.elf64.e_entry;
+        load->elf_class = ELFCLASS64;
+    }
+    else if (elfHeader.ident[EI_CLASS] == ELFCLASS32)
+    {
+        headerOffset = elfHeader.elf32.e_phoff;
+        headerCount = elfHeader.elf32.e_phnum;
+        headerSize = sizeof(Elf32_Phdr);
+        load->entry = elfHeader.elf32.e_entry;
+        load->elf_class = ELFCLASS32;
+    }
+    else
+    {
+        xil_printf("Unsupported ELF class %u in %s\r\n", elfHeader.ident[EI_CLASS], file_name);
+        return elf_load_finish(load, -1);
+    }
+    xil_printf("Valid ELF%u file identified.\r\n", (headerSize == sizeof(Elf64_Phdr)) ? 64U : 32U);
+    if (elf_check_class(load, elfClass) != 0)
+    {
+        return elf_load_finish(load, -1);
+    }
+
+    // Debug: Print ELF header info
+    xil_printf("ELF Header - Program header offset: %llu, Number of program headers: %u\r\n",
+        headerOffset, headerCount);
+
+    // Jump to the program headers
+    if (headerOffset >= load->file.size)
+    {
+        xil_printf("Invalid program header offset.\r\n");
+        return elf_load_finish(load, -1);
+    }
+
+    // Allocate memory for all program headers and the segments built from them
+    programHeaders = malloc(headerCount * headerSize + 1);
+    load->segments = malloc(headerCount * sizeof(struct elf_load_segment) + 1);
+    if (programHeaders == NULL || load->segments == NULL)
+    {
+        xil_printf("Memory allocation for program headers failed.\r\n");
+        goto fail;
+    }
+
+    // Read all program headers at once
+    if (boot_read_now(&load->file, headerOffset, programHeaders, headerCount * headerSize) != 0)
+    {
+        xil_printf("Failed to read program headers; Expected: %u bytes\r\n", headerCount * headerSize);
+        goto fail;
+    }
+
+    // Check where every segment goes before reading any of them
+    for (uint32_t i = 0; i < headerCount; i++)
+    {
+        struct elf_load_segment *segment = &load->segments[i];
+        uint64_t vaddr, paddr;
+        uint32_t type;
+
+        if (headerSize == sizeof(Elf64_Phdr))
+        {
+            Elf64_Phdr *programHeader = (Elf64_Phdr *)programHeaders + i;
+
+            type = programHeader->p_type;
+            vaddr = programHeader->p_vaddr;
+            paddr = programHeader->p_paddr;
+            segment->offset = programHeader->p_offset;
+            segment->filesz = programHeader->p_filesz;
+            segment->memsz = programHeader->p_memsz;
+        }
+        else
+        {
+            Elf32_Phdr *programHeader = (Elf32_Phdr *)programHeaders + i;
+
+            type = programHeader->p_type;
+            vaddr = programHeader->p_vaddr;
+            paddr = programHeader->p_paddr;
+            segment->offset = programHeader->p_offset;
+            segment->filesz = programHeader->p_filesz;
+            segment->memsz = programHeader->p_memsz;
+        }
+
+        // Print the values of the program header
+        xil_printf("Program header %u read successfully: type=0x%x, offset=0x%llx, filesz=0x%llx, memsz=0x%llx\r\n",
+            i, type, segment->offset, segment->filesz, segment->memsz);
+
+        // Validate segment offset
+        if (segment->offset + segment->filesz > load->file.size)
+        {
+            xil_printf("Invalid segment offset for program header %u: offset=0x%llx, filesize=0x%llx\r\n",
+                i, segment->offset, load->file.size);
+            goto fail;
+        }
+
+        if (elf_place_segment(load, i, vaddr, paddr) != 0)
+        {
+            goto fail;
+        }
+    }
+    free(programHeaders);
+    load->num_segments = headerCount;
+
+    // Plain ELF images are logged without a digest
+    return elf_load_begin(load, NULL);
+
+fail:
+    free(programHeaders);
+    free(load->segments);
+    load->segments = NULL;
+    return elf_load_finish(load, -1);
+}
+
+int32_t elf_load_start(struct elf_load *load, const char *file_name)
+{
+    return elf_load_open(load, file_name, 0);
+}
+
+int32_t elf_load_start32(struct elf_load *load, const char *file_name)
+{
+    return elf_load_open(load, file_name, ELFCLASS32);
+}
+
+int32_t elf_load_poll(struct elf_load *load)
+{
+    boot_sched_yield();
+
+    return load->status;
+}
+
+int32_t elf_load_segment_done(const struct elf_load *load, uint32_t index)
+{
+    return index < load->num_segments && load->segments[index].done;
+}
+
+int32_t elf_load_wait(struct elf_load *load, uint64_t *entryPoint)
+{
+    boot_sched_wait(&load->task);
+#if ELF_PLAN && ELF_PLAN_VERIFY
+    if (load->status == 0 && load->plan != NULL && elf_plan_verify(load) != 0)
+    {
+        load->status = -1;
+    }
+#endif
+    free(load->segments);
+    load->segments = NULL;
+    load->num_segments = 0;
+
+    if (load->status != 0)
+    {
+        return -1;
+    }
+    *entryPoint = load->entry;
+    boot_cache_update(&load->file, load->name);
+
+    return 0;
+}
+
+int32_t load_elf32(const char *file_name, uint32_t *entryPoint)
+{
+    struct elf_load load;
+    uint64_t entry;
+
+    boot_trace_begin(BOOT_TRACE_IMAGE, elfImageCount);
+    if (elf_load_start32(&load, file_name) != 0 || elf_load_wait(&load, &entry) != 0)
+    {
+        boot_trace_end(BOOT_TRACE_IMAGE, load.image_number);
+        return -1;
+    }
+    boot_trace_end(BOOT_TRACE_IMAGE, load.image_number);
+
+    // Calculate the entry point
+    *entryPoint = (uint32_t)entry;
+    xil_printf("Entry point calculated: %x\r\n", *entryPoint);
+
+    return 0;
+}
+
+int32_t load_elf64(const char *file_name, uint64_t *entryPoint)
+{
+    struct elf_load load;
+    uint64_t entry;
+
+    boot_trace_begin(BOOT_TRACE_IMAGE, elfImageCount);
+    if (elf_load_start(&load, file_name) != 0 || elf_load_wait(&load, &entry) != 0)
+    {
+        boot_trace_end(BOOT_TRACE_IMAGE, load.image_number);
+        return -1;
+    }
+    boot_trace_end(BOOT_TRACE_IMAGE, load.image_number);
+
+    // Calculate the entry point
+    *entryPoint = entry;
+    xil_printf("Entry point calculated: 0x%08llx\r\n", entry);
+
+    return 0;
+}
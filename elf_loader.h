@@ -0,0 +1,94 @@
+/*
+ * Description: ELF image loading shared by the bootloaders. Each loader reads an ELF32 or
+ * ELF64 image, or a boot pack container stored under the same name, into place from
+ * whichever boot medium holds it (boot_storage.h) and returns its entry point without
+ * handing off to it.
+ *
+ * elf_load_start() parses and places an image and returns with its segments still to be
+ * read. They are streamed in the background by a boot_sched.h task that the caller
+ * steps with elf_load_poll() (or any other yield), so several images can load while the
+ * caller configures cores or builds handoff structures. Loads take turns on a medium a
+ * segment at a time. load_elf32() and load_elf64() are a start and a wait. Segments go
+ * through the boot_map.h table when the load starts, so the next image may install its
+ * own table while this one is still streaming in.
+ *
+ * Boot pack containers are not loaded in the background: their decode pipeline is not a
+ * boot_sched.h task, so elf_load_start() reads, decodes and checks the whole container
+ * before it returns, and the load is already complete when it does. Loads started
+ * earlier keep reading while it waits on the medium, but the caller gets nothing done
+ * in the meantime; start container images after the ELF images they should overlap
+ * with.
+ * With ELF_PLAN, images listed in the generated elf_plan.c skip the header parsing
+ * (see elf_plan.h).
+ */
+
+#ifndef ELF_LOADER_H
+#define ELF_LOADER_H
+
+#include "stdint.h"
+#include "boot_storage.h"
+#include "boot_sched.h"
+#include "boot_stats.h"
+#include "elf_plan.h"
+
+// Segment of an image being loaded
+struct elf_load_segment
+{
+    uint64_t address;               // Where this core writes it
+    uint64_t offset;                // In the file
+    uint64_t filesz;
+    uint64_t memsz;
+    uint32_t done;                  // Read, with its bss queued for clearing
+};
+
+// Image being loaded; owned by the caller until elf_load_wait() returns
+struct elf_load
+{
+    struct boot_task task;
+    struct boot_file file;
+    const char *name;
+    uint64_t entry;                 // Known once elf_load_start() returns
+    uint8_t elf_class;              // ELFCLASS32 or ELFCLASS64, 0 for plans and boot packs
+    struct elf_load_segment *segments;
+    uint32_t num_segments;
+    uint32_t next;                  // Segment being read
+    int32_t read_status;            // Of that segment's read
+    uint64_t bytes_total;           // File data to read, for progress
+    uint64_t bytes_loaded;
+    struct boot_stats_image *stats;
+    const struct elf_plan *plan;    // Baked plan the segments came from, or NULL
+    uint32_t image_number;
+    int32_t status;                 // BOOT_TASK_RUNNING, then 0 or -1
+};
+
+// Mounts the SD card once for every image that follows
+int32_t elf_mount(void);
+
+// Opens, checks and places an image, logs it and starts reading its segments; returns -1
+// if the image cannot be loaded, in which case there is nothing to wait for. A boot pack
+// container is loaded completely before this returns.
+int32_t elf_load_start(struct elf_load *load, const char *file_name);
+
+// elf_load_start() for a 32-bit core: fails an ELF64 image or an entry point above 4 GiB
+// before any of it is placed
+int32_t elf_load_start32(struct elf_load *load, const char *file_name);
+
+// Steps every background task; returns BOOT_TASK_RUNNING while the image loads, then 0,
+// or -1 if it failed
+int32_t elf_load_poll(struct elf_load *load);
+
+// Whether segment index is in memory (its bss may still be clearing; see boot_zero.h)
+int32_t elf_load_segment_done(const struct elf_load *load, uint32_t index);
+
+// Waits for the load, releases it and returns the entry point; returns -1 if it failed.
+// Every started load must be waited for.
+int32_t elf_load_wait(struct elf_load *load, uint64_t *entryPoint);
+
+// Loads an ELF32 image and returns its entry point; returns -1 for an ELF64 image or an
+// entry point above 4 GiB, which a 32-bit core cannot jump to (see elf_load_start32())
+int32_t load_elf32(const char *file_name, uint32_t *entryPoint);
+
+// Loads an ELF64 image and returns its entry point
+int32_t load_elf64(const char *file_name, uint64_t *entryPoint);
+
+#endif
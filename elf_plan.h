@@ -0,0 +1,54 @@
+/*
+ * Description: Load plans baked into the loader for images that do not change between
+ * boots. tools/elfplan.c reads an ELF on the host and writes elf_plan.c, which lists
+ * every PT_LOAD segment of it (file offset, sizes, run and load addresses, digest) and
+ * its entry point. A loader built with ELF_PLAN=1 and that file only checks the size of
+ * an image and a digest of its ELF and program headers, then reads the planned segments
+ * without parsing anything. Images without a plan, or whose headers no longer match, are
+ * parsed as usual. Shared with the host generator, so it must stay free of Xilinx
+ * includes.
+ */
+
+#ifndef ELF_PLAN_H
+#define ELF_PLAN_H
+
+#include "stdint.h"
+#include "sha3.h"
+
+// Look images up in the generated elf_plan.c
+#ifndef ELF_PLAN
+#define ELF_PLAN 0
+#endif
+
+// Hash every planned segment against its digest in elf_load_wait() and record the image
+// in the boot log as measured
+#ifndef ELF_PLAN_VERIFY
+#define ELF_PLAN_VERIFY 0
+#endif
+
+// Longest run of ELF and program headers a fingerprint covers
+#define ELF_PLAN_MAX_HEADER 4096U
+
+struct elf_plan_segment
+{
+    uint64_t vaddr;                 // Run address
+    uint64_t paddr;                 // Load address
+    uint64_t offset;                // In the file
+    uint64_t filesz;
+    uint64_t memsz;                 // Zero filled past filesz
+    uint8_t digest[SHA3_384_DIGEST_SIZE];   // SHA3-384 of the file data
+};
+
+struct elf_plan
+{
+    const char *name;               // File name on the card
+    uint64_t file_size;
+    uint32_t header_size;           // Bytes from the start of the file the fingerprint covers
+    uint8_t fingerprint[SHA3_384_DIGEST_SIZE];
+    uint64_t entry;
+    uint8_t digest[SHA3_384_DIGEST_SIZE];   // SHA3-384 of the segment digests in order
+    uint32_t num_segments;
+    const struct elf_plan_segment *segments;
+};
+
+#endif
@@ -0,0 +1,95 @@
+/*
+ * Description: Minimal LZ4 block decoder used by the boot pack loader. All copies are
+ * done a byte at a time so the decoder is safe to run on a secondary core that has not
+ * enabled its MMU/MPU, where unaligned word accesses would fault.
+ */
+
+#include "lz4_block.h"
+
+// Reads an LZ4 length extension (a run of 255 bytes terminated by a smaller byte)
+static int32_t lz4_read_length(const uint8_t **ip, const uint8_t *iend, uint32_t *length)
+{
+    uint8_t s;
+
+    do
+    {
+        if (*ip >= iend)
+        {
+            return -1;
+        }
+        s = *(*ip)++;
+        *length += s;
+    } while (s == 255);
+
+    return 0;
+}
+
+int32_t lz4_decompress_block(const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+{
+    const uint8_t *ip = src;
+    const uint8_t *iend = src + srcSize;
+    uint8_t *op = dst;
+    uint8_t *oend = dst + dstCapacity;
+
+    while (ip < iend)
+    {
+        uint8_t token = *ip++;
+        uint32_t length = token >> 4;
+
+        // Literal run
+        if (length == 15 && lz4_read_length(&ip, iend, &length) != 0)
+        {
+            return -1;
+        }
+        if (length > (uint32_t)(iend - ip) || length > (uint32_t)(oend - op))
+        {
+            return -1;
+        }
+        for (uint32_t i = 0; i < length; i++)
+        {
+            op[i] = ip[i];
+        }
+        ip += length;
+        op += length;
+
+        // The last sequence of a block carries literals only
+        if (ip == iend)
+        {
+            break;
+        }
+
+        // Match offset
+        if (iend - ip < 2)
+        {
+            return -1;
+        }
+        uint32_t offset = (uint32_t)ip[0] | ((uint32_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (uint32_t)(op - dst))
+        {
+            return -1;
+        }
+
+        // Match length
+        length = token & 0xF;
+        if (length == 15 && lz4_read_length(&ip, iend, &length) != 0)
+        {
+            return -1;
+        }
+        length += 4;
+        if (length > (uint32_t)(oend - op))
+        {
+            return -1;
+        }
+
+        // Matches may overlap their own output, so copy forwards byte by byte
+        const uint8_t *match = op - offset;
+        for (uint32_t i = 0; i < length; i++)
+        {
+            op[i] = match[i];
+        }
+        op += length;
+    }
+
+    return (int32_t)(op - dst);
+}
@@ -0,0 +1,15 @@
+/*
+ * Description: Minimal LZ4 block decoder used by the boot pack loader. Only the raw
+ * block format is supported (no frame header); every block is decoded on its own so
+ * any core can pick up any block.
+ */
+
+#ifndef LZ4_BLOCK_H
+#define LZ4_BLOCK_H
+
+#include "stdint.h"
+
+// Returns the number of bytes written to dst, or -1 if the block is malformed
+int32_t lz4_decompress_block(const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity);
+
+#endif
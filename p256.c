@@ -0,0 +1,744 @@
+/*
+ * Description: ECDSA P-256 verification (see p256.h). Field and scalar arithmetic use
+ * 8 x 32-bit limbs in Montgomery form with one generic multiply for both moduli, points
+ * use Jacobian coordinates, and the comb tables are added in mixed coordinates. The
+ * final x(R) == r check is done projectively, so the only inversion is s^-1 mod n.
+ */
+
+#include "string.h"
+#include "p256.h"
+
+struct p256_modulus
+{
+    uint32_t m[8];
+    uint32_t rr[8];                 // 2^512 mod m, for conversion into Montgomery form
+    uint32_t n0;                    // -m^-1 mod 2^32
+};
+
+struct p256_jacobian
+{
+    uint32_t x[8];
+    uint32_t y[8];
+    uint32_t z[8];
+};
+
+static const struct p256_modulus p256P =
+{
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0xFFFFFFFF },
+    { 0x00000003, 0x00000000, 0xFFFFFFFF, 0xFFFFFFFB, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFD, 0x00000004 },
+    0x00000001
+};
+
+static const struct p256_modulus p256N =
+{
+    { 0xFC632551, 0xF3B9CAC2, 0xA7179E84, 0xBCE6FAAD, 0xFFFFFFFF, 0xFFFFFFFF, 0x00000000, 0xFFFFFFFF },
+    { 0xBE79EEA2, 0x83244C95, 0x49BD6FA6, 0x4699799C, 0x2B6BEC59, 0x2845B239, 0xF3D95620, 0x66E12D94 },
+    0xEE00BC4F
+};
+
+static const uint32_t p256B[8] =
+{
+    0x27D2604B, 0x3BCE3C3E, 0xCC53B0F6, 0x651D06B0, 0x769886BC, 0xB3EBBD55, 0xAA3A93E7, 0x5AC635D8
+};
+
+// Comb table for the generator G, as produced by p256_comb_build() from its coordinates
+static const struct p256_comb p256BaseComb =
+{
+    {
+        {
+            { 0x18A9143C, 0x79E730D4, 0x5FEDB601, 0x75BA95FC, 0x77622510, 0x79FB732B, 0xA53755C6, 0x18905F76 },
+            { 0xCE95560A, 0xDDF25357, 0xBA19E45C, 0x8B4AB8E4, 0xDD21F325, 0xD2E88688, 0x25885D85, 0x8571FF18 }
+        },
+        {
+            { 0x03605C39, 0x89105079, 0xA142C96C, 0xF0843D9E, 0x16923684, 0xF3744934, 0xFA0A2893, 0x732CAA2F },
+            { 0x61160170, 0xB2E8C270, 0x437FBAA3, 0xC32788CC, 0xA6EDA3AC, 0x39CD818E, 0x9E2B2E07, 0xE2E94239 }
+        },
+        {
+            { 0xABC3E190, 0xB9C0D276, 0xCB55B9CA, 0x610E3D4D, 0x5720F50A, 0xD16DBD02, 0xA607DE84, 0xD0ED73DC },
+            { 0x49219FB5, 0x3BBDE5BF, 0x57771843, 0x698E12C0, 0x63470A5E, 0xDB606A97, 0x853635D5, 0x61C71975 }
+        },
+        {
+            { 0xEC7FAE9F, 0xEB5DDCB6, 0xEFB66E5A, 0x995F2714, 0x69445D52, 0xDEE95D8E, 0x09E27620, 0x1B6C2D46 },
+            { 0x8129D716, 0x32621C31, 0x0958C1AA, 0xB03909F1, 0x1AF4AF63, 0x8C468EF9, 0xFBA5CDF6, 0x162C429F }
+        },
+        {
+            { 0xC1D85F12, 0x4615D912, 0xE1F4E302, 0x1F0880B0, 0x6F1FCA13, 0x336BCC89, 0xC70DEDBC, 0xDA59AD0D },
+            { 0xB0F62ECE, 0x3897EFAE, 0xF4990CFD, 0xBAED81CD, 0x60321BBB, 0xA3B1C2F2, 0xDDC84F79, 0x2AEFD95A }
+        },
+        {
+            { 0xEE9E92E6, 0x2D427E3C, 0x437FE629, 0x43D40DA0, 0x6AB72B31, 0x0006E4E0, 0x6F5C8E02, 0x21CCFBB4 },
+            { 0x53E821EC, 0x53A2F1A7, 0xE209D591, 0x5D72D201, 0x45E8AD41, 0xFD84A264, 0x4059CC6E, 0x86EE0E68 }
+        },
+        {
+            { 0x9248FCE2, 0x3D8242D0, 0x7F49F33D, 0x32D4BF82, 0x29D41FD1, 0x78807BEB, 0xF8F562CB, 0xFCE48B99 },
+            { 0x9F38F097, 0x72A7D484, 0xA37059AD, 0x1B482C10, 0x472E5ED3, 0xC1AA8284, 0xEF23E9C9, 0xC5D6F3BB }
+        },
+        {
+            { 0xB8A24A20, 0x23F949FE, 0xF52CA53F, 0x17EBFED1, 0xBCFB4853, 0x9B691BBE, 0x6278A05D, 0x5617FF6B },
+            { 0xE3C99EBD, 0x241B34C5, 0x1784156A, 0xFC64242E, 0x695D67DF, 0x4206482F, 0xEE27C011, 0xB967CE0E }
+        },
+        {
+            { 0x9FC3DF19, 0x569AACDF, 0xC34C6FB2, 0x0C6782C7, 0xC4EC873D, 0xBB5F98B2, 0x9FE9E475, 0x5578433B },
+            { 0x9CA84821, 0xFA14F386, 0x39589501, 0xB8EF658D, 0x07127B8E, 0x4022C48E, 0x5402EA12, 0xCBC4DFE3 }
+        },
+        {
+            { 0x2AD408A3, 0x092EF96A, 0xCFBC45A3, 0xF1E1A4C4, 0xEFEECDEE, 0x966B2676, 0x3A6216C5, 0xA0E2C671 },
+            { 0x92C4BF61, 0xCD6E22A2, 0xD830DFC7, 0x56D99A11, 0x259DE547, 0xB8C612BD, 0xE91F8FF7, 0x3D8E9A72 }
+        },
+        {
+            { 0x2352B4FF, 0x0B885E96, 0xA6545766, 0x6BE320D2, 0xB9A59E72, 0xBD22A444, 0xCCC55D7D, 0x2F2D32D6 },
+            { 0xDDCEC70B, 0xD86E4C4C, 0x7A25C934, 0x19CDB0E9, 0x9CA97E28, 0x542ADE06, 0x746517F7, 0x58C5927C }
+        },
+        {
+            { 0x8D087091, 0x24ABB0F0, 0x51ADD8DE, 0x6AA2C2EF, 0xCC2A2134, 0xC3E1CB4C, 0x95589212, 0x35631128 },
+            { 0x7984344B, 0x3BF17D2A, 0xF8A142CC, 0xBCB6F7B2, 0x08EC9266, 0xD6057D8A, 0x2852405A, 0x75C150D2 }
+        },
+        {
+            { 0xA9FEE73E, 0xA8F88EB5, 0x576EA39B, 0x72A84174, 0xE2692E7D, 0x671FA0AD, 0x96769F9E, 0x25562885 },
+            { 0xE850A6B0, 0x254323BC, 0xFFF6C89A, 0x74B61C18, 0xCFAE2690, 0x2E7C563F, 0x164AFB0F, 0x2CF454B7 }
+        },
+        {
+            { 0x8F10F423, 0xE312A561, 0xF2B85DF4, 0x59A1F1FF, 0x41C48122, 0x56C59919, 0xAE3D175F, 0x74953C1E },
+            { 0x8859244C, 0x4D767FC7, 0x719A4CC1, 0xC486BC00, 0xDF1C1787, 0xDD282985, 0xAE93C719, 0x1143301A }
+        },
+        {
+            { 0x1FAB7D71, 0x7201A1D6, 0x32CBBEE8, 0x65931F54, 0xDCB387EE, 0x202955D3, 0xC4678432, 0xA5045BA5 },
+            { 0xDCA85FF6, 0xCFB5EE87, 0xDFEC0F67, 0xDD25A7C6, 0x356A87C6, 0xFEE47169, 0xC3D7ECE9, 0x20A8F159 }
+        },
+        {
+            { 0x070D3AAB, 0xE4AC8B33, 0x9A2CD5E5, 0x2643672B, 0x1CFC9173, 0x52EFF79B, 0x90A7C13F, 0x665CA49B },
+            { 0xB3EFB998, 0x5A8DDA59, 0x052F1341, 0x8A5B922D, 0x3CF9A530, 0xAE9EBBAB, 0xF56DA4D7, 0x35986E7B }
+        },
+        {
+            { 0xBC0A70C0, 0x21E07F9A, 0x989A0182, 0xECFDB3A2, 0xE40E8125, 0x360682C0, 0x2F837F32, 0x73A63795 },
+            { 0x9C0D326B, 0xF4EB8CEF, 0xEBF4C7A5, 0xEFB97FEC, 0xAF3D5D7E, 0xF9352123, 0x34E22AB1, 0xB71EF4EF }
+        },
+        {
+            { 0x0D488032, 0xD6BD0D81, 0x71F0B92E, 0x1676DF99, 0xB6D215AC, 0xA7ACDCFC, 0xCD0FF939, 0x82461A26 },
+            { 0xB635D2E5, 0x827189C0, 0xA92F1622, 0x18F3B6DD, 0x05CEF325, 0x10D738AA, 0x39BB0AA6, 0x12C2A13F }
+        },
+        {
+            { 0xB50B4E82, 0x5F94D8DE, 0x34BD93E9, 0xBCD9144E, 0x07C08623, 0x61C33921, 0x7E3DE8EE, 0xEDEC947E },
+            { 0x2F21B202, 0x9D2DA51D, 0x96692A89, 0xC0C885CD, 0xA5E7309C, 0x4A613462, 0x0F28DEE6, 0x22778855 }
+        },
+        {
+            { 0x7695447A, 0x1FF0BD52, 0x42AE2627, 0x63534A4A, 0xD0CC09F2, 0xD96AF0DA, 0x412D3E1A, 0xB59EA545 },
+            { 0x6A759072, 0xD10518CF, 0x10475DFD, 0xFFEEC37C, 0xB25089C4, 0xACBC29CC, 0x21B6D4EE, 0xBF3DFC85 }
+        },
+        {
+            { 0x49388995, 0x8F2EACFE, 0x841BE9ED, 0x000FC8D4, 0x6955C290, 0x2ED8085A, 0x6D8E176F, 0x1929CF60 },
+            { 0xFD1A09DB, 0x2EFD26A5, 0x6CB626CD, 0x58D767AD, 0xB26C6E05, 0x13A81B95, 0x8F61832B, 0x68FE6107 }
+        },
+        {
+            { 0x2D85C2F6, 0x4AD7DE2E, 0x510101A1, 0xCD552FCB, 0x02ACDABF, 0x638D122B, 0x50BFD921, 0x117221E8 },
+            { 0x99A99129, 0x08571EE1, 0xBA2F03A9, 0xEBD046D1, 0xA6F8A181, 0x035ED7BA, 0x3187C6F3, 0x8AABF98D }
+        },
+        {
+            { 0xE3AB5F4E, 0xAF8E65CA, 0x7561A69C, 0x8B0B8B89, 0xB17C1E66, 0x37E83AA0, 0xF8D80EDC, 0xE894D84C },
+            { 0xCE514E22, 0xF1E465E7, 0xA72340EF, 0xC7FA324C, 0xE7370673, 0x08297FCA, 0xB119AE5E, 0x4F799682 }
+        },
+        {
+            { 0xF180F206, 0x014D6BD8, 0x7AB44F55, 0x56640C8B, 0x93F9A5B8, 0x9A39660D, 0x959B68F1, 0xCAC069E9 },
+            { 0x208D9918, 0x2BF6B65E, 0x3F943291, 0xB7E45DFB, 0xD439C712, 0xAD5770F0, 0x7654D805, 0xFEC635E1 }
+        },
+        {
+            { 0x3F031A88, 0x37221CD1, 0x0B5558D4, 0xE4D53D2F, 0xDAFC51CD, 0x2EDE8E8F, 0xA8A883EA, 0xB587284C },
+            { 0x44FA5251, 0xFA376740, 0x5C5E3528, 0x5E5E18F9, 0x6E10B958, 0x8AF51FAC, 0x2C429B30, 0x09BE7903 }
+        },
+        {
+            { 0x7F29936D, 0x7A468BA4, 0x7CFB8176, 0xACBBE365, 0x4DB9CD5D, 0xE892C10A, 0xA1AADE8B, 0xCB2F29D7 },
+            { 0xEFFFCB14, 0x3087EEF4, 0x2AFE8F2E, 0x92A7F3EC, 0x136F29D2, 0x199D89B8, 0xB4836623, 0x3131604E }
+        },
+        {
+            { 0x31B5DF76, 0xF5CCA5DA, 0x76A4ABC0, 0x94313186, 0x1877C7C7, 0x5DB8E6F7, 0x6031AC99, 0x3CE3F5F9 },
+            { 0x7E7CEF80, 0x585961D0, 0xD424F16A, 0x5ED6E841, 0x56B16A49, 0x18289CD0, 0x2E5770FA, 0x8008D03B }
+        },
+        {
+            { 0x254E39DE, 0xC8C2AF64, 0x8582571C, 0x783CEA73, 0xA6EDD971, 0x2F2F55F1, 0xC86BF30A, 0x7E00CC92 },
+            { 0x47D7491F, 0xA0DB7354, 0xA5B12260, 0xB3EB751C, 0x297FB234, 0x3BC39A23, 0xB8B4BFE4, 0xD1330C20 }
+        },
+        {
+            { 0x7824D53A, 0xFB776AF0, 0x422DEA35, 0x04709096, 0x5FEC3AC7, 0x6F480B6B, 0xE27EDDA4, 0xDB2B1B62 },
+            { 0xDA78B494, 0x0BBA904C, 0x91A147F7, 0x37EF59B6, 0x26A4730A, 0xF8805177, 0xA8AB368E, 0xECC9D79A }
+        },
+        {
+            { 0x85A4BD0E, 0x628E05C1, 0x00E244E8, 0xEBF7B678, 0x8B176EEB, 0xF645947B, 0x1641AB35, 0xC92BF830 },
+            { 0x21BE7A6F, 0x7A039C1A, 0x2FD4BD92, 0x11E4354D, 0x886FD224, 0x42552422, 0xC44CED37, 0xDBF3194C }
+        },
+        {
+            { 0xC56F6B04, 0x832DA983, 0x8EF098AE, 0x7AAA84EB, 0xA6A616A2, 0x602E3EEF, 0xB7B717A3, 0xC2824DDC },
+            { 0xDDB0A2E9, 0x19F50324, 0x5BEDFBBD, 0x04553A28, 0xAA1AEE0A, 0x37EA8B12, 0x945959A1, 0xC1844E79 }
+        },
+        {
+            { 0xE0F222C2, 0x5043DEA7, 0x72E65142, 0x309D42AC, 0x9216CD30, 0x94FE9DDD, 0x0F87FEEC, 0xD6539C7D },
+            { 0x432AC7D7, 0x03C5A57C, 0x327FDA10, 0x72692CF0, 0x280698DE, 0xEC28C85F, 0x7EC283B1, 0x2331FB46 }
+        },
+        {
+            { 0x43248E67, 0x651CFDEB, 0xEE561DE8, 0x2C3D72CE, 0x443DAC8B, 0xA48B8F33, 0x7991F986, 0xE6B042FE },
+            { 0xE810BCD2, 0xD091636D, 0xA97416D7, 0xFC1E96AE, 0x2892694D, 0x2B6087CB, 0x9985A628, 0x0F8AC245 }
+        },
+        {
+            { 0x7F2326A2, 0x54E90874, 0xFA9E1131, 0xCE43DD44, 0xD3D2D948, 0x4B2C740C, 0xA86E8B07, 0x9B0B126A },
+            { 0xB77F5AF2, 0x228EF320, 0xCA07661C, 0x14FC8A01, 0xD34F1A3A, 0x1D72509E, 0x29D9086E, 0xD1690317 }
+        },
+        {
+            { 0x03C5FE33, 0x13E44ACC, 0x0105BBC6, 0x13F4374E, 0xCB4451B8, 0x0CBA5018, 0xFA29A4E1, 0xA1A38E4A },
+            { 0xF4403917, 0x063FB9A8, 0x996EA7F2, 0x7AFE108F, 0xF93A1F87, 0xEC252363, 0x7E432609, 0xC029C811 }
+        },
+        {
+            { 0x486E548E, 0x25080C29, 0x7868AB32, 0xDAA41132, 0xD61D1A3A, 0x46891511, 0x3EFC8FAC, 0xC87F3F53 },
+            { 0xF3E31393, 0x984F613F, 0x7648F5D2, 0x10BB15F6, 0xDEFAA440, 0xE4990F2B, 0xDD51C31D, 0xCE647F03 }
+        },
+        {
+            { 0x9C2C0ABF, 0x3161EBDD, 0xF497CF35, 0x48B7EE7B, 0x94DD9C97, 0x9233E31D, 0xC5D2988F, 0x4AEF9A62 },
+            { 0xA03E6456, 0x89A54161, 0xC1F02B47, 0x9D25E003, 0xC1857782, 0x8784CDBF, 0x0222B49C, 0x7928CAFD }
+        },
+        {
+            { 0xECF4EA23, 0x5A591ABD, 0x80BD9B8A, 0xB2725E8A, 0x29FF348B, 0xF569679F, 0x6F22536A, 0xA28163D3 },
+            { 0x21C43971, 0x89E7A8F6, 0xC4A09567, 0x60CBE4A1, 0x5928B03D, 0x41046C8F, 0xEF74A95A, 0x646FEDA7 }
+        },
+        {
+            { 0x5D75D310, 0x3AEF6BC0, 0x82476E5C, 0xF3E7F03C, 0x8419B8A0, 0x9DCF3D50, 0xEAF07F07, 0x221A3885 },
+            { 0x37BDCB7D, 0x16D533F3, 0xBB49550D, 0xD778066B, 0x36C2600C, 0xF6F45409, 0xC1C61709, 0x7544396F }
+        },
+        {
+            { 0xDE08CD42, 0xF79F556F, 0xE13CADC8, 0x7D0ABA1E, 0xD4D81FEF, 0x841D9DF6, 0x602D2043, 0x8F7AE1F2 },
+            { 0xB57EE181, 0x950C4DE4, 0xC55CF490, 0xFE51E045, 0x1EFDD0A8, 0xDB60B56A, 0xBF0FA497, 0x276BCCB3 }
+        },
+        {
+            { 0x19E5A603, 0x7926625B, 0xE1BF712B, 0xF1B98E93, 0xE33ABECC, 0x933ECB52, 0xF826619B, 0x9EBFC506 },
+            { 0xA1692C52, 0xD2965F67, 0xFC4F9564, 0x8AC4012D, 0x6739F003, 0xA8AF5703, 0xBC715E13, 0x7DD2282D }
+        },
+        {
+            { 0xCF2BB490, 0x3EC01587, 0x3F1EA428, 0x5346082C, 0x6739E506, 0xF2C679E2, 0x930C28E4, 0xEAB710D6 },
+            { 0xE043249A, 0xE9947FF8, 0xAD54B0E6, 0x63640678, 0x1854EAAF, 0x8CDE4259, 0x6B25BDCE, 0xF1FEEAEC }
+        },
+        {
+            { 0x1BDD2AA2, 0x49F7E899, 0x34E3CAE9, 0x88FD2735, 0x82CBFEA2, 0x5AC05101, 0x4CF84578, 0x324C9D41 },
+            { 0x19F13061, 0xA2423117, 0x5F3B9932, 0x69D67CF1, 0xDDE2DFAD, 0x32ECDB3C, 0xB916F7A6, 0x2F74D995 }
+        },
+        {
+            { 0x3D14BC68, 0x35F7ED42, 0x45574F91, 0x32F63A04, 0x5E8801E7, 0xD0410833, 0x1C9C1462, 0x63B6F13C },
+            { 0x9DC7201F, 0x180DCBCD, 0x360350DF, 0xA07B5B2C, 0x4236F5CC, 0x2582B277, 0xA7AB06B9, 0x90163924 }
+        },
+        {
+            { 0x0767CDF2, 0x35E751B5, 0x9D8E2838, 0x808372E6, 0x646914D7, 0xCBAD6B30, 0x6C7B3CAB, 0x4EEEB1DE },
+            { 0x8C965004, 0x3EF3AF96, 0xD281920B, 0xD162290F, 0x181F811B, 0x4626C313, 0xBE61DD14, 0x5FA42F4F }
+        },
+        {
+            { 0xA185E98E, 0x1F5A9C53, 0xEA9E83C3, 0x13C28277, 0xB693A226, 0xB566E4C0, 0x01533E9E, 0x2EA3F1C0 },
+            { 0x6215A21F, 0xB4DBCC33, 0xCB4E98F0, 0x7DF608C3, 0xB4DD95DD, 0x677DF928, 0xEEED2934, 0x4C1D7142 }
+        },
+        {
+            { 0x86A2EE12, 0x30BF236C, 0x05ECB4C0, 0x74D5A127, 0x1601CCA9, 0x9EF43B0F, 0xAC4DD202, 0xBE1B1BF9 },
+            { 0x17B6F93B, 0x84943E47, 0xCD5214B3, 0x6F789757, 0x7F313DFA, 0x5E0DB1A9, 0xECE0B72B, 0x0515EFAC }
+        },
+        {
+            { 0xA78C3F8B, 0x433A677C, 0xF376A9C1, 0x204A9FEA, 0x44BAEADF, 0xB6BFBEA4, 0x2B48A3F4, 0x5A43CAFD },
+            { 0x67D1D226, 0xE25A7D0B, 0xF6837985, 0xB2115844, 0xD87C2B88, 0x8C9CCA3E, 0x894772E1, 0xECD4BC73 }
+        },
+        {
+            { 0x783490E7, 0x368ABEC6, 0xD925C359, 0xF26DA8BD, 0xE8FB0679, 0xF9B643E5, 0xB555D175, 0x7AB803D9 },
+            { 0x4EBAE595, 0x1B405999, 0xBA417A49, 0x07FBBF25, 0xC617957A, 0x02D7CF1C, 0x565C1FBB, 0x79070EA5 }
+        },
+        {
+            { 0xD9B028FA, 0x70194602, 0x9FF06760, 0x9C49969D, 0x6AD27B42, 0xBF4ADD81, 0x8651524E, 0x7D1F226D },
+            { 0xEECD7724, 0xB0779B40, 0x65938707, 0xD3560772, 0xD054B903, 0xE3A61FE5, 0x3365136B, 0xD6F5A343 }
+        },
+        {
+            { 0xD2970FCF, 0x25C87C76, 0x4D5546A8, 0x7C9F60A0, 0x8DD8BF8C, 0x7DAB072F, 0xE8FF9F28, 0x3D10907C },
+            { 0x34BB2A29, 0xB08D6D0E, 0xC3FCFDAF, 0x5DFD4907, 0x47123BA6, 0xE4A2D4B1, 0x42DE6D8D, 0x6E9EEF0B }
+        },
+        {
+            { 0xCBB55F9D, 0x81255AF5, 0x5328D39E, 0x579F2705, 0x3E5AE663, 0xA7BFC917, 0xA1246E42, 0xE9B55D57 },
+            { 0x75629188, 0x240ECD94, 0x457BD3C0, 0x8748D297, 0x373C361C, 0x50E215EF, 0x18C967B9, 0xAF9D8A86 }
+        },
+        {
+            { 0x0A04143F, 0x79A04104, 0xC700C616, 0x03F7410F, 0x91108CA6, 0xE8F2A3F2, 0xF5AC679A, 0xA26D67E8 },
+            { 0xB83FBD9A, 0xA15DBFEB, 0x3A0B5587, 0xF1AAEBD2, 0xCE0EAD44, 0x639A97DD, 0x71D12EE0, 0xF253B00C }
+        },
+        {
+            { 0x9E35E57C, 0x7BAECF4C, 0x6786E3A5, 0x522E26A1, 0x8AF829A2, 0x600B538B, 0x2C6DE44A, 0x19FA80B7 },
+            { 0xAAF0FF52, 0xB52364F0, 0x6714587F, 0x2E4BC21A, 0xC245967D, 0x401377A3, 0xA23CF3EB, 0x65178766 }
+        },
+        {
+            { 0x923AC000, 0xC1C81838, 0xC4ABC0EE, 0x42021F02, 0x47132A20, 0xCDE3BC9A, 0xC69F55FB, 0x6F52A864 },
+            { 0xDF89FF6A, 0x0BDFD3E4, 0xC88BD74E, 0x244C943B, 0x2612998B, 0x649E0B53, 0xD3413D4A, 0xCE61EBC3 }
+        },
+        {
+            { 0x2CBA5A90, 0xE3162904, 0xDB6C224E, 0xA72710AE, 0xD87E44DB, 0x51831390, 0x48FE2EF3, 0xA687DC98 },
+            { 0x16A21CA9, 0x857E9855, 0xC9A7BC12, 0xE3428D8E, 0x12B044A2, 0x16D3BCD0, 0xE85F6704, 0xE6FA0C69 }
+        },
+        {
+            { 0x8FD42692, 0xE4CCA34B, 0xE15F3ACF, 0xC86D49A6, 0xA6B18392, 0xBFE1F263, 0xDCD266F6, 0x0664C933 },
+            { 0x19399D88, 0x86738CF5, 0x749CE6BC, 0x1CBCC8C3, 0xC773B884, 0x28171F7B, 0x01ACF19E, 0x306FC957 }
+        },
+        {
+            { 0xAFB6A419, 0x0DA7A737, 0x195FBC40, 0x637FC26A, 0x9C64E8E7, 0x0FC8F876, 0x208C0626, 0x2A68579B },
+            { 0x8628ABC3, 0x82E82310, 0xAB23AE94, 0xE4E09313, 0xE5155CF1, 0x66BF9ADB, 0xE8A2DD0C, 0x17909F6C }
+        },
+        {
+            { 0x43D7AD31, 0x767C3596, 0x49CCEF62, 0x7BA3A1AA, 0x0242BF5A, 0x5261C316, 0x9EB82DFB, 0x85F45219 },
+            { 0x37B42E47, 0x554CB382, 0x4CF66133, 0xC9771EC1, 0x153905A3, 0xDE70617A, 0xBC61316D, 0x2CAB26FC }
+        },
+        {
+            { 0x75C10315, 0x7DABABBD, 0xA48DF64E, 0x9A8FBE88, 0xE1B8F912, 0x2B076FE5, 0xCCBD50DC, 0x1A530CE9 },
+            { 0x6647D225, 0x47361AB7, 0x4D636A15, 0xF84E73BE, 0x5904A2FA, 0xD58FCAAF, 0x38523A19, 0x73747D4B }
+        },
+        {
+            { 0xB6864CC0, 0x6E6B0FB8, 0xAB3B623C, 0x5D8A0027, 0x9A1CFC9C, 0x5E666538, 0x521E4FF3, 0x816B19DE },
+            { 0x0BC447F8, 0x56709AD0, 0x8F1464D7, 0x1D46CB1C, 0xA949873D, 0x49CEF820, 0xD9D3E65F, 0x02804692 }
+        },
+        {
+            { 0xAD8B5976, 0x1AE0EA28, 0x869458FB, 0x4E9AD48E, 0x96CFEDF8, 0xE9437EC9, 0x2AFA74D9, 0xA4F924A2 },
+            { 0xAAF797C0, 0xCB5B1845, 0xBA6F557F, 0xE5D6DD0E, 0x91DC2E7C, 0xA1496FE6, 0x8C179FC7, 0xAD31EDAC }
+        },
+        {
+            { 0x44B06ED7, 0xF9C5E9DE, 0x4A597159, 0x6CE7C4F7, 0x833ACCB5, 0xD02EC441, 0x6296E8FC, 0xF3020599 },
+            { 0xC2AFBE06, 0x7DF6C5C6, 0x9C849B09, 0xFF429DDA, 0xF5DD78D6, 0x42170166, 0x830C388B, 0x2403EA21 }
+        }
+    }
+};
+
+static void p256_from_bytes(uint32_t *r, const uint8_t *bytes)
+{
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        const uint8_t *word = &bytes[28 - 4 * i];
+        r[i] = ((uint32_t)word[0] << 24) | ((uint32_t)word[1] << 16) | ((uint32_t)word[2] << 8) | word[3];
+    }
+}
+
+static uint8_t p256_is_zero(const uint32_t *a)
+{
+    uint32_t bits = 0;
+
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        bits |= a[i];
+    }
+
+    return bits == 0;
+}
+
+// Returns 1 if a >= b
+static uint8_t p256_greater_equal(const uint32_t *a, const uint32_t *b)
+{
+    for (int32_t i = 7; i >= 0; i--)
+    {
+        if (a[i] != b[i])
+        {
+            return a[i] > b[i];
+        }
+    }
+
+    return 1;
+}
+
+// r = a - b, returning the borrow
+static uint32_t p256_sub_raw(uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+    int64_t borrow = 0;
+
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        borrow += (int64_t)a[i] - b[i];
+        r[i] = (uint32_t)borrow;
+        borrow >>= 32;
+    }
+
+    return (uint32_t)(borrow & 1);
+}
+
+// r = a + b, returning the carry
+static uint32_t p256_add_raw(uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+    uint64_t carry = 0;
+
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        carry += (uint64_t)a[i] + b[i];
+        r[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+
+    return (uint32_t)carry;
+}
+
+static void p256_mod_add(const struct p256_modulus *mod, uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+    if (p256_add_raw(r, a, b) || p256_greater_equal(r, mod->m))
+    {
+        p256_sub_raw(r, r, mod->m);
+    }
+}
+
+static void p256_mod_sub(const struct p256_modulus *mod, uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+    if (p256_sub_raw(r, a, b))
+    {
+        p256_add_raw(r, r, mod->m);
+    }
+}
+
+// r = a * b / 2^256 mod m (CIOS); r may alias a or b
+static void p256_mont_mul(const struct p256_modulus *mod, uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+    uint32_t t[10] = { 0 };
+
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        uint64_t carry = 0;
+
+        for (uint32_t j = 0; j < 8; j++)
+        {
+            carry += t[j] + (uint64_t)a[j] * b[i];
+            t[j] = (uint32_t)carry;
+            carry >>= 32;
+        }
+        carry += t[8];
+        t[8] = (uint32_t)carry;
+        t[9] = (uint32_t)(carry >> 32);
+
+        uint32_t factor = t[0] * mod->n0;
+        carry = (t[0] + (uint64_t)factor * mod->m[0]) >> 32;
+        for (uint32_t j = 1; j < 8; j++)
+        {
+            carry += t[j] + (uint64_t)factor * mod->m[j];
+            t[j - 1] = (uint32_t)carry;
+            carry >>= 32;
+        }
+        carry += t[8];
+        t[7] = (uint32_t)carry;
+        t[8] = t[9] + (uint32_t)(carry >> 32);
+    }
+
+    if (t[8] != 0 || p256_greater_equal(t, mod->m))
+    {
+        p256_sub_raw(t, t, mod->m);
+    }
+    memcpy(r, t, 8 * sizeof(uint32_t));
+}
+
+// r = a^(m - 2), i.e. a^-1 in Montgomery form
+static void p256_mod_inverse(const struct p256_modulus *mod, uint32_t *r, const uint32_t *a)
+{
+    uint32_t exponent[8];
+    uint32_t two[8] = { 2 };
+    uint32_t result[8];
+
+    p256_sub_raw(exponent, mod->m, two);
+
+    // Montgomery one is 2^256 mod m = 2^256 - m
+    memset(result, 0, sizeof(result));
+    p256_sub_raw(result, result, mod->m);
+
+    for (int32_t bit = 255; bit >= 0; bit--)
+    {
+        p256_mont_mul(mod, result, result, result);
+        if ((exponent[bit / 32] >> (bit % 32)) & 1)
+        {
+            p256_mont_mul(mod, result, result, a);
+        }
+    }
+
+    memcpy(r, result, sizeof(result));
+}
+
+// Field shorthands, everything in Montgomery form mod p
+static void p256_fmul(uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+    p256_mont_mul(&p256P, r, a, b);
+}
+
+static void p256_fadd(uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+    p256_mod_add(&p256P, r, a, b);
+}
+
+static void p256_fsub(uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+    p256_mod_sub(&p256P, r, a, b);
+}
+
+// p = 2p, with a = -3 (dbl-2001-b)
+static void p256_double(struct p256_jacobian *p)
+{
+    uint32_t delta[8], gamma[8], beta[8], alpha[8], t0[8], t1[8];
+
+    p256_fmul(delta, p->z, p->z);
+    p256_fmul(gamma, p->y, p->y);
+    p256_fmul(beta, p->x, gamma);
+
+    p256_fsub(t0, p->x, delta);
+    p256_fadd(t1, p->x, delta);
+    p256_fmul(alpha, t0, t1);
+    p256_fadd(t0, alpha, alpha);
+    p256_fadd(alpha, alpha, t0);
+
+    // z3 = (y + z)^2 - gamma - delta
+    p256_fadd(t0, p->y, p->z);
+    p256_fmul(t0, t0, t0);
+    p256_fsub(t0, t0, gamma);
+    p256_fsub(p->z, t0, delta);
+
+    // x3 = alpha^2 - 8 * beta
+    p256_fadd(beta, beta, beta);
+    p256_fadd(beta, beta, beta);
+    p256_fadd(t1, beta, beta);
+    p256_fmul(t0, alpha, alpha);
+    p256_fsub(p->x, t0, t1);
+
+    // y3 = alpha * (4 * beta - x3) - 8 * gamma^2
+    p256_fsub(t0, beta, p->x);
+    p256_fmul(t0, alpha, t0);
+    p256_fmul(gamma, gamma, gamma);
+    p256_fadd(gamma, gamma, gamma);
+    p256_fadd(gamma, gamma, gamma);
+    p256_fadd(gamma, gamma, gamma);
+    p256_fsub(p->y, t0, gamma);
+}
+
+// p = p + q for an affine q (madd-2007-bl)
+static void p256_add_affine(struct p256_jacobian *p, const struct p256_affine *q)
+{
+    uint32_t z1z1[8], u2[8], s2[8], h[8], hh[8], i[8], j[8], r[8], v[8], t0[8];
+
+    if (p256_is_zero(p->z))
+    {
+        memcpy(p->x, q->x, sizeof(p->x));
+        memcpy(p->y, q->y, sizeof(p->y));
+        memset(p->z, 0, sizeof(p->z));
+        p256_sub_raw(p->z, p->z, p256P.m);     // Montgomery one
+        return;
+    }
+
+    p256_fmul(z1z1, p->z, p->z);
+    p256_fmul(u2, q->x, z1z1);
+    p256_fmul(s2, q->y, p->z);
+    p256_fmul(s2, s2, z1z1);
+    p256_fsub(h, u2, p->x);
+    p256_fsub(r, s2, p->y);
+
+    if (p256_is_zero(h))
+    {
+        if (p256_is_zero(r))
+        {
+            p256_double(p);
+        }
+        else
+        {
+            memset(p->z, 0, sizeof(p->z));
+        }
+        return;
+    }
+
+    p256_fadd(r, r, r);
+    p256_fmul(hh, h, h);
+    p256_fadd(i, hh, hh);
+    p256_fadd(i, i, i);
+    p256_fmul(j, h, i);
+    p256_fmul(v, p->x, i);
+
+    // z3 = (z1 + h)^2 - z1z1 - hh
+    p256_fadd(t0, p->z, h);
+    p256_fmul(t0, t0, t0);
+    p256_fsub(t0, t0, z1z1);
+    p256_fsub(p->z, t0, hh);
+
+    // x3 = r^2 - j - 2 * v
+    p256_fmul(t0, r, r);
+    p256_fsub(t0, t0, j);
+    p256_fsub(t0, t0, v);
+    p256_fsub(p->x, t0, v);
+
+    // y3 = r * (v - x3) - 2 * y1 * j
+    p256_fmul(j, p->y, j);
+    p256_fadd(j, j, j);
+    p256_fsub(t0, v, p->x);
+    p256_fmul(t0, r, t0);
+    p256_fsub(p->y, t0, j);
+}
+
+static void p256_to_affine(struct p256_affine *r, const struct p256_jacobian *p)
+{
+    uint32_t zInverse[8], zz[8];
+
+    p256_mod_inverse(&p256P, zInverse, p->z);
+    p256_fmul(zz, zInverse, zInverse);
+    p256_fmul(r->x, p->x, zz);
+    p256_fmul(zz, zz, zInverse);
+    p256_fmul(r->y, p->y, zz);
+}
+
+// Comb index for column `column`: bit column + P256_COMB_SPACING * j of k becomes bit j
+static uint32_t p256_comb_index(const uint32_t *k, uint32_t column)
+{
+    uint32_t index = 0;
+
+    for (uint32_t j = 0; j < P256_COMB_TEETH; j++)
+    {
+        uint32_t bit = column + P256_COMB_SPACING * j;
+        if (bit < 256)
+        {
+            index |= ((k[bit / 32] >> (bit % 32)) & 1) << j;
+        }
+    }
+
+    return index;
+}
+
+int32_t p256_comb_build(struct p256_comb *comb, const uint8_t *publicKey)
+{
+    struct p256_affine teeth[P256_COMB_TEETH];
+    struct p256_jacobian point;
+    uint32_t lhs[8], rhs[8], t0[8];
+
+    // Convert into Montgomery form and check y^2 = x^3 - 3x + b
+    p256_from_bytes(point.x, publicKey);
+    p256_from_bytes(point.y, publicKey + P256_SCALAR_SIZE);
+    if (p256_greater_equal(point.x, p256P.m) || p256_greater_equal(point.y, p256P.m))
+    {
+        return -1;
+    }
+    p256_fmul(point.x, point.x, p256P.rr);
+    p256_fmul(point.y, point.y, p256P.rr);
+
+    p256_fmul(lhs, point.y, point.y);
+    p256_fmul(rhs, point.x, point.x);
+    p256_fmul(rhs, rhs, point.x);
+    p256_fadd(t0, point.x, point.x);
+    p256_fadd(t0, t0, point.x);
+    p256_fsub(rhs, rhs, t0);
+    p256_fmul(t0, p256B, p256P.rr);
+    p256_fadd(rhs, rhs, t0);
+    if (memcmp(lhs, rhs, sizeof(lhs)) != 0)
+    {
+        return -1;
+    }
+
+    // Tooth j is 2^(P256_COMB_SPACING * j) * P
+    memset(point.z, 0, sizeof(point.z));
+    p256_sub_raw(point.z, point.z, p256P.m);
+    for (uint32_t j = 0; j < P256_COMB_TEETH; j++)
+    {
+        if (j != 0)
+        {
+            for (uint32_t i = 0; i < P256_COMB_SPACING; i++)
+            {
+                p256_double(&point);
+            }
+        }
+        p256_to_affine(&teeth[j], &point);
+    }
+
+    // Every other entry adds its highest tooth to an earlier entry
+    for (uint32_t i = 1; i <= P256_COMB_ENTRIES; i++)
+    {
+        uint32_t top = 0;
+        while ((i >> (top + 1)) != 0)
+        {
+            top++;
+        }
+
+        uint32_t rest = i & ~(1U << top);
+        if (rest == 0)
+        {
+            comb->points[i - 1] = teeth[top];
+            continue;
+        }
+
+        memcpy(point.x, comb->points[rest - 1].x, sizeof(point.x));
+        memcpy(point.y, comb->points[rest - 1].y, sizeof(point.y));
+        memset(point.z, 0, sizeof(point.z));
+        p256_sub_raw(point.z, point.z, p256P.m);
+        p256_add_affine(&point, &teeth[top]);
+        p256_to_affine(&comb->points[i - 1], &point);
+    }
+
+    return 0;
+}
+
+int32_t p256_verify(const struct p256_comb *key, const uint8_t *hash, uint32_t hashSize,
+    const uint8_t *signature)
+{
+    uint8_t truncated[P256_SCALAR_SIZE];
+    uint32_t r[8], s[8], e[8], u1[8], u2[8], t0[8];
+
+    p256_from_bytes(r, signature);
+    p256_from_bytes(s, signature + P256_SCALAR_SIZE);
+    if (p256_is_zero(r) || p256_is_zero(s) || p256_greater_equal(r, p256N.m) || p256_greater_equal(s, p256N.m))
+    {
+        return -1;
+    }
+
+    // e is the leftmost 256 bits of the hash, reduced mod n
+    memset(truncated, 0, sizeof(truncated));
+    if (hashSize >= P256_SCALAR_SIZE)
+    {
+        memcpy(truncated, hash, P256_SCALAR_SIZE);
+    }
+    else
+    {
+        memcpy(truncated + P256_SCALAR_SIZE - hashSize, hash, hashSize);
+    }
+    p256_from_bytes(e, truncated);
+    if (p256_greater_equal(e, p256N.m))
+    {
+        p256_sub_raw(e, e, p256N.m);
+    }
+
+    // u1 = e / s, u2 = r / s; multiplying a plain value by the Montgomery form of s^-1
+    // leaves a plain result
+    p256_mont_mul(&p256N, t0, s, p256N.rr);
+    p256_mod_inverse(&p256N, t0, t0);
+    p256_mont_mul(&p256N, u1, e, t0);
+    p256_mont_mul(&p256N, u2, r, t0);
+
+    // R = u1 * G + u2 * Q, one shared doubling per comb column
+    struct p256_jacobian point;
+    memset(&point, 0, sizeof(point));
+    for (int32_t column = P256_COMB_SPACING - 1; column >= 0; column--)
+    {
+        uint32_t index;
+
+        p256_double(&point);
+        index = p256_comb_index(u1, column);
+        if (index != 0)
+        {
+            p256_add_affine(&point, &p256BaseComb.points[index - 1]);
+        }
+        index = p256_comb_index(u2, column);
+        if (index != 0)
+        {
+            p256_add_affine(&point, &key->points[index - 1]);
+        }
+    }
+
+    if (p256_is_zero(point.z))
+    {
+        return -1;
+    }
+
+    // x(R) mod n == r, compared as X == r * Z^2 (and (r + n) * Z^2 when that is below p)
+    uint32_t zz[8];
+    p256_fmul(zz, point.z, point.z);
+    p256_fmul(t0, r, p256P.rr);
+    p256_fmul(t0, t0, zz);
+    if (memcmp(t0, point.x, sizeof(t0)) == 0)
+    {
+        return 0;
+    }
+
+    if (p256_add_raw(t0, r, p256N.m) == 0 && !p256_greater_equal(t0, p256P.m))
+    {
+        p256_fmul(t0, t0, p256P.rr);
+        p256_fmul(t0, t0, zz);
+        if (memcmp(t0, point.x, sizeof(t0)) == 0)
+        {
+            return 0;
+        }
+    }
+
+    return -1;
+}
@@ -0,0 +1,44 @@
+/*
+ * Description: ECDSA P-256 signature verification against a fixed public key. Both the
+ * generator and the public key are multiplied with fixed-base comb tables: the table for
+ * the generator is built into p256.c and the one for the key is generated on the host by
+ * tools/bootpack.c (-K), so a verification is P256_COMB_SPACING doublings, two table
+ * additions per doubling and one inversion mod n. Verification works on public data only
+ * and is not constant time.
+ */
+
+#ifndef P256_H
+#define P256_H
+
+#include "stdint.h"
+
+#define P256_SCALAR_SIZE 32
+#define P256_SIGNATURE_SIZE 64      // r || s, big-endian
+#define P256_PUBLIC_KEY_SIZE 64     // x || y, big-endian
+
+// Comb of P256_COMB_TEETH points spaced P256_COMB_SPACING bits apart
+#define P256_COMB_TEETH 6
+#define P256_COMB_SPACING 43
+#define P256_COMB_ENTRIES ((1 << P256_COMB_TEETH) - 1)
+
+// Affine point with both coordinates in Montgomery form, least significant word first
+struct p256_affine
+{
+    uint32_t x[8];
+    uint32_t y[8];
+};
+
+// points[i - 1] = sum of 2^(P256_COMB_SPACING * j) * P over the set bits j of i
+struct p256_comb
+{
+    struct p256_affine points[P256_COMB_ENTRIES];
+};
+
+// Builds the comb table for a public key; returns -1 if the point is not on the curve
+int32_t p256_comb_build(struct p256_comb *comb, const uint8_t *publicKey);
+
+// Checks an ECDSA signature over a hash (truncated to 256 bits); returns 0 if valid
+int32_t p256_verify(const struct p256_comb *key, const uint8_t *hash, uint32_t hashSize,
+    const uint8_t *signature);
+
+#endif
@@ -2,8 +2,10 @@
  * Author: Ryan Proietto
  * Description: This file was written in Vitis 2024 in support of the Xilinx ZCU102
  * Reference Board. This program was written to run on the Cortex-R5 processor and
- * is responsible for bootstrapping an ELF32 application from the on-board SDHC SD
- * Card.
+ * orchestrates the boot of both processors from the on-board SDHC SD Card: it loads
+ * AT-F(bl31) and u-boot for the Cortex-A53 and releases the APU into them, then loads
+ * the ELF32 application for R5-0 while the APU runs. When the RPU runs in split mode,
+ * R5-1's own image streams in alongside R5-0's and R5-1 is released as soon as it is in.
  */
 
 // Standard Libraries 
@@ -14,195 +16,334 @@
 // Xilinx Libraries
 #include "ff.h"         // Include the FatFs library header
 #include "xil_cache.h"  // Include cache management functions
+#include "xil_mpu.h"    // Include MPU region configuration
 #include <xil_printf.h> // Include Debug IO
 
 // Addtional Libraries
-#include "elf.h"
+#include "elf_loader.h"
+#include "apu_control.h"
+#include "boot_map.h"
+#include "boot_memmap.h"
+#include "ddr_ecc.h"
+#include "boot_zero.h"
+#include "boot_reloc.h"
+#include "bootpack.h"
+#include "boot_log.h"
+#include "boot_stats.h"
+#include "boot_trace.h"
 
 // Prototypes
-uint8_t load_elf32(const char *file_name);
+int32_t boot_apu(void);
+int32_t boot_r5_1_start(void);
+int32_t boot_r5_1_release(void);
 void print_buffer(const uint8_t *buffer, size_t size);
+void start_decode_workers(void);
 
 // Definitions
-#define CHUNK_SIZE 4096
+#define RPU_IMAGE "vxWorks.elf"
+#define APU_ATF_IMAGE "bl31.elf"
+#define APU_SSBL_IMAGE "u-boot.elf"
+#define RPU_1_IMAGE "r5_1.elf"
+
+// Load and release the A53 images ahead of the R5 image; 0 boots the R5 alone
+#ifndef RPU_BOOT_APU
+#define RPU_BOOT_APU 1
+#endif
+
+// In split mode, load RPU_1_IMAGE for R5-1 alongside R5-0's own image and release R5-1
+// once its image is in
+#ifndef RPU_BOOT_R5_1
+#define RPU_BOOT_R5_1 0
+#endif
+
+// Boot pack decompression workers. R5-1 can help decode blocks when the RPU runs in
+// split mode, but only if this loader is linked into OCM or DDR: R5-1 cannot see
+// R5-0's TCM, so it has no way to execute bpk_worker() from there.
+#define BPK_WORKER_CORES 0
+#define WORKER_STACK_SIZE 0x1000
+
+#if RPU_BOOT_R5_1 && BPK_WORKER_CORES > 0
+#error "R5-1 cannot decode boot pack blocks and run its own image"
+#endif
+
+// RPU Global Control
+#define RPU_GLBL_CNTL (*(volatile uint32_t *)(0xFF9A0000U))
+#define RPU_GLBL_CNTL_SLSPLIT 0x8U
+
+// RPU-1 Configuration and Reset Control
+#define RPU_1_CFG (*(volatile uint32_t *)(0xFF9A0200U))
+#define RPU_CFG_NCPUHALT 0x1U
+#define RPU_CFG_VINITHI 0x4U
+#define RST_LPD_TOP (*(volatile uint32_t *)(0xFF5E023CU))
+#define RST_LPD_TOP_R51 0x2U
+
+// Split mode TCM as R5-1 sees it, and as seen from the global address map
+#define R5_ATCM_LOCAL 0x00000000U
+#define R5_BTCM_LOCAL 0x00020000U
+#define R5_TCM_SIZE 0x00010000U
+#define R5_1_ATCM_GLOBAL 0xFFE90000U
+#define R5_1_BTCM_GLOBAL 0xFFEB0000U
+
+// Reset vector base with RPU_CFG_VINITHI set
+#define R5_HIGH_VECTORS 0xFFFF0000U
+
+// Loads R5-1's image into its TCM through the global aliases, matched by run address so
+// hot code linked into TCM with a DDR load address lands there without a startup copy.
+// R5-0's own image keeps its local TCM addresses, which are faster to write than going
+// out and back in over AXI.
+static const struct boot_map_region rpu_1_map[] =
+{
+    { R5_ATCM_LOCAL, R5_TCM_SIZE, R5_1_ATCM_GLOBAL, 0 },
+    { R5_BTCM_LOCAL, R5_TCM_SIZE, R5_1_BTCM_GLOBAL, 0 },
+};
+
+// Images of both R5 cores, loading side by side; r5_1_loading is set once R5-1's starts
+static struct elf_load rpu_load;
+static struct elf_load r5_1_load;
+static uint8_t r5_1_loading = 0;
+
+#if BPK_WORKER_CORES > 0
+static uint8_t rpu_worker_stack[WORKER_STACK_SIZE] __attribute__((aligned(8)));
+#endif
 
 // Main
 int main() 
 {
     // Ensure filename is short unless you have enabled long file name support in the BSP settings.
     // The file will fail to open otherwise with no explainable behavior.
-    load_elf32("vxWorks.elf");
-    return 0;
-}
-
-uint8_t load_elf32(const char *file_name) 
-{
-    FRESULT fr;  
-    FATFS fs;    
-    FIL file;    
-    UINT bytesRead;
-    Elf32_Ehdr elfHeader;
-
-    // Mount the file system
-    fr = f_mount(&fs, "0:", 0); 
-    if (fr != FR_OK) 
+    boot_stats_init();
+    boot_trace_init();
+    start_decode_workers();
+    boot_stats_stage(BOOT_STAGE_WORKERS);
+    boot_log_init();
+
+    // One mount serves every image of both processors
+    if (boot_memmap_init() != 0 || ddr_ecc_init() != 0 || elf_mount() != 0)
     {
-        xil_printf("Failed to mount SD card.\r\n");
         return -1;
     }
-    xil_printf("SD card mounted successfully.\r\n");
 
-    // Open the ELF file
-    fr = f_open(&file, file_name, FA_READ);
-    if(fr != FR_OK)
+#if RPU_BOOT_APU
+    // The APU boots while the R5 image is still streaming in
+    if (boot_apu() != 0)
     {
-        xil_printf("Failed to open file: %s (%d bytes)\r\n", file_name, fr);
+        xil_printf("Failed to boot the APU, halting.\r\n");
         return -1;
     }
-    xil_printf("File opened successfully: %s\r\n", file_name);
+#endif
 
-    // Read ELF header
-    fr = f_read(&file, &elfHeader, sizeof(elfHeader), &bytesRead);
-    if (fr != FR_OK || bytesRead != sizeof(elfHeader)) 
+#if RPU_BOOT_R5_1
+    if (boot_r5_1_start() != 0)
     {
-        xil_printf("Failed to read ELF header\r\n");
-        f_close(&file);
+        xil_printf("Failed to boot R5-1, halting.\r\n");
         return -1;
     }
-    xil_printf("ELF header read successfully.\r\n");
+#endif
 
-    // Validate ELF identification
-    if (elfHeader.e_ident[0] != ELFMAG0 || elfHeader.e_ident[1] != ELFMAG1 ||
-        elfHeader.e_ident[2] != ELFMAG2 || elfHeader.e_ident[3] != ELFMAG3) 
+    uint64_t entry;
+    uint32_t entry_point;
+    int32_t status;
+#if RPU_LOAD_OVER_LOADER
+    if (boot_reloc_prepare() != 0)
     {
-        xil_printf("File is not a valid ELF32 file\r\n");
-        f_close(&file);
         return -1;
-    }    
-    xil_printf("Valid ELF32 file identified.\r\n");
-
-    // Debug: Print ELF header info
-    xil_printf("ELF Header - Program header offset: %u, Number of program headers: %u\r\n",
-        elfHeader.e_phoff, elfHeader.e_phnum);
+    }
+#endif
+    status = elf_load_start32(&rpu_load, RPU_IMAGE);
 
-    // Jump to the program headers
-    if (elfHeader.e_phoff >= f_size(&file)) 
+#if RPU_BOOT_R5_1
+    // Waiting for R5-1's image keeps R5-0's streaming in too
+    if (boot_r5_1_release() != 0)
     {
-        xil_printf("Invalid program header offset.\r\n");
-        f_close(&file);
+        xil_printf("Failed to boot R5-1, halting.\r\n");
+        if (status == 0)
+        {
+            elf_load_wait(&rpu_load, &entry);
+        }
         return -1;
     }
-    
-    // Allocate memory for all program headers
-    Elf32_Phdr *programHeaders = malloc(elfHeader.e_phnum * sizeof(Elf32_Phdr));
-    if (programHeaders == NULL) 
+#endif
+    if (status != 0 || elf_load_wait(&rpu_load, &entry) != 0)
     {
-        xil_printf("Memory allocation for program headers failed.\r\n");
-        f_close(&file);
         return -1;
     }
+    entry_point = (uint32_t)entry;
+    xil_printf("Entry point calculated: %x\r\n", entry_point);
+    boot_stats_stage(BOOT_STAGE_LOADED);
 
-    f_lseek(&file, elfHeader.e_phoff); // Seek to the program headers section
+    if (bpk_verify_deferred() != 0)
+    {
+        xil_printf("Failed to verify boot pack: %s\r\n", RPU_IMAGE);
+        return -1;
+    }
+    boot_stats_stage(BOOT_STAGE_VERIFIED);
+    ddr_ecc_finish();
+    boot_zero_finish();
+
+    // Hand the measurement log and boot statistics to the next stage. The APU is already
+    // running by now, so its OS has to wait for GLOBAL_GEN_STORAGE3/4 to become non-zero.
+    boot_log_seal();
+    boot_stats_publish();
+    boot_trace_mark(BOOT_TRACE_RELEASE, entry_point);
+    boot_trace_dump();
+
+#if RPU_LOAD_OVER_LOADER
+    // Copies the staged TCM segments into place from OCM and branches to the entry point
+    boot_reloc_start(entry_point);
+#else
+    // Inline assembly to branch to the entry point for the PC register
+    asm volatile("blx %0":: "r" (entry_point));
+#endif
+    
+    // Will not return, but just in case
+    xil_printf("Returned from ELF program (this should not happen).\r\n");
+
+    return 0; // Will not return
+}
 
-    // Read all program headers at once
-    fr = f_read(&file, programHeaders, elfHeader.e_phnum * sizeof(Elf32_Phdr), &bytesRead);
-    if (fr != FR_OK || bytesRead != elfHeader.e_phnum * sizeof(Elf32_Phdr)) 
+// Loads AT-F and u-boot for the A53 and starts the APU in AT-F
+int32_t boot_apu(void)
+{
+    uint64_t bl31_entrypoint;
+    uint64_t uboot_entrypoint;
+
+    if (load_apu_images(APU_ATF_IMAGE, APU_SSBL_IMAGE, &bl31_entrypoint, &uboot_entrypoint) != 0)
     {
-        xil_printf("Failed to read program headers; Read bytes: %u, Expected: %u\r\n", bytesRead, elfHeader.e_phnum * sizeof(Elf32_Phdr));
-        free(programHeaders);
-        f_close(&file);
         return -1;
     }
 
-    for (int i = 0; i < elfHeader.e_phnum; i++) 
+    // Nothing runs on the APU before its cold boot pack segments have been checked too
+    if (bpk_verify_deferred() != 0)
     {
-        Elf32_Phdr *programHeader = &programHeaders[i];
+        xil_printf("Failed to verify the APU images\r\n");
+        return -1;
+    }
 
-        // Print the values of the program header
-        xil_printf("Program header %d read successfully: type=0x%x, offset=0x%x, filesz=0x%x, memsz=0x%x\r\n", 
-            i, programHeader->p_type, programHeader->p_offset, programHeader->p_filesz, programHeader->p_memsz);
+    // The AT-F handoff is in place; let the APU go. Linux uses all of DDR, so the ECC fill
+    // and bss clearing have to finish first.
+    ddr_ecc_finish();
+    boot_zero_finish();
+    boot_trace_mark(BOOT_TRACE_RELEASE, (uint32_t)bl31_entrypoint);
+    release_apu((uint32_t)bl31_entrypoint);
+    xil_printf("APU released to AT-F at 0x%08x while %s loads.\r\n", (uint32_t)bl31_entrypoint, RPU_IMAGE);
 
-        // Validate segment offset
-        if (programHeader->p_offset + programHeader->p_filesz > f_size(&file)) 
-        {
-            xil_printf("Invalid segment offset for program header %d: offset=0x%x, filesize=0x%x\r\n", 
-                i, programHeader->p_offset, f_size(&file));
-            free(programHeaders);
-            f_close(&file);
-            return -1;
-        }
+    return 0;
+}
 
-        // Seek to the segment data offset
-        f_lseek(&file, programHeader->p_offset);
-        
-        // Allocate memory for the segment
-        void *segmentMemory = (void *)(programHeader->p_vaddr);
+// Starts loading R5-1's image, with R5-1 held, for R5-0's image to load alongside
+int32_t boot_r5_1_start(void)
+{
+    int32_t status;
 
-        // Read segment data into memory
-        uint8_t buffer[CHUNK_SIZE];
-        uint32_t bytesToRead = programHeader->p_filesz; // Total bytes to read
-        uint32_t bytesLoaded = 0;
+    // In lockstep mode R5-1 has no TCM of its own and runs whatever R5-0 runs
+    if (!(RPU_GLBL_CNTL & RPU_GLBL_CNTL_SLSPLIT))
+    {
+        xil_printf("RPU is in lockstep mode, not booting %s\r\n", RPU_1_IMAGE);
+        return 0;
+    }
 
-        xil_printf("Reading segment data: offset=0x%x, filesize=0x%x, memsize=0x%x\r\n", 
-            programHeader->p_offset, programHeader->p_filesz, programHeader->p_memsz);
+    // Hold R5-1 while its TCM is written
+    RPU_1_CFG &= ~RPU_CFG_NCPUHALT;
+    RST_LPD_TOP |= RST_LPD_TOP_R51;
+    RST_LPD_TOP &= ~RST_LPD_TOP_R51;
 
-        // Read data in chunks
-        while (bytesToRead > 0) 
-        {
-            uint32_t chunkSize;
-            if (bytesToRead > CHUNK_SIZE) 
-            {
-                chunkSize = CHUNK_SIZE;
-            } 
-            else 
-            {
-                chunkSize = bytesToRead;
-            }
+    // The segments are translated before this returns, so the table can go right after
+    if (boot_map_set(rpu_1_map, sizeof(rpu_1_map) / sizeof(rpu_1_map[0])) != 0)
+    {
+        return -1;
+    }
+    status = elf_load_start32(&r5_1_load, RPU_1_IMAGE);
+    boot_map_set(NULL, 0);
+    if (status != 0)
+    {
+        return -1;
+    }
+    r5_1_loading = 1;
 
-            fr = f_read(&file, buffer, chunkSize, &bytesRead);
-            if (fr != FR_OK || bytesRead == 0) 
-            {
-                xil_printf("Error reading segment data at offset 0x%x: %d\r\n", programHeader->p_offset + bytesLoaded, fr);
-                free(programHeaders);
-                f_close(&file);
-                return -1;
-            }
+    return 0;
+}
 
-            // Copy data to allocated memory
-            memcpy(segmentMemory + bytesLoaded, buffer, bytesRead);
-            bytesLoaded += bytesRead;
-            bytesToRead -= bytesRead;
+// Waits for R5-1's image and lets R5-1 run while R5-0's image may still be loading
+int32_t boot_r5_1_release(void)
+{
+    volatile uint32_t *vectors = (volatile uint32_t *)R5_1_ATCM_GLOBAL;
+    uint64_t entry;
+    uint32_t entry_point;
 
-            // Flush cache
-            Xil_DCacheFlushRange((uint32_t)(segmentMemory + bytesLoaded - bytesRead), bytesRead);
-        }
+    // Nothing started in lockstep mode
+    if (!r5_1_loading)
+    {
+        return 0;
+    }
+    r5_1_loading = 0;
+    if (elf_load_wait(&r5_1_load, &entry) != 0)
+    {
+        return -1;
+    }
+    entry_point = (uint32_t)entry;
 
-        // Clear uninitialized space
-        if (programHeader->p_memsz > programHeader->p_filesz) 
+    // Nothing runs on R5-1 before its cold boot pack segments have been checked too
+    if (bpk_verify_deferred() != 0)
+    {
+        xil_printf("Failed to verify %s\r\n", RPU_1_IMAGE);
+        return -1;
+    }
+
+    // Start from the vector table the image was linked with; any other entry point gets a
+    // branch in the first two words of ATCM, which the image must leave free
+    if (entry_point == R5_HIGH_VECTORS)
+    {
+        RPU_1_CFG |= RPU_CFG_VINITHI;
+    }
+    else
+    {
+        RPU_1_CFG &= ~RPU_CFG_VINITHI;
+        if (entry_point != R5_ATCM_LOCAL)
         {
-            memset(segmentMemory + bytesLoaded, 0, programHeader->p_memsz - programHeader->p_filesz);
+            vectors[0] = 0xE51FF004U; // ldr pc, [pc, #-4]
+            vectors[1] = entry_point;
+            Xil_DCacheFlushRange((UINTPTR)vectors, 2 * sizeof(uint32_t));
         }
-
-        // Print the loaded segment information        
-        xil_printf("Segment loaded successfully: vaddr=0x%x, filesz=0x%x, memsz=0x%x\r\n",
-            programHeader->p_vaddr, programHeader->p_filesz, programHeader->p_memsz);
     }
 
-    xil_printf("All segments loaded successfully.\r\n");
-    free(programHeaders); // Free allocated memory for program headers
-    f_close(&file);
-
-    // Calculate the entry point
-    uint32_t entry_point = elfHeader.e_entry;
-    xil_printf("Entry point calculated: %x\r\n", entry_point);
+    ddr_ecc_finish();
+    boot_zero_finish();
+    boot_trace_mark(BOOT_TRACE_RELEASE, entry_point);
+    RPU_1_CFG |= RPU_CFG_NCPUHALT;
+    xil_printf("R5-1 released at 0x%08x while %s loads.\r\n", entry_point, RPU_IMAGE);
 
-    // Inline assembly to branch to the entry point for the PC register
-    asm volatile("blx %0":: "r" (entry_point));
-    
-    // Will not return, but just in case
-    xil_printf("Returned from ELF program (this should not happen).\r\n");
+    return 0;
+}
 
-    return 0; // Will not return
+void start_decode_workers(void)
+{
+#if BPK_WORKER_CORES > 0
+    // R5-1 runs the worker with its caches off, so keep the shared staging area and trace uncached here too
+    Xil_SetMPURegion(BPK_STAGING_ADDR, BPK_STAGING_SIZE, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+    Xil_SetMPURegion(BOOT_TRACE_ADDR, BOOT_TRACE_SIZE, NORM_SHARED_NCACHE | PRIV_RW_USER_RW);
+#endif
+    bpk_init();
+
+#if BPK_WORKER_CORES > 0
+    volatile uint32_t *vectors = (volatile uint32_t *)R5_1_ATCM_GLOBAL;
+
+    // Hold R5-1 while its reset vector is rewritten
+    RPU_1_CFG &= ~RPU_CFG_NCPUHALT;
+    RST_LPD_TOP |= RST_LPD_TOP_R51;
+    RST_LPD_TOP &= ~RST_LPD_TOP_R51;
+
+    // Reset vector: load the worker stack pointer and branch to bpk_worker()
+    vectors[0] = 0xE59FD000U; // ldr sp, [pc]
+    vectors[1] = 0xE59FF000U; // ldr pc, [pc]
+    vectors[2] = (uint32_t)(rpu_worker_stack + WORKER_STACK_SIZE);
+    vectors[3] = (uint32_t)bpk_worker;
+
+    // Boot R5-1 from its TCM (low vectors) and let it run
+    RPU_1_CFG &= ~RPU_CFG_VINITHI;
+    boot_trace_mark(BOOT_TRACE_RELEASE, 1U << 1);
+    RPU_1_CFG |= RPU_CFG_NCPUHALT;
+    xil_printf("Started R5-1 as boot pack worker.\r\n");
+#endif
 }
 
 // Debug for printing buffer data and their ASCI values similar to BIO_DUMP
@@ -0,0 +1,118 @@
+/*
+ * Description: Multi-block ADMA2 reads on an SD host controller (see sd_adma.h).
+ */
+
+// Standard Libraries
+#include "stdint.h"
+
+// Xilinx Libraries
+#include "xil_cache.h"  // Include cache management functions
+
+// Addtional Libraries
+#include "sd_adma.h"
+
+// Controller registers (SD host controller 3.0 layout)
+#define SD_REG8(host, offset) (*(volatile uint8_t *)((host)->base + (offset)))
+#define SD_REG16(host, offset) (*(volatile uint16_t *)((host)->base + (offset)))
+#define SD_REG32(host, offset) (*(volatile uint32_t *)((host)->base + (offset)))
+#define SD_BLK_SIZE 0x04U
+#define SD_BLK_CNT 0x06U
+#define SD_ARGUMENT 0x08U
+#define SD_XFER_MODE 0x0CU              // Transfer mode; the command above it starts it
+#define SD_PRES_STATE 0x24U
+#define SD_HOST_CTRL1 0x28U
+#define SD_SW_RST 0x2FU
+#define SD_NORM_INTR_STS 0x30U
+#define SD_ERR_INTR_STS 0x32U
+#define SD_ADMA_ADDR_LO 0x58U
+#define SD_ADMA_ADDR_HI 0x5CU
+
+#define SD_PRES_INHIBIT 0x3U            // Command or data lines busy
+#define SD_HC_DMA_MASK 0x18U
+#if defined(__aarch64__)
+#define SD_HC_DMA_ADMA2 0x18U           // 64-bit descriptors, as the driver uses
+#else
+#define SD_HC_DMA_ADMA2 0x10U
+#endif
+#define SD_SW_RST_CMD_DAT 0x06U
+#define SD_INTR_XFER_DONE 0x0002U
+#define SD_INTR_ERROR 0x8000U
+#define SD_INTR_ALL 0xFFFFU
+
+// CMD18 READ_MULTIPLE_BLOCK: 48-bit response, index and CRC checked, data present
+#define SD_CMD18 0x123AU
+// DMA, block count, auto CMD12, card to host, multiple blocks
+#define SD_XFER_READ_MULTI 0x0037U
+
+#define SD_DESC_VALID 0x01U
+#define SD_DESC_END 0x02U
+#define SD_DESC_TRAN 0x20U
+
+struct sd_desc
+{
+    uint16_t attribute;
+    uint16_t length;
+#if defined(__aarch64__)
+    uint64_t address;
+#else
+    uint32_t address;
+#endif
+} __attribute__((packed));
+
+void sd_adma_start(const struct sd_adma *host, uint64_t block, void *dst, uint32_t size)
+{
+    volatile struct sd_desc *desc = (volatile struct sd_desc *)host->desc;
+    uint32_t count = (size + SD_ADMA_DESC_LENGTH - 1) / SD_ADMA_DESC_LENGTH;
+    uint8_t *bytes = dst;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t length = (size - i * SD_ADMA_DESC_LENGTH > SD_ADMA_DESC_LENGTH) ? SD_ADMA_DESC_LENGTH : size - i * SD_ADMA_DESC_LENGTH;
+
+        desc[i].attribute = SD_DESC_TRAN | SD_DESC_VALID | ((i == count - 1) ? SD_DESC_END : 0);
+        desc[i].length = (uint16_t)length;
+        desc[i].address = (uintptr_t)(bytes + i * SD_ADMA_DESC_LENGTH);
+    }
+    Xil_DCacheFlushRange((UINTPTR)host->desc, count * sizeof(struct sd_desc));
+
+    // The driver's last command may still be finishing its busy phase
+    while (SD_REG32(host, SD_PRES_STATE) & SD_PRES_INHIBIT)
+    {
+
+    };
+    SD_REG16(host, SD_NORM_INTR_STS) = SD_INTR_ALL;
+    SD_REG16(host, SD_ERR_INTR_STS) = SD_INTR_ALL;
+    SD_REG8(host, SD_HOST_CTRL1) = (SD_REG8(host, SD_HOST_CTRL1) & ~SD_HC_DMA_MASK) | SD_HC_DMA_ADMA2;
+    SD_REG32(host, SD_ADMA_ADDR_LO) = (uint32_t)host->desc;
+    SD_REG32(host, SD_ADMA_ADDR_HI) = 0;
+    SD_REG16(host, SD_BLK_SIZE) = SD_ADMA_BLOCK_SIZE;
+    SD_REG16(host, SD_BLK_CNT) = (uint16_t)(size / SD_ADMA_BLOCK_SIZE);
+    SD_REG32(host, SD_ARGUMENT) = host->byte_address ? (uint32_t)(block * SD_ADMA_BLOCK_SIZE) : (uint32_t)block;
+    SD_REG32(host, SD_XFER_MODE) = (SD_CMD18 << 16) | SD_XFER_READ_MULTI;
+}
+
+int32_t sd_adma_done(const struct sd_adma *host)
+{
+    uint16_t status = SD_REG16(host, SD_NORM_INTR_STS);
+
+    if ((status & SD_INTR_ERROR) || SD_REG16(host, SD_ERR_INTR_STS) != 0)
+    {
+        SD_REG16(host, SD_ERR_INTR_STS) = SD_INTR_ALL;
+        SD_REG16(host, SD_NORM_INTR_STS) = SD_INTR_ALL;
+
+        // Leave the lines idle for the driver
+        SD_REG8(host, SD_SW_RST) = SD_SW_RST_CMD_DAT;
+        while (SD_REG8(host, SD_SW_RST) & SD_SW_RST_CMD_DAT)
+        {
+
+        };
+        return -1;
+    }
+    if (!(status & SD_INTR_XFER_DONE))
+    {
+        return 0;
+    }
+    SD_REG16(host, SD_NORM_INTR_STS) = SD_INTR_ALL;
+
+    return 1;
+}
@@ -0,0 +1,38 @@
+/*
+ * Description: Multi-block reads on an SD host controller (SD 3.0 layout) through its
+ * ADMA2 engine, shared by the SD card and eMMC media. A read is one CMD18 with auto
+ * CMD12 straight into the destination, described by a descriptor table the caller
+ * reserves in OCM; completion is polled from the controller's status flags. The
+ * controller must have been brought up by the xilffs / XSdPs driver, which may use it
+ * between reads but not during one.
+ */
+
+#ifndef SD_ADMA_H
+#define SD_ADMA_H
+
+#include "stdint.h"
+
+#define SD_ADMA_BLOCK_SIZE 512U
+
+// Descriptors per table and bytes per descriptor; a read moves at most SD_ADMA_MAX_READ
+#define SD_ADMA_NUM_DESC 64
+#define SD_ADMA_DESC_LENGTH 0x8000U
+#define SD_ADMA_DESC_SIZE (SD_ADMA_NUM_DESC * 12U)
+#define SD_ADMA_MAX_READ (SD_ADMA_NUM_DESC * SD_ADMA_DESC_LENGTH)
+
+struct sd_adma
+{
+    uintptr_t base;                 // Controller registers
+    uintptr_t desc;                 // Descriptor table, SD_ADMA_DESC_SIZE bytes
+    uint8_t byte_address;           // Card takes byte addresses (SDSC) instead of blocks
+};
+
+// Starts reading size bytes (whole blocks) from block into dst, which must start on a
+// cache line and have been invalidated
+void sd_adma_start(const struct sd_adma *host, uint64_t block, void *dst, uint32_t size);
+
+// Returns 0 while the read runs, 1 once its data is in memory and -1 if it failed, in
+// which case the lines are reset for the driver
+int32_t sd_adma_done(const struct sd_adma *host);
+
+#endif
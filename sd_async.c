@@ -0,0 +1,325 @@
+/*
+ * Description: Background SD reads (see sd_async.h).
+ */
+
+// Standard Libraries
+#include "stdint.h"
+#include "string.h"
+
+// Xilinx Libraries
+#include "ff.h"
+#include "xil_cache.h"  // Include cache management functions
+#include <xil_printf.h> // Include Debug IO
+
+// Addtional Libraries
+#include "sd_async.h"
+#include "sd_adma.h"
+#include "boot_sched.h"
+#include "boot_trace.h"
+
+#define SD_SECTOR_SIZE SD_ADMA_BLOCK_SIZE
+
+// DMA runs start on whole cache lines of either processor
+#define SD_LINE 64U
+
+// The DMA finds a file's blocks through the FatFs link map
+#if SD_ASYNC && defined(FF_USE_FASTSEEK) && FF_USE_FASTSEEK
+#define SD_ASYNC_DMA 1
+#else
+#define SD_ASYNC_DMA 0
+#endif
+
+// The R5's TCM at the bottom of its map is not where the controller would write
+#if defined(__aarch64__)
+#define SD_ASYNC_DMA_START 0x0ULL
+#else
+#define SD_ASYNC_DMA_START 0x40000ULL
+#endif
+
+// Bytes per command (well inside the 16-bit block count)
+#define SD_MAX_PIECE SD_ADMA_MAX_READ
+
+// Reads for memory the driver's DMA cannot reach go through this
+#define SD_BOUNCE_SIZE 4096U
+
+static int32_t sd_async_step(struct boot_task *task);
+static struct boot_task sdTask = { "SD read", sd_async_step, NULL, 0, 0, NULL };
+
+#if SD_ASYNC_DMA
+// Read in flight: the DMA part of the range, and how far the transfer has got
+static int32_t *sdResult;
+static int32_t sdStatus;
+static FIL *sdFile;
+static uint8_t *sdStart;
+static uint32_t sdSize;
+static uint8_t *sdDst;
+static uint32_t sdOffset;           // File offset matching sdDst
+static uint32_t sdRemaining;
+static uint32_t sdPiece;            // Bytes of the command in flight
+static LBA_t sdSector;
+static int32_t sdPieceStatus;
+
+// FatFs cluster link map of a file read recently: its size, then (clusters, first
+// cluster) for every contiguous run, then 0
+struct sd_async_map
+{
+    DWORD link_map[2 + 2 * SD_ASYNC_MAX_RUNS];
+    FATFS *fs;                      // NULL while unused
+    DWORD cluster;                  // First cluster of the file
+    int32_t status;                 // -1 when the file has too many runs for the map
+};
+static struct sd_async_map sdMaps[SD_ASYNC_MAX_FILES];
+static uint32_t sdMapNext = 0;      // Replaced next
+static struct sd_async_map *sdMap;  // Of the read in flight
+#endif
+
+// Reads on the spot with FatFs and pushes the data out to memory
+static int32_t sd_async_read_now(FIL *file, uint32_t offset, uint8_t *dst, uint32_t size)
+{
+    static uint8_t bounce[SD_BOUNCE_SIZE] __attribute__((aligned(64)));
+    UINT bytesRead;
+
+    if (size == 0)
+    {
+        return 0;
+    }
+    if (f_lseek(file, offset) != FR_OK)
+    {
+        return -1;
+    }
+
+    if ((uintptr_t)dst >= SD_ASYNC_DMA_START)
+    {
+        if (f_read(file, dst, size, &bytesRead) != FR_OK || bytesRead != size)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        for (uint32_t done = 0; done < size; done += bytesRead)
+        {
+            uint32_t chunkSize = (size - done > SD_BOUNCE_SIZE) ? SD_BOUNCE_SIZE : size - done;
+
+            if (f_read(file, bounce, chunkSize, &bytesRead) != FR_OK || bytesRead != chunkSize)
+            {
+                return -1;
+            }
+            boot_trace_begin(BOOT_TRACE_COPY, bytesRead);
+            memcpy(dst + done, bounce, bytesRead);
+            boot_trace_end(BOOT_TRACE_COPY, bytesRead);
+        }
+    }
+    Xil_DCacheFlushRange((UINTPTR)dst, size);
+
+    return 0;
+}
+
+#if SD_ASYNC_DMA
+#ifndef SD_ASYNC_EMULATE
+
+static const struct sd_adma sdHost = { SD_ASYNC_BASE, SD_ASYNC_DESC_ADDR, SD_ASYNC_BYTE_ADDRESS };
+
+// Issues CMD18 for sdPiece bytes at sdSector into sdDst and returns
+static void sd_async_piece_start(void)
+{
+    sd_adma_start(&sdHost, sdSector, sdDst, sdPiece);
+}
+
+// Returns 0 while the command runs, 1 once its data is in memory and -1 if it failed
+static int32_t sd_async_piece_done(void)
+{
+    return sd_adma_done(&sdHost);
+}
+
+#else
+
+// Host stand-in: the data arrives through FatFs a few polls after the command
+static uint32_t sdEmulatePolls;
+
+static void sd_async_piece_start(void)
+{
+    sdEmulatePolls = SD_ASYNC_EMULATE_POLLS;
+}
+
+static int32_t sd_async_piece_done(void)
+{
+    if (sdEmulatePolls != 0)
+    {
+        sdEmulatePolls--;
+        return 0;
+    }
+
+    return (sd_async_read_now(sdFile, sdOffset, sdDst, sdPiece) == 0) ? 1 : -1;
+}
+
+#endif
+
+// Builds the link map for the file unless it is the one already mapped
+static int32_t sd_async_map(FIL *file)
+{
+    FRESULT fr;
+
+    // Loads running side by side alternate between their files
+    for (uint32_t i = 0; i < SD_ASYNC_MAX_FILES; i++)
+    {
+        if (sdMaps[i].fs == file->obj.fs && sdMaps[i].cluster == file->obj.sclust)
+        {
+            sdMap = &sdMaps[i];
+            return sdMap->status;
+        }
+    }
+
+    sdMap = &sdMaps[sdMapNext];
+    sdMapNext = (sdMapNext + 1) % SD_ASYNC_MAX_FILES;
+    sdMap->link_map[0] = sizeof(sdMap->link_map) / sizeof(sdMap->link_map[0]);
+    file->cltbl = sdMap->link_map;
+    fr = f_lseek(file, CREATE_LINKMAP);
+
+    // FatFs keeps following the cluster chain for its own reads of the file
+    file->cltbl = NULL;
+    sdMap->fs = file->obj.fs;
+    sdMap->cluster = file->obj.sclust;
+    sdMap->status = (fr == FR_OK) ? 0 : -1;
+    if (fr != FR_OK)
+    {
+        xil_printf("SD file too fragmented for background reads: %u runs\r\n", (sdMap->link_map[0] - 2) / 2);
+    }
+
+    return sdMap->status;
+}
+
+// Finds the block holding sdOffset; returns how many bytes follow it contiguously, or 0
+static uint64_t sd_async_locate(void)
+{
+    FATFS *fs = sdFile->obj.fs;
+    uint32_t clusterSize = fs->csize * SD_SECTOR_SIZE;
+    DWORD cluster = sdOffset / clusterSize;
+    const DWORD *run = &sdMap->link_map[1];
+
+    while (run[0] != 0 && cluster >= run[0])
+    {
+        cluster -= run[0];
+        run += 2;
+    }
+    if (run[0] == 0)
+    {
+        return 0;
+    }
+
+    uint32_t within = sdOffset % clusterSize;
+    sdSector = fs->database + (LBA_t)fs->csize * (run[1] + cluster - 2) + within / SD_SECTOR_SIZE;
+
+    return (uint64_t)(run[0] - cluster) * clusterSize - within;
+}
+
+// Moves the read through the file a command at a time
+static int32_t sd_async_step(struct boot_task *task)
+{
+    BOOT_TASK_BEGIN(task);
+    while (sdRemaining != 0)
+    {
+        uint64_t contiguous = sd_async_locate();
+        if (contiguous == 0)
+        {
+            xil_printf("SD read at 0x%x is outside the file\r\n", sdOffset);
+            sdStatus = -1;
+            break;
+        }
+
+        sdPiece = (sdRemaining < SD_MAX_PIECE) ? sdRemaining : SD_MAX_PIECE;
+        if (contiguous < sdPiece)
+        {
+            sdPiece = (uint32_t)contiguous;
+        }
+        sd_async_piece_start();
+
+        BOOT_TASK_WAIT_UNTIL(task, (sdPieceStatus = sd_async_piece_done()) != 0);
+        if (sdPieceStatus < 0)
+        {
+            // Rare enough to block for: read it again through the driver
+            xil_printf("SD transfer at 0x%x failed, reading it again\r\n", sdOffset);
+            if (sd_async_read_now(sdFile, sdOffset, sdDst, sdPiece) != 0)
+            {
+                sdStatus = -1;
+                break;
+            }
+        }
+        sdDst += sdPiece;
+        sdOffset += sdPiece;
+        sdRemaining -= sdPiece;
+    }
+
+    // Drop whatever the core fetched from the range while the controller wrote it
+    Xil_DCacheInvalidateRange((UINTPTR)sdStart, sdSize);
+    *sdResult = sdStatus;
+    BOOT_TASK_END(task);
+}
+
+#else
+
+static int32_t sd_async_step(struct boot_task *task)
+{
+    (void)task;
+
+    return BOOT_TASK_DONE;
+}
+
+#endif
+
+int32_t sd_async_read(FIL *file, uint32_t offset, void *dst, uint32_t size, int32_t *status)
+{
+    uint8_t *bytes = dst;
+
+    // The controller and FatFs serve one read at a time
+    sd_async_wait();
+
+#if SD_ASYNC_DMA
+    uint32_t head = ((offset + SD_SECTOR_SIZE - 1) & ~(SD_SECTOR_SIZE - 1)) - offset;
+    uint32_t tail = (offset + size) % SD_SECTOR_SIZE;
+
+    // Whole sectors go to the DMA when they start on a cache line; sectors are whole lines
+    if (head + tail >= size || ((uintptr_t)bytes + head) % SD_LINE != 0 ||
+        (uintptr_t)bytes < SD_ASYNC_DMA_START || sd_async_map(file) != 0)
+    {
+        *status = sd_async_read_now(file, offset, bytes, size);
+        return *status;
+    }
+
+    // FatFs has to be done with the controller before the transfer starts
+    if (sd_async_read_now(file, offset, bytes, head) != 0 ||
+        sd_async_read_now(file, offset + size - tail, bytes + size - tail, tail) != 0)
+    {
+        *status = -1;
+        return -1;
+    }
+
+    sdFile = file;
+    sdStart = sdDst = bytes + head;
+    sdSize = sdRemaining = size - head - tail;
+    sdOffset = offset + head;
+    sdStatus = 0;
+    sdResult = status;
+    *status = BOOT_TASK_RUNNING;
+    Xil_DCacheInvalidateRange((UINTPTR)sdStart, sdSize);
+
+    boot_sched_start(&sdTask);
+    boot_sched_yield();
+    return 0;
+#else
+    *status = sd_async_read_now(file, offset, bytes, size);
+    return *status;
+#endif
+}
+
+int32_t sd_async_busy(void)
+{
+    boot_sched_yield();
+
+    return boot_sched_running(&sdTask);
+}
+
+void sd_async_wait(void)
+{
+    boot_sched_wait(&sdTask);
+}
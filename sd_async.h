@@ -0,0 +1,77 @@
+/*
+ * Description: Background SD reads. The xilffs driver polls the controller inside every
+ * f_read, so the loading core does nothing else while the card transfers. sd_async_read()
+ * instead maps the whole sectors of a file range to card blocks through the FatFs cluster
+ * link map and hands them to the SD controller's ADMA2 engine as multi-block reads
+ * (sd_adma.h) straight into the destination, then returns. The transfer runs as a
+ * boot_sched.h task, completion is taken from the controller's status flags, and the
+ * caller does other work until the read's status changes. Partial sectors at either
+ * end of the range are read with f_read before the transfer starts.
+ *
+ * The controller is shared with FatFs, so only one read is in flight and no other FatFs
+ * call may run until it completes. The card has to be initialized and mounted through
+ * xilffs first. Ranges that cannot go to the DMA (the link map does not fit, the
+ * destination is not DMA visible or not aligned to the file on a cache line) are read
+ * with f_read on the spot, as are transfers the controller reports as failed. Building
+ * with SD_ASYNC_EMULATE swaps the controller for a stand-in that completes every
+ * transfer with f_read a few polls after it starts, so the same callers can run on a
+ * host (tests/test_loader.c, against the BSP stand-ins in tests/host/).
+ */
+
+#ifndef SD_ASYNC_H
+#define SD_ASYNC_H
+
+#include "stdint.h"
+#include "ff.h"
+#include "sd_adma.h"
+
+// Use the DMA at all; 0 reads everything with f_read. Needs FF_USE_FASTSEEK in ffconf.h.
+#ifndef SD_ASYNC
+#define SD_ASYNC 1
+#endif
+
+// Controller holding the card. ZCU102: SD1.
+#ifndef SD_ASYNC_BASE
+#define SD_ASYNC_BASE 0xFF170000U
+#endif
+
+// Cards up to 2 GB (SDSC) take byte addresses instead of block numbers
+#ifndef SD_ASYNC_BYTE_ADDRESS
+#define SD_ASYNC_BYTE_ADDRESS 0
+#endif
+
+// ADMA2 descriptor table in reserved OCM, visible to the controller from either processor
+#ifndef SD_ASYNC_DESC_ADDR
+#define SD_ASYNC_DESC_ADDR 0xFFFE3C00U
+#endif
+#define SD_ASYNC_DESC_SIZE SD_ADMA_DESC_SIZE
+
+// Contiguous runs of a fragmented file the link map can hold
+#ifndef SD_ASYNC_MAX_RUNS
+#define SD_ASYNC_MAX_RUNS 32
+#endif
+
+// Files whose link maps are kept, for loads that take turns on the card
+#ifndef SD_ASYNC_MAX_FILES
+#define SD_ASYNC_MAX_FILES 4
+#endif
+
+// Polls before the host stand-in completes a transfer
+#ifndef SD_ASYNC_EMULATE_POLLS
+#define SD_ASYNC_EMULATE_POLLS 4
+#endif
+
+// Starts reading size bytes at offset of an open file into dst; waits for any read still
+// in flight first. *status stays BOOT_TASK_RUNNING until the data is in memory, not just
+// in this core's cache, then becomes 0, or -1 if the read failed. The file position is
+// left undefined. Returns -1 if the read failed before anything was started.
+int32_t sd_async_read(FIL *file, uint32_t offset, void *dst, uint32_t size, int32_t *status);
+
+// Whether a read is in flight; steps the transfer and every other task. Inside a step it
+// only checks, which is what a task has to do before starting a read of its own.
+int32_t sd_async_busy(void);
+
+// Waits until no read is in flight; any direct FatFs call has to come after this
+void sd_async_wait(void);
+
+#endif
@@ -0,0 +1,187 @@
+/*
+ * Description: Software SHA3-384 (FIPS 202). The state is kept as 25 little-endian
+ * 64-bit lanes and input is XORed in a byte at a time, so it works on any alignment.
+ */
+
+#include "string.h"
+#include "sha3.h"
+
+#define SHA3_ROUNDS 24
+
+static const uint64_t sha3RoundConstants[SHA3_ROUNDS] =
+{
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808AULL, 0x8000000080008000ULL,
+    0x000000000000808BULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008AULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000AULL,
+    0x000000008000808BULL, 0x800000000000008BULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800AULL, 0x800000008000000AULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+static uint64_t sha3_rotl(uint64_t value, uint32_t shift)
+{
+    return (value << shift) | (value >> (64 - shift));
+}
+
+static void sha3_permute(uint64_t *state)
+{
+    uint64_t c0, c1, c2, c3, c4, d0, d1, d2, d3, d4;
+
+    for (uint32_t round = 0; round < SHA3_ROUNDS; round++)
+    {
+        // Theta
+        c0 = state[0] ^ state[5] ^ state[10] ^ state[15] ^ state[20];
+        c1 = state[1] ^ state[6] ^ state[11] ^ state[16] ^ state[21];
+        c2 = state[2] ^ state[7] ^ state[12] ^ state[17] ^ state[22];
+        c3 = state[3] ^ state[8] ^ state[13] ^ state[18] ^ state[23];
+        c4 = state[4] ^ state[9] ^ state[14] ^ state[19] ^ state[24];
+        d0 = c4 ^ sha3_rotl(c1, 1);
+        d1 = c0 ^ sha3_rotl(c2, 1);
+        d2 = c1 ^ sha3_rotl(c3, 1);
+        d3 = c2 ^ sha3_rotl(c4, 1);
+        d4 = c3 ^ sha3_rotl(c0, 1);
+        for (uint32_t y = 0; y < 25; y += 5)
+        {
+            state[y] ^= d0;
+            state[y + 1] ^= d1;
+            state[y + 2] ^= d2;
+            state[y + 3] ^= d3;
+            state[y + 4] ^= d4;
+        }
+
+        // Rho and pi, following the lane cycle starting at lane 1
+        c0 = state[1];
+        c1 = state[10];
+        state[10] = sha3_rotl(c0, 1);
+        c0 = state[7];
+        state[7] = sha3_rotl(c1, 3);
+        c1 = state[11];
+        state[11] = sha3_rotl(c0, 6);
+        c0 = state[17];
+        state[17] = sha3_rotl(c1, 10);
+        c1 = state[18];
+        state[18] = sha3_rotl(c0, 15);
+        c0 = state[3];
+        state[3] = sha3_rotl(c1, 21);
+        c1 = state[5];
+        state[5] = sha3_rotl(c0, 28);
+        c0 = state[16];
+        state[16] = sha3_rotl(c1, 36);
+        c1 = state[8];
+        state[8] = sha3_rotl(c0, 45);
+        c0 = state[21];
+        state[21] = sha3_rotl(c1, 55);
+        c1 = state[24];
+        state[24] = sha3_rotl(c0, 2);
+        c0 = state[4];
+        state[4] = sha3_rotl(c1, 14);
+        c1 = state[15];
+        state[15] = sha3_rotl(c0, 27);
+        c0 = state[23];
+        state[23] = sha3_rotl(c1, 41);
+        c1 = state[19];
+        state[19] = sha3_rotl(c0, 56);
+        c0 = state[13];
+        state[13] = sha3_rotl(c1, 8);
+        c1 = state[12];
+        state[12] = sha3_rotl(c0, 25);
+        c0 = state[2];
+        state[2] = sha3_rotl(c1, 43);
+        c1 = state[20];
+        state[20] = sha3_rotl(c0, 62);
+        c0 = state[14];
+        state[14] = sha3_rotl(c1, 18);
+        c1 = state[22];
+        state[22] = sha3_rotl(c0, 39);
+        c0 = state[9];
+        state[9] = sha3_rotl(c1, 61);
+        c1 = state[6];
+        state[6] = sha3_rotl(c0, 20);
+        c0 = state[1];
+        state[1] = sha3_rotl(c1, 44);
+
+        // Chi
+        for (uint32_t y = 0; y < 25; y += 5)
+        {
+            c0 = state[y];
+            c1 = state[y + 1];
+            c2 = state[y + 2];
+            c3 = state[y + 3];
+            c4 = state[y + 4];
+            state[y] = c0 ^ (~c1 & c2);
+            state[y + 1] = c1 ^ (~c2 & c3);
+            state[y + 2] = c2 ^ (~c3 & c4);
+            state[y + 3] = c3 ^ (~c4 & c0);
+            state[y + 4] = c4 ^ (~c0 & c1);
+        }
+
+        // Iota
+        state[0] ^= sha3RoundConstants[round];
+    }
+}
+
+static uint64_t sha3_load64(const uint8_t *bytes)
+{
+    uint64_t value = 0;
+
+    for (int32_t i = 7; i >= 0; i--)
+    {
+        value = (value << 8) | bytes[i];
+    }
+
+    return value;
+}
+
+void sha3_384_init(struct sha3_context *context)
+{
+    memset(context, 0, sizeof(*context));
+}
+
+void sha3_384_update(struct sha3_context *context, const void *data, uint32_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint32_t i = 0;
+
+    // Whole rate blocks are absorbed a lane at a time
+    while (context->offset == 0 && size - i >= SHA3_384_RATE)
+    {
+        for (uint32_t lane = 0; lane < SHA3_384_RATE / 8; lane++)
+        {
+            context->state[lane] ^= sha3_load64(bytes + i + 8 * lane);
+        }
+        sha3_permute(context->state);
+        i += SHA3_384_RATE;
+    }
+
+    for (; i < size; i++)
+    {
+        context->state[context->offset / 8] ^= (uint64_t)bytes[i] << (8 * (context->offset % 8));
+        if (++context->offset == SHA3_384_RATE)
+        {
+            sha3_permute(context->state);
+            context->offset = 0;
+        }
+    }
+}
+
+void sha3_384_final(struct sha3_context *context, uint8_t *digest)
+{
+    // SHA3 domain padding: 0x06 ... 0x80
+    context->state[context->offset / 8] ^= 0x06ULL << (8 * (context->offset % 8));
+    context->state[(SHA3_384_RATE - 1) / 8] ^= 0x80ULL << (8 * ((SHA3_384_RATE - 1) % 8));
+    sha3_permute(context->state);
+
+    for (uint32_t i = 0; i < SHA3_384_DIGEST_SIZE; i++)
+    {
+        digest[i] = (uint8_t)(context->state[i / 8] >> (8 * (i % 8)));
+    }
+}
+
+void sha3_384(const void *data, uint32_t size, uint8_t *digest)
+{
+    struct sha3_context context;
+
+    sha3_384_init(&context);
+    sha3_384_update(&context, data, size);
+    sha3_384_final(&context, digest);
+}
@@ -0,0 +1,27 @@
+/*
+ * Description: Software SHA3-384 (FIPS 202) used for boot pack block verification.
+ * Shared with the host packer, so it must stay free of Xilinx includes.
+ */
+
+#ifndef SHA3_H
+#define SHA3_H
+
+#include "stdint.h"
+
+#define SHA3_384_DIGEST_SIZE 48
+#define SHA3_384_RATE 104
+
+struct sha3_context
+{
+    uint64_t state[25];
+    uint32_t offset;            // Bytes absorbed into the current rate block
+};
+
+void sha3_384_init(struct sha3_context *context);
+void sha3_384_update(struct sha3_context *context, const void *data, uint32_t size);
+void sha3_384_final(struct sha3_context *context, uint8_t *digest);
+
+// One-shot digest of a single buffer
+void sha3_384(const void *data, uint32_t size, uint8_t *digest);
+
+#endif
@@ -0,0 +1,67 @@
+/*
+ * Description: Host stand-in for the FatFs API the loaders use, over stdio (see
+ * host_bsp.c). Files are opened by their path on the host. Each file reports a FAT
+ * layout of its own, a few cluster runs long, so the link map path of sd_async.c runs
+ * as it does on a card.
+ */
+
+#ifndef FF_H
+#define FF_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef unsigned int UINT;
+typedef uint8_t BYTE;
+typedef uint32_t DWORD;
+typedef uint64_t FSIZE_t;
+typedef uint32_t LBA_t;
+
+typedef enum
+{
+    FR_OK = 0,
+    FR_DISK_ERR,
+    FR_INT_ERR,
+    FR_NOT_READY,
+    FR_NO_FILE,
+    FR_NOT_ENOUGH_CORE = 17
+} FRESULT;
+
+typedef struct
+{
+    uint16_t csize;                 // Sectors per cluster
+    LBA_t database;                 // First sector of the data area
+} FATFS;
+
+typedef struct
+{
+    FATFS *fs;
+    DWORD sclust;                   // First cluster
+    FSIZE_t objsize;
+} FFOBJID;
+
+typedef struct
+{
+    FFOBJID obj;
+    FSIZE_t fptr;
+    DWORD *cltbl;                   // Link map for f_lseek(CREATE_LINKMAP)
+    FILE *host;
+} FIL;
+
+#define FA_READ 0x01
+#define FF_USE_FASTSEEK 1
+#define CREATE_LINKMAP ((FSIZE_t)0 - 1)
+
+#define f_size(fp) ((fp)->obj.objsize)
+#define f_tell(fp) ((fp)->fptr)
+
+FRESULT f_mount(FATFS *fs, const char *path, BYTE opt);
+FRESULT f_open(FIL *fp, const char *path, BYTE mode);
+FRESULT f_close(FIL *fp);
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br);
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs);
+
+// Link maps built so far, so tests can tell the background read path ran
+extern uint32_t hostLinkMaps;
+
+#endif
@@ -0,0 +1,150 @@
+/*
+ * Description: Host implementations of the BSP and FatFs calls the loaders make, for
+ * the host tests built with the headers in this directory. Files on the "card" are host
+ * files; caches are no-ops and the global timer is the monotonic clock.
+ */
+
+// Standard Libraries
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// Xilinx Libraries
+#include "ff.h"
+#include "xil_cache.h"
+#include "xil_printf.h"
+#include "xtime_l.h"
+
+// Made-up FAT layout: every file gets clusters of its own, in runs of HOST_FAT_RUN
+#define HOST_FAT_CLUSTER_SECTORS 8
+#define HOST_FAT_CLUSTER_SIZE (HOST_FAT_CLUSTER_SECTORS * 512U)
+#define HOST_FAT_RUN 16U
+#define HOST_FAT_GAP 100U
+
+static FATFS hostFs = { HOST_FAT_CLUSTER_SECTORS, 1000 };
+static DWORD hostNextCluster = 2;
+
+uint32_t hostLinkMaps = 0;
+
+FRESULT f_mount(FATFS *fs, const char *path, BYTE opt)
+{
+    (void)path;
+    (void)opt;
+
+    *fs = hostFs;
+    return FR_OK;
+}
+
+FRESULT f_open(FIL *fp, const char *path, BYTE mode)
+{
+    (void)mode;
+
+    memset(fp, 0, sizeof(*fp));
+    fp->host = fopen(path, "rb");
+    if (fp->host == NULL)
+    {
+        return FR_NO_FILE;
+    }
+    fseek(fp->host, 0, SEEK_END);
+    fp->obj.objsize = (FSIZE_t)ftell(fp->host);
+    fseek(fp->host, 0, SEEK_SET);
+
+    // Leave room for the gaps between runs
+    fp->obj.fs = &hostFs;
+    fp->obj.sclust = hostNextCluster;
+    hostNextCluster += (DWORD)(fp->obj.objsize / HOST_FAT_CLUSTER_SIZE / HOST_FAT_RUN + 1) *
+        (HOST_FAT_RUN + HOST_FAT_GAP);
+
+    return FR_OK;
+}
+
+FRESULT f_close(FIL *fp)
+{
+    if (fp->host != NULL)
+    {
+        fclose(fp->host);
+        fp->host = NULL;
+    }
+
+    return FR_OK;
+}
+
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br)
+{
+    *br = (UINT)fread(buff, 1, btr, fp->host);
+    fp->fptr += *br;
+
+    return ferror(fp->host) ? FR_DISK_ERR : FR_OK;
+}
+
+// Writes the link map of the made-up layout: runs of HOST_FAT_RUN clusters with gaps
+static FRESULT host_link_map(FIL *fp)
+{
+    DWORD clusters = (DWORD)((fp->obj.objsize + HOST_FAT_CLUSTER_SIZE - 1) / HOST_FAT_CLUSTER_SIZE);
+    DWORD runs = (clusters + HOST_FAT_RUN - 1) / HOST_FAT_RUN;
+    DWORD *map = fp->cltbl;
+
+    hostLinkMaps++;
+    if (2 * runs + 2 > map[0])
+    {
+        map[0] = 2 * runs + 2;
+        return FR_NOT_ENOUGH_CORE;
+    }
+    for (DWORD i = 0; i < runs; i++)
+    {
+        map[1 + 2 * i] = (i == runs - 1) ? clusters - HOST_FAT_RUN * i : HOST_FAT_RUN;
+        map[2 + 2 * i] = fp->obj.sclust + i * (HOST_FAT_RUN + HOST_FAT_GAP);
+    }
+    map[1 + 2 * runs] = 0;
+
+    return FR_OK;
+}
+
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs)
+{
+    if (ofs == CREATE_LINKMAP)
+    {
+        return host_link_map(fp);
+    }
+    if (fseek(fp->host, (long)ofs, SEEK_SET) != 0)
+    {
+        return FR_DISK_ERR;
+    }
+    fp->fptr = ofs;
+
+    return FR_OK;
+}
+
+void xil_printf(const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+void Xil_DCacheFlushRange(INTPTR address, INTPTR size)
+{
+    (void)address;
+    (void)size;
+}
+
+void Xil_DCacheInvalidateRange(INTPTR address, INTPTR size)
+{
+    (void)address;
+    (void)size;
+}
+
+void Xil_DCacheFlush(void)
+{
+}
+
+void XTime_GetTime(XTime *time)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    *time = (XTime)now.tv_sec * COUNTS_PER_SECOND + (XTime)now.tv_nsec / (1000000000ULL / COUNTS_PER_SECOND);
+}
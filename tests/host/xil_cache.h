@@ -0,0 +1,15 @@
+/*
+ * Description: Host stand-in for the BSP's cache maintenance; the host is coherent, so
+ * every call does nothing (see host_bsp.c).
+ */
+
+#ifndef XIL_CACHE_H
+#define XIL_CACHE_H
+
+#include "xil_types.h"
+
+void Xil_DCacheFlushRange(INTPTR address, INTPTR size);
+void Xil_DCacheInvalidateRange(INTPTR address, INTPTR size);
+void Xil_DCacheFlush(void);
+
+#endif
@@ -0,0 +1,12 @@
+/*
+ * Description: Host stand-in for the BSP's debug output (see host_bsp.c).
+ */
+
+#ifndef XIL_PRINTF_H
+#define XIL_PRINTF_H
+
+#include "xil_types.h"
+
+void xil_printf(const char *format, ...);
+
+#endif
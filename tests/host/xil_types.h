@@ -0,0 +1,22 @@
+/*
+ * Description: Host stand-in for the BSP's basic types.
+ */
+
+#ifndef XIL_TYPES_H
+#define XIL_TYPES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int32_t s32;
+typedef uintptr_t UINTPTR;
+typedef intptr_t INTPTR;
+
+#define XST_SUCCESS 0L
+#define XST_FAILURE 1L
+
+#endif
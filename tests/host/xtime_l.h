@@ -0,0 +1,17 @@
+/*
+ * Description: Host stand-in for the BSP's global timer, read from the monotonic clock
+ * (see host_bsp.c).
+ */
+
+#ifndef XTIME_L_H
+#define XTIME_L_H
+
+#include <stdint.h>
+
+typedef uint64_t XTime;
+
+#define COUNTS_PER_SECOND 100000000ULL
+
+void XTime_GetTime(XTime *time);
+
+#endif
@@ -0,0 +1,185 @@
+/*
+ * Description: Host test of AES-256-GCM decryption (../aes_gcm.h). Checks the GCM
+ * specification's AES-256 vectors without additional data (test cases 13 to 15) and a
+ * ciphertext that ends in a partial block, decrypting both into a separate buffer and in
+ * place, then checks that a changed tag or ciphertext is rejected. Finally times the
+ * decryption of a few MiB and prints the rate and the cost per MiB for this host; build
+ * for the A53 with -march=armv8-a+crypto to time the instruction path.
+ *
+ * Build: make -C tests, or gcc -O2 -I.. -o test_aes_gcm test_aes_gcm.c ../aes_gcm.c
+ */
+
+// Standard Libraries
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Addtional Libraries
+#include "aes_gcm.h"
+
+#define MAX_SIZE 64
+#define TIMING_SIZE (4U << 20)
+#define TIMING_ROUNDS 8
+
+struct gcm_vector
+{
+    const char *name;
+    const char *key;
+    const char *iv;
+    const char *plaintext;
+    const char *ciphertext;
+    const char *tag;
+};
+
+static const struct gcm_vector gcmVectors[] =
+{
+    {
+        "test case 13 (empty)",
+        "0000000000000000000000000000000000000000000000000000000000000000",
+        "000000000000000000000000",
+        "",
+        "",
+        "530f8afbc74536b9a963b4f1c4cb738b",
+    },
+    {
+        "test case 14 (one block)",
+        "0000000000000000000000000000000000000000000000000000000000000000",
+        "000000000000000000000000",
+        "00000000000000000000000000000000",
+        "cea7403d4d606b6e074ec5d3baf39d18",
+        "d0d1c8a799996bf0265b98b5d48ab919",
+    },
+    {
+        "test case 15 (four blocks)",
+        "feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308",
+        "cafebabefacedbaddecaf888",
+        "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+        "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255",
+        "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa"
+        "8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662898015ad",
+        "b094dac5d93471bdec1a502270e3cc6c",
+    },
+    {
+        "test case 15 cut to 60 bytes (partial block)",
+        "feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308",
+        "cafebabefacedbaddecaf888",
+        "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+        "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+        "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa"
+        "8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662",
+        "eb9f796c8d356fc31a8433884b696f4f",
+    },
+};
+
+static int failures;
+
+static void check(int condition, const char *what, const char *name)
+{
+    printf("%s: %s, %s\n", condition ? "ok  " : "FAIL", what, name);
+    if (!condition)
+    {
+        failures++;
+    }
+}
+
+static uint32_t from_hex(const char *hex, uint8_t *out)
+{
+    uint32_t size = (uint32_t)strlen(hex) / 2;
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        sscanf(hex + 2 * i, "%2hhx", &out[i]);
+    }
+
+    return size;
+}
+
+static void check_vector(const struct gcm_vector *vector)
+{
+    static struct aes_gcm_context context;
+    uint8_t key[AES_GCM_KEY_SIZE], iv[AES_GCM_IV_SIZE], tag[AES_GCM_TAG_SIZE];
+    uint8_t plaintext[MAX_SIZE], ciphertext[MAX_SIZE], out[MAX_SIZE];
+    uint32_t size;
+
+    from_hex(vector->key, key);
+    from_hex(vector->iv, iv);
+    from_hex(vector->tag, tag);
+    from_hex(vector->plaintext, plaintext);
+    size = from_hex(vector->ciphertext, ciphertext);
+    aes_gcm_init(&context, key);
+
+    memset(out, 0, sizeof(out));
+    check(aes_gcm_decrypt(&context, iv, ciphertext, out, size, tag) == 0 && memcmp(out, plaintext, size) == 0,
+        "decrypts to the plaintext", vector->name);
+
+    memcpy(out, ciphertext, size);
+    check(aes_gcm_decrypt(&context, iv, out, out, size, tag) == 0 && memcmp(out, plaintext, size) == 0,
+        "decrypts in place", vector->name);
+
+    tag[AES_GCM_TAG_SIZE - 1] ^= 0x01;
+    check(aes_gcm_decrypt(&context, iv, ciphertext, out, size, tag) != 0, "rejects a changed tag", vector->name);
+    tag[AES_GCM_TAG_SIZE - 1] ^= 0x01;
+
+    if (size != 0)
+    {
+        ciphertext[size - 1] ^= 0x80;
+        check(aes_gcm_decrypt(&context, iv, ciphertext, out, size, tag) != 0, "rejects a changed ciphertext",
+            vector->name);
+        ciphertext[size - 1] ^= 0x80;
+    }
+
+    iv[0] ^= 0x01;
+    check(aes_gcm_decrypt(&context, iv, ciphertext, out, size, tag) != 0, "rejects a changed IV", vector->name);
+}
+
+static double seconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// The tag is only compared after the whole buffer is authenticated and decrypted, so a
+// mismatching one costs the same as a valid one
+static void time_decrypt(void)
+{
+    static struct aes_gcm_context context;
+    static const uint8_t key[AES_GCM_KEY_SIZE] = { 1 };
+    static const uint8_t iv[AES_GCM_IV_SIZE] = { 2 };
+    static const uint8_t tag[AES_GCM_TAG_SIZE];
+    uint8_t *buffer = calloc(1, TIMING_SIZE);
+
+    if (buffer == NULL)
+    {
+        check(0, "allocate the timing buffer", "throughput");
+        return;
+    }
+
+    aes_gcm_init(&context, key);
+    double start = seconds();
+    for (uint32_t i = 0; i < TIMING_ROUNDS; i++)
+    {
+        aes_gcm_decrypt(&context, iv, buffer, buffer, TIMING_SIZE, tag);
+    }
+    double elapsed = seconds() - start;
+    double mebibytes = (double)TIMING_SIZE * TIMING_ROUNDS / (1 << 20);
+
+    printf("time: %.0f MiB decrypted in place at %.1f MiB/s, %.0f us per MiB\n", mebibytes, mebibytes / elapsed,
+        elapsed * 1e6 / mebibytes);
+    free(buffer);
+}
+
+int main(void)
+{
+    for (uint32_t i = 0; i < sizeof(gcmVectors) / sizeof(gcmVectors[0]); i++)
+    {
+        check_vector(&gcmVectors[i]);
+    }
+    time_decrypt();
+
+    printf("%s\n", failures ? "test_aes_gcm: FAILED" : "test_aes_gcm: passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,187 @@
+/*
+ * Description: Host test of the boot pack hash tree (../bootpack_hash.h). Builds the
+ * metadata and leaves of a small container, then checks that tampering with a block, a
+ * stored leaf, an inner node, the header (including bytes past the struct), either table
+ * or the root is caught by recomputing the root the way the loader does.
+ *
+ * Build: make -C tests, or gcc -O2 -I.. -o test_bootpack_hash test_bootpack_hash.c ../bootpack_hash.c ../sha3.c
+ */
+
+// Standard Libraries
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+// Addtional Libraries
+#include "bootpack_hash.h"
+#include "sha3.h"
+
+#define NUM_SEGMENTS 2
+#define NUM_BLOCKS 5                // Odd, so a node is promoted
+#define BLOCK_SIZE 256
+#define HEADER_EXTRA 16             // Header bytes a newer packer might add
+
+struct container
+{
+    union
+    {
+        struct bpk_header header;
+        uint8_t bytes[sizeof(struct bpk_header) + HEADER_EXTRA];
+    } header;
+    struct bpk_segment segments[NUM_SEGMENTS];
+    struct bpk_block blocks[NUM_BLOCKS];
+    uint8_t data[NUM_BLOCKS][BLOCK_SIZE];
+    uint8_t leaves[NUM_BLOCKS][BPK_HASH_SIZE];
+};
+
+static int failures;
+
+static void check(int condition, const char *what)
+{
+    printf("%s: %s\n", condition ? "ok  " : "FAIL", what);
+    if (!condition)
+    {
+        failures++;
+    }
+}
+
+// Root the loader computes from the stored leaves and metadata
+static void compute_root(const struct container *c, uint8_t *root)
+{
+    uint8_t nodes[(NUM_BLOCKS + 1) * BPK_HASH_SIZE];
+
+    memcpy(nodes, c->leaves, sizeof(c->leaves));
+    bpk_hash_manifest(c->header.bytes, c->segments, c->blocks, nodes + NUM_BLOCKS * BPK_HASH_SIZE);
+    bpk_hash_root(nodes, NUM_BLOCKS + 1, root);
+}
+
+static int root_matches(const struct container *c)
+{
+    uint8_t root[BPK_HASH_SIZE];
+
+    compute_root(c, root);
+    return memcmp(root, c->header.header.root, BPK_HASH_SIZE) == 0;
+}
+
+// Whether the decoded block still matches its stored leaf
+static int block_matches(const struct container *c, uint32_t index)
+{
+    uint8_t digest[BPK_HASH_SIZE];
+
+    bpk_hash_leaf(index, c->data[index], BLOCK_SIZE, digest);
+    return memcmp(digest, c->leaves[index], BPK_HASH_SIZE) == 0;
+}
+
+static void build(struct container *c)
+{
+    memset(c, 0, sizeof(*c));
+    memcpy(c->header.header.magic, "BPK1", 4);
+    c->header.header.version = BPK_VERSION;
+    c->header.header.header_size = sizeof(c->header.bytes);
+    c->header.header.num_segments = NUM_SEGMENTS;
+    c->header.header.num_blocks = NUM_BLOCKS;
+    c->header.header.block_size = BLOCK_SIZE;
+    c->header.header.entry = 0x50000000;
+    memset(c->header.bytes + sizeof(struct bpk_header), 0x5A, HEADER_EXTRA);
+
+    c->segments[0].dest = 0x50000000;
+    c->segments[0].filesz = c->segments[0].memsz = 3 * BLOCK_SIZE;
+    c->segments[0].num_blocks = 3;
+    c->segments[1].dest = 0x50100000;
+    c->segments[1].filesz = c->segments[1].memsz = 2 * BLOCK_SIZE;
+    c->segments[1].first_block = 3;
+    c->segments[1].num_blocks = 2;
+
+    for (uint32_t i = 0; i < NUM_BLOCKS; i++)
+    {
+        for (uint32_t j = 0; j < BLOCK_SIZE; j++)
+        {
+            c->data[i][j] = (uint8_t)(i * 31 + j * 7);
+        }
+        c->blocks[i].offset = 0x1000 + i * BLOCK_SIZE;
+        c->blocks[i].stored = BLOCK_SIZE;
+        bpk_hash_leaf(i, c->data[i], BLOCK_SIZE, c->leaves[i]);
+    }
+
+    compute_root(c, c->header.header.root);
+
+    // Signing fills the signature after the root; neither is part of the manifest
+    memset(c->header.header.signature, 0xC3, BPK_SIGNATURE_SIZE);
+}
+
+int main(void)
+{
+    static struct container c;
+
+    build(&c);
+    check(root_matches(&c), "untouched container matches its root");
+    for (uint32_t i = 0; i < NUM_BLOCKS; i++)
+    {
+        check(block_matches(&c, i), "untouched block matches its leaf");
+    }
+
+    build(&c);
+    c.data[3][100] ^= 0x01;
+    check(!block_matches(&c, 3), "flipped bit in block data is caught by its leaf");
+
+    build(&c);
+    c.leaves[2][0] ^= 0x80;
+    check(!root_matches(&c), "tampered stored leaf is caught by the root");
+
+    build(&c);
+    {
+        // Present the parent of leaves 0 and 1 as a single leaf
+        uint8_t merged[NUM_BLOCKS * BPK_HASH_SIZE];
+        uint8_t nodes[NUM_BLOCKS * BPK_HASH_SIZE];
+        uint8_t root[BPK_HASH_SIZE];
+        struct sha3_context context;
+        uint8_t domain = BPK_HASH_NODE;
+
+        sha3_384_init(&context);
+        sha3_384_update(&context, &domain, 1);
+        sha3_384_update(&context, c.leaves, 2 * BPK_HASH_SIZE);
+        sha3_384_final(&context, merged);
+        memcpy(merged + BPK_HASH_SIZE, c.leaves[2], (NUM_BLOCKS - 2) * BPK_HASH_SIZE);
+        memcpy(nodes, merged, (NUM_BLOCKS - 1) * BPK_HASH_SIZE);
+        bpk_hash_manifest(c.header.bytes, c.segments, c.blocks, nodes + (NUM_BLOCKS - 1) * BPK_HASH_SIZE);
+        bpk_hash_root(nodes, NUM_BLOCKS, root);
+        check(memcmp(root, c.header.header.root, BPK_HASH_SIZE) != 0, "inner node passed off as a leaf is caught");
+    }
+
+    build(&c);
+    {
+        uint8_t swap[BPK_HASH_SIZE];
+
+        memcpy(swap, c.leaves[0], BPK_HASH_SIZE);
+        memcpy(c.leaves[0], c.leaves[1], BPK_HASH_SIZE);
+        memcpy(c.leaves[1], swap, BPK_HASH_SIZE);
+        check(!root_matches(&c), "swapped sibling leaves are caught");
+    }
+
+    build(&c);
+    c.header.header.entry += 4;
+    check(!root_matches(&c), "tampered header field is caught by the manifest");
+
+    build(&c);
+    c.header.bytes[sizeof(struct bpk_header) + HEADER_EXTRA - 1] ^= 0x01;
+    check(!root_matches(&c), "tampered header byte past the struct is caught by the manifest");
+
+    build(&c);
+    c.segments[1].dest += 0x1000;
+    check(!root_matches(&c), "tampered segment table is caught by the manifest");
+
+    build(&c);
+    c.blocks[4].codec = BPK_CODEC_FILL;
+    check(!root_matches(&c), "tampered block table is caught by the manifest");
+
+    build(&c);
+    c.header.header.root[BPK_HASH_SIZE - 1] ^= 0x01;
+    check(!root_matches(&c), "tampered root is caught");
+
+    build(&c);
+    memset(c.header.header.signature, 0, BPK_SIGNATURE_SIZE);
+    check(root_matches(&c), "signature is left out of the manifest");
+
+    printf("%s\n", failures ? "test_bootpack_hash: FAILED" : "test_bootpack_hash: passed");
+    return failures ? 1 : 0;
+}
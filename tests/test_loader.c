@@ -0,0 +1,850 @@
+/*
+ * Description: Host test of the image loaders (../elf_loader.h) over the storage
+ * stand-ins: SD_ASYNC_EMULATE reads the card through FatFs a few polls after each
+ * command, with the host files standing in for the card (host/ff.h), and
+ * BOOT_QSPI_EMULATE maps qspi.bin, an image partition written here, in place of the
+ * linear window and copies a few polls after each read starts. The partition also
+ * serves as the SD cache (BOOT_STORAGE_CACHE), with the flag that fills it: a hashed
+ * container is stored on a miss and read from flash on the next load, a damaged cached
+ * copy falls back to the card and is replaced, an entry whose container has another
+ * root is passed over, and a store into a full partition starts it over. With
+ * BOOT_STORAGE_STRIPE, containers are striped over QSPI and the card in several unit
+ * sizes, and a truncated part and one with another image's id must fail.
+ * BOOT_EMMC_EMULATE reads blocks of emmc.bin, a second partition laid out the same way
+ * with block-aligned images. Builds ELF images with a misaligned segment, a bss tail
+ * and a segment spanning several cluster runs, loads them one after the other and side
+ * by side, on one medium and on two at once, and checks every byte that lands and the
+ * entry point. Then checks that an image reaching past its file, one placed over the
+ * loader's own memory, one with more file data than memory, an ELF64 image loaded for a
+ * 32-bit core, a directory entry past either partition and a missing one fail, and that
+ * a cache entry is not opened in place of the card image of its name. The loader's
+ * memory (OCM and the handoff registers) and the images' DDR are mapped at their target
+ * addresses.
+ *
+ * Build: make -C tests
+ */
+
+// Standard Libraries
+#include <elf.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+// Addtional Libraries
+#include "elf_loader.h"
+#include "boot_log.h"
+#include "boot_memmap.h"
+#include "boot_stats.h"
+#include "boot_trace.h"
+#include "boot_zero.h"
+#include "bootpack.h"
+#include "bootpack_hash.h"
+#include "boot_qspi.h"
+#include "boot_emmc.h"
+#include "boot_stripe.h"
+#include "ff.h"
+
+// Target memory the loader touches: OCM, the handoff registers and DDR for the images
+#define OCM_ADDR 0xFFFC0000UL
+#define OCM_SIZE 0x40000UL
+#define HANDOFF_ADDR 0xFFD80000UL
+#define HANDOFF_SIZE 0x1000UL
+#define DDR_ADDR 0x10000000UL
+#define DDR_SIZE 0x01000000UL
+
+#define MAX_SEGMENTS 3
+#define FILL 0xA5
+
+// Segments sit in the file at their address modulo this, as linkers lay them out
+#define PAGE_SIZE 0x1000U
+
+// eMMC images start on blocks, as qspiimg -a 512 places them
+#define EMMC_ALIGN 512U
+
+// Boot pack containers are packed into raw blocks of this size
+#define PACK_BLOCK 0x1000U
+
+// QSPI parts of striped images go here, clear of the cached containers
+#define STRIPE_QSPI_OFFSET 0x400000U
+#define STRIPE_QSPI_SPACING 0x40000U
+
+struct test_segment
+{
+    uint64_t address;
+    uint32_t filesz;
+    uint32_t memsz;
+};
+
+struct test_image
+{
+    const char *name;
+    uint64_t entry;
+    uint32_t num_segments;
+    struct test_segment segments[MAX_SEGMENTS];
+    uint32_t cut;                   // Bytes left off the end of the stored file
+};
+
+// Far apart, so images loading side by side do not share memory
+static const struct test_image sdImage =
+{
+    "sd.elf", 0x10000100ULL, 3,
+    {
+        { 0x10000000ULL, 0x28000, 0x30000 },        // Runs over several cluster runs, bss tail
+        { 0x10040003ULL, 0x1FD, 0x1FD },            // Starts and ends off a sector
+        { 0x10050000ULL, 0, 0x2000 },               // bss only
+    },
+    0,
+};
+static const struct test_image sdSecond =
+{
+    "sd2.elf", 0x10800000ULL, 2,
+    {
+        { 0x10800000ULL, 0x10000, 0x10000 },
+        { 0x10900040ULL, 0x8123, 0x9000 },
+    },
+    0,
+};
+static const struct test_image qspiImage =
+{
+    "qspi.elf", 0x10400000ULL, 2,
+    {
+        { 0x10400000ULL, 0x30000, 0x31000 },        // Copied in the background
+        { 0x10480007ULL, 0x5001, 0x5001 },          // Partial lines at both ends
+    },
+    0,
+};
+static const struct test_image emmcImage =
+{
+    "emmc.elf", 0x10600000ULL, 2,
+    {
+        { 0x10600000ULL, 0x24000, 0x24000 },        // Several blocks straight into place
+        { 0x10640021ULL, 0x3E1, 0x1000 },           // Partial blocks at both ends, bss tail
+    },
+    0,
+};
+static const struct test_image packImage =
+{
+    "pack.bpk", 0x10A00000ULL, 2,
+    {
+        { 0x10A00000ULL, 0x6000, 0x7000 },
+        { 0x10A20000ULL, 0x2345, 0x2345 },          // Cold, its check deferred from the card
+    },
+    0,
+};
+static const struct test_image stripeImage =
+{
+    "stripe.bpk", 0x10B00000ULL, 2,
+    {
+        { 0x10B00000ULL, 0x3C000, 0x3D000 },        // Spans many units of either part
+        { 0x10B80000ULL, 0x1234, 0x1234 },
+    },
+    0,
+};
+static const struct test_image qspiCut =
+{
+    "qspicut.elf", 0x10400000ULL, 1,
+    {
+        { 0x10400000ULL, 0x8000, 0x8000 },
+    },
+    0x100,
+};
+
+static int failures;
+
+static void check(int condition, const char *what, const char *name)
+{
+    printf("%s: %s, %s\n", condition ? "ok  " : "FAIL", what, name);
+    if (!condition)
+    {
+        failures++;
+    }
+}
+
+static int map_target(uintptr_t address, size_t size)
+{
+    void *mapped = mmap((void *)address, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+    return (mapped == (void *)address) ? 0 : -1;
+}
+
+// Byte i of segment n's file data
+static uint8_t image_byte(const struct test_image *image, uint32_t n, uint32_t i)
+{
+    return (uint8_t)((i * 131U) ^ (i >> 8) ^ (n * 29U) ^ image->name[0]);
+}
+
+// File offset of the segment following data that ends at offset
+static uint32_t segment_offset(const struct test_segment *segment, uint32_t offset)
+{
+    uint32_t page = (uint32_t)(segment->address % PAGE_SIZE);
+
+    return offset + (page - offset) % PAGE_SIZE;
+}
+
+// Lays the image out as an ELF64 file: header, program headers, then the segments
+static uint8_t *image_build(const struct test_image *image, uint32_t *size)
+{
+    uint32_t offset = sizeof(Elf64_Ehdr) + image->num_segments * sizeof(Elf64_Phdr);
+    uint32_t total = offset;
+
+    for (uint32_t n = 0; n < image->num_segments; n++)
+    {
+        total = segment_offset(&image->segments[n], total) + image->segments[n].filesz;
+    }
+
+    uint8_t *file = calloc(1, total);
+    Elf64_Ehdr *header = (Elf64_Ehdr *)file;
+    Elf64_Phdr *programHeaders = (Elf64_Phdr *)(file + sizeof(Elf64_Ehdr));
+
+    memcpy(header->e_ident, ELFMAG, SELFMAG);
+    header->e_ident[EI_CLASS] = ELFCLASS64;
+    header->e_ident[EI_DATA] = ELFDATA2LSB;
+    header->e_ident[EI_VERSION] = EV_CURRENT;
+    header->e_type = ET_EXEC;
+    header->e_machine = EM_AARCH64;
+    header->e_version = EV_CURRENT;
+    header->e_entry = image->entry;
+    header->e_phoff = sizeof(Elf64_Ehdr);
+    header->e_ehsize = sizeof(Elf64_Ehdr);
+    header->e_phentsize = sizeof(Elf64_Phdr);
+    header->e_phnum = (uint16_t)image->num_segments;
+
+    for (uint32_t n = 0; n < image->num_segments; n++)
+    {
+        const struct test_segment *segment = &image->segments[n];
+
+        offset = segment_offset(segment, offset);
+        programHeaders[n].p_type = PT_LOAD;
+        programHeaders[n].p_flags = PF_R | PF_W | PF_X;
+        programHeaders[n].p_offset = offset;
+        programHeaders[n].p_vaddr = segment->address;
+        programHeaders[n].p_paddr = segment->address;
+        programHeaders[n].p_filesz = segment->filesz;
+        programHeaders[n].p_memsz = segment->memsz;
+        programHeaders[n].p_align = 1;
+        for (uint32_t i = 0; i < segment->filesz; i++)
+        {
+            file[offset + i] = image_byte(image, n, i);
+        }
+        offset += segment->filesz;
+    }
+
+    *size = total;
+    return file;
+}
+
+static int write_file(const char *path, const uint8_t *data, uint32_t size)
+{
+    FILE *out = fopen(path, "wb");
+    int status = (out != NULL && fwrite(data, 1, size, out) == size) ? 0 : -1;
+
+    if (out != NULL && fclose(out) != 0)
+    {
+        status = -1;
+    }
+
+    return status;
+}
+
+// Writes the image as a file on the card
+static void image_to_sd(const struct test_image *image)
+{
+    uint32_t size;
+    uint8_t *file = image_build(image, &size);
+
+    check(write_file(image->name, file, size - image->cut) == 0, "writes the image file", image->name);
+    free(file);
+}
+
+// Writes the images behind an image directory, each starting on a multiple of align, as
+// tools/qspiimg.c lays out a partition
+static void images_to_media(const char *path, const struct test_image *const images[], uint32_t count,
+    uint32_t align)
+{
+    static struct boot_qspi_directory directory;
+    uint8_t *files[BOOT_QSPI_MAX_IMAGES];
+    uint32_t sizes[BOOT_QSPI_MAX_IMAGES];
+    uint32_t offset = sizeof(directory);
+
+    memset(&directory, 0, sizeof(directory));
+    memcpy(directory.magic, BOOT_QSPI_MAGIC, 4);
+    directory.version = BOOT_QSPI_VERSION;
+    directory.num_images = count;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        struct boot_qspi_image *entry = &directory.images[i];
+
+        files[i] = image_build(images[i], &sizes[i]);
+        sizes[i] -= images[i]->cut;
+        offset = (offset + align - 1) & ~(align - 1);
+        strncpy(entry->name, images[i]->name, BOOT_QSPI_NAME_SIZE);
+        entry->offset = offset;
+        entry->size = sizes[i];
+        offset += sizes[i];
+    }
+
+    uint8_t *media = calloc(1, offset);
+    memcpy(media, &directory, sizeof(directory));
+    for (uint32_t i = 0; i < count; i++)
+    {
+        memcpy(media + directory.images[i].offset, files[i], sizes[i]);
+        free(files[i]);
+    }
+    check(write_file(path, media, offset) == 0, "writes the image directory", path);
+    free(media);
+}
+
+// Adds an entry to the directory written by images_to_media(), pointing wherever it says
+static void media_add_entry(const char *path, const struct boot_qspi_image *entry)
+{
+    static struct boot_qspi_directory directory;
+    FILE *media = fopen(path, "r+b");
+    int status = -1;
+
+    if (media != NULL && fread(&directory, sizeof(directory), 1, media) == 1 &&
+        directory.num_images < BOOT_QSPI_MAX_IMAGES)
+    {
+        directory.images[directory.num_images++] = *entry;
+        status = (fseek(media, 0, SEEK_SET) == 0 && fwrite(&directory, sizeof(directory), 1, media) == 1) ? 0 : -1;
+    }
+    if (media != NULL && fclose(media) != 0)
+    {
+        status = -1;
+    }
+    check(status == 0, "adds a directory entry", entry->name);
+}
+
+// Packs the image as a hashed boot pack container of raw blocks, the last segment cold,
+// laid out as tools/bootpack.c writes one
+static uint8_t *container_build(const struct test_image *image, uint32_t *size)
+{
+    uint32_t numBlocks = 0;
+    uint32_t dataSize = 0;
+
+    for (uint32_t n = 0; n < image->num_segments; n++)
+    {
+        numBlocks += (image->segments[n].filesz + PACK_BLOCK - 1) / PACK_BLOCK;
+        dataSize += (image->segments[n].filesz + PACK_BLOCK - 1) / PACK_BLOCK * PACK_BLOCK;
+    }
+
+    uint32_t segmentOffset = sizeof(struct bpk_header);
+    uint32_t blockOffset = segmentOffset + image->num_segments * sizeof(struct bpk_segment);
+    uint32_t hashOffset = blockOffset + numBlocks * sizeof(struct bpk_block);
+    uint32_t offset = (hashOffset + numBlocks * BPK_HASH_SIZE + BOOT_QSPI_ALIGN - 1) & ~(BOOT_QSPI_ALIGN - 1);
+    uint8_t *file = calloc(1, offset + dataSize);
+    uint8_t *leaves = calloc(numBlocks + 1, BPK_HASH_SIZE);
+    struct bpk_header *header = (struct bpk_header *)file;
+    struct bpk_segment *segments = (struct bpk_segment *)(file + segmentOffset);
+    struct bpk_block *blocks = (struct bpk_block *)(file + blockOffset);
+    uint32_t index = 0;
+
+    memcpy(header->magic, "BPK1", 4);
+    header->version = BPK_VERSION;
+    header->header_size = sizeof(*header);
+    header->num_segments = image->num_segments;
+    header->num_blocks = numBlocks;
+    header->block_size = PACK_BLOCK;
+    header->max_stored = PACK_BLOCK;
+    header->entry = image->entry;
+    header->segment_offset = segmentOffset;
+    header->block_offset = blockOffset;
+    header->hash_offset = hashOffset;
+    for (uint32_t n = 0; n < image->num_segments; n++)
+    {
+        const struct test_segment *segment = &image->segments[n];
+
+        segments[n].dest = segment->address;
+        segments[n].filesz = segment->filesz;
+        segments[n].memsz = segment->memsz;
+        segments[n].first_block = index;
+        segments[n].flags = (n + 1 == image->num_segments) ? BPK_SEGMENT_COLD : 0;
+        for (uint32_t start = 0; start < segment->filesz; start += PACK_BLOCK, index++)
+        {
+            uint32_t length = (segment->filesz - start < PACK_BLOCK) ? segment->filesz - start : PACK_BLOCK;
+
+            for (uint32_t i = 0; i < length; i++)
+            {
+                file[offset + i] = image_byte(image, n, start + i);
+            }
+            blocks[index].offset = offset;
+            blocks[index].stored = length;
+            blocks[index].codec = BPK_CODEC_RAW;
+            bpk_hash_leaf(index, file + offset, length, leaves + index * BPK_HASH_SIZE);
+            offset += PACK_BLOCK;
+        }
+        segments[n].num_blocks = index - segments[n].first_block;
+    }
+
+    memcpy(file + hashOffset, leaves, numBlocks * BPK_HASH_SIZE);
+    bpk_hash_manifest(header, segments, blocks, leaves + numBlocks * BPK_HASH_SIZE);
+    bpk_hash_root(leaves, numBlocks + 1, header->root);
+    free(leaves);
+
+    *size = offset;
+    return file;
+}
+
+// Writes the image as a container on the card
+static void container_to_sd(const struct test_image *image)
+{
+    uint32_t size;
+    uint8_t *file = container_build(image, &size);
+
+    check(write_file(image->name, file, size) == 0, "writes the container", image->name);
+    free(file);
+}
+
+// Container offset of the first block of segment n
+static uint32_t container_block(const struct test_image *image, uint32_t n)
+{
+    uint32_t size;
+    uint8_t *file = container_build(image, &size);
+    const struct bpk_header *header = (const struct bpk_header *)file;
+    const struct bpk_segment *segments = (const struct bpk_segment *)(file + header->segment_offset);
+    const struct bpk_block *blocks = (const struct bpk_block *)(file + header->block_offset);
+    uint32_t offset = blocks[segments[n].first_block].offset;
+
+    free(file);
+    return offset;
+}
+
+// Flips a byte of a file in place, as a bad sector would
+static int flip_byte(const char *path, uint32_t offset)
+{
+    FILE *file = fopen(path, "r+b");
+    int value = (file != NULL && fseek(file, offset, SEEK_SET) == 0) ? fgetc(file) : EOF;
+    int status = (value != EOF && fseek(file, offset, SEEK_SET) == 0 && fputc(value ^ 0x01, file) != EOF) ? 0 : -1;
+
+    if (file != NULL && fclose(file) != 0)
+    {
+        status = -1;
+    }
+
+    return status;
+}
+
+// Finds the partition's entry named name; returns the number of entries, or -1 if the
+// directory cannot be read
+static int media_entry(const char *path, const char *name, struct boot_qspi_image *entry, int *found)
+{
+    static struct boot_qspi_directory directory;
+    FILE *media = fopen(path, "rb");
+    int count = -1;
+
+    *found = 0;
+    if (media != NULL && fread(&directory, sizeof(directory), 1, media) == 1 &&
+        memcmp(directory.magic, BOOT_QSPI_MAGIC, 4) == 0)
+    {
+        count = (int)directory.num_images;
+        for (uint32_t i = 0; i < directory.num_images && i < BOOT_QSPI_MAX_IMAGES; i++)
+        {
+            if (strncmp(directory.images[i].name, name, BOOT_QSPI_NAME_SIZE) == 0)
+            {
+                *entry = directory.images[i];
+                *found = 1;
+            }
+        }
+    }
+    if (media != NULL)
+    {
+        fclose(media);
+    }
+
+    return count;
+}
+
+// Whether the partition holds the image's container under its name, keyed by its root
+static int media_holds_container(const char *path, const struct test_image *image)
+{
+    struct boot_qspi_image entry;
+    uint32_t size;
+    int found;
+    uint8_t *file = container_build(image, &size);
+    uint8_t *stored = malloc(size);
+    FILE *media = fopen(path, "rb");
+    int holds = 0;
+
+    if (media_entry(path, image->name, &entry, &found) >= 0 && found && entry.size == size && media != NULL &&
+        fseek(media, entry.offset, SEEK_SET) == 0 && fread(stored, 1, size, media) == size)
+    {
+        holds = memcmp(stored, file, size) == 0 &&
+            memcmp(entry.key, ((const struct bpk_header *)file)->root, BOOT_QSPI_KEY_SIZE) == 0;
+    }
+    if (media != NULL)
+    {
+        fclose(media);
+    }
+    free(stored);
+    free(file);
+
+    return holds;
+}
+
+// Writes data into a partition written by images_to_media() at offset, under the name
+static void media_write(const char *path, const char *name, uint32_t offset, const uint8_t *data, uint32_t size)
+{
+    struct boot_qspi_image entry = { "", offset, size, { 0 } };
+    FILE *media = fopen(path, "r+b");
+    int status = (media != NULL && fseek(media, offset, SEEK_SET) == 0 && fwrite(data, 1, size, media) == size) ?
+        0 : -1;
+
+    if (media != NULL && fclose(media) != 0)
+    {
+        status = -1;
+    }
+    check(status == 0, "writes the image into the partition", name);
+    memcpy(entry.name, name, strnlen(name, BOOT_QSPI_NAME_SIZE));
+    media_add_entry(path, &entry);
+}
+
+// Cuts part index of a striped image out of the container, laid out as tools/bootpack.c
+// writes it with -p
+static uint8_t *stripe_part(const uint8_t *file, uint32_t size, uint32_t unit, uint32_t index, const uint8_t *id,
+    uint32_t *partSize)
+{
+    uint8_t *part = calloc(1, BOOT_STRIPE_HEADER_SIZE + size);
+    struct boot_stripe_header *header = (struct boot_stripe_header *)part;
+    uint32_t offset = BOOT_STRIPE_HEADER_SIZE;
+
+    memcpy(header->magic, BOOT_STRIPE_MAGIC, 4);
+    header->version = BOOT_STRIPE_VERSION;
+    header->index = (uint8_t)index;
+    header->count = BOOT_STRIPE_PARTS;
+    header->unit = unit;
+    header->size = size;
+    memcpy(header->id, id, BOOT_STRIPE_ID_SIZE);
+    for (uint32_t start = index * unit; start < size; start += BOOT_STRIPE_PARTS * unit)
+    {
+        uint32_t length = (size - start < unit) ? size - start : unit;
+
+        memcpy(part + offset, file + start, length);
+        offset += length;
+    }
+
+    *partSize = offset;
+    return part;
+}
+
+// Stripes the image's container over QSPI, the first part at offset, and the card. The
+// card's part carries secondId and is cut short by cut bytes.
+static void stripe_to_media(const struct test_image *image, uint32_t unit, uint32_t offset, const uint8_t *secondId,
+    uint32_t cut)
+{
+    uint32_t size;
+    uint32_t partSize;
+    uint8_t *file = container_build(image, &size);
+    const uint8_t *root = ((const struct bpk_header *)file)->root;
+    uint8_t *part = stripe_part(file, size, unit, 0, root, &partSize);
+
+    media_write(BOOT_QSPI_EMULATE_FILE, image->name, offset, part, partSize);
+    free(part);
+    part = stripe_part(file, size, unit, 1, (secondId != NULL) ? secondId : root, &partSize);
+    check(write_file(image->name, part, partSize - cut) == 0, "writes the second part", image->name);
+    free(part);
+    free(file);
+}
+
+// Fills the image's memory so bytes the loader missed show up
+static void image_clear(const struct test_image *image)
+{
+    for (uint32_t n = 0; n < image->num_segments; n++)
+    {
+        memset((void *)(uintptr_t)image->segments[n].address, FILL, image->segments[n].memsz);
+    }
+}
+
+static int image_in_memory(const struct test_image *image)
+{
+    for (uint32_t n = 0; n < image->num_segments; n++)
+    {
+        const struct test_segment *segment = &image->segments[n];
+        const uint8_t *memory = (const uint8_t *)(uintptr_t)segment->address;
+
+        for (uint32_t i = 0; i < segment->memsz; i++)
+        {
+            if (memory[i] != ((i < segment->filesz) ? image_byte(image, n, i) : 0))
+            {
+                printf("      segment %u differs at 0x%x\n", n, i);
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+// Loads one image by name and checks what lands
+static void check_load(const struct test_image *image, const char *what)
+{
+    uint64_t entry = 0;
+
+    image_clear(image);
+    int32_t status = load_elf64(image->name, &entry);
+    boot_zero_finish();
+
+    check(status == 0, "loads", what);
+    check(status == 0 && entry == image->entry, "returns the entry point", what);
+    check(status == 0 && image_in_memory(image), "places every segment and clears its bss", what);
+}
+
+// Loads two images side by side, stepping both from here
+static void check_side_by_side(const struct test_image *first, const struct test_image *second, const char *what)
+{
+    struct elf_load loads[2];
+    uint64_t entries[2] = { 0, 0 };
+    int32_t status = 0;
+
+    image_clear(first);
+    image_clear(second);
+    if (elf_load_start(&loads[0], first->name) != 0)
+    {
+        check(0, "starts the first load", what);
+        return;
+    }
+    if (elf_load_start(&loads[1], second->name) != 0)
+    {
+        elf_load_wait(&loads[0], &entries[0]);
+        check(0, "starts the second load", what);
+        return;
+    }
+    while (elf_load_poll(&loads[0]) == BOOT_TASK_RUNNING || elf_load_poll(&loads[1]) == BOOT_TASK_RUNNING)
+    {
+    }
+    status |= elf_load_wait(&loads[0], &entries[0]);
+    status |= elf_load_wait(&loads[1], &entries[1]);
+    boot_zero_finish();
+
+    check(status == 0, "loads both", what);
+    check(entries[0] == first->entry && entries[1] == second->entry, "returns both entry points", what);
+    check(status == 0 && image_in_memory(first) && image_in_memory(second), "places both images", what);
+}
+
+static void check_sd(void)
+{
+    static const struct test_image overLoader =
+    {
+        "sdbad.elf", 0x0ULL, 1,
+        {
+            { BPK_STAGING_ADDR, 0x100, 0x100 },
+        },
+        0,
+    };
+    static const struct test_image oversized =
+    {
+        "sdover.elf", 0x10060000ULL, 1,
+        {
+            { 0x10060000ULL, 0x200, 0x100 },        // More file data than memory
+        },
+        0,
+    };
+    const uint8_t *pastOversized = (const uint8_t *)(uintptr_t)(oversized.segments[0].address +
+        oversized.segments[0].memsz);
+    struct test_image truncated = sdImage;
+    uint64_t entry;
+    uint32_t entry32;
+
+    uint32_t linkMaps = hostLinkMaps;
+    check_load(&sdImage, "SD");
+    check(hostLinkMaps != linkMaps, "reads in the background through the stand-in", "SD");
+    check_side_by_side(&sdImage, &sdSecond, "SD with SD");
+
+    truncated.name = "sdcut.elf";
+    truncated.cut = 0x100;
+    image_to_sd(&truncated);
+    check(load_elf64(truncated.name, &entry) != 0, "rejects an image reaching past its file", "SD");
+
+    image_to_sd(&overLoader);
+    check(load_elf64(overLoader.name, &entry) != 0, "rejects an image over the loader's memory", "SD");
+
+    image_to_sd(&oversized);
+    memset((void *)(uintptr_t)oversized.segments[0].address, FILL, oversized.segments[0].filesz);
+    check(load_elf64(oversized.name, &entry) != 0 && pastOversized[0] == FILL,
+        "rejects a segment with more file data than memory", "SD");
+
+    image_clear(&sdImage);
+    check(load_elf32(sdImage.name, &entry32) != 0 && *(const uint8_t *)(uintptr_t)sdImage.entry == FILL,
+        "turns an ELF64 image away from a 32-bit core before placing it", "SD");
+
+    check(load_elf64("missing.elf", &entry) != 0, "fails a missing image", "SD");
+    boot_zero_finish();
+}
+
+static void check_qspi(void)
+{
+    uint64_t entry;
+
+    check_load(&qspiImage, "QSPI");
+    check_side_by_side(&qspiImage, &sdSecond, "QSPI with SD");
+    check(load_elf64(qspiCut.name, &entry) != 0, "rejects an image reaching past its entry", "QSPI");
+    check(load_elf64("qspifar.elf", &entry) != 0, "rejects an entry reaching past the partition", "QSPI");
+    boot_zero_finish();
+
+    // The keyed entry named like the card image holds another image; the card's must load
+    check_load(&sdSecond, "card image with a cache entry of its name");
+}
+
+static void check_emmc(void)
+{
+    uint64_t entry;
+
+    check_load(&emmcImage, "eMMC");
+    check_side_by_side(&emmcImage, &qspiImage, "eMMC with QSPI");
+    check_side_by_side(&emmcImage, &sdSecond, "eMMC with SD");
+    check(load_elf64("emmcfar.elf", &entry) != 0, "rejects an entry reaching past the partition", "eMMC");
+    boot_zero_finish();
+}
+
+// Runs with the card flagged to fill the cache, so every container that misses is stored
+static void check_cache(void)
+{
+    struct test_image other = packImage;
+    struct test_image fresh = packImage;
+    struct boot_qspi_image entry;
+    uint32_t size;
+    int found;
+
+    // Same layout and size, other contents and root
+    other.name = "mpack.bpk";
+    fresh.name = "npack.bpk";
+    container_to_sd(&packImage);
+    container_to_sd(&other);
+    container_to_sd(&fresh);
+
+    check_load(&packImage, "cache miss");
+    check(media_holds_container(BOOT_QSPI_EMULATE_FILE, &packImage), "stores the missed container in QSPI",
+        "cache miss");
+
+    // With the card's copy damaged, only the cached one loads
+    uint32_t cardBlock = container_block(&packImage, 0);
+    check(flip_byte(packImage.name, cardBlock) == 0, "damages the card's copy", "cache hit");
+    check_load(&packImage, "cache hit");
+    flip_byte(packImage.name, cardBlock);
+
+    // A bad sector under a cold block: the copy is dropped, the card's loads and is stored again
+    media_entry(BOOT_QSPI_EMULATE_FILE, packImage.name, &entry, &found);
+    check(found && flip_byte(BOOT_QSPI_EMULATE_FILE, entry.offset + container_block(&packImage, 1)) == 0,
+        "damages the cached copy", "bad cached copy");
+    check_load(&packImage, "bad cached copy");
+    check(bpk_verify_deferred() == 0, "passes the deferred checks", "bad cached copy");
+    check(media_holds_container(BOOT_QSPI_EMULATE_FILE, &packImage), "replaces the bad copy from the card",
+        "bad cached copy");
+
+    // An entry keyed with another container's root but holding this one is not a hit
+    uint8_t *file = container_build(&other, &size);
+    struct boot_qspi_image mislabelled = { "mpack.bpk", 0, 0, { 0 } };
+    media_entry(BOOT_QSPI_EMULATE_FILE, packImage.name, &entry, &found);
+    mislabelled.offset = entry.offset;
+    mislabelled.size = entry.size;
+    memcpy(mislabelled.key, ((const struct bpk_header *)file)->root, BOOT_QSPI_KEY_SIZE);
+    free(file);
+    media_add_entry(BOOT_QSPI_EMULATE_FILE, &mislabelled);
+    check_load(&other, "mislabelled cache entry");
+    check(bpk_verify_deferred() == 0, "passes the deferred checks", "mislabelled cache entry");
+    check(media_holds_container(BOOT_QSPI_EMULATE_FILE, &other), "stores the card's container in its place",
+        "mislabelled cache entry");
+
+    // A full directory, naming sectors a start-over reuses, is erased and written anew
+    struct boot_qspi_image filler = { "filler", 0, 0x100, { 0 } };
+    filler.offset = entry.offset;
+    while (media_entry(BOOT_QSPI_EMULATE_FILE, filler.name, &entry, &found) < BOOT_QSPI_MAX_IMAGES)
+    {
+        media_add_entry(BOOT_QSPI_EMULATE_FILE, &filler);
+    }
+    check_load(&fresh, "start-over");
+    check(bpk_verify_deferred() == 0, "passes the deferred checks", "start-over");
+    check(media_entry(BOOT_QSPI_EMULATE_FILE, fresh.name, &entry, &found) == 1 &&
+        media_holds_container(BOOT_QSPI_EMULATE_FILE, &fresh), "starts the partition over with the new container",
+        "start-over");
+    boot_zero_finish();
+}
+
+// Runs after the cache checks, which start the QSPI partition over
+static void check_stripe(void)
+{
+    static const uint32_t units[] = { 0x200, 0x1000, 0x4000, 0x10000 };
+    static const uint8_t otherId[BOOT_STRIPE_ID_SIZE] = { 0x5A };
+    struct test_image image = stripeImage;
+    char name[BOOT_QSPI_NAME_SIZE];
+    char what[48];
+    uint32_t offset = STRIPE_QSPI_OFFSET;
+    uint64_t entry;
+
+    // Whole and partial units at both ends of each part, byte-exact
+    for (uint32_t i = 0; i < sizeof(units) / sizeof(units[0]); i++, offset += STRIPE_QSPI_SPACING)
+    {
+        snprintf(name, sizeof(name), "stripe%u.bpk", units[i]);
+        snprintf(what, sizeof(what), "striped over QSPI and SD, %u-byte units", units[i]);
+        image.name = name;
+        stripe_to_media(&image, units[i], offset, NULL, 0);
+        check_load(&image, what);
+        check(bpk_verify_deferred() == 0, "passes the deferred checks", what);
+    }
+
+    image.name = "stripecut.bpk";
+    stripe_to_media(&image, units[2], offset, NULL, 0x100);
+    image_clear(&image);
+    check(load_elf64(image.name, &entry) != 0 && *(const uint8_t *)(uintptr_t)image.entry == FILL,
+        "rejects a truncated part", "striped");
+    offset += STRIPE_QSPI_SPACING;
+
+    image.name = "stripeid.bpk";
+    stripe_to_media(&image, units[2], offset, otherId, 0);
+    check(load_elf64(image.name, &entry) != 0 && *(const uint8_t *)(uintptr_t)image.entry == FILL,
+        "rejects a part of another image", "striped");
+    boot_zero_finish();
+}
+
+int main(void)
+{
+    if (map_target(OCM_ADDR, OCM_SIZE) != 0 || map_target(HANDOFF_ADDR, HANDOFF_SIZE) != 0 ||
+        map_target(DDR_ADDR, DDR_SIZE) != 0)
+    {
+        printf("FAIL: map the target memory\ntest_loader: FAILED\n");
+        return 1;
+    }
+
+    boot_stats_init();
+    boot_trace_init();
+    boot_log_init();
+    if (boot_memmap_init() != 0 || elf_mount() != 0)
+    {
+        printf("FAIL: bring the loader up\ntest_loader: FAILED\n");
+        return 1;
+    }
+
+    // The media and the cache flag are looked up once, on first use
+    check(write_file(BOOT_STORAGE_CACHE_FLAG, (const uint8_t *)"", 0) == 0, "flags the card to fill the cache",
+        BOOT_STORAGE_CACHE_FLAG);
+    static const struct test_image *const qspiImages[] = { &qspiImage, &qspiCut };
+    static const struct test_image *const emmcImages[] = { &emmcImage };
+    image_to_sd(&sdImage);
+    image_to_sd(&sdSecond);
+    images_to_media(BOOT_QSPI_EMULATE_FILE, qspiImages, 2, BOOT_QSPI_ALIGN);
+    images_to_media(BOOT_EMMC_EMULATE_FILE, emmcImages, 1, EMMC_ALIGN);
+
+    // An entry past the end of the partition, and a cache entry (keyed) under a card
+    // image's name that points at another image
+    struct boot_qspi_image far = { "qspifar.elf", BOOT_QSPI_PART_SIZE - 0x1000, 0x2000, { 0 } };
+    struct boot_qspi_image keyed = { "sd2.elf", BOOT_QSPI_ALIGN * 8, 0x10000, { 0 } };
+    memset(keyed.key, 0x5A, sizeof(keyed.key));
+    media_add_entry(BOOT_QSPI_EMULATE_FILE, &far);
+    media_add_entry(BOOT_QSPI_EMULATE_FILE, &keyed);
+
+    // The file stands for the whole eMMC partition; this entry holds emmc.elf but runs
+    // past the end, so only the bounds check turns it away
+    uint32_t emmcFirst = (sizeof(struct boot_qspi_directory) + EMMC_ALIGN - 1) & ~(EMMC_ALIGN - 1);
+    struct boot_qspi_image emmcFar = { "emmcfar.elf", emmcFirst, 0x40000, { 0 } };
+    media_add_entry(BOOT_EMMC_EMULATE_FILE, &emmcFar);
+
+    check_sd();
+    check_qspi();
+    check_emmc();
+    check_cache();
+    check_stripe();
+
+    printf("%s\n", failures ? "test_loader: FAILED" : "test_loader: passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,178 @@
+/*
+ * Description: Host test of ECDSA P-256 verification (../p256.h). Checks a signature over
+ * a SHA3-384 boot pack root, truncated to 256 bits as the loader uses it, and one over a
+ * SHA-256 hash, both made with OpenSSL, then checks that a changed hash or signature, a
+ * zero r, an s of n and a key off the curve are rejected. Finally times the comb table
+ * build and the verification for this host.
+ *
+ * Build: make -C tests, or gcc -O2 -I.. -o test_p256 test_p256.c ../p256.c
+ */
+
+// Standard Libraries
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+// Addtional Libraries
+#include "p256.h"
+
+#define MAX_HASH_SIZE 48
+#define TIMING_ROUNDS 200
+
+// Public half of the key both signatures were made with
+static const char *publicKeyHex =
+    "eda0a4281c0026ed0d0d06a1f51c5e05541ba1ee69b830dc3fe632ad83174e10"
+    "e572a3ff5796307274111a92c32b7760c2f7ff99c3727d5fc146418666b3864b";
+
+// Group order n
+static const char *orderHex = "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632551";
+
+struct p256_vector
+{
+    const char *name;
+    const char *hash;
+    const char *signature;
+};
+
+static const struct p256_vector p256Vectors[] =
+{
+    {
+        "SHA3-384 root",
+        "692f169169d67f5d3c723878c5bed162af37c6921a33a9b35490a7d70be56397"
+        "a40ad3263224ff09cce5772d57d89326",
+        "de9e8f9f1b1a6f55969e7830cfba6d5616d47ca3ee3a85a7c9162f969f9c0aa7"
+        "6ee331bc8a47a51f2b0dc46e8ef181864c470a69e8815c77beefe0d7de053296",
+    },
+    {
+        "SHA-256 hash",
+        "dc4f1c4ecee0a823da91bc9e648d6110b17ac9d2f0460ac565939155802e0881",
+        "4c2679dfb0258fb3900d2d52ebc64d0a0ce210ea7087080bb66edb353ea644e0"
+        "ef7e953a660b460d58e150a151ffd79aa6abf8cf5402f147d4f9f936b347f2b0",
+    },
+};
+
+static struct p256_comb key;
+static int failures;
+
+static void check(int condition, const char *what, const char *name)
+{
+    printf("%s: %s, %s\n", condition ? "ok  " : "FAIL", what, name);
+    if (!condition)
+    {
+        failures++;
+    }
+}
+
+static uint32_t from_hex(const char *hex, uint8_t *out)
+{
+    uint32_t size = (uint32_t)strlen(hex) / 2;
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        sscanf(hex + 2 * i, "%2hhx", &out[i]);
+    }
+
+    return size;
+}
+
+static void check_vector(const struct p256_vector *vector)
+{
+    uint8_t hash[MAX_HASH_SIZE], signature[P256_SIGNATURE_SIZE], changed[P256_SIGNATURE_SIZE];
+    uint32_t hashSize = from_hex(vector->hash, hash);
+
+    from_hex(vector->signature, signature);
+    check(p256_verify(&key, hash, hashSize, signature) == 0, "accepts the signature", vector->name);
+
+    hash[0] ^= 0x01;
+    check(p256_verify(&key, hash, hashSize, signature) != 0, "rejects a changed hash", vector->name);
+    hash[0] ^= 0x01;
+
+    // Past the 256 bits the loader signs, a SHA3-384 root may change freely
+    if (hashSize > P256_SCALAR_SIZE)
+    {
+        hash[hashSize - 1] ^= 0x01;
+        check(p256_verify(&key, hash, hashSize, signature) == 0, "ignores the bytes past 256 bits", vector->name);
+        hash[hashSize - 1] ^= 0x01;
+    }
+
+    memcpy(changed, signature, sizeof(changed));
+    changed[P256_SCALAR_SIZE - 1] ^= 0x01;
+    check(p256_verify(&key, hash, hashSize, changed) != 0, "rejects a changed r", vector->name);
+
+    memcpy(changed, signature, sizeof(changed));
+    changed[P256_SIGNATURE_SIZE - 1] ^= 0x01;
+    check(p256_verify(&key, hash, hashSize, changed) != 0, "rejects a changed s", vector->name);
+
+    memset(changed, 0, P256_SCALAR_SIZE);
+    memcpy(changed + P256_SCALAR_SIZE, signature + P256_SCALAR_SIZE, P256_SCALAR_SIZE);
+    check(p256_verify(&key, hash, hashSize, changed) != 0, "rejects a zero r", vector->name);
+
+    memcpy(changed, signature, P256_SCALAR_SIZE);
+    from_hex(orderHex, changed + P256_SCALAR_SIZE);
+    check(p256_verify(&key, hash, hashSize, changed) != 0, "rejects an s of n", vector->name);
+}
+
+static void check_key(void)
+{
+    static struct p256_comb offCurve;
+    uint8_t publicKey[P256_PUBLIC_KEY_SIZE];
+
+    from_hex(publicKeyHex, publicKey);
+    check(p256_comb_build(&key, publicKey) == 0, "builds the comb table", "public key");
+
+    publicKey[P256_PUBLIC_KEY_SIZE - 1] ^= 0x01;
+    check(p256_comb_build(&offCurve, publicKey) != 0, "rejects a point off the curve", "public key");
+}
+
+static double seconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// Verification works on public data only, so a rejected signature costs about the same
+static void time_verify(void)
+{
+    static struct p256_comb comb;
+    const struct p256_vector *vector = &p256Vectors[0];
+    uint8_t publicKey[P256_PUBLIC_KEY_SIZE], hash[MAX_HASH_SIZE], signature[P256_SIGNATURE_SIZE];
+    uint32_t hashSize = from_hex(vector->hash, hash);
+    int32_t status = 0;
+
+    from_hex(publicKeyHex, publicKey);
+    from_hex(vector->signature, signature);
+
+    double start = seconds();
+    for (uint32_t i = 0; i < TIMING_ROUNDS; i++)
+    {
+        status |= p256_comb_build(&comb, publicKey);
+    }
+    double build = (seconds() - start) / TIMING_ROUNDS;
+
+    start = seconds();
+    for (uint32_t i = 0; i < TIMING_ROUNDS; i++)
+    {
+        status |= p256_verify(&comb, hash, hashSize, signature);
+    }
+    double verify = (seconds() - start) / TIMING_ROUNDS;
+
+    check(status == 0, "every timed round succeeds", "timing");
+    printf("time: comb table built in %.0f us (host tool only), signature verified in %.0f us\n", build * 1e6,
+        verify * 1e6);
+}
+
+int main(void)
+{
+    check_key();
+    for (uint32_t i = 0; i < sizeof(p256Vectors) / sizeof(p256Vectors[0]); i++)
+    {
+        check_vector(&p256Vectors[i]);
+    }
+    time_verify();
+
+    printf("%s\n", failures ? "test_p256: FAILED" : "test_p256: passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,1229 @@
+/*
+ * Description: Host packer for boot pack containers (.bpk). Reads an ELF32 or ELF64
+ * image, splits every PT_LOAD segment into independently compressed blocks and writes
+ * the container described in ../bootpack_format.h. Blocks that do not shrink are
+ * stored raw so the loader can read them straight into place. Blocks that repeat a
+ * single 32-bit pattern (zero pages in particular) become fill holes that are not
+ * stored at all, and trailing zeros are trimmed from each segment's filesz.
+ *
+ * With -c auto (the default) every segment is packed with each codec and the one with
+ * the lowest estimated load time is kept. The estimate uses the SD read rate and the
+ * per-core decode rates printed by the loader after each boot pack, and assumes reads
+ * overlap decoding when more than one core decodes. zstd blocks can share a dictionary,
+ * either given with -d or trained from the image with -T; copy it to the boot medium
+ * as boot.dic.
+ *
+ * Every container carries the hash tree described in ../bootpack_hash.h. Segments
+ * given with -C (repeatable) are marked cold, so the loader verifies them only when
+ * bpk_verify_deferred() runs. -V checks an existing container against its tree and
+ * lists any block that does not match.
+ *
+ * With -k the stored blocks are encrypted with AES-256-GCM under the 32-byte key in
+ * the given file, using a fresh random base IV per container. The same key has to be
+ * built into the loader (BPK_IMAGE_KEY in ../bootpack.h), and -V needs it too.
+ *
+ * With -S the hash tree root is signed with the ECDSA P-256 private key in the given PEM
+ * file. -K writes the comb table for that key's public half as a C source file to link
+ * into loaders built with BPK_REQUIRE_SIGNATURE; -V -S checks the signature against it.
+ *
+ * With -p the container is striped across two boot media (../boot_stripe.h): the output
+ * becomes the part holding units 0, 2, 4, ... and the file given with -p the part
+ * holding the others, -u bytes each. Put both under the container's name, on two media
+ * the loader reads from (SD card, eMMC, QSPI), and build it with BOOT_STORAGE_STRIPE.
+ * Units span a quarter of a default block, so most block reads keep both media busy.
+ *
+ * Build: gcc -O2 -I.. -o bootpack bootpack.c ../sha3.c ../bootpack_hash.c ../p256.c -llz4 -lzstd -lcrypto
+ * Usage: bootpack [-b block_size] [-c raw|lz4|zstd|auto] [-d dict | -T dict_out] [-C segment]
+ *                 [-k key] [-S signing_key.pem] [-s sd_MBps] [-l lz4_MBps] [-z zstd_MBps] [-j cores]
+ *                 [-p second_part.bpk [-u unit]] input.elf output.bpk
+ *        bootpack -V [-d dict] [-k key] [-S signing_key.pem] container.bpk
+ *        bootpack -S signing_key.pem -K boot_key.c
+ */
+
+// Standard Libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <elf.h>
+
+// Compression Libraries
+#include <lz4.h>
+#include <lz4hc.h>
+#include <zstd.h>
+#include <zdict.h>
+
+// Crypto Libraries
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/pem.h>
+#include <openssl/ec.h>
+#include <openssl/core_names.h>
+
+// Addtional Libraries
+#include "bootpack_format.h"
+#include "bootpack_hash.h"
+#include "boot_stripe.h"
+#include "p256.h"
+
+// Definitions
+#define DEFAULT_BLOCK_SIZE 0x10000
+#define MAX_SEGMENTS 32
+#define CODEC_AUTO 0xFF
+#define ZSTD_LEVEL 19
+#define ZSTD_MIN_WINDOW_LOG 10
+#define ZSTD_MAX_WINDOW_LOG 27
+#define DICT_CAPACITY 0x8000        // Must not exceed BPK_DICT_MAX_SIZE in ../bootpack.h
+#define KEY_SIZE 32
+#define DEFAULT_STRIPE_UNIT 0x4000
+
+// Default cost model, measured on a ZCU102 booting from SD
+#define DEFAULT_SD_RATE 20.0
+#define DEFAULT_LZ4_RATE 400.0
+#define DEFAULT_ZSTD_RATE 120.0
+#define DEFAULT_CORES 4
+
+struct segment
+{
+    uint64_t dest;
+    uint64_t filesz;
+    uint64_t memsz;
+    const uint8_t *data;
+};
+
+struct block
+{
+    uint8_t *data;
+    uint32_t stored;
+    uint32_t codec;
+    uint32_t fill;
+};
+
+struct cost_model
+{
+    double sdRate;                  // MB/s read from the boot medium
+    double decodeRate[BPK_CODEC_FILL];  // MB/s decoded by one core, indexed by codec
+    uint32_t cores;
+};
+
+static ZSTD_CCtx *zstdContext;
+
+static uint8_t *read_file(const char *path, size_t *size)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        perror(path);
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long length = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    uint8_t *data = malloc(length > 0 ? length : 1);
+    if (data == NULL || fread(data, 1, length, fp) != (size_t)length)
+    {
+        fprintf(stderr, "Failed to read %s\n", path);
+        free(data);
+        fclose(fp);
+        return NULL;
+    }
+
+    fclose(fp);
+    *size = length;
+    return data;
+}
+
+// Collects the PT_LOAD segments of an ELF32 or ELF64 image
+static int parse_elf(const uint8_t *image, size_t size, struct segment *segments, uint32_t *count, uint64_t *entry)
+{
+    if (size < EI_NIDENT || memcmp(image, ELFMAG, SELFMAG) != 0)
+    {
+        fprintf(stderr, "Input is not an ELF file\n");
+        return -1;
+    }
+
+    *count = 0;
+    if (image[EI_CLASS] == ELFCLASS32)
+    {
+        const Elf32_Ehdr *ehdr = (const Elf32_Ehdr *)image;
+        *entry = ehdr->e_entry;
+
+        for (int i = 0; i < ehdr->e_phnum; i++)
+        {
+            const Elf32_Phdr *phdr = (const Elf32_Phdr *)(image + ehdr->e_phoff + i * ehdr->e_phentsize);
+            if (phdr->p_type != PT_LOAD || phdr->p_memsz == 0)
+            {
+                continue;
+            }
+            if (phdr->p_offset + (uint64_t)phdr->p_filesz > size || *count == MAX_SEGMENTS)
+            {
+                fprintf(stderr, "Invalid program header %d\n", i);
+                return -1;
+            }
+            segments[*count].dest = phdr->p_vaddr;
+            segments[*count].filesz = phdr->p_filesz;
+            segments[*count].memsz = phdr->p_memsz;
+            segments[*count].data = image + phdr->p_offset;
+            (*count)++;
+        }
+    }
+    else if (image[EI_CLASS] == ELFCLASS64)
+    {
+        const Elf64_Ehdr *ehdr = (const Elf64_Ehdr *)image;
+        *entry = ehdr->e_entry;
+
+        for (int i = 0; i < ehdr->e_phnum; i++)
+        {
+            const Elf64_Phdr *phdr = (const Elf64_Phdr *)(image + ehdr->e_phoff + i * ehdr->e_phentsize);
+            if (phdr->p_type != PT_LOAD || phdr->p_memsz == 0)
+            {
+                continue;
+            }
+            if (phdr->p_offset + phdr->p_filesz > size || *count == MAX_SEGMENTS)
+            {
+                fprintf(stderr, "Invalid program header %d\n", i);
+                return -1;
+            }
+            segments[*count].dest = phdr->p_vaddr;
+            segments[*count].filesz = phdr->p_filesz;
+            segments[*count].memsz = phdr->p_memsz;
+            segments[*count].data = image + phdr->p_offset;
+            (*count)++;
+        }
+    }
+    else
+    {
+        fprintf(stderr, "Unsupported ELF class %u\n", image[EI_CLASS]);
+        return -1;
+    }
+
+    return 0;
+}
+
+// Returns 1 if the block is one 32-bit pattern repeated, storing the pattern in fill
+static int is_fill(const uint8_t *data, uint32_t length, uint32_t *fill)
+{
+    uint8_t pattern[4] = { 0, 0, 0, 0 };
+
+    memcpy(pattern, data, (length < 4) ? length : 4);
+    for (uint32_t i = 4; i < length; i++)
+    {
+        if (data[i] != pattern[i & 3])
+        {
+            return 0;
+        }
+    }
+
+    *fill = pattern[0] | (pattern[1] << 8) | (pattern[2] << 16) | ((uint32_t)pattern[3] << 24);
+    return 1;
+}
+
+// Compresses one block, falling back to raw storage when compression does not help
+static int pack_block(const uint8_t *data, uint32_t length, uint32_t codec, struct block *block)
+{
+    block->codec = BPK_CODEC_RAW;
+    block->stored = length;
+    block->fill = 0;
+
+    if (is_fill(data, length, &block->fill))
+    {
+        block->codec = BPK_CODEC_FILL;
+        block->stored = 0;
+        block->data = NULL;
+        return 0;
+    }
+
+    if (codec == BPK_CODEC_LZ4 || codec == BPK_CODEC_ZSTD)
+    {
+        size_t bound = (codec == BPK_CODEC_LZ4) ? (size_t)LZ4_compressBound(length) : ZSTD_compressBound(length);
+        uint8_t *compressed = malloc(bound);
+        if (compressed == NULL)
+        {
+            return -1;
+        }
+
+        size_t stored = 0;
+        if (codec == BPK_CODEC_LZ4)
+        {
+            int result = LZ4_compress_HC((const char *)data, (char *)compressed, length, bound, LZ4HC_CLEVEL_MAX);
+            stored = (result > 0) ? (size_t)result : 0;
+        }
+        else
+        {
+            stored = ZSTD_compress2(zstdContext, compressed, bound, data, length);
+            if (ZSTD_isError(stored))
+            {
+                stored = 0;
+            }
+        }
+
+        if (stored > 0 && stored < length)
+        {
+            block->data = compressed;
+            block->stored = stored;
+            block->codec = codec;
+            return 0;
+        }
+        free(compressed);
+    }
+
+    block->data = malloc(length ? length : 1);
+    if (block->data == NULL)
+    {
+        return -1;
+    }
+    memcpy(block->data, data, length);
+    return 0;
+}
+
+// Packs every block of a segment with one codec; returns the estimated load time in seconds
+static double pack_segment(const struct segment *segment, uint32_t blockSize, uint32_t codec,
+    const struct cost_model *model, struct block *blocks)
+{
+    double readBytes = 0;
+    double decodeSeconds = 0;
+    uint32_t index = 0;
+
+    for (uint64_t start = 0; start < segment->filesz; start += blockSize, index++)
+    {
+        uint32_t length = (segment->filesz - start < blockSize) ? segment->filesz - start : blockSize;
+
+        if (pack_block(segment->data + start, length, codec, &blocks[index]) != 0)
+        {
+            return -1;
+        }
+
+        readBytes += blocks[index].stored;
+        if (blocks[index].codec == BPK_CODEC_LZ4 || blocks[index].codec == BPK_CODEC_ZSTD)
+        {
+            decodeSeconds += length / (model->decodeRate[blocks[index].codec] * 1e6);
+        }
+    }
+
+    // Reads overlap decoding once other cores help, otherwise they add up
+    double readSeconds = readBytes / (model->sdRate * 1e6);
+    if (model->cores > 1)
+    {
+        decodeSeconds /= model->cores;
+        return (readSeconds > decodeSeconds) ? readSeconds : decodeSeconds;
+    }
+
+    return readSeconds + decodeSeconds;
+}
+
+static void free_blocks(struct block *blocks, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        free(blocks[i].data);
+        blocks[i].data = NULL;
+    }
+}
+
+// Trains a zstd dictionary on the blocks of every segment and writes it to path; exits if
+// either fails, so a build never goes on without the dictionary it asked for
+static size_t train_dict(const struct segment *segments, uint32_t numSegments, uint32_t blockSize,
+    uint8_t *dict, const char *path)
+{
+    uint32_t numSamples = 0;
+    uint64_t total = 0;
+
+    for (uint32_t i = 0; i < numSegments; i++)
+    {
+        numSamples += (segments[i].filesz + blockSize - 1) / blockSize;
+        total += segments[i].filesz;
+    }
+
+    uint8_t *samples = malloc(total ? total : 1);
+    size_t *sampleSizes = calloc(numSamples ? numSamples : 1, sizeof(size_t));
+    if (samples == NULL || sampleSizes == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+
+    uint64_t offset = 0;
+    uint32_t index = 0;
+    for (uint32_t i = 0; i < numSegments; i++)
+    {
+        memcpy(samples + offset, segments[i].data, segments[i].filesz);
+        offset += segments[i].filesz;
+        for (uint64_t start = 0; start < segments[i].filesz; start += blockSize)
+        {
+            sampleSizes[index++] = (segments[i].filesz - start < blockSize) ? segments[i].filesz - start : blockSize;
+        }
+    }
+
+    size_t dictSize = ZDICT_trainFromBuffer(dict, DICT_CAPACITY, samples, sampleSizes, numSamples);
+    free(sampleSizes);
+    free(samples);
+    if (ZDICT_isError(dictSize))
+    {
+        fprintf(stderr, "Dictionary training failed: %s\n", ZDICT_getErrorName(dictSize));
+        exit(1);
+    }
+
+    FILE *out = fopen(path, "wb");
+    if (out == NULL || fwrite(dict, 1, dictSize, out) != dictSize || fclose(out) != 0)
+    {
+        perror(path);
+        exit(1);
+    }
+
+    return dictSize;
+}
+
+// Per-block IV: the base IV with the block number XORed big-endian into its last four bytes
+static void block_iv(const uint8_t *base, uint32_t index, uint8_t *iv)
+{
+    memcpy(iv, base, BPK_IV_SIZE);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        iv[BPK_IV_SIZE - 1 - i] ^= (uint8_t)(index >> (8 * i));
+    }
+}
+
+// Replaces a block's stored data with its ciphertext followed by the GCM tag
+static int encrypt_block(const uint8_t *key, const uint8_t *baseIv, uint32_t index, struct block *block)
+{
+    uint8_t iv[BPK_IV_SIZE];
+    uint8_t *sealed = malloc(block->stored + BPK_TAG_SIZE);
+    EVP_CIPHER_CTX *cipher = EVP_CIPHER_CTX_new();
+    int length;
+    int ok;
+
+    block_iv(baseIv, index, iv);
+    ok = sealed != NULL && cipher != NULL &&
+        EVP_EncryptInit_ex(cipher, EVP_aes_256_gcm(), NULL, key, iv) == 1 &&
+        EVP_EncryptUpdate(cipher, sealed, &length, block->data, block->stored) == 1 &&
+        EVP_EncryptFinal_ex(cipher, sealed + length, &length) == 1 &&
+        EVP_CIPHER_CTX_ctrl(cipher, EVP_CTRL_GCM_GET_TAG, BPK_TAG_SIZE, sealed + block->stored) == 1;
+    EVP_CIPHER_CTX_free(cipher);
+
+    if (!ok)
+    {
+        free(sealed);
+        return -1;
+    }
+
+    free(block->data);
+    block->data = sealed;
+    block->stored += BPK_TAG_SIZE;
+    return 0;
+}
+
+// Authenticates and decrypts stored block data into plain; returns the plaintext size or -1
+static long decrypt_block(const uint8_t *key, const uint8_t *baseIv, uint32_t index,
+    const uint8_t *stored, uint32_t size, uint8_t *plain)
+{
+    uint8_t iv[BPK_IV_SIZE];
+    EVP_CIPHER_CTX *cipher;
+    int length;
+    int ok;
+
+    if (size < BPK_TAG_SIZE || (cipher = EVP_CIPHER_CTX_new()) == NULL)
+    {
+        return -1;
+    }
+
+    block_iv(baseIv, index, iv);
+    size -= BPK_TAG_SIZE;
+    ok = EVP_DecryptInit_ex(cipher, EVP_aes_256_gcm(), NULL, key, iv) == 1 &&
+        EVP_DecryptUpdate(cipher, plain, &length, stored, size) == 1 &&
+        EVP_CIPHER_CTX_ctrl(cipher, EVP_CTRL_GCM_SET_TAG, BPK_TAG_SIZE, (void *)(stored + size)) == 1 &&
+        EVP_DecryptFinal_ex(cipher, plain + length, &length) == 1;
+    EVP_CIPHER_CTX_free(cipher);
+
+    return ok ? (long)size : -1;
+}
+
+// Reads a raw AES-256 key file
+static int read_key(const char *path, uint8_t *key)
+{
+    size_t size;
+    uint8_t *data = read_file(path, &size);
+
+    if (data == NULL)
+    {
+        return -1;
+    }
+    if (size != KEY_SIZE)
+    {
+        fprintf(stderr, "%s: expected a %u-byte AES-256 key\n", path, KEY_SIZE);
+        free(data);
+        return -1;
+    }
+
+    memcpy(key, data, KEY_SIZE);
+    free(data);
+    return 0;
+}
+
+// Reads a P-256 key from a PEM file, private or public, and returns its public point
+static EVP_PKEY *read_signing_key(const char *path, uint8_t *publicKey)
+{
+    FILE *in = fopen(path, "r");
+    EVP_PKEY *key;
+    uint8_t point[1 + P256_PUBLIC_KEY_SIZE];
+    char group[32];
+    size_t length;
+
+    if (in == NULL)
+    {
+        perror(path);
+        return NULL;
+    }
+    key = PEM_read_PrivateKey(in, NULL, NULL, NULL);
+    if (key == NULL)
+    {
+        rewind(in);
+        key = PEM_read_PUBKEY(in, NULL, NULL, NULL);
+    }
+    fclose(in);
+
+    // Uncompressed point: 0x04 || x || y
+    if (key == NULL ||
+        EVP_PKEY_get_utf8_string_param(key, OSSL_PKEY_PARAM_GROUP_NAME, group, sizeof(group), NULL) != 1 ||
+        strcmp(group, "prime256v1") != 0 ||
+        EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PUB_KEY, point, sizeof(point), &length) != 1 ||
+        length != sizeof(point) || point[0] != 0x04)
+    {
+        fprintf(stderr, "%s: not an ECDSA P-256 key\n", path);
+        EVP_PKEY_free(key);
+        return NULL;
+    }
+
+    memcpy(publicKey, point + 1, P256_PUBLIC_KEY_SIZE);
+    return key;
+}
+
+// Signs the hash tree root; the signature is r || s, big-endian
+static int sign_root(EVP_PKEY *key, const uint8_t *root, uint8_t *signature)
+{
+    EVP_PKEY_CTX *context = EVP_PKEY_CTX_new(key, NULL);
+    uint8_t der[80];
+    size_t derSize = sizeof(der);
+    const uint8_t *cursor = der;
+    ECDSA_SIG *parsed = NULL;
+    int ok;
+
+    ok = context != NULL && EVP_PKEY_sign_init(context) == 1 &&
+        EVP_PKEY_sign(context, der, &derSize, root, BPK_HASH_SIZE) == 1 &&
+        (parsed = d2i_ECDSA_SIG(NULL, &cursor, derSize)) != NULL &&
+        BN_bn2binpad(ECDSA_SIG_get0_r(parsed), signature, P256_SCALAR_SIZE) == P256_SCALAR_SIZE &&
+        BN_bn2binpad(ECDSA_SIG_get0_s(parsed), signature + P256_SCALAR_SIZE, P256_SCALAR_SIZE) == P256_SCALAR_SIZE;
+
+    ECDSA_SIG_free(parsed);
+    EVP_PKEY_CTX_free(context);
+    return ok ? 0 : -1;
+}
+
+// Writes the public key comb table as C source for the loader
+static int write_key_source(const uint8_t *publicKey, const char *keyPath, const char *path)
+{
+    static struct p256_comb comb;
+    FILE *out;
+
+    if (p256_comb_build(&comb, publicKey) != 0)
+    {
+        fprintf(stderr, "%s: public key is not on the curve\n", keyPath);
+        return 1;
+    }
+
+    out = fopen(path, "w");
+    if (out == NULL)
+    {
+        perror(path);
+        return 1;
+    }
+
+    fprintf(out, "/*\n * Description: Boot pack signing key comb table, generated by tools/bootpack.c -K\n"
+        " * from %s. Regenerate rather than edit.\n */\n\n#include \"p256.h\"\n\n"
+        "const struct p256_comb bpkSigningKey =\n{\n    {\n", keyPath);
+    for (uint32_t i = 0; i < P256_COMB_ENTRIES; i++)
+    {
+        const uint32_t *coordinates[2] = { comb.points[i].x, comb.points[i].y };
+
+        fprintf(out, "        {\n");
+        for (uint32_t c = 0; c < 2; c++)
+        {
+            fprintf(out, "            { ");
+            for (uint32_t k = 0; k < 8; k++)
+            {
+                fprintf(out, "0x%08X%s", coordinates[c][k], (k < 7) ? ", " : " }");
+            }
+            fprintf(out, "%s\n", (c == 0) ? "," : "");
+        }
+        fprintf(out, "        }%s\n", (i < P256_COMB_ENTRIES - 1) ? "," : "");
+    }
+    fprintf(out, "    }\n};\n");
+
+    if (fclose(out) != 0)
+    {
+        perror(path);
+        return 1;
+    }
+
+    printf("%s: comb table for %s\n", path, keyPath);
+    return 0;
+}
+
+// Decodes every block of a container and checks it against the hash tree
+static int verify_container(const char *path, const uint8_t *dict, size_t dictSize, const uint8_t *key,
+    const uint8_t *publicKey)
+{
+    size_t size;
+    uint8_t *file = read_file(path, &size);
+    if (file == NULL)
+    {
+        return 1;
+    }
+
+    const struct bpk_header *header = (const struct bpk_header *)file;
+    if (size < sizeof(*header) || memcmp(header->magic, "BPK1", 4) != 0 || header->version != BPK_VERSION ||
+        header->header_size < sizeof(*header) || header->header_size > size || header->hash_offset == 0 ||
+        header->segment_offset + (uint64_t)header->num_segments * sizeof(struct bpk_segment) > size ||
+        header->block_offset + (uint64_t)header->num_blocks * sizeof(struct bpk_block) > size ||
+        header->hash_offset + (uint64_t)header->num_blocks * BPK_HASH_SIZE > size)
+    {
+        fprintf(stderr, "%s: not a hashed version %u boot pack\n", path, BPK_VERSION);
+        return 1;
+    }
+    if (header->cipher != BPK_CIPHER_NONE && (header->cipher != BPK_CIPHER_AES256_GCM || key == NULL))
+    {
+        fprintf(stderr, "%s: encrypted with cipher %u, needs a key (-k)\n", path, header->cipher);
+        return 1;
+    }
+
+    const struct bpk_segment *segments = (const struct bpk_segment *)(file + header->segment_offset);
+    const struct bpk_block *blocks = (const struct bpk_block *)(file + header->block_offset);
+    const uint8_t *leaves = file + header->hash_offset;
+    int failures = 0;
+
+    // The leaf table and metadata must reduce to the root
+    uint8_t *nodes = malloc((header->num_blocks + 1) * BPK_HASH_SIZE);
+    uint8_t root[BPK_HASH_SIZE];
+    memcpy(nodes, leaves, header->num_blocks * BPK_HASH_SIZE);
+    bpk_hash_manifest(header, segments, blocks, nodes + header->num_blocks * BPK_HASH_SIZE);
+    bpk_hash_root(nodes, header->num_blocks + 1, root);
+    free(nodes);
+    if (memcmp(root, header->root, BPK_HASH_SIZE) != 0)
+    {
+        printf("%s: hash tree or metadata does not match the root\n", path);
+        failures++;
+    }
+
+    // Checked with the loader's verifier rather than OpenSSL
+    static struct p256_comb signer;
+    if (publicKey != NULL && (p256_comb_build(&signer, publicKey) != 0 ||
+        p256_verify(&signer, header->root, BPK_HASH_SIZE, header->signature) != 0))
+    {
+        printf("%s: signature is missing or does not match the key\n", path);
+        failures++;
+    }
+
+    ZSTD_DDict *zstdDict = (dict != NULL) ? ZSTD_createDDict(dict, dictSize) : NULL;
+    ZSTD_DCtx *zstdDecoder = ZSTD_createDCtx();
+    uint8_t *buffer = malloc(header->block_size);
+    uint8_t *plain = malloc(header->max_stored ? header->max_stored : 1);
+
+    for (uint32_t i = 0; i < header->num_segments; i++)
+    {
+        for (uint32_t j = 0; j < segments[i].num_blocks; j++)
+        {
+            uint32_t index = segments[i].first_block + j;
+            const struct bpk_block *block = &blocks[index];
+            uint64_t start = (uint64_t)j * header->block_size;
+            uint32_t length = (segments[i].filesz - start < header->block_size) ? segments[i].filesz - start : header->block_size;
+            const uint8_t *stored = file + block->offset;
+            uint32_t storedSize = block->stored;
+            int usable = index < header->num_blocks && block->offset + (uint64_t)block->stored <= size;
+            long decoded = -1;
+
+            // Encrypted blocks are authenticated and decrypted before decoding
+            if (usable && header->cipher != BPK_CIPHER_NONE && block->codec != BPK_CODEC_FILL)
+            {
+                long plainSize = (block->stored <= header->max_stored) ?
+                    decrypt_block(key, header->iv, index, stored, block->stored, plain) : -1;
+                if (plainSize < 0)
+                {
+                    printf("%s: block %u failed authentication\n", path, index);
+                    usable = 0;
+                }
+                stored = plain;
+                storedSize = (uint32_t)plainSize;
+            }
+
+            if (!usable)
+            {
+                decoded = -1;
+            }
+            else if (block->codec == BPK_CODEC_RAW && storedSize == length)
+            {
+                memcpy(buffer, stored, length);
+                decoded = length;
+            }
+            else if (block->codec == BPK_CODEC_LZ4)
+            {
+                decoded = LZ4_decompress_safe((const char *)stored, (char *)buffer, storedSize, length);
+            }
+            else if (block->codec == BPK_CODEC_ZSTD)
+            {
+                size_t result = (zstdDict != NULL) ?
+                    ZSTD_decompress_usingDDict(zstdDecoder, buffer, length, stored, storedSize, zstdDict) :
+                    ZSTD_decompressDCtx(zstdDecoder, buffer, length, stored, storedSize);
+                decoded = ZSTD_isError(result) ? -1 : (long)result;
+            }
+            else if (block->codec == BPK_CODEC_FILL)
+            {
+                for (uint32_t k = 0; k < length; k++)
+                {
+                    buffer[k] = (uint8_t)(block->fill >> (8 * (k & 3)));
+                }
+                decoded = length;
+            }
+
+            uint8_t digest[BPK_HASH_SIZE];
+            if (decoded == (long)length)
+            {
+                bpk_hash_leaf(index, buffer, length, digest);
+            }
+            if (decoded != (long)length || memcmp(digest, leaves + index * BPK_HASH_SIZE, BPK_HASH_SIZE) != 0)
+            {
+                printf("%s: block %u (segment %u, offset 0x%x) failed verification\n", path, index, i, block->offset);
+                failures++;
+            }
+        }
+    }
+
+    printf("%s: %u block(s), %d failure(s)\n", path, header->num_blocks, failures);
+
+    free(plain);
+    free(buffer);
+    ZSTD_freeDCtx(zstdDecoder);
+    ZSTD_freeDDict(zstdDict);
+    free(file);
+    return failures ? 1 : 0;
+}
+
+// Splits the container just written into the two parts of a striped image, the first
+// in its place
+static int write_parts(const char *path, const char *secondPath, uint32_t unit, const uint8_t *root)
+{
+    static const uint8_t padding[BOOT_STRIPE_HEADER_SIZE];
+    const char *paths[BOOT_STRIPE_PARTS] = { path, secondPath };
+    size_t size;
+    uint8_t *container = read_file(path, &size);
+
+    if (container == NULL)
+    {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < BOOT_STRIPE_PARTS; i++)
+    {
+        struct boot_stripe_header header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, BOOT_STRIPE_MAGIC, 4);
+        header.version = BOOT_STRIPE_VERSION;
+        header.index = i;
+        header.count = BOOT_STRIPE_PARTS;
+        header.unit = unit;
+        header.size = size;
+        memcpy(header.id, root, BOOT_STRIPE_ID_SIZE);
+
+        FILE *out = fopen(paths[i], "wb");
+        if (out == NULL)
+        {
+            perror(paths[i]);
+            free(container);
+            return -1;
+        }
+
+        fwrite(&header, sizeof(header), 1, out);
+        fwrite(padding, 1, BOOT_STRIPE_HEADER_SIZE - sizeof(header), out);
+        for (size_t start = (size_t)i * unit; start < size; start += (size_t)BOOT_STRIPE_PARTS * unit)
+        {
+            fwrite(container + start, 1, (size - start < unit) ? size - start : unit, out);
+        }
+
+        if (fclose(out) != 0)
+        {
+            perror(paths[i]);
+            free(container);
+            return -1;
+        }
+    }
+
+    free(container);
+    return 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: bootpack [-b block_size] [-c raw|lz4|zstd|auto] [-d dict | -T dict_out] [-C segment]\n"
+        "                [-k key] [-S signing_key.pem] [-s sd_MBps] [-l lz4_MBps] [-z zstd_MBps] [-j cores]\n"
+        "                [-p second_part.bpk [-u unit]] input.elf output.bpk\n"
+        "       bootpack -V [-d dict] [-k key] [-S signing_key.pem] container.bpk\n"
+        "       bootpack -S signing_key.pem -K boot_key.c\n");
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t blockSize = DEFAULT_BLOCK_SIZE;
+    uint32_t codec = CODEC_AUTO;
+    const char *dictPath = NULL;
+    const char *trainPath = NULL;
+    const char *keyPath = NULL;
+    uint8_t key[KEY_SIZE];
+    const char *signingKeyPath = NULL;
+    const char *keySourcePath = NULL;
+    EVP_PKEY *signingKey = NULL;
+    uint8_t publicKey[P256_PUBLIC_KEY_SIZE];
+    uint32_t coldSegments = 0;
+    const char *secondPartPath = NULL;
+    uint32_t stripeUnit = DEFAULT_STRIPE_UNIT;
+    int verify = 0;
+    struct cost_model model = { DEFAULT_SD_RATE, { 0, DEFAULT_LZ4_RATE, DEFAULT_ZSTD_RATE }, DEFAULT_CORES };
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:c:d:T:C:k:S:K:Vs:l:z:j:p:u:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'b':
+                blockSize = strtoul(optarg, NULL, 0);
+                break;
+            case 'c':
+                if (strcmp(optarg, "raw") == 0)
+                {
+                    codec = BPK_CODEC_RAW;
+                }
+                else if (strcmp(optarg, "lz4") == 0)
+                {
+                    codec = BPK_CODEC_LZ4;
+                }
+                else if (strcmp(optarg, "zstd") == 0)
+                {
+                    codec = BPK_CODEC_ZSTD;
+                }
+                else if (strcmp(optarg, "auto") == 0)
+                {
+                    codec = CODEC_AUTO;
+                }
+                else
+                {
+                    usage();
+                    return 1;
+                }
+                break;
+            case 'd':
+                dictPath = optarg;
+                break;
+            case 'T':
+                trainPath = optarg;
+                break;
+            case 's':
+                model.sdRate = strtod(optarg, NULL);
+                break;
+            case 'l':
+                model.decodeRate[BPK_CODEC_LZ4] = strtod(optarg, NULL);
+                break;
+            case 'z':
+                model.decodeRate[BPK_CODEC_ZSTD] = strtod(optarg, NULL);
+                break;
+            case 'C':
+                if (strtoul(optarg, NULL, 0) >= MAX_SEGMENTS)
+                {
+                    usage();
+                    return 1;
+                }
+                coldSegments |= 1U << strtoul(optarg, NULL, 0);
+                break;
+            case 'k':
+                keyPath = optarg;
+                break;
+            case 'S':
+                signingKeyPath = optarg;
+                break;
+            case 'K':
+                keySourcePath = optarg;
+                break;
+            case 'V':
+                verify = 1;
+                break;
+            case 'j':
+                model.cores = strtoul(optarg, NULL, 0);
+                break;
+            case 'p':
+                secondPartPath = optarg;
+                break;
+            case 'u':
+                stripeUnit = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                usage();
+                return 1;
+        }
+    }
+
+    if (keyPath != NULL && read_key(keyPath, key) != 0)
+    {
+        return 1;
+    }
+    if (signingKeyPath != NULL && (signingKey = read_signing_key(signingKeyPath, publicKey)) == NULL)
+    {
+        return 1;
+    }
+
+    if (keySourcePath != NULL)
+    {
+        if (signingKey == NULL || argc != optind)
+        {
+            usage();
+            return 1;
+        }
+
+        int result = write_key_source(publicKey, signingKeyPath, keySourcePath);
+        EVP_PKEY_free(signingKey);
+        return result;
+    }
+
+    if (verify)
+    {
+        size_t dictSize = 0;
+        uint8_t *dict = NULL;
+
+        if (argc - optind != 1 || (dictPath != NULL && (dict = read_file(dictPath, &dictSize)) == NULL))
+        {
+            usage();
+            return 1;
+        }
+
+        int result = verify_container(argv[optind], dict, dictSize, (keyPath != NULL) ? key : NULL,
+            (signingKey != NULL) ? publicKey : NULL);
+        free(dict);
+        EVP_PKEY_free(signingKey);
+        return result;
+    }
+
+    if (argc - optind != 2 || blockSize == 0 || (blockSize % BPK_DATA_ALIGN) != 0 || (dictPath && trainPath) ||
+        stripeUnit == 0 || (stripeUnit % BOOT_STRIPE_UNIT_ALIGN) != 0 ||
+        model.sdRate <= 0 || model.decodeRate[BPK_CODEC_LZ4] <= 0 || model.decodeRate[BPK_CODEC_ZSTD] <= 0)
+    {
+        usage();
+        return 1;
+    }
+
+    size_t imageSize;
+    uint8_t *image = read_file(argv[optind], &imageSize);
+    if (image == NULL)
+    {
+        return 1;
+    }
+
+    struct segment segments[MAX_SEGMENTS];
+    uint32_t numSegments;
+    uint64_t entry;
+    if (parse_elf(image, imageSize, segments, &numSegments, &entry) != 0)
+    {
+        return 1;
+    }
+
+    // Trailing zeros are cleared by the loader along with the rest of memsz
+    uint64_t trimmedBytes = 0;
+    for (uint32_t i = 0; i < numSegments; i++)
+    {
+        while (segments[i].filesz > 0 && segments[i].data[segments[i].filesz - 1] == 0)
+        {
+            segments[i].filesz--;
+            trimmedBytes++;
+        }
+    }
+
+    // zstd frames record their content size and skip the checksum; the window never
+    // needs to exceed one block since every block is decoded on its own
+    uint8_t dictBuffer[DICT_CAPACITY];
+    uint8_t *dict = NULL;
+    size_t dictSize = 0;
+    int windowLog = ZSTD_MIN_WINDOW_LOG;
+    while (windowLog < ZSTD_MAX_WINDOW_LOG && (1U << windowLog) < blockSize)
+    {
+        windowLog++;
+    }
+
+    zstdContext = ZSTD_createCCtx();
+    ZSTD_CCtx_setParameter(zstdContext, ZSTD_c_compressionLevel, ZSTD_LEVEL);
+    ZSTD_CCtx_setParameter(zstdContext, ZSTD_c_contentSizeFlag, 1);
+    ZSTD_CCtx_setParameter(zstdContext, ZSTD_c_checksumFlag, 0);
+    ZSTD_CCtx_setParameter(zstdContext, ZSTD_c_windowLog, windowLog);
+
+    if (trainPath != NULL)
+    {
+        dictSize = train_dict(segments, numSegments, blockSize, dictBuffer, trainPath);
+        dict = dictBuffer;
+    }
+    else if (dictPath != NULL)
+    {
+        dict = read_file(dictPath, &dictSize);
+        if (dict == NULL)
+        {
+            return 1;
+        }
+        if (dictSize > DICT_CAPACITY || ZDICT_getDictID(dict, dictSize) == 0)
+        {
+            fprintf(stderr, "%s is not a zstd dictionary of at most %u bytes\n", dictPath, DICT_CAPACITY);
+            return 1;
+        }
+    }
+
+    if (dict != NULL && ZSTD_isError(ZSTD_CCtx_loadDictionary(zstdContext, dict, dictSize)))
+    {
+        fprintf(stderr, "Failed to load dictionary\n");
+        return 1;
+    }
+
+    // Split every segment into blocks
+    uint32_t numBlocks = 0;
+    uint32_t maxSegmentBlocks = 1;
+    for (uint32_t i = 0; i < numSegments; i++)
+    {
+        uint32_t segmentBlocks = (segments[i].filesz + blockSize - 1) / blockSize;
+        numBlocks += segmentBlocks;
+        if (segmentBlocks > maxSegmentBlocks)
+        {
+            maxSegmentBlocks = segmentBlocks;
+        }
+    }
+
+    struct bpk_segment *packSegments = calloc(numSegments, sizeof(struct bpk_segment));
+    struct bpk_block *packBlocks = calloc(numBlocks ? numBlocks : 1, sizeof(struct bpk_block));
+    struct block *blocks = calloc(numBlocks ? numBlocks : 1, sizeof(struct block));
+    struct block *candidate = calloc(maxSegmentBlocks, sizeof(struct block));
+    if (packSegments == NULL || packBlocks == NULL || blocks == NULL || candidate == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    struct bpk_header header;
+    memset(&header, 0, sizeof(header));
+    header.magic[0] = BPK_MAGIC0;
+    header.magic[1] = BPK_MAGIC1;
+    header.magic[2] = BPK_MAGIC2;
+    header.magic[3] = BPK_MAGIC3;
+    header.version = BPK_VERSION;
+    header.header_size = sizeof(header);
+    header.num_segments = numSegments;
+    header.num_blocks = numBlocks;
+    header.block_size = blockSize;
+    header.entry = entry;
+    header.segment_offset = sizeof(header);
+    header.block_offset = header.segment_offset + numSegments * sizeof(struct bpk_segment);
+    header.hash_offset = header.block_offset + numBlocks * sizeof(struct bpk_block);
+    if (keyPath != NULL)
+    {
+        header.cipher = BPK_CIPHER_AES256_GCM;
+        if (RAND_bytes(header.iv, BPK_IV_SIZE) != 1)
+        {
+            fprintf(stderr, "Failed to generate an IV\n");
+            return 1;
+        }
+    }
+
+    uint8_t *leaves = malloc((numBlocks ? numBlocks : 1) * BPK_HASH_SIZE);
+    if (leaves == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    uint32_t offset = header.hash_offset + numBlocks * BPK_HASH_SIZE;
+    uint64_t rawBytes = 0;
+    uint64_t storedBytes = 0;
+    uint64_t fillBytes = 0;
+    uint32_t blockIndex = 0;
+
+    for (uint32_t i = 0; i < numSegments; i++)
+    {
+        static const char *codecNames[] = { "raw", "lz4", "zstd" };
+        uint32_t segmentBlocks = (segments[i].filesz + blockSize - 1) / blockSize;
+        struct block *segmentBlocksOut = &blocks[blockIndex];
+        uint32_t chosen = codec;
+
+        packSegments[i].dest = segments[i].dest;
+        packSegments[i].filesz = segments[i].filesz;
+        packSegments[i].memsz = segments[i].memsz;
+        packSegments[i].first_block = blockIndex;
+        packSegments[i].num_blocks = segmentBlocks;
+        packSegments[i].flags = (coldSegments & (1U << i)) ? BPK_SEGMENT_COLD : 0;
+
+        if (codec != CODEC_AUTO)
+        {
+            if (pack_segment(&segments[i], blockSize, codec, &model, segmentBlocksOut) < 0)
+            {
+                fprintf(stderr, "Out of memory\n");
+                return 1;
+            }
+        }
+        else
+        {
+            // Keep whichever codec loads this segment fastest
+            double best = -1;
+            for (uint32_t c = BPK_CODEC_RAW; c <= BPK_CODEC_ZSTD; c++)
+            {
+                double seconds = pack_segment(&segments[i], blockSize, c, &model, candidate);
+                if (seconds < 0)
+                {
+                    fprintf(stderr, "Out of memory\n");
+                    return 1;
+                }
+
+                if (best < 0 || seconds < best)
+                {
+                    best = seconds;
+                    chosen = c;
+                    free_blocks(segmentBlocksOut, segmentBlocks);
+                    memcpy(segmentBlocksOut, candidate, segmentBlocks * sizeof(struct block));
+                }
+                else
+                {
+                    free_blocks(candidate, segmentBlocks);
+                }
+            }
+        }
+
+        uint64_t segmentStored = 0;
+        for (uint32_t j = 0; j < segmentBlocks; j++, blockIndex++)
+        {
+            struct block *block = &blocks[blockIndex];
+            uint64_t start = (uint64_t)j * blockSize;
+            uint32_t length = (segments[i].filesz - start < blockSize) ? segments[i].filesz - start : blockSize;
+
+            bpk_hash_leaf(blockIndex, segments[i].data + start, length, leaves + blockIndex * BPK_HASH_SIZE);
+
+            // Encrypted blocks all pass through the loader's staging slots, raw ones included
+            if (keyPath != NULL && block->codec != BPK_CODEC_FILL &&
+                encrypt_block(key, header.iv, blockIndex, block) != 0)
+            {
+                fprintf(stderr, "Failed to encrypt block %u\n", blockIndex);
+                return 1;
+            }
+
+            offset = (offset + BPK_DATA_ALIGN - 1) & ~(BPK_DATA_ALIGN - 1);
+            packBlocks[blockIndex].offset = offset;
+            packBlocks[blockIndex].stored = block->stored;
+            packBlocks[blockIndex].codec = block->codec;
+            packBlocks[blockIndex].fill = block->fill;
+            if (block->codec == BPK_CODEC_FILL)
+            {
+                fillBytes += length;
+            }
+            if ((block->codec != BPK_CODEC_RAW || keyPath != NULL) && block->stored > header.max_stored)
+            {
+                header.max_stored = block->stored;
+            }
+            if (block->codec == BPK_CODEC_ZSTD && dict != NULL)
+            {
+                header.dict_id = ZDICT_getDictID(dict, dictSize);
+            }
+
+            offset += block->stored;
+            segmentStored += block->stored;
+        }
+
+        printf("  segment %u: %s, %llu -> %llu bytes\n", i, codecNames[chosen],
+            (unsigned long long)segments[i].filesz, (unsigned long long)segmentStored);
+        rawBytes += segments[i].filesz;
+        storedBytes += segmentStored;
+    }
+
+    // The root covers every leaf plus the finished metadata
+    uint8_t *nodes = malloc((numBlocks + 1) * BPK_HASH_SIZE);
+    if (nodes == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    memcpy(nodes, leaves, numBlocks * BPK_HASH_SIZE);
+    bpk_hash_manifest(&header, packSegments, packBlocks, nodes + numBlocks * BPK_HASH_SIZE);
+    bpk_hash_root(nodes, numBlocks + 1, header.root);
+    free(nodes);
+
+    if (signingKey != NULL && sign_root(signingKey, header.root, header.signature) != 0)
+    {
+        fprintf(stderr, "Failed to sign the container\n");
+        return 1;
+    }
+
+    // Write the container
+    FILE *out = fopen(argv[optind + 1], "wb");
+    if (out == NULL)
+    {
+        perror(argv[optind + 1]);
+        return 1;
+    }
+
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(packSegments, sizeof(struct bpk_segment), numSegments, out);
+    fwrite(packBlocks, sizeof(struct bpk_block), numBlocks, out);
+    fwrite(leaves, BPK_HASH_SIZE, numBlocks, out);
+    for (uint32_t i = 0; i < numBlocks; i++)
+    {
+        static const uint8_t padding[BPK_DATA_ALIGN];
+        long position = ftell(out);
+
+        fwrite(padding, 1, packBlocks[i].offset - position, out);
+        fwrite(blocks[i].data, 1, blocks[i].stored, out);
+        free(blocks[i].data);
+    }
+
+    if (fclose(out) != 0)
+    {
+        perror(argv[optind + 1]);
+        return 1;
+    }
+    if (secondPartPath != NULL && write_parts(argv[optind + 1], secondPartPath, stripeUnit, header.root) != 0)
+    {
+        return 1;
+    }
+
+    printf("%s: %u segment(s), %u block(s), %llu -> %llu bytes, entry 0x%llx", argv[optind + 1],
+        numSegments, numBlocks, (unsigned long long)rawBytes, (unsigned long long)storedBytes,
+        (unsigned long long)entry);
+    if (header.dict_id != 0)
+    {
+        printf(", dictionary 0x%08x", header.dict_id);
+    }
+    if (header.cipher != BPK_CIPHER_NONE)
+    {
+        printf(", AES-256-GCM");
+    }
+    if (signingKey != NULL)
+    {
+        printf(", signed");
+    }
+    if (secondPartPath != NULL)
+    {
+        printf(", striped with %s in %u-byte units", secondPartPath, stripeUnit);
+    }
+    printf("\n%llu byte(s) elided as fill blocks, %llu trailing zero byte(s) trimmed\n",
+        (unsigned long long)fillBytes, (unsigned long long)trimmedBytes);
+
+    ZSTD_freeCCtx(zstdContext);
+    EVP_PKEY_free(signingKey);
+    free(leaves);
+    free(candidate);
+    free(blocks);
+    free(packBlocks);
+    free(packSegments);
+    if (dict != dictBuffer)
+    {
+        free(dict);
+    }
+    free(image);
+    return 0;
+}
@@ -0,0 +1,328 @@
+/*
+ * Description: Host converter for the loader's boot trace (see ../boot_trace.h). Reads
+ * either a UART log holding the "#BT " lines printed by a loader built with
+ * BOOT_TRACE_DUMP, or a memory image containing the trace ring (for example saved over
+ * JTAG with "mrd -bin -file trace.bin 0xFFFE4000 4096" in xsct), and writes Chrome
+ * trace-event JSON with one lane per core. Open the result in chrome://tracing or
+ * ui.perfetto.dev to see where reads, decoding, hashing, flushes and bss clearing
+ * serialize and where cores sit idle. If a log holds several dumps the last one is used.
+ *
+ * Build: gcc -O2 -I.. -o boottrace boottrace.c
+ * Usage: boottrace [-o trace.json] trace.log|trace.bin
+ */
+
+// Standard Libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+// Addtional Libraries
+#include "boot_trace.h"
+
+// Definitions
+#define MAX_CORES 256
+
+struct event_info
+{
+    const char *name;
+    const char *category;
+    const char *argName;            // Meaning of the event argument, or NULL
+};
+
+// Indexed by BOOT_TRACE_* event
+static const struct event_info eventInfo[BOOT_TRACE_NUM_EVENTS] =
+{
+    { "Image", "image", "image" },
+    { "SD read", "io", "bytes" },
+    { "Copy", "memory", "bytes" },
+    { "AES-GCM decrypt", "decode", "block" },
+    { "Decode", "decode", "block" },
+    { "SHA3 verify", "verify", "block" },
+    { "CSU SHA3 wait", "verify", NULL },
+    { "Cache flush", "memory", "bytes" },
+    { "Zero bss", "memory", "bytes" },
+    { "Deferred verify", "verify", "blocks" },
+    { "Core release", "handoff", "target" },
+};
+
+struct trace_entry
+{
+    struct boot_trace_event event;
+    uint32_t order;                 // Position in the ring, to keep equal timestamps stable
+};
+
+static uint8_t *read_file(const char *path, size_t *size)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        perror(path);
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long length = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    uint8_t *data = malloc(length > 0 ? length + 1 : 1);
+    if (data == NULL || fread(data, 1, length, fp) != (size_t)length)
+    {
+        fprintf(stderr, "Failed to read %s\n", path);
+        free(data);
+        fclose(fp);
+        return NULL;
+    }
+
+    fclose(fp);
+    data[length] = 0;
+    *size = length;
+    return data;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Rebuilds the trace ring from the hex dump lines of a UART log, in place; returns its size
+static size_t parse_uart_log(uint8_t *log, size_t size)
+{
+    const size_t prefixSize = strlen(BOOT_TRACE_LINE_PREFIX);
+    size_t length = 0;
+    char *line = (char *)log;
+
+    while (line < (char *)log + size)
+    {
+        char *next = memchr(line, '\n', (char *)log + size - line);
+        next = (next != NULL) ? next + 1 : (char *)log + size;
+
+        // Terminal programs may put a timestamp in front of the line
+        char *hex = strstr(line, BOOT_TRACE_LINE_PREFIX);
+        if (hex != NULL && hex < next)
+        {
+            hex += prefixSize;
+
+            // A new header starts a new dump
+            if (strncmp(hex, "42545243", 8) == 0)
+            {
+                length = 0;
+            }
+            while (hex + 1 < next && hex_value(hex[0]) >= 0 && hex_value(hex[1]) >= 0)
+            {
+                // Decoded bytes never overtake the text they came from
+                log[length++] = (uint8_t)((hex_value(hex[0]) << 4) | hex_value(hex[1]));
+                hex += 2;
+            }
+        }
+        line = next;
+    }
+
+    return length;
+}
+
+// Finds a plausible trace header in a memory image
+static const struct boot_trace *find_trace(const uint8_t *image, size_t size)
+{
+    for (size_t offset = 0; offset + sizeof(struct boot_trace) <= size; offset += 4)
+    {
+        const struct boot_trace *trace = (const struct boot_trace *)(image + offset);
+
+        if (memcmp(trace->magic, BOOT_TRACE_MAGIC, sizeof(trace->magic)) == 0 &&
+            trace->version == BOOT_TRACE_VERSION && trace->event_size == sizeof(struct boot_trace_event) &&
+            trace->counts_per_second != 0)
+        {
+            return trace;
+        }
+    }
+
+    return NULL;
+}
+
+static int compare_entries(const void *a, const void *b)
+{
+    const struct trace_entry *left = a;
+    const struct trace_entry *right = b;
+
+    if (left->event.time != right->event.time)
+    {
+        return (left->event.time < right->event.time) ? -1 : 1;
+    }
+    return (left->order < right->order) ? -1 : (left->order > right->order);
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: boottrace [-o trace.json] trace.log|trace.bin\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *outputPath = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "o:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'o':
+                outputPath = optarg;
+                break;
+            default:
+                usage();
+                return 1;
+        }
+    }
+    if (optind + 1 != argc)
+    {
+        usage();
+        return 1;
+    }
+
+    size_t size;
+    uint8_t *input = read_file(argv[optind], &size);
+    if (input == NULL)
+    {
+        return 1;
+    }
+
+    // UART logs carry the ring as hex lines, memory images carry it as is
+    if (strstr((const char *)input, BOOT_TRACE_LINE_PREFIX) != NULL)
+    {
+        size = parse_uart_log(input, size);
+    }
+
+    const struct boot_trace *trace = find_trace(input, size);
+    if (trace == NULL)
+    {
+        fprintf(stderr, "No boot trace found in %s\n", argv[optind]);
+        free(input);
+        return 1;
+    }
+
+    // The ring only holds the newest capacity events; a dump may also be cut short
+    uint32_t available = (uint32_t)((input + size - (const uint8_t *)trace - sizeof(*trace)) /
+        sizeof(struct boot_trace_event));
+    uint32_t numEvents = (trace->count < trace->capacity) ? trace->count : trace->capacity;
+    if (numEvents > available)
+    {
+        fprintf(stderr, "Trace truncated: %u of %u events present\n", available, numEvents);
+        numEvents = available;
+    }
+    if (trace->count > trace->capacity)
+    {
+        fprintf(stderr, "Trace ring wrapped: %u oldest events lost\n", trace->count - trace->capacity);
+    }
+
+    struct trace_entry *entries = malloc((numEvents ? numEvents : 1) * sizeof(struct trace_entry));
+    if (entries == NULL)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(input);
+        return 1;
+    }
+    for (uint32_t i = 0; i < numEvents; i++)
+    {
+        memcpy(&entries[i].event, &trace->events[i], sizeof(struct boot_trace_event));
+        entries[i].order = (trace->count > trace->capacity) ?
+            (i + trace->capacity - trace->count % trace->capacity) % trace->capacity : i;
+    }
+    qsort(entries, numEvents, sizeof(struct trace_entry), compare_entries);
+
+    FILE *out = stdout;
+    if (outputPath != NULL && (out = fopen(outputPath, "w")) == NULL)
+    {
+        perror(outputPath);
+        free(entries);
+        free(input);
+        return 1;
+    }
+
+    uint32_t pid = trace->cluster;
+    uint64_t origin = numEvents ? entries[0].event.time : 0;
+    uint32_t depth[MAX_CORES] = { 0 };
+    uint8_t seen[MAX_CORES] = { 0 };
+    double perUs = trace->counts_per_second / 1e6;
+
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"name\":\"%s\"}}", pid,
+        (trace->cluster == BOOT_TRACE_APU) ? "APU (Cortex-A53)" : "RPU (Cortex-R5)");
+
+    for (uint32_t i = 0; i < numEvents; i++)
+    {
+        const struct boot_trace_event *event = &entries[i].event;
+        const struct event_info *info;
+
+        if (event->id >= BOOT_TRACE_NUM_EVENTS)
+        {
+            continue;
+        }
+        info = &eventInfo[event->id];
+
+        if (!seen[event->core])
+        {
+            seen[event->core] = 1;
+            fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"Core %u\"}}",
+                pid, event->core, event->core);
+            fprintf(out, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"sort_index\":%u}}",
+                pid, event->core, event->core);
+        }
+
+        // Ends whose begin was overwritten in the ring would close an unrelated span
+        if (event->phase == BOOT_TRACE_END)
+        {
+            if (depth[event->core] == 0)
+            {
+                continue;
+            }
+            depth[event->core]--;
+        }
+        else if (event->phase == BOOT_TRACE_BEGIN)
+        {
+            depth[event->core]++;
+        }
+        else if (event->phase != BOOT_TRACE_INSTANT)
+        {
+            continue;
+        }
+
+        fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%u,\"tid\":%u",
+            info->name, info->category, event->phase, (event->time - origin) / perUs, pid, event->core);
+        if (event->phase == BOOT_TRACE_INSTANT)
+        {
+            fprintf(out, ",\"s\":\"p\"");
+        }
+        if (info->argName != NULL && event->phase != BOOT_TRACE_END)
+        {
+            // Release targets are addresses or core masks, everything else is a count
+            fprintf(out, (event->id == BOOT_TRACE_RELEASE) ? ",\"args\":{\"%s\":\"0x%x\"}" :
+                ",\"args\":{\"%s\":%u}", info->argName, event->arg);
+        }
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n]}\n");
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    fprintf(stderr, "%u events, %.3f ms\n", numEvents,
+        numEvents ? (entries[numEvents - 1].event.time - origin) / perUs / 1000.0 : 0.0);
+
+    free(entries);
+    free(input);
+    return 0;
+}
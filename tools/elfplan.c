@@ -0,0 +1,321 @@
+/*
+ * Description: Host generator for baked load plans (see ../elf_plan.h). Reads one or more
+ * ELF32 or ELF64 images and writes a C source file listing, for each, the file size, a
+ * SHA3-384 fingerprint of its ELF and program headers, the entry point and every PT_LOAD
+ * segment with its file offset, sizes, run and load addresses and a SHA3-384 digest of
+ * its data. Every check the loader would make against the file itself is made here, so
+ * a loader built with ELF_PLAN=1 and the result only compares the fingerprint before
+ * reading the segments. Placement against the loader's memory map is still checked at
+ * boot. Each image is looked up by its file name without the directory, so name the
+ * inputs as they are named on the card. Regenerate whenever an image is rebuilt; a
+ * stale plan is ignored and the image parsed as usual.
+ *
+ * Build: gcc -O2 -I.. -o elfplan elfplan.c ../sha3.c
+ * Usage: elfplan -o elf_plan.c image.elf [image.elf ...]
+ */
+
+// Standard Libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <elf.h>
+
+// Addtional Libraries
+#include "elf_plan.h"
+#include "sha3.h"
+
+// Definitions
+#define MAX_SEGMENTS 32
+
+struct plan
+{
+    const char *name;
+    uint64_t fileSize;
+    uint32_t headerSize;
+    uint8_t fingerprint[SHA3_384_DIGEST_SIZE];
+    uint64_t entry;
+    uint8_t digest[SHA3_384_DIGEST_SIZE];
+    uint32_t numSegments;
+    struct elf_plan_segment segments[MAX_SEGMENTS];
+};
+
+static uint8_t *read_file(const char *path, size_t *size)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        perror(path);
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long length = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    uint8_t *data = malloc(length > 0 ? length : 1);
+    if (data == NULL || fread(data, 1, length, fp) != (size_t)length)
+    {
+        fprintf(stderr, "Failed to read %s\n", path);
+        free(data);
+        fclose(fp);
+        return NULL;
+    }
+
+    fclose(fp);
+    *size = length;
+    return data;
+}
+
+// Adds one program header to the plan if the loader has to read it
+static int add_segment(struct plan *plan, const uint8_t *image, size_t size, uint32_t type, uint64_t offset,
+    uint64_t vaddr, uint64_t paddr, uint64_t filesz, uint64_t memsz)
+{
+    if (type != PT_LOAD || memsz == 0)
+    {
+        return 0;
+    }
+    if (offset + filesz > size || filesz > memsz || filesz > UINT32_MAX || plan->numSegments == MAX_SEGMENTS)
+    {
+        fprintf(stderr, "%s: invalid program header at offset 0x%llx\n", plan->name, (unsigned long long)offset);
+        return -1;
+    }
+
+    struct elf_plan_segment *segment = &plan->segments[plan->numSegments++];
+    segment->vaddr = vaddr;
+    segment->paddr = paddr;
+    segment->offset = offset;
+    segment->filesz = filesz;
+    segment->memsz = memsz;
+    sha3_384(image + offset, (uint32_t)filesz, segment->digest);
+
+    return 0;
+}
+
+// Reads the headers of an ELF32 or ELF64 image into a plan
+static int build_plan(struct plan *plan, const uint8_t *image, size_t size)
+{
+    uint64_t headerOffset;
+    uint32_t headerCount;
+    uint32_t entrySize;
+
+    if (size < sizeof(Elf32_Ehdr) || memcmp(image, ELFMAG, SELFMAG) != 0)
+    {
+        fprintf(stderr, "%s is not an ELF file\n", plan->name);
+        return -1;
+    }
+
+    if (image[EI_CLASS] == ELFCLASS64 && size >= sizeof(Elf64_Ehdr))
+    {
+        const Elf64_Ehdr *ehdr = (const Elf64_Ehdr *)image;
+        headerOffset = ehdr->e_phoff;
+        headerCount = ehdr->e_phnum;
+        entrySize = ehdr->e_phentsize;
+        plan->entry = ehdr->e_entry;
+        plan->headerSize = sizeof(Elf64_Ehdr);
+        if (entrySize != sizeof(Elf64_Phdr))
+        {
+            fprintf(stderr, "%s: unexpected program header size %u\n", plan->name, entrySize);
+            return -1;
+        }
+    }
+    else if (image[EI_CLASS] == ELFCLASS32)
+    {
+        const Elf32_Ehdr *ehdr = (const Elf32_Ehdr *)image;
+        headerOffset = ehdr->e_phoff;
+        headerCount = ehdr->e_phnum;
+        entrySize = ehdr->e_phentsize;
+        plan->entry = ehdr->e_entry;
+        plan->headerSize = sizeof(Elf32_Ehdr);
+        if (entrySize != sizeof(Elf32_Phdr))
+        {
+            fprintf(stderr, "%s: unexpected program header size %u\n", plan->name, entrySize);
+            return -1;
+        }
+    }
+    else
+    {
+        fprintf(stderr, "%s: unsupported ELF class %u\n", plan->name, image[EI_CLASS]);
+        return -1;
+    }
+
+    // The fingerprint runs from the start of the file to the end of the program headers
+    if (headerOffset + (uint64_t)headerCount * entrySize > size)
+    {
+        fprintf(stderr, "%s: program headers run past the end of the file\n", plan->name);
+        return -1;
+    }
+    if (headerOffset + (uint64_t)headerCount * entrySize > plan->headerSize)
+    {
+        plan->headerSize = (uint32_t)(headerOffset + (uint64_t)headerCount * entrySize);
+    }
+    if (plan->headerSize > ELF_PLAN_MAX_HEADER)
+    {
+        fprintf(stderr, "%s: headers span 0x%x bytes, more than the loader fingerprints\n", plan->name,
+            plan->headerSize);
+        return -1;
+    }
+    plan->fileSize = size;
+    sha3_384(image, plan->headerSize, plan->fingerprint);
+
+    for (uint32_t i = 0; i < headerCount; i++)
+    {
+        const uint8_t *header = image + headerOffset + (uint64_t)i * entrySize;
+        int status;
+
+        if (image[EI_CLASS] == ELFCLASS64)
+        {
+            const Elf64_Phdr *phdr = (const Elf64_Phdr *)header;
+            status = add_segment(plan, image, size, phdr->p_type, phdr->p_offset, phdr->p_vaddr, phdr->p_paddr,
+                phdr->p_filesz, phdr->p_memsz);
+        }
+        else
+        {
+            const Elf32_Phdr *phdr = (const Elf32_Phdr *)header;
+            status = add_segment(plan, image, size, phdr->p_type, phdr->p_offset, phdr->p_vaddr, phdr->p_paddr,
+                phdr->p_filesz, phdr->p_memsz);
+        }
+        if (status != 0)
+        {
+            return -1;
+        }
+    }
+
+    // Digest of the segment digests, recorded in the boot log for verified images
+    struct sha3_context context;
+    sha3_384_init(&context);
+    for (uint32_t i = 0; i < plan->numSegments; i++)
+    {
+        sha3_384_update(&context, plan->segments[i].digest, SHA3_384_DIGEST_SIZE);
+    }
+    sha3_384_final(&context, plan->digest);
+
+    return 0;
+}
+
+static void write_digest(FILE *out, const uint8_t *digest, const char *indent)
+{
+    fprintf(out, "{\n");
+    for (uint32_t i = 0; i < SHA3_384_DIGEST_SIZE; i++)
+    {
+        if (i % 12 == 0)
+        {
+            fprintf(out, "%s    ", indent);
+        }
+        fprintf(out, "0x%02X%s", digest[i], (i == SHA3_384_DIGEST_SIZE - 1) ? "\n" : (i % 12 == 11) ? ",\n" : ", ");
+    }
+    fprintf(out, "%s}", indent);
+}
+
+static int write_plans(const char *path, const struct plan *plans, uint32_t count)
+{
+    FILE *out = fopen(path, "w");
+    if (out == NULL)
+    {
+        perror(path);
+        return 1;
+    }
+
+    fprintf(out, "/*\n * Description: Baked load plans, generated by tools/elfplan.c for:\n");
+    for (uint32_t p = 0; p < count; p++)
+    {
+        fprintf(out, " * %s (%u segments, entry 0x%llx)\n", plans[p].name, plans[p].numSegments,
+            (unsigned long long)plans[p].entry);
+    }
+    fprintf(out, " * Regenerate rather than edit.\n */\n\n#include \"elf_plan.h\"\n");
+
+    for (uint32_t p = 0; p < count; p++)
+    {
+        fprintf(out, "\nstatic const struct elf_plan_segment plan%uSegments[] =\n{\n", p);
+        for (uint32_t i = 0; i < plans[p].numSegments; i++)
+        {
+            const struct elf_plan_segment *segment = &plans[p].segments[i];
+
+            fprintf(out, "    {\n        0x%llxULL, 0x%llxULL, 0x%llxULL, 0x%llxULL, 0x%llxULL,\n        ",
+                (unsigned long long)segment->vaddr, (unsigned long long)segment->paddr,
+                (unsigned long long)segment->offset, (unsigned long long)segment->filesz,
+                (unsigned long long)segment->memsz);
+            write_digest(out, segment->digest, "        ");
+            fprintf(out, "\n    }%s\n", (i < plans[p].numSegments - 1) ? "," : "");
+        }
+        fprintf(out, "};\n");
+    }
+
+    fprintf(out, "\nconst struct elf_plan elfPlans[] =\n{\n");
+    for (uint32_t p = 0; p < count; p++)
+    {
+        fprintf(out, "    {\n        \"%s\", 0x%llxULL, 0x%x,\n        ", plans[p].name,
+            (unsigned long long)plans[p].fileSize, plans[p].headerSize);
+        write_digest(out, plans[p].fingerprint, "        ");
+        fprintf(out, ",\n        0x%llxULL,\n        ", (unsigned long long)plans[p].entry);
+        write_digest(out, plans[p].digest, "        ");
+        fprintf(out, ",\n        %u, plan%uSegments\n    }%s\n", plans[p].numSegments, p, (p < count - 1) ? "," : "");
+    }
+    fprintf(out, "};\n\nconst uint32_t elfNumPlans = %u;\n", count);
+
+    if (fclose(out) != 0)
+    {
+        perror(path);
+        return 1;
+    }
+
+    return 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: elfplan -o elf_plan.c image.elf [image.elf ...]\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *outPath = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "o:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'o':
+                outPath = optarg;
+                break;
+            default:
+                usage();
+                return 1;
+        }
+    }
+    if (outPath == NULL || optind == argc)
+    {
+        usage();
+        return 1;
+    }
+
+    uint32_t count = argc - optind;
+    struct plan *plans = calloc(count, sizeof(*plans));
+    if (plans == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    for (uint32_t p = 0; p < count; p++)
+    {
+        const char *path = argv[optind + p];
+        const char *slash = strrchr(path, '/');
+        size_t size;
+
+        plans[p].name = (slash != NULL) ? slash + 1 : path;
+        uint8_t *image = read_file(path, &size);
+        if (image == NULL || build_plan(&plans[p], image, size) != 0)
+        {
+            return 1;
+        }
+        free(image);
+
+        printf("%s: %u segments, entry 0x%llx, fingerprint over 0x%x bytes\n", plans[p].name,
+            plans[p].numSegments, (unsigned long long)plans[p].entry, plans[p].headerSize);
+    }
+
+    return write_plans(outPath, plans, count);
+}
@@ -0,0 +1,165 @@
+/*
+ * Description: Host builder for the QSPI image partition (see ../boot_qspi.h). Writes a
+ * directory followed by each input file, aligned to a cache line, so the loader can copy
+ * segments straight out of the linear QSPI window. The images start in the erase sector
+ * after the directory's, which the loader rewrites when it stores images. Inputs are
+ * stored under their file name without the directory, which is the name the loaders
+ * open them by; ELF images and boot pack containers are stored as they are on the SD
+ * card, and hashed containers are keyed by their hash tree root for BOOT_STORAGE_CACHE.
+ * Program the result at BOOT_QSPI_PART_OFFSET, or pass it to a host build with
+ * BOOT_QSPI_EMULATE. The same layout serves the eMMC (../boot_emmc.h); -a 512 starts
+ * every image on a block there.
+ *
+ * Build: gcc -O2 -I.. -o qspiimg qspiimg.c
+ * Usage: qspiimg [-a align] -o qspi.bin image [image ...]
+ */
+
+// Standard Libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+// Addtional Libraries
+#include "boot_qspi.h"
+#include "bootpack_format.h"
+
+static uint8_t *read_file(const char *path, size_t *size)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        perror(path);
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long length = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    uint8_t *data = malloc(length > 0 ? length : 1);
+    if (data == NULL || fread(data, 1, length, fp) != (size_t)length)
+    {
+        fprintf(stderr, "Failed to read %s\n", path);
+        free(data);
+        fclose(fp);
+        return NULL;
+    }
+
+    fclose(fp);
+    *size = length;
+    return data;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: qspiimg [-a align] -o qspi.bin image [image ...]\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *outPath = NULL;
+    uint64_t align = BOOT_QSPI_ALIGN;
+    struct boot_qspi_directory directory;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "a:o:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'a':
+                align = strtoull(optarg, NULL, 0);
+                if (align < BOOT_QSPI_ALIGN || (align & (align - 1)) != 0)
+                {
+                    fprintf(stderr, "Alignment must be a power of two of at least %u\n", BOOT_QSPI_ALIGN);
+                    return 1;
+                }
+                break;
+            case 'o':
+                outPath = optarg;
+                break;
+            default:
+                usage();
+                return 1;
+        }
+    }
+    if (outPath == NULL || optind == argc || argc - optind > BOOT_QSPI_MAX_IMAGES)
+    {
+        usage();
+        return 1;
+    }
+
+    FILE *out = fopen(outPath, "wb");
+    if (out == NULL)
+    {
+        perror(outPath);
+        return 1;
+    }
+
+    memset(&directory, 0, sizeof(directory));
+    memcpy(directory.magic, BOOT_QSPI_MAGIC, 4);
+    directory.version = BOOT_QSPI_VERSION;
+    directory.num_images = argc - optind;
+
+    // Images follow the directory, which is written last once their offsets are known
+    uint64_t offset = (sizeof(directory) + BOOT_QSPI_SECTOR_SIZE - 1) & ~(uint64_t)(BOOT_QSPI_SECTOR_SIZE - 1);
+    for (uint32_t i = 0; i < directory.num_images; i++)
+    {
+        const char *path = argv[optind + i];
+        const char *slash = strrchr(path, '/');
+        const char *name = (slash != NULL) ? slash + 1 : path;
+        size_t size;
+        int keyed = 0;
+
+        if (strlen(name) >= BOOT_QSPI_NAME_SIZE)
+        {
+            fprintf(stderr, "%s: name longer than %u characters\n", name, BOOT_QSPI_NAME_SIZE - 1);
+            return 1;
+        }
+        uint8_t *data = read_file(path, &size);
+        if (data == NULL)
+        {
+            return 1;
+        }
+        if (offset + size > UINT32_MAX)
+        {
+            fprintf(stderr, "%s: partition too large\n", name);
+            return 1;
+        }
+
+        strncpy(directory.images[i].name, name, BOOT_QSPI_NAME_SIZE);
+        directory.images[i].offset = (uint32_t)offset;
+        directory.images[i].size = (uint32_t)size;
+        if (size >= sizeof(struct bpk_header))
+        {
+            const struct bpk_header *header = (const struct bpk_header *)data;
+
+            if (header->magic[0] == BPK_MAGIC0 && header->magic[1] == BPK_MAGIC1 && header->magic[2] == BPK_MAGIC2 &&
+                header->magic[3] == BPK_MAGIC3 && header->hash_offset != 0)
+            {
+                memcpy(directory.images[i].key, header->root, BOOT_QSPI_KEY_SIZE);
+                keyed = 1;
+            }
+        }
+        if (fseek(out, offset, SEEK_SET) != 0 || fwrite(data, 1, size, out) != size)
+        {
+            perror(outPath);
+            return 1;
+        }
+        printf("%-16s 0x%08llx %10zu bytes%s\n", name, (unsigned long long)offset, size,
+            keyed ? ", keyed" : "");
+
+        offset = (offset + size + align - 1) & ~(align - 1);
+        free(data);
+    }
+
+    if (fseek(out, 0, SEEK_SET) != 0 || fwrite(&directory, sizeof(directory), 1, out) != 1 || fclose(out) != 0)
+    {
+        perror(outPath);
+        return 1;
+    }
+    printf("%u images, 0x%llx bytes\n", directory.num_images, (unsigned long long)offset);
+
+    return 0;
+}
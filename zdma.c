@@ -0,0 +1,83 @@
+/*
+ * Description: ZDMA memory fill and copy (see zdma.h).
+ */
+
+// Standard Libraries
+#include "stdint.h"
+
+// Addtional Libraries
+#include "zdma.h"
+
+// Channel registers
+#define ZDMA_REG(channel, offset) (*(volatile uint32_t *)((channel) + (offset)))
+#define ZDMA_CH_ISR 0x100U
+#define ZDMA_CH_CTRL0 0x110U
+#define ZDMA_CH_SRC_DSCR_WORD0 0x128U
+#define ZDMA_CH_SRC_DSCR_WORD1 0x12CU
+#define ZDMA_CH_SRC_DSCR_WORD2 0x130U
+#define ZDMA_CH_DST_DSCR_WORD0 0x138U
+#define ZDMA_CH_DST_DSCR_WORD1 0x13CU
+#define ZDMA_CH_DST_DSCR_WORD2 0x140U
+#define ZDMA_CH_WR_ONLY_WORD0 0x148U
+#define ZDMA_CH_CTRL2 0x200U
+
+#define ZDMA_CTRL0_POINT_TYPE 0x40U     // Clear for simple (register) mode
+#define ZDMA_CTRL0_MODE 0x30U
+#define ZDMA_CTRL0_MODE_WR_ONLY 0x10U   // Write the WR_ONLY words, no source
+#define ZDMA_CTRL0_MODE_NORMAL 0x00U    // Read the source, write the destination
+#define ZDMA_CTRL2_EN 0x1U
+#define ZDMA_ISR_DMA_DONE 0x400U
+#define ZDMA_ISR_ERRORS 0x0FFU          // Bus, descriptor and address errors
+#define ZDMA_ISR_ALL 0xFFFU
+
+void zdma_fill_init(uintptr_t channel)
+{
+    ZDMA_REG(channel, ZDMA_CH_CTRL0) = (ZDMA_REG(channel, ZDMA_CH_CTRL0) &
+        ~(ZDMA_CTRL0_POINT_TYPE | ZDMA_CTRL0_MODE)) | ZDMA_CTRL0_MODE_WR_ONLY;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        ZDMA_REG(channel, ZDMA_CH_WR_ONLY_WORD0 + (i * 4U)) = 0;
+    }
+    ZDMA_REG(channel, ZDMA_CH_ISR) = ZDMA_ISR_ALL;
+}
+
+void zdma_fill_start(uintptr_t channel, uint64_t dst, uint32_t size)
+{
+    ZDMA_REG(channel, ZDMA_CH_ISR) = ZDMA_ISR_ALL;
+    ZDMA_REG(channel, ZDMA_CH_DST_DSCR_WORD0) = (uint32_t)dst;
+    ZDMA_REG(channel, ZDMA_CH_DST_DSCR_WORD1) = (uint32_t)(dst >> 32) & 0xFFFU;
+    ZDMA_REG(channel, ZDMA_CH_DST_DSCR_WORD2) = size;
+    ZDMA_REG(channel, ZDMA_CH_CTRL2) = ZDMA_CTRL2_EN;
+}
+
+int32_t zdma_fill_done(uintptr_t channel)
+{
+    uint32_t isr = ZDMA_REG(channel, ZDMA_CH_ISR);
+
+    if (!(isr & (ZDMA_ISR_DMA_DONE | ZDMA_ISR_ERRORS)))
+    {
+        return 0;
+    }
+    ZDMA_REG(channel, ZDMA_CH_ISR) = ZDMA_ISR_ALL;
+
+    return (isr & ZDMA_ISR_ERRORS) ? -1 : 1;
+}
+
+void zdma_copy_init(uintptr_t channel)
+{
+    ZDMA_REG(channel, ZDMA_CH_CTRL0) = (ZDMA_REG(channel, ZDMA_CH_CTRL0) &
+        ~(ZDMA_CTRL0_POINT_TYPE | ZDMA_CTRL0_MODE)) | ZDMA_CTRL0_MODE_NORMAL;
+    ZDMA_REG(channel, ZDMA_CH_ISR) = ZDMA_ISR_ALL;
+}
+
+void zdma_copy_start(uintptr_t channel, uint64_t dst, uint64_t src, uint32_t size)
+{
+    ZDMA_REG(channel, ZDMA_CH_ISR) = ZDMA_ISR_ALL;
+    ZDMA_REG(channel, ZDMA_CH_SRC_DSCR_WORD0) = (uint32_t)src;
+    ZDMA_REG(channel, ZDMA_CH_SRC_DSCR_WORD1) = (uint32_t)(src >> 32) & 0xFFFU;
+    ZDMA_REG(channel, ZDMA_CH_SRC_DSCR_WORD2) = size;
+    ZDMA_REG(channel, ZDMA_CH_DST_DSCR_WORD0) = (uint32_t)dst;
+    ZDMA_REG(channel, ZDMA_CH_DST_DSCR_WORD1) = (uint32_t)(dst >> 32) & 0xFFFU;
+    ZDMA_REG(channel, ZDMA_CH_DST_DSCR_WORD2) = size;
+    ZDMA_REG(channel, ZDMA_CH_CTRL2) = ZDMA_CTRL2_EN;
+}
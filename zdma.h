@@ -0,0 +1,36 @@
+/*
+ * Description: FPD general purpose DMA (ZDMA) channels used as memory fill and copy
+ * engines. In simple write-only mode a channel writes its four WR_ONLY words over the
+ * destination without reading anything, at DDR speed and without occupying a core; in
+ * simple normal mode it copies from a source address. Channels are driven by polling;
+ * the loaders have no interrupt handling.
+ */
+
+#ifndef ZDMA_H
+#define ZDMA_H
+
+#include "stdint.h"
+
+// FPD DMA channel register blocks
+#define ZDMA_GDMA_CH(n) (0xFD500000U + ((n) * 0x10000U))
+
+// Largest single transfer: the descriptor size field is 30 bits wide, kept to whole
+// 64-byte cache lines so the pieces of a longer run stay aligned
+#define ZDMA_MAX_TRANSFER 0x3FFFFFC0U
+
+// Puts the channel in write-only mode writing zeros
+void zdma_fill_init(uintptr_t channel);
+
+// Starts zeroing size bytes at the physical address dst
+void zdma_fill_start(uintptr_t channel, uint64_t dst, uint32_t size);
+
+// Returns 0 while the transfer runs, 1 once it is done and -1 if it failed
+int32_t zdma_fill_done(uintptr_t channel);
+
+// Puts the channel in normal mode, copying from a source
+void zdma_copy_init(uintptr_t channel);
+
+// Starts copying size bytes between physical addresses; completion as for zdma_fill_done()
+void zdma_copy_start(uintptr_t channel, uint64_t dst, uint64_t src, uint32_t size);
+
+#endif
@@ -0,0 +1,1180 @@
+/*
+ * Description: Compact Zstandard (RFC 8878) frame decoder used by the boot pack loader.
+ * Decoded literals are staged at the tail of the destination buffer: every remaining
+ * literal still has to be written at or after the current output position, so output
+ * never overtakes the literals it has yet to consume. Copies are done a byte at a time
+ * for the same reason as in lz4_block.c.
+ */
+
+#include "string.h"
+#include "zstd_decoder.h"
+
+#define ZSTD_MAGIC 0xFD2FB528U
+#define ZSTD_DICT_MAGIC 0xEC30A437U
+
+#define ZSTD_BLOCK_RAW 0
+#define ZSTD_BLOCK_RLE 1
+#define ZSTD_BLOCK_COMPRESSED 2
+
+#define ZSTD_LIT_RAW 0
+#define ZSTD_LIT_RLE 1
+#define ZSTD_LIT_COMPRESSED 2
+#define ZSTD_LIT_TREELESS 3
+
+#define ZSTD_MODE_PREDEFINED 0
+#define ZSTD_MODE_RLE 1
+#define ZSTD_MODE_FSE 2
+#define ZSTD_MODE_REPEAT 3
+
+#define ZSTD_TABLE_LL 0x1U
+#define ZSTD_TABLE_OF 0x2U
+#define ZSTD_TABLE_ML 0x4U
+#define ZSTD_TABLE_HUF 0x8U
+
+#define ZSTD_LL_MAX_SYMBOL 35
+#define ZSTD_ML_MAX_SYMBOL 52
+#define ZSTD_OF_MAX_SYMBOL 31
+#define ZSTD_HUF_MAX_SYMBOL 255
+#define ZSTD_HUF_WEIGHT_LOG 6
+
+// Literal and match length codes (RFC 8878 section 3.1.1.3.2.1.1)
+static const uint32_t zstdLLBase[ZSTD_LL_MAX_SYMBOL + 1] =
+{
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+    16, 18, 20, 22, 24, 28, 32, 40, 48, 64, 128, 256, 512, 1024, 2048, 4096,
+    8192, 16384, 32768, 65536
+};
+static const uint8_t zstdLLBits[ZSTD_LL_MAX_SYMBOL + 1] =
+{
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    1, 1, 1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12,
+    13, 14, 15, 16
+};
+static const uint32_t zstdMLBase[ZSTD_ML_MAX_SYMBOL + 1] =
+{
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+    19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34,
+    35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515, 1027, 2051,
+    4099, 8195, 16387, 32771, 65539
+};
+static const uint8_t zstdMLBits[ZSTD_ML_MAX_SYMBOL + 1] =
+{
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    1, 1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 7, 8, 9, 10, 11,
+    12, 13, 14, 15, 16
+};
+
+// Predefined distributions (RFC 8878 section 3.1.1.3.2.2)
+static const int16_t zstdLLDefault[ZSTD_LL_MAX_SYMBOL + 1] =
+{
+    4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1,
+    -1, -1, -1, -1
+};
+static const int16_t zstdMLDefault[ZSTD_ML_MAX_SYMBOL + 1] =
+{
+    1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1,
+    -1, -1, -1, -1, -1
+};
+static const int16_t zstdOFDefault[29] =
+{
+    1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1
+};
+
+// Tables in use for the frame being decoded
+struct zstd_frame
+{
+    const struct zstd_fse_entry *ll;
+    const struct zstd_fse_entry *of;
+    const struct zstd_fse_entry *ml;
+    const struct zstd_huf_entry *huf;
+    uint8_t llLog;
+    uint8_t ofLog;
+    uint8_t mlLog;
+    uint8_t hufLog;
+    uint32_t rep[3];
+    uint8_t *dst;
+    uint8_t *dstEnd;
+    uint8_t *op;
+    const uint8_t *dictContent;
+    uint32_t dictSize;
+};
+
+// Backward bit stream, read from the last byte towards the first
+struct zstd_bits
+{
+    const uint8_t *src;
+    int32_t bitPos;     // Bits still unread; negative once the stream has been overrun
+};
+
+static uint32_t zstd_read_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t zstd_highbit(uint32_t value)
+{
+    uint32_t bit = 0;
+
+    while (value >>= 1)
+    {
+        bit++;
+    }
+
+    return bit;
+}
+
+// Returns count (<= 32) bits starting at bit position start of a little-endian stream
+static uint32_t zstd_gather(const uint8_t *src, uint32_t start, uint32_t count)
+{
+    uint32_t byte = start >> 3;
+    uint32_t shift = start & 7;
+    uint32_t needed = (shift + count + 7) >> 3;
+    uint64_t value = 0;
+
+    for (uint32_t i = 0; i < needed; i++)
+    {
+        value |= (uint64_t)src[byte + i] << (8 * i);
+    }
+
+    return (uint32_t)((value >> shift) & ((count == 32) ? 0xFFFFFFFFU : ((1U << count) - 1)));
+}
+
+static int32_t zstd_bits_init(struct zstd_bits *bits, const uint8_t *src, uint32_t size)
+{
+    if (size == 0 || src[size - 1] == 0)
+    {
+        return -1;
+    }
+
+    // The highest set bit of the last byte marks the end of the stream
+    bits->src = src;
+    bits->bitPos = (int32_t)((size - 1) * 8 + zstd_highbit(src[size - 1]));
+    return 0;
+}
+
+// Returns the next count bits without consuming them; bits before the stream read as zero
+static uint32_t zstd_bits_peek(const struct zstd_bits *bits, uint32_t count)
+{
+    int32_t start = bits->bitPos - (int32_t)count;
+
+    if (count == 0 || bits->bitPos <= 0)
+    {
+        return 0;
+    }
+    if (start < 0)
+    {
+        return zstd_gather(bits->src, 0, count + start) << (-start);
+    }
+
+    return zstd_gather(bits->src, (uint32_t)start, count);
+}
+
+static uint32_t zstd_bits_read(struct zstd_bits *bits, uint32_t count)
+{
+    uint32_t value = zstd_bits_peek(bits, count);
+
+    bits->bitPos -= (int32_t)count;
+    return value;
+}
+
+// Reads an FSE table description; returns the number of bytes used or -1
+static int32_t zstd_fse_read_counts(const uint8_t *src, uint32_t size, int16_t *norm,
+    uint32_t maxSymbol, uint8_t maxLog, uint8_t *tableLog)
+{
+    uint8_t padded[8];
+    uint32_t bitOffset = 4;
+    uint32_t symbol = 0;
+    uint8_t previousZero = 0;
+
+    if (size == 0)
+    {
+        return -1;
+    }
+
+    // Short descriptions are read through a zero padded copy
+    const uint8_t *stream = src;
+    if (size < sizeof(padded))
+    {
+        memset(padded, 0, sizeof(padded));
+        memcpy(padded, src, size);
+        stream = padded;
+    }
+    uint32_t limit = ((size < sizeof(padded)) ? sizeof(padded) : size) * 8;
+
+    uint8_t log = (stream[0] & 0xF) + 5;
+    if (log > maxLog)
+    {
+        return -1;
+    }
+
+    int32_t remaining = (1 << log) + 1;
+    int32_t threshold = 1 << log;
+    uint32_t nbBits = log + 1;
+
+    while (remaining > 1 && symbol <= maxSymbol)
+    {
+        if (bitOffset + 32 > limit && bitOffset + nbBits > limit)
+        {
+            return -1;
+        }
+
+        if (previousZero)
+        {
+            uint32_t zeroEnd = symbol;
+
+            // Runs of zero probabilities are coded as 2-bit repeat flags
+            while (bitOffset + 16 <= limit && zstd_gather(stream, bitOffset, 16) == 0xFFFF)
+            {
+                zeroEnd += 24;
+                bitOffset += 16;
+            }
+            while (bitOffset + 2 <= limit && zstd_gather(stream, bitOffset, 2) == 3)
+            {
+                zeroEnd += 3;
+                bitOffset += 2;
+            }
+            if (bitOffset + 2 > limit)
+            {
+                return -1;
+            }
+            zeroEnd += zstd_gather(stream, bitOffset, 2);
+            bitOffset += 2;
+
+            if (zeroEnd > maxSymbol)
+            {
+                return -1;
+            }
+            while (symbol < zeroEnd)
+            {
+                norm[symbol++] = 0;
+            }
+        }
+
+        int32_t max = (2 * threshold - 1) - remaining;
+        uint32_t available = limit - bitOffset;
+        uint32_t value = zstd_gather(stream, bitOffset, (nbBits < available) ? nbBits : available);
+        int32_t count;
+
+        if ((int32_t)(value & (threshold - 1)) < max)
+        {
+            count = value & (threshold - 1);
+            bitOffset += nbBits - 1;
+        }
+        else
+        {
+            count = value & (2 * threshold - 1);
+            if (count >= threshold)
+            {
+                count -= max;
+            }
+            bitOffset += nbBits;
+        }
+
+        // A count of -1 marks a "less than one" probability
+        count--;
+        remaining -= (count < 0) ? -count : count;
+        norm[symbol++] = (int16_t)count;
+        previousZero = (count == 0);
+
+        while (remaining < threshold)
+        {
+            nbBits--;
+            threshold >>= 1;
+        }
+    }
+
+    if (remaining != 1 || bitOffset > size * 8)
+    {
+        return -1;
+    }
+
+    while (symbol <= maxSymbol)
+    {
+        norm[symbol++] = 0;
+    }
+
+    *tableLog = log;
+    return (int32_t)((bitOffset + 7) >> 3);
+}
+
+// Builds an FSE decoding table from normalized counts (RFC 8878 section 4.1.1)
+static void zstd_fse_build(struct zstd_fse_entry *table, const int16_t *norm, uint32_t maxSymbol, uint8_t log)
+{
+    uint32_t tableSize = 1U << log;
+    uint32_t highThreshold = tableSize - 1;
+    uint16_t symbolNext[ZSTD_HUF_MAX_SYMBOL + 1];
+
+    // "Less than one" symbols take the last cells
+    for (uint32_t s = 0; s <= maxSymbol; s++)
+    {
+        if (norm[s] == -1)
+        {
+            table[highThreshold--].symbol = (uint8_t)s;
+            symbolNext[s] = 1;
+        }
+        else
+        {
+            symbolNext[s] = (uint16_t)norm[s];
+        }
+    }
+
+    // Spread the remaining symbols across the table
+    uint32_t step = (tableSize >> 1) + (tableSize >> 3) + 3;
+    uint32_t mask = tableSize - 1;
+    uint32_t position = 0;
+    for (uint32_t s = 0; s <= maxSymbol; s++)
+    {
+        for (int32_t i = 0; i < norm[s]; i++)
+        {
+            table[position].symbol = (uint8_t)s;
+            do
+            {
+                position = (position + step) & mask;
+            } while (position > highThreshold);
+        }
+    }
+
+    for (uint32_t i = 0; i < tableSize; i++)
+    {
+        uint32_t next = symbolNext[table[i].symbol]++;
+        uint8_t nbBits = (uint8_t)(log - zstd_highbit(next));
+
+        table[i].nbBits = nbBits;
+        table[i].newState = (uint16_t)((next << nbBits) - tableSize);
+    }
+}
+
+// Reads an FSE table description and builds its decoding table
+static int32_t zstd_fse_read_table(struct zstd_fse_entry *table, uint8_t *log, const uint8_t *src,
+    uint32_t size, uint32_t maxSymbol, uint8_t maxLog)
+{
+    int16_t norm[ZSTD_HUF_MAX_SYMBOL + 1];
+    int32_t used = zstd_fse_read_counts(src, size, norm, maxSymbol, maxLog, log);
+
+    if (used < 0)
+    {
+        return -1;
+    }
+
+    zstd_fse_build(table, norm, maxSymbol, *log);
+    return used;
+}
+
+static uint8_t zstd_fse_decode(const struct zstd_fse_entry *table, uint32_t *state, struct zstd_bits *bits)
+{
+    const struct zstd_fse_entry *entry = &table[*state];
+
+    *state = entry->newState + zstd_bits_read(bits, entry->nbBits);
+    return entry->symbol;
+}
+
+// Reads a Huffman tree description; returns the number of bytes used or -1
+static int32_t zstd_huf_read_table(struct zstd_huf_entry *table, uint8_t *tableLog, const uint8_t *src, uint32_t size)
+{
+    uint8_t weights[ZSTD_HUF_MAX_SYMBOL + 1];
+    uint32_t numWeights = 0;
+    int32_t used;
+
+    if (size == 0)
+    {
+        return -1;
+    }
+
+    uint8_t header = src[0];
+    if (header >= 128)
+    {
+        // Weights stored directly, two per byte
+        numWeights = header - 127;
+        used = 1 + (int32_t)((numWeights + 1) / 2);
+        if ((uint32_t)used > size)
+        {
+            return -1;
+        }
+        for (uint32_t i = 0; i < numWeights; i++)
+        {
+            uint8_t byte = src[1 + i / 2];
+            weights[i] = (i & 1) ? (byte & 0xF) : (byte >> 4);
+        }
+    }
+    else
+    {
+        // Weights compressed with FSE using two interleaved states
+        struct zstd_fse_entry weightTable[1 << ZSTD_HUF_WEIGHT_LOG];
+        struct zstd_bits bits;
+        uint8_t weightLog;
+
+        used = 1 + header;
+        if ((uint32_t)used > size)
+        {
+            return -1;
+        }
+
+        int32_t countSize = zstd_fse_read_table(weightTable, &weightLog, src + 1, header,
+            ZSTD_HUF_MAX_SYMBOL, ZSTD_HUF_WEIGHT_LOG);
+        if (countSize < 0 || zstd_bits_init(&bits, src + 1 + countSize, header - countSize) != 0)
+        {
+            return -1;
+        }
+
+        uint32_t state1 = zstd_bits_read(&bits, weightLog);
+        uint32_t state2 = zstd_bits_read(&bits, weightLog);
+        while (1)
+        {
+            if (numWeights > ZSTD_HUF_MAX_SYMBOL - 1)
+            {
+                return -1;
+            }
+            weights[numWeights++] = zstd_fse_decode(weightTable, &state1, &bits);
+            if (bits.bitPos < 0)
+            {
+                weights[numWeights++] = weightTable[state2].symbol;
+                break;
+            }
+
+            weights[numWeights++] = zstd_fse_decode(weightTable, &state2, &bits);
+            if (bits.bitPos < 0)
+            {
+                weights[numWeights++] = weightTable[state1].symbol;
+                break;
+            }
+        }
+    }
+
+    // The last weight is implied by completing the total to a power of two
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < numWeights; i++)
+    {
+        if (weights[i] > ZSTD_HUF_MAX_LOG)
+        {
+            return -1;
+        }
+        total += (weights[i] > 0) ? (1U << (weights[i] - 1)) : 0;
+    }
+    if (total == 0 || numWeights > ZSTD_HUF_MAX_SYMBOL)
+    {
+        return -1;
+    }
+
+    uint8_t log = (uint8_t)(zstd_highbit(total) + 1);
+    uint32_t rest = (1U << log) - total;
+    if (log > ZSTD_HUF_MAX_LOG || (rest & (rest - 1)) != 0)
+    {
+        return -1;
+    }
+    weights[numWeights++] = (uint8_t)(zstd_highbit(rest) + 1);
+
+    // Fill the decoding table: longer codes (smaller weights) take the lower cells
+    uint32_t rankStart[ZSTD_HUF_MAX_LOG + 2];
+    uint32_t rankCount[ZSTD_HUF_MAX_LOG + 2];
+    memset(rankCount, 0, sizeof(rankCount));
+    for (uint32_t i = 0; i < numWeights; i++)
+    {
+        rankCount[weights[i]]++;
+    }
+
+    uint32_t next = 0;
+    for (uint32_t w = 1; w <= log; w++)
+    {
+        rankStart[w] = next;
+        next += rankCount[w] << (w - 1);
+    }
+
+    for (uint32_t i = 0; i < numWeights; i++)
+    {
+        uint8_t w = weights[i];
+        if (w == 0)
+        {
+            continue;
+        }
+
+        uint32_t length = 1U << (w - 1);
+        for (uint32_t j = 0; j < length; j++)
+        {
+            table[rankStart[w] + j].symbol = (uint8_t)i;
+            table[rankStart[w] + j].nbBits = (uint8_t)(log + 1 - w);
+        }
+        rankStart[w] += length;
+    }
+
+    *tableLog = log;
+    return used;
+}
+
+static int32_t zstd_huf_decode_stream(const struct zstd_huf_entry *table, uint8_t log,
+    const uint8_t *src, uint32_t size, uint8_t *dst, uint32_t count)
+{
+    struct zstd_bits bits;
+
+    if (zstd_bits_init(&bits, src, size) != 0)
+    {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const struct zstd_huf_entry *entry = &table[zstd_bits_peek(&bits, log)];
+        dst[i] = entry->symbol;
+        bits.bitPos -= entry->nbBits;
+    }
+
+    // Every stream must be consumed exactly
+    return (bits.bitPos == 0) ? 0 : -1;
+}
+
+// Decodes the literals section; returns the bytes used and where the literals now live
+static int32_t zstd_decode_literals(struct zstd_context *context, struct zstd_frame *frame,
+    const uint8_t *src, uint32_t size, const uint8_t **literals, uint32_t *literalSize)
+{
+    uint8_t type;
+    uint8_t format;
+    uint32_t regenerated;
+    uint32_t compressed = 0;
+    uint32_t headerSize;
+    uint8_t streams = 1;
+
+    // A compressed block holds at least the literals section header
+    if (size == 0)
+    {
+        return -1;
+    }
+    type = src[0] & 3;
+    format = (src[0] >> 2) & 3;
+
+    if (type == ZSTD_LIT_RAW || type == ZSTD_LIT_RLE)
+    {
+        if (format == 0 || format == 2)
+        {
+            headerSize = 1;
+            regenerated = src[0] >> 3;
+        }
+        else if (format == 1)
+        {
+            headerSize = 2;
+            if (size < headerSize)
+            {
+                return -1;
+            }
+            regenerated = (src[0] >> 4) | ((uint32_t)src[1] << 4);
+        }
+        else
+        {
+            headerSize = 3;
+            if (size < headerSize)
+            {
+                return -1;
+            }
+            regenerated = (src[0] >> 4) | ((uint32_t)src[1] << 4) | ((uint32_t)src[2] << 12);
+        }
+    }
+    else
+    {
+        headerSize = (format < 2) ? 3 : (format == 2) ? 4 : 5;
+        streams = (format == 0) ? 1 : 4;
+        if (size < headerSize + 1)
+        {
+            return -1;
+        }
+
+        uint64_t header = 0;
+        for (uint32_t i = 0; i < headerSize; i++)
+        {
+            header |= (uint64_t)src[i] << (8 * i);
+        }
+
+        uint32_t fieldBits = (headerSize == 3) ? 10 : (headerSize == 4) ? 14 : 18;
+        regenerated = (uint32_t)(header >> 4) & ((1U << fieldBits) - 1);
+        compressed = (uint32_t)(header >> (4 + fieldBits)) & ((1U << fieldBits) - 1);
+    }
+
+    // Literals never exceed what is left of the output
+    if (regenerated > (uint32_t)(frame->dstEnd - frame->op))
+    {
+        return -1;
+    }
+    *literalSize = regenerated;
+
+    if (type == ZSTD_LIT_RAW)
+    {
+        if (headerSize + regenerated > size)
+        {
+            return -1;
+        }
+        *literals = src + headerSize;
+        return (int32_t)(headerSize + regenerated);
+    }
+
+    uint8_t *buffer = frame->dstEnd - regenerated;
+    *literals = buffer;
+
+    if (type == ZSTD_LIT_RLE)
+    {
+        if (headerSize + 1 > size)
+        {
+            return -1;
+        }
+        for (uint32_t i = 0; i < regenerated; i++)
+        {
+            buffer[i] = src[headerSize];
+        }
+        return (int32_t)(headerSize + 1);
+    }
+
+    if (headerSize + compressed > size)
+    {
+        return -1;
+    }
+
+    const uint8_t *stream = src + headerSize;
+    uint32_t streamSize = compressed;
+
+    if (type == ZSTD_LIT_COMPRESSED)
+    {
+        int32_t used = zstd_huf_read_table(context->tables.huf, &context->tables.hufLog, stream, streamSize);
+        if (used < 0)
+        {
+            return -1;
+        }
+        frame->huf = context->tables.huf;
+        frame->hufLog = context->tables.hufLog;
+        stream += used;
+        streamSize -= used;
+    }
+    else if (frame->huf == NULL)
+    {
+        return -1;
+    }
+
+    if (streams == 1)
+    {
+        if (zstd_huf_decode_stream(frame->huf, frame->hufLog, stream, streamSize, buffer, regenerated) != 0)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        // Four streams behind a jump table of three 16-bit sizes
+        if (streamSize < 6)
+        {
+            return -1;
+        }
+
+        uint32_t sizes[4];
+        sizes[0] = stream[0] | ((uint32_t)stream[1] << 8);
+        sizes[1] = stream[2] | ((uint32_t)stream[3] << 8);
+        sizes[2] = stream[4] | ((uint32_t)stream[5] << 8);
+        if (sizes[0] + sizes[1] + sizes[2] + 6 > streamSize)
+        {
+            return -1;
+        }
+        sizes[3] = streamSize - 6 - sizes[0] - sizes[1] - sizes[2];
+        stream += 6;
+
+        uint32_t segment = (regenerated + 3) / 4;
+        uint32_t written = 0;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            uint32_t count = (i < 3) ? segment : regenerated - written;
+            if (i < 3 && written + count > regenerated)
+            {
+                return -1;
+            }
+            if (zstd_huf_decode_stream(frame->huf, frame->hufLog, stream, sizes[i], buffer + written, count) != 0)
+            {
+                return -1;
+            }
+            stream += sizes[i];
+            written += count;
+        }
+    }
+
+    return (int32_t)(headerSize + compressed);
+}
+
+// Selects the table for one sequence symbol type; returns the bytes used or -1
+static int32_t zstd_select_table(uint8_t mode, const uint8_t *src, uint32_t size, struct zstd_fse_entry *storage,
+    const struct zstd_fse_entry **table, uint8_t *log, const int16_t *defaults, uint8_t defaultLog,
+    uint32_t maxSymbol, uint8_t maxLog)
+{
+    switch (mode)
+    {
+        case ZSTD_MODE_PREDEFINED:
+            zstd_fse_build(storage, defaults, maxSymbol, defaultLog);
+            *table = storage;
+            *log = defaultLog;
+            return 0;
+
+        case ZSTD_MODE_RLE:
+            if (size < 1 || src[0] > maxSymbol)
+            {
+                return -1;
+            }
+            storage[0].symbol = src[0];
+            storage[0].nbBits = 0;
+            storage[0].newState = 0;
+            *table = storage;
+            *log = 0;
+            return 1;
+
+        case ZSTD_MODE_FSE:
+        {
+            int32_t used = zstd_fse_read_table(storage, log, src, size, maxSymbol, maxLog);
+            if (used < 0)
+            {
+                return -1;
+            }
+            *table = storage;
+            return used;
+        }
+
+        default:
+            return (*table == NULL) ? -1 : 0;
+    }
+}
+
+static int32_t zstd_copy_match(struct zstd_frame *frame, uint32_t offset, uint32_t length)
+{
+    uint8_t *op = frame->op;
+    uint32_t produced = (uint32_t)(op - frame->dst);
+
+    if (offset > produced + frame->dictSize)
+    {
+        return -1;
+    }
+
+    // Part of the match may come from the dictionary content in front of the output
+    if (offset > produced)
+    {
+        const uint8_t *match = frame->dictContent + frame->dictSize - (offset - produced);
+        uint32_t fromDict = offset - produced;
+        if (fromDict > length)
+        {
+            fromDict = length;
+        }
+        for (uint32_t i = 0; i < fromDict; i++)
+        {
+            op[i] = match[i];
+        }
+        op += fromDict;
+        length -= fromDict;
+        offset = (uint32_t)(op - frame->dst);
+    }
+
+    const uint8_t *match = op - offset;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        op[i] = match[i];
+    }
+    frame->op = op + length;
+    return 0;
+}
+
+static int32_t zstd_decode_block(struct zstd_context *context, struct zstd_frame *frame,
+    const uint8_t *src, uint32_t size)
+{
+    const uint8_t *literals;
+    uint32_t literalSize;
+
+    int32_t used = zstd_decode_literals(context, frame, src, size, &literals, &literalSize);
+    if (used < 0)
+    {
+        return -1;
+    }
+    src += used;
+    size -= used;
+
+    // Number of sequences
+    if (size < 1)
+    {
+        return -1;
+    }
+    uint32_t numSequences = src[0];
+    uint32_t headerSize = 1;
+    if (numSequences >= 128)
+    {
+        if (numSequences == 255)
+        {
+            if (size < 3)
+            {
+                return -1;
+            }
+            numSequences = src[1] + ((uint32_t)src[2] << 8) + 0x7F00;
+            headerSize = 3;
+        }
+        else
+        {
+            if (size < 2)
+            {
+                return -1;
+            }
+            numSequences = ((numSequences - 128) << 8) + src[1];
+            headerSize = 2;
+        }
+    }
+    src += headerSize;
+    size -= headerSize;
+
+    const uint8_t *literalEnd = literals + literalSize;
+    uint8_t *op = frame->op;
+
+    if (numSequences > 0)
+    {
+        if (size < 1)
+        {
+            return -1;
+        }
+
+        uint8_t modes = src[0];
+        src++;
+        size--;
+
+        used = zstd_select_table((modes >> 6) & 3, src, size, context->tables.ll, &frame->ll, &frame->llLog,
+            zstdLLDefault, 6, ZSTD_LL_MAX_SYMBOL, ZSTD_LL_MAX_LOG);
+        if (used < 0)
+        {
+            return -1;
+        }
+        src += used;
+        size -= used;
+
+        used = zstd_select_table((modes >> 4) & 3, src, size, context->tables.of, &frame->of, &frame->ofLog,
+            zstdOFDefault, 5, 28, ZSTD_OF_MAX_LOG);
+        if (used < 0)
+        {
+            return -1;
+        }
+        src += used;
+        size -= used;
+
+        used = zstd_select_table((modes >> 2) & 3, src, size, context->tables.ml, &frame->ml, &frame->mlLog,
+            zstdMLDefault, 6, ZSTD_ML_MAX_SYMBOL, ZSTD_ML_MAX_LOG);
+        if (used < 0)
+        {
+            return -1;
+        }
+        src += used;
+        size -= used;
+
+        struct zstd_bits bits;
+        if (zstd_bits_init(&bits, src, size) != 0)
+        {
+            return -1;
+        }
+
+        uint32_t llState = zstd_bits_read(&bits, frame->llLog);
+        uint32_t ofState = zstd_bits_read(&bits, frame->ofLog);
+        uint32_t mlState = zstd_bits_read(&bits, frame->mlLog);
+
+        for (uint32_t i = 0; i < numSequences; i++)
+        {
+            uint8_t ofCode = frame->of[ofState].symbol;
+            uint8_t mlCode = frame->ml[mlState].symbol;
+            uint8_t llCode = frame->ll[llState].symbol;
+
+            if (ofCode > ZSTD_OF_MAX_SYMBOL || mlCode > ZSTD_ML_MAX_SYMBOL || llCode > ZSTD_LL_MAX_SYMBOL)
+            {
+                return -1;
+            }
+
+            // Extra bits are read as offset, match length, then literal length
+            uint32_t offsetValue = (1U << ofCode) + zstd_bits_read(&bits, ofCode);
+            uint32_t matchLength = zstdMLBase[mlCode] + zstd_bits_read(&bits, zstdMLBits[mlCode]);
+            uint32_t literalLength = zstdLLBase[llCode] + zstd_bits_read(&bits, zstdLLBits[llCode]);
+
+            // Resolve repeat offsets
+            uint32_t offset;
+            if (offsetValue > 3)
+            {
+                offset = offsetValue - 3;
+                frame->rep[2] = frame->rep[1];
+                frame->rep[1] = frame->rep[0];
+                frame->rep[0] = offset;
+            }
+            else
+            {
+                uint32_t index = offsetValue - 1 + (literalLength == 0);
+                if (index == 0)
+                {
+                    offset = frame->rep[0];
+                }
+                else
+                {
+                    offset = (index == 3) ? frame->rep[0] - 1 : frame->rep[index];
+                    if (index != 1)
+                    {
+                        frame->rep[2] = frame->rep[1];
+                    }
+                    frame->rep[1] = frame->rep[0];
+                    frame->rep[0] = offset;
+                }
+            }
+
+            if (literalLength > (uint32_t)(literalEnd - literals) ||
+                (uint64_t)literalLength + matchLength > (uint64_t)(frame->dstEnd - op) || offset == 0)
+            {
+                return -1;
+            }
+
+            // Literals first, then the match
+            for (uint32_t j = 0; j < literalLength; j++)
+            {
+                op[j] = literals[j];
+            }
+            op += literalLength;
+            literals += literalLength;
+
+            frame->op = op;
+            if (zstd_copy_match(frame, offset, matchLength) != 0)
+            {
+                return -1;
+            }
+            op = frame->op;
+
+            // States are updated in the order literal length, match length, offset
+            if (i + 1 < numSequences)
+            {
+                zstd_fse_decode(frame->ll, &llState, &bits);
+                zstd_fse_decode(frame->ml, &mlState, &bits);
+                zstd_fse_decode(frame->of, &ofState, &bits);
+            }
+        }
+
+        if (bits.bitPos != 0)
+        {
+            return -1;
+        }
+    }
+
+    // Trailing literals
+    uint32_t remaining = (uint32_t)(literalEnd - literals);
+    if (remaining > (uint32_t)(frame->dstEnd - op))
+    {
+        return -1;
+    }
+    for (uint32_t j = 0; j < remaining; j++)
+    {
+        op[j] = literals[j];
+    }
+    frame->op = op + remaining;
+
+    return 0;
+}
+
+int32_t zstd_dict_load(struct zstd_dict *dict, const uint8_t *data, uint32_t size)
+{
+    memset(dict, 0, sizeof(*dict));
+    dict->tables.rep[0] = 1;
+    dict->tables.rep[1] = 4;
+    dict->tables.rep[2] = 8;
+
+    // Anything without the dictionary magic is used as raw content
+    if (size < 8 || zstd_read_le32(data) != ZSTD_DICT_MAGIC)
+    {
+        dict->content = data;
+        dict->contentSize = size;
+        return 0;
+    }
+
+    dict->id = zstd_read_le32(data + 4);
+    const uint8_t *p = data + 8;
+    const uint8_t *end = data + size;
+    int32_t used;
+
+    // Entropy tables: Huffman, then offset, match length and literal length FSE tables
+    used = zstd_huf_read_table(dict->tables.huf, &dict->tables.hufLog, p, end - p);
+    if (used < 0)
+    {
+        return -1;
+    }
+    p += used;
+
+    used = zstd_fse_read_table(dict->tables.of, &dict->tables.ofLog, p, end - p, ZSTD_OF_MAX_SYMBOL, ZSTD_OF_MAX_LOG);
+    if (used < 0)
+    {
+        return -1;
+    }
+    p += used;
+
+    used = zstd_fse_read_table(dict->tables.ml, &dict->tables.mlLog, p, end - p, ZSTD_ML_MAX_SYMBOL, ZSTD_ML_MAX_LOG);
+    if (used < 0)
+    {
+        return -1;
+    }
+    p += used;
+
+    used = zstd_fse_read_table(dict->tables.ll, &dict->tables.llLog, p, end - p, ZSTD_LL_MAX_SYMBOL, ZSTD_LL_MAX_LOG);
+    if (used < 0)
+    {
+        return -1;
+    }
+    p += used;
+
+    if (end - p < 12)
+    {
+        return -1;
+    }
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        dict->tables.rep[i] = zstd_read_le32(p + 4 * i);
+    }
+    p += 12;
+
+    dict->content = p;
+    dict->contentSize = (uint32_t)(end - p);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        if (dict->tables.rep[i] == 0 || dict->tables.rep[i] > dict->contentSize)
+        {
+            return -1;
+        }
+    }
+    dict->tables.valid = ZSTD_TABLE_LL | ZSTD_TABLE_OF | ZSTD_TABLE_ML | ZSTD_TABLE_HUF;
+
+    return 0;
+}
+
+int32_t zstd_decompress(struct zstd_context *context, const uint8_t *src, uint32_t srcSize,
+    uint8_t *dst, uint32_t dstSize, const struct zstd_dict *dict)
+{
+    struct zstd_frame frame;
+    const uint8_t *end = src + srcSize;
+
+    if (srcSize < 6 || zstd_read_le32(src) != ZSTD_MAGIC)
+    {
+        return -1;
+    }
+
+    // Frame header descriptor
+    uint8_t descriptor = src[4];
+    uint8_t sizeFlag = descriptor >> 6;
+    uint8_t singleSegment = (descriptor >> 5) & 1;
+    uint8_t checksum = (descriptor >> 2) & 1;
+    uint8_t dictFlag = descriptor & 3;
+    const uint8_t *p = src + 5;
+
+    if (descriptor & 0x08)
+    {
+        return -1;
+    }
+    if (!singleSegment)
+    {
+        p++;    // Window descriptor; the destination buffer is the window
+    }
+
+    uint32_t dictIdSize = (dictFlag == 3) ? 4 : dictFlag;
+    uint32_t sizeBytes = (sizeFlag == 0) ? singleSegment : (1U << sizeFlag);
+    if (sizeBytes == 0 || p + dictIdSize + sizeBytes > end)
+    {
+        return -1;  // The content size is needed to place the literals
+    }
+
+    uint32_t dictId = 0;
+    for (uint32_t i = 0; i < dictIdSize; i++)
+    {
+        dictId |= (uint32_t)p[i] << (8 * i);
+    }
+    p += dictIdSize;
+
+    uint64_t contentSize = 0;
+    for (uint32_t i = 0; i < sizeBytes; i++)
+    {
+        contentSize |= (uint64_t)p[i] << (8 * i);
+    }
+    if (sizeBytes == 2)
+    {
+        contentSize += 256;
+    }
+    p += sizeBytes;
+
+    if (contentSize != dstSize || (dictId != 0 && (dict == NULL || dict->id != dictId)))
+    {
+        return -1;
+    }
+
+    // Seed the frame from the dictionary, if any
+    memset(&frame, 0, sizeof(frame));
+    frame.dst = dst;
+    frame.dstEnd = dst + dstSize;
+    frame.op = dst;
+    frame.rep[0] = 1;
+    frame.rep[1] = 4;
+    frame.rep[2] = 8;
+    if (dict != NULL)
+    {
+        frame.dictContent = dict->content;
+        frame.dictSize = dict->contentSize;
+        if (dict->tables.valid)
+        {
+            frame.ll = dict->tables.ll;
+            frame.of = dict->tables.of;
+            frame.ml = dict->tables.ml;
+            frame.huf = dict->tables.huf;
+            frame.llLog = dict->tables.llLog;
+            frame.ofLog = dict->tables.ofLog;
+            frame.mlLog = dict->tables.mlLog;
+            frame.hufLog = dict->tables.hufLog;
+            frame.rep[0] = dict->tables.rep[0];
+            frame.rep[1] = dict->tables.rep[1];
+            frame.rep[2] = dict->tables.rep[2];
+        }
+    }
+
+    // Blocks
+    uint8_t last = 0;
+    while (!last)
+    {
+        if (end - p < 3)
+        {
+            return -1;
+        }
+
+        uint32_t blockHeader = p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+        uint8_t type = (blockHeader >> 1) & 3;
+        uint32_t blockSize = blockHeader >> 3;
+        last = blockHeader & 1;
+        p += 3;
+
+        uint32_t storedSize = (type == ZSTD_BLOCK_RLE) ? 1 : blockSize;
+        if ((uint32_t)(end - p) < storedSize)
+        {
+            return -1;
+        }
+
+        if (type == ZSTD_BLOCK_RAW || type == ZSTD_BLOCK_RLE)
+        {
+            if (blockSize > (uint32_t)(frame.dstEnd - frame.op))
+            {
+                return -1;
+            }
+            for (uint32_t i = 0; i < blockSize; i++)
+            {
+                frame.op[i] = (type == ZSTD_BLOCK_RAW) ? p[i] : p[0];
+            }
+            frame.op += blockSize;
+        }
+        else if (type == ZSTD_BLOCK_COMPRESSED)
+        {
+            if (zstd_decode_block(context, &frame, p, blockSize) != 0)
+            {
+                return -1;
+            }
+        }
+        else
+        {
+            return -1;
+        }
+        p += storedSize;
+    }
+
+    if (checksum && end - p < 4)
+    {
+        return -1;
+    }
+
+    return (int32_t)(frame.op - dst);
+}
@@ -0,0 +1,69 @@
+/*
+ * Description: Compact Zstandard (RFC 8878) frame decoder used by the boot pack loader.
+ * Output is written straight into the destination buffer, which doubles as the match
+ * window and as scratch space for decoded literals, so the only working memory is the
+ * entropy tables in struct zstd_context (about 9 KiB). Frames must record their content
+ * size, and the destination must be exactly that large. Optional dictionaries in the
+ * zstd format (or raw content) are supported; frame checksums are skipped.
+ */
+
+#ifndef ZSTD_DECODER_H
+#define ZSTD_DECODER_H
+
+#include "stdint.h"
+
+#define ZSTD_LL_MAX_LOG 9
+#define ZSTD_ML_MAX_LOG 9
+#define ZSTD_OF_MAX_LOG 8
+#define ZSTD_HUF_MAX_LOG 11
+
+struct zstd_fse_entry
+{
+    uint8_t symbol;
+    uint8_t nbBits;
+    uint16_t newState;
+};
+
+struct zstd_huf_entry
+{
+    uint8_t symbol;
+    uint8_t nbBits;
+};
+
+// Entropy tables carried from block to block (and seeded from a dictionary)
+struct zstd_tables
+{
+    struct zstd_fse_entry ll[1 << ZSTD_LL_MAX_LOG];
+    struct zstd_fse_entry of[1 << ZSTD_OF_MAX_LOG];
+    struct zstd_fse_entry ml[1 << ZSTD_ML_MAX_LOG];
+    struct zstd_huf_entry huf[1 << ZSTD_HUF_MAX_LOG];
+    uint8_t llLog;
+    uint8_t ofLog;
+    uint8_t mlLog;
+    uint8_t hufLog;
+    uint8_t valid;              // ZSTD_TABLE_* bits for tables that may be repeated
+    uint32_t rep[3];
+};
+
+struct zstd_dict
+{
+    uint32_t id;
+    const uint8_t *content;
+    uint32_t contentSize;
+    struct zstd_tables tables;
+};
+
+// Per-core decoder state; one context must not be shared between cores
+struct zstd_context
+{
+    struct zstd_tables tables;
+};
+
+// Parses a dictionary; the data must stay in memory while frames use it
+int32_t zstd_dict_load(struct zstd_dict *dict, const uint8_t *data, uint32_t size);
+
+// Decodes one frame and returns the number of bytes written, or -1 on malformed input
+int32_t zstd_decompress(struct zstd_context *context, const uint8_t *src, uint32_t srcSize,
+    uint8_t *dst, uint32_t dstSize, const struct zstd_dict *dict);
+
+#endif